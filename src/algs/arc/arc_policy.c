@@ -9,7 +9,7 @@
 #include "arc_policy_struct.h"
 #include "cache_nucleus_internal.h"
 #include "common.h"
-#include "tools/queue.h"
+#include "tools/iqueue.h"
 
 struct arc_transaction {
   oblock_t oblock;
@@ -100,7 +100,7 @@ bool arc_transaction_is_legal(struct arc_policy *arc,
   bool legal = true;
 
   if (at->cache_evict != ARC_NULL) {
-    legal &= queue_length(&arc->arc_q[at->cache_evict]) > 0;
+    legal &= iqueue_length(&arc->arc_q[at->cache_evict]) > 0;
   }
 
   return legal;
@@ -112,7 +112,7 @@ void arc_remove_entry(struct arc_policy *arc, struct arc_entry *ae) {
 
   --arc->length[ae->loc];
   if (!e->migrating) {
-    queue_remove(&ae->arc_list);
+    iqueue_remove(&arc->queues, &ae->arc_list);
     if (in_cache(cn, e)) {
       inc_demotions(&cn->stats);
     }
@@ -126,7 +126,7 @@ void arc_evict(struct arc_policy *arc, enum arc_list list,
                struct cache_nucleus_result *result) {
   struct cache_nucleus *cn = &arc->nucleus;
   struct arc_entry *ae =
-      queue_pop_entry(&arc->arc_q[list], struct arc_entry, arc_list);
+      iqueue_pop_entry(&arc->arc_q[list], struct arc_entry, arc_list);
   struct entry *evicted = &ae->e;
   if (result != NULL) {
     result->old_oblock = evicted->oblock;
@@ -195,7 +195,7 @@ void arc_transaction_commit(struct arc_policy *arc, struct arc_transaction *at,
 
       meta_ae->loc = ARC_NULL;
       arc_set_for_list(arc, meta_ae, meta_dest);
-      queue_push(&arc->arc_q[meta_dest], &meta_ae->arc_list);
+      iqueue_push(&arc->arc_q[meta_dest], &meta_ae->arc_list);
     }
   }
 
@@ -206,8 +206,8 @@ void arc_transaction_commit(struct arc_policy *arc, struct arc_transaction *at,
     result->cblock = infer_cblock(&cn->cache_pool, e);
 
     if (!migrating) {
-      queue_remove(&ae->arc_list);
-      queue_push(&arc->arc_q[at->dest], &ae->arc_list);
+      iqueue_remove(&arc->queues, &ae->arc_list);
+      iqueue_push(&arc->arc_q[at->dest], &ae->arc_list);
     }
   } else {
     e = insert_in_cache(cn, at->oblock, result);
@@ -247,7 +247,7 @@ void arc_remove_api(struct cache_nucleus *cn, oblock_t oblock,
 
     ae->loc = ARC_NULL;
     arc_set_for_list(arc, ae, dest);
-    queue_push(&arc->arc_q[dest], &ae->arc_list);
+    iqueue_push(&arc->arc_q[dest], &ae->arc_list);
   }
 }
 
@@ -259,7 +259,7 @@ void arc_insert_api(struct cache_nucleus *cn, oblock_t oblock,
 
   ae->loc = ARC_NULL;
   arc_set_for_list(arc, ae, ARC_T1);
-  queue_push(&arc->arc_q[ARC_T1], &ae->arc_list);
+  iqueue_push(&arc->arc_q[ARC_T1], &ae->arc_list);
 }
 
 void arc_migrated_api(struct cache_nucleus *cn, oblock_t oblock) {
@@ -275,7 +275,7 @@ void arc_migrated_api(struct cache_nucleus *cn, oblock_t oblock) {
 
   LOG_ASSERT(ae->loc != ARC_NULL);
 
-  queue_push(&arc->arc_q[ae->loc], &ae->arc_list);
+  iqueue_push(&arc->arc_q[ae->loc], &ae->arc_list);
 
   inc_promotions(&cn->stats);
 }
@@ -333,8 +333,8 @@ enum cache_nucleus_operation arc_next_victim_api(struct cache_nucleus *cn,
     if (at.current_loc == ARC_T1 || at.current_loc == ARC_T2) {
       return CACHE_NUCLEUS_HIT;
     } else if (at.cache_evict != ARC_NULL) {
-      struct arc_entry *ae = queue_peek_entry(&arc->arc_q[at.cache_evict],
-                                              struct arc_entry, arc_list);
+      struct arc_entry *ae = iqueue_peek_entry(&arc->arc_q[at.cache_evict],
+                                               struct arc_entry, arc_list);
       *next_victim_p = &ae->e;
       return CACHE_NUCLEUS_REPLACE;
     } else {
@@ -356,24 +356,27 @@ int arc_init(struct arc_policy *arc, cblock_t cache_size, cblock_t meta_size) {
       default_residency, default_cache_is_full, default_infer_cblock,
       arc_next_victim_api);
 
+  iqueue_set_init(&arc->queues, sizeof(struct arc_entry));
   for (i = 0; i < NUM_ARC_LISTS; ++i) {
-    queue_init(&arc->arc_q[i]);
+    iqueue_init(&arc->arc_q[i], &arc->queues, struct arc_entry, arc_list);
     arc->length[i] = 0;
   }
 
   arc->p = 0;
 
   epool_create(&cn->cache_pool, cache_size, struct arc_entry, e);
-  if (!cn->cache_pool.entries_begin || !cn->cache_pool.entries) {
+  if (!cn->cache_pool.entries_begin) {
     LOG_DEBUG("epool_create for cache_pool failed.");
     goto cache_epool_create_fail;
   }
+  iqueue_set_add_pool(&arc->queues, &cn->cache_pool);
 
   epool_create(&cn->meta_pool, meta_size, struct arc_entry, e);
-  if (!cn->meta_pool.entries_begin || !cn->meta_pool.entries) {
+  if (!cn->meta_pool.entries_begin) {
     LOG_DEBUG("epool_create for meta_pool failed.");
     goto meta_epool_create_fail;
   }
+  iqueue_set_add_pool(&arc->queues, &cn->meta_pool);
 
   if (policy_init(cn, cache_size, meta_size, CACHE_NUCLEUS_SINGLE_THREAD)) {
     LOG_DEBUG("policy_init failed");
@@ -4,21 +4,22 @@
 #include "cache_nucleus_struct.h"
 #include "common.h"
 #include "entry.h"
-#include "tools/queue.h"
+#include "tools/iqueue.h"
 
 #define NUM_ARC_LISTS 4
 enum arc_list { ARC_T1, ARC_T2, ARC_B1, ARC_B2, ARC_NULL };
 
 struct arc_policy {
   struct cache_nucleus nucleus;
-  struct queue arc_q[NUM_ARC_LISTS];
+  struct iqueue_set queues;
+  struct iqueue arc_q[NUM_ARC_LISTS];
   cblock_t p;
   cblock_t length[NUM_ARC_LISTS];
 };
 
 struct arc_entry {
   struct entry e;
-  struct queue_head arc_list;
+  struct iqueue_head arc_list;
   enum arc_list loc;
 };
 
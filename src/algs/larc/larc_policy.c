@@ -109,7 +109,7 @@ void larc_transaction_set(struct larc_policy *larc,
       lt->dest = LARC_Q;
     } else {
       lt->dest = LARC_G;
-      if (queue_length(&larc->larc_g) + 1 > lt->g_size) {
+      if (iqueue_length(&larc->larc_g) + 1 > lt->g_size) {
         lt->g_evict = true;
       }
     }
@@ -121,7 +121,7 @@ bool larc_transaction_is_legal(struct larc_policy *larc,
   bool legal = true;
 
   if (lt->c_evict) {
-    legal &= queue_length(&larc->larc_q) > 0;
+    legal &= iqueue_length(&larc->larc_q) > 0;
   }
 
   return legal;
@@ -131,7 +131,7 @@ void larc_remove_entry(struct larc_policy *larc, struct larc_entry *le) {
   struct cache_nucleus *cn = &larc->nucleus;
   struct entry *e = &le->e;
   if (!e->migrating) {
-    queue_remove(&le->larc_list);
+    iqueue_remove(&larc->queues, &le->larc_list);
     if (in_cache(cn, e)) {
       inc_demotions(&cn->stats);
     }
@@ -139,10 +139,10 @@ void larc_remove_entry(struct larc_policy *larc, struct larc_entry *le) {
   cache_nucleus_remove(cn, e);
 }
 
-void larc_evict(struct larc_policy *larc, struct queue *q,
+void larc_evict(struct larc_policy *larc, struct iqueue *q,
                 struct cache_nucleus_result *result) {
   struct cache_nucleus *cn = &larc->nucleus;
-  struct larc_entry *le = queue_peek_entry(q, struct larc_entry, larc_list);
+  struct larc_entry *le = iqueue_peek_entry(q, struct larc_entry, larc_list);
   struct entry *demoted = &le->e;
   if (result != NULL) {
     result->old_oblock = demoted->oblock;
@@ -182,7 +182,7 @@ void larc_transaction_commit(struct larc_policy *larc,
       result->cblock = infer_cblock(&cn->cache_pool, e);
 
       if (!e->migrating) {
-        queue_remove(&le->larc_list);
+        iqueue_remove(&larc->queues, &le->larc_list);
       }
 
       inc_hits(&cn->stats);
@@ -196,12 +196,12 @@ void larc_transaction_commit(struct larc_policy *larc,
     }
 
     if (!e->migrating) {
-      queue_push(&larc->larc_q, &le->larc_list);
+      iqueue_push(&larc->larc_q, &le->larc_list);
     }
   } else {
     struct entry *e = insert_in_meta(cn, lt->oblock);
     struct larc_entry *le = to_larc_entry(e);
-    queue_push(&larc->larc_g, &le->larc_list);
+    iqueue_push(&larc->larc_g, &le->larc_list);
 
     inc_filters(&cn->stats);
     result->op = CACHE_NUCLEUS_FILTER;
@@ -227,7 +227,7 @@ void larc_insert_api(struct cache_nucleus *cn, oblock_t oblock,
   struct entry *e = insert_in_cache_at(cn, oblock, cblock, NULL);
   struct larc_entry *le = to_larc_entry(e);
 
-  queue_push(&larc->larc_q, &le->larc_list);
+  iqueue_push(&larc->larc_q, &le->larc_list);
 }
 
 void larc_migrated_api(struct cache_nucleus *cn, oblock_t oblock) {
@@ -240,7 +240,7 @@ void larc_migrated_api(struct cache_nucleus *cn, oblock_t oblock) {
 
   le = to_larc_entry(e);
   migrated_entry(&cn->cache_pool, e);
-  queue_push(&larc->larc_q, &le->larc_list);
+  iqueue_push(&larc->larc_q, &le->larc_list);
 
   inc_promotions(&cn->stats);
 }
@@ -294,7 +294,7 @@ larc_next_victim_api(struct cache_nucleus *cn, oblock_t oblock,
   if (larc_transaction_is_legal(larc, &lt)) {
     if (lt.c_evict) {
       struct larc_entry *le =
-          queue_peek_entry(&larc->larc_q, struct larc_entry, larc_list);
+          iqueue_peek_entry(&larc->larc_q, struct larc_entry, larc_list);
       *next_victim_p = &le->e;
       return CACHE_NUCLEUS_REPLACE;
     }
@@ -317,21 +317,24 @@ int larc_init(struct larc_policy *larc, cblock_t cache_size,
       default_residency, default_cache_is_full, default_infer_cblock,
       larc_next_victim_api);
 
-  queue_init(&larc->larc_q);
-  queue_init(&larc->larc_g);
+  iqueue_set_init(&larc->queues, sizeof(struct larc_entry));
+  iqueue_init(&larc->larc_q, &larc->queues, struct larc_entry, larc_list);
+  iqueue_init(&larc->larc_g, &larc->queues, struct larc_entry, larc_list);
 
   larc->g_size = meta_size / 10;
 
   epool_create(&cn->cache_pool, cache_size, struct larc_entry, e);
-  if (!cn->cache_pool.entries_begin || !cn->cache_pool.entries) {
+  if (!cn->cache_pool.entries_begin) {
     LOG_DEBUG("epool_create for cache_pool failed");
     goto cache_epool_create_fail;
   }
+  iqueue_set_add_pool(&larc->queues, &cn->cache_pool);
   epool_create(&cn->meta_pool, meta_size, struct larc_entry, e);
-  if (!cn->meta_pool.entries_begin || !cn->meta_pool.entries) {
+  if (!cn->meta_pool.entries_begin) {
     LOG_DEBUG("epool_create for meta_pool failed");
     goto meta_epool_create_fail;
   }
+  iqueue_set_add_pool(&larc->queues, &cn->meta_pool);
 
   if (policy_init(cn, cache_size, meta_size, CACHE_NUCLEUS_SINGLE_THREAD)) {
     LOG_DEBUG("policy_init failed");
@@ -4,23 +4,25 @@
 #include "cache_nucleus_struct.h"
 #include "common.h"
 #include "entry.h"
-#include "tools/queue.h"
+#include "tools/iqueue.h"
 
 /** larc_policy:
+ * queues - Set of LARC's queues, linking its entries
  * larc_q - LARC's LRU queue
  * larc_g - LARC's LRU "ghost" queue
  * g_size - size of LARC's "ghost" queue
  */
 struct larc_policy {
   struct cache_nucleus nucleus;
-  struct queue larc_q;
-  struct queue larc_g;
+  struct iqueue_set queues;
+  struct iqueue larc_q;
+  struct iqueue larc_g;
   cblock_t g_size;
 };
 
 struct larc_entry {
   struct entry e;
-  struct queue_head larc_list;
+  struct iqueue_head larc_list;
 };
 
 static struct larc_policy *to_larc_policy(struct cache_nucleus *cn) {
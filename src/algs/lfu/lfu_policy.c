@@ -215,7 +215,7 @@ int lfu_init(struct lfu_policy *lfu, cblock_t cache_size) {
       lfu_next_victim_api);
 
   epool_create(&cn->cache_pool, cache_size, struct lfu_entry, e);
-  if (!cn->cache_pool.entries_begin || !cn->cache_pool.entries) {
+  if (!cn->cache_pool.entries_begin) {
     LOG_DEBUG("epool_create for cache_pool failed.");
     goto cache_epool_create_fail;
   }
@@ -64,12 +64,12 @@ void lirs_transaction_set(struct lirs_policy *lirs,
     lt->hir_remove = true;
   }
 
-  le = queue_peek_entry(&lirs->s, struct lirs_entry, s_list);
+  le = iqueue_peek_entry(&lirs->s, struct lirs_entry, s_list);
   if (le != NULL && lt->oblock == le->e.oblock) {
     lt->lir_s_lru = true;
   }
 
-  if (e != NULL && lt->is_HIR && in_queue(&lirs->s, &le->s_list)) {
+  if (e != NULL && lt->is_HIR && in_iqueue(&lirs->s, &le->s_list)) {
     lt->is_HIR = false;
 
     if (lirs->lir_count + 1 > cn->cache_size - lirs->hir_limit) {
@@ -85,25 +85,25 @@ bool lirs_transaction_is_legal(struct lirs_policy *lirs,
   bool legal = true;
 
   if (lt->hir_evict) {
-    legal &= queue_length(&lirs->q) > 0;
+    legal &= iqueue_length(&lirs->q) > 0;
   }
 
   if (lt->lir_evict) {
-    legal &= queue_length(&lirs->s) > 0;
+    legal &= iqueue_length(&lirs->s) > 0;
   }
 
   return legal;
 }
 
 void lirs_remove_from_queues(struct lirs_policy *lirs, struct lirs_entry *le) {
-  if (in_queue(&lirs->q, &le->q_list) || in_queue(&lirs->g, &le->q_list)) {
-    queue_remove(&le->q_list);
+  if (in_iqueue(&lirs->q, &le->q_list) || in_iqueue(&lirs->g, &le->q_list)) {
+    iqueue_remove(&lirs->queues, &le->q_list);
   }
-  if (in_queue(&lirs->r, &le->r_list)) {
-    queue_remove(&le->r_list);
+  if (in_iqueue(&lirs->r, &le->r_list)) {
+    iqueue_remove(&lirs->queues, &le->r_list);
   }
-  if (in_queue(&lirs->s, &le->s_list)) {
-    queue_remove(&le->s_list);
+  if (in_iqueue(&lirs->s, &le->s_list)) {
+    iqueue_remove(&lirs->queues, &le->s_list);
     lirs->s_len--;
   }
 }
@@ -114,16 +114,16 @@ void lirs_push_to_queues(struct lirs_policy *lirs, struct lirs_entry *le,
              false);
 
   if (queue_flags & LIRS_G_FLAG) {
-    queue_push(&lirs->g, &le->q_list);
+    iqueue_push(&lirs->g, &le->q_list);
   }
   if (queue_flags & LIRS_Q_FLAG) {
-    queue_push(&lirs->q, &le->q_list);
+    iqueue_push(&lirs->q, &le->q_list);
   }
   if (queue_flags & LIRS_R_FLAG) {
-    queue_push(&lirs->r, &le->r_list);
+    iqueue_push(&lirs->r, &le->r_list);
   }
   if (queue_flags & LIRS_S_FLAG) {
-    queue_push(&lirs->s, &le->s_list);
+    iqueue_push(&lirs->s, &le->s_list);
   }
 }
 
@@ -145,7 +145,8 @@ void lirs_remove_entry(struct lirs_policy *lirs, struct lirs_entry *le) {
 }
 
 void lirs_g_evict(struct lirs_policy *lirs) {
-  struct lirs_entry *le = queue_peek_entry(&lirs->g, struct lirs_entry, q_list);
+  struct lirs_entry *le =
+      iqueue_peek_entry(&lirs->g, struct lirs_entry, q_list);
   lirs_remove_entry(lirs, le);
 }
 
@@ -157,7 +158,7 @@ void lirs_replace_with_meta(struct lirs_policy *lirs,
   struct lirs_entry *meta_le;
   struct entry *meta_e;
 
-  LOG_ASSERT(in_queue(&lirs->s, &cache_le->s_list));
+  LOG_ASSERT(in_iqueue(&lirs->s, &cache_le->s_list));
   LOG_ASSERT(cache_le->is_HIR);
   LOG_ASSERT(in_cache(cn, cache_e));
 
@@ -171,21 +172,22 @@ void lirs_replace_with_meta(struct lirs_policy *lirs,
   lirs_push_to_queues(lirs, meta_le, LIRS_G_FLAG | LIRS_R_FLAG | LIRS_S_FLAG);
   lirs->s_len++;
 
-  queue_swap(&cache_le->r_list, &meta_le->r_list);
-  queue_swap(&cache_le->s_list, &meta_le->s_list);
+  iqueue_swap(&lirs->queues, &cache_le->r_list, &meta_le->r_list);
+  iqueue_swap(&lirs->queues, &cache_le->s_list, &meta_le->s_list);
 
   lirs_remove_entry(lirs, cache_le);
 }
 
 void lirs_q_evict(struct lirs_policy *lirs,
                   struct cache_nucleus_result *result) {
-  struct lirs_entry *le = queue_peek_entry(&lirs->q, struct lirs_entry, q_list);
+  struct lirs_entry *le =
+      iqueue_peek_entry(&lirs->q, struct lirs_entry, q_list);
   struct entry *e = &le->e;
 
   result->old_oblock = e->oblock;
   result->dirty_eviction = e->dirty;
 
-  if (in_queue(&lirs->s, &le->s_list)) {
+  if (in_iqueue(&lirs->s, &le->s_list)) {
     lirs_replace_with_meta(lirs, le);
   } else {
     lirs_remove_entry(lirs, le);
@@ -194,11 +196,12 @@ void lirs_q_evict(struct lirs_policy *lirs,
 
 void lirs_r_evict(struct lirs_policy *lirs) {
   struct cache_nucleus *cn = &lirs->nucleus;
-  struct lirs_entry *le = queue_peek_entry(&lirs->r, struct lirs_entry, r_list);
+  struct lirs_entry *le =
+      iqueue_peek_entry(&lirs->r, struct lirs_entry, r_list);
   struct entry *e = &le->e;
 
-  queue_remove(&le->s_list);
-  queue_remove(&le->r_list);
+  iqueue_remove(&lirs->queues, &le->s_list);
+  iqueue_remove(&lirs->queues, &le->r_list);
   lirs->s_len--;
 
   if (!in_cache(cn, e)) {
@@ -208,7 +211,8 @@ void lirs_r_evict(struct lirs_policy *lirs) {
 
 void lirs_s_evict(struct lirs_policy *lirs) {
   struct cache_nucleus *cn = &lirs->nucleus;
-  struct lirs_entry *le = queue_peek_entry(&lirs->s, struct lirs_entry, s_list);
+  struct lirs_entry *le =
+      iqueue_peek_entry(&lirs->s, struct lirs_entry, s_list);
   struct entry *e = &le->e;
 
   LOG_ASSERT(!le->is_HIR);
@@ -224,16 +228,16 @@ void lirs_s_evict(struct lirs_policy *lirs) {
 void lirs_find_last_lir_lru(struct lirs_policy *lirs) {
   struct cache_nucleus *cn = &lirs->nucleus;
 
-  while (!queue_empty(&lirs->s)) {
+  while (!iqueue_empty(&lirs->s)) {
     struct lirs_entry *le =
-        queue_peek_entry(&lirs->s, struct lirs_entry, s_list);
+        iqueue_peek_entry(&lirs->s, struct lirs_entry, s_list);
     struct entry *e = &le->e;
 
     if (!le->is_HIR) {
       break;
     }
 
-    LOG_ASSERT(le == queue_peek_entry(&lirs->r, struct lirs_entry, r_list));
+    LOG_ASSERT(le == iqueue_peek_entry(&lirs->r, struct lirs_entry, r_list));
     lirs_r_evict(lirs);
   }
 }
@@ -261,7 +265,7 @@ void lirs_transaction_commit(struct lirs_policy *lirs,
 
   if (e != NULL) {
     le = to_lirs_entry(e);
-    in_S = in_queue(&lirs->s, &le->s_list);
+    in_S = in_iqueue(&lirs->s, &le->s_list);
     is_HIR = le->is_HIR;
     migrating = e->migrating;
   }
@@ -337,7 +341,7 @@ void lirs_remove_api(struct cache_nucleus *cn, oblock_t oblock,
   struct lirs_entry *le = to_lirs_entry(e);
 
   if (in_cache(cn, e)) {
-    bool HIR_in_S = le->is_HIR && in_queue(&lirs->s, &le->s_list);
+    bool HIR_in_S = le->is_HIR && in_iqueue(&lirs->s, &le->s_list);
 
     if (remove_to_history && HIR_in_S) {
       lirs_replace_with_meta(lirs, le);
@@ -440,7 +444,7 @@ lirs_next_victim_api(struct cache_nucleus *cn, oblock_t oblock,
     }
     if (lt.hir_evict) {
       struct lirs_entry *le =
-          queue_peek_entry(&lirs->q, struct lirs_entry, q_list);
+          iqueue_peek_entry(&lirs->q, struct lirs_entry, q_list);
       *next_victim_p = &le->e;
       return CACHE_NUCLEUS_REPLACE;
     }
@@ -461,10 +465,11 @@ int lirs_init(struct lirs_policy *lirs, cblock_t cache_size,
       default_residency, default_cache_is_full, default_infer_cblock,
       lirs_next_victim_api);
 
-  queue_init(&lirs->q);
-  queue_init(&lirs->r);
-  queue_init(&lirs->s);
-  queue_init(&lirs->g);
+  iqueue_set_init(&lirs->queues, sizeof(struct lirs_entry));
+  iqueue_init(&lirs->q, &lirs->queues, struct lirs_entry, q_list);
+  iqueue_init(&lirs->r, &lirs->queues, struct lirs_entry, r_list);
+  iqueue_init(&lirs->s, &lirs->queues, struct lirs_entry, s_list);
+  iqueue_init(&lirs->g, &lirs->queues, struct lirs_entry, q_list);
 
   // TODO for super small caches do special checks for hir_limit?
   // lirs->lir_limit = cache_size - max(2u, cache_size / 100u);
@@ -477,16 +482,18 @@ int lirs_init(struct lirs_policy *lirs, cblock_t cache_size,
   lirs->s_maxlen = 2 * cache_size;
 
   epool_create(&cn->cache_pool, cache_size, struct lirs_entry, e);
-  if (!cn->cache_pool.entries_begin || !cn->cache_pool.entries) {
+  if (!cn->cache_pool.entries_begin) {
     LOG_DEBUG("epool_create for cache_pool failed.");
     goto cache_epool_create_fail;
   }
+  iqueue_set_add_pool(&lirs->queues, &cn->cache_pool);
 
   epool_create(&cn->meta_pool, meta_size, struct lirs_entry, e);
-  if (!cn->meta_pool.entries_begin || !cn->meta_pool.entries) {
+  if (!cn->meta_pool.entries_begin) {
     LOG_DEBUG("epool_create for meta_pool failed.");
     goto meta_epool_create_fail;
   }
+  iqueue_set_add_pool(&lirs->queues, &cn->meta_pool);
 
   if (policy_init(cn, cache_size, meta_size, CACHE_NUCLEUS_SINGLE_THREAD)) {
     LOG_DEBUG("policy_init failed.");
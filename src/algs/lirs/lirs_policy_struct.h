@@ -1,16 +1,22 @@
 #ifndef ALGS_LIRS_LIRS_POLICY_STRUCT_H
 #define ALGS_LIRS_LIRS_POLICY_STRUCT_H
 
+#include "cache_nucleus_struct.h"
+#include "common.h"
+#include "entry.h"
+#include "tools/iqueue.h"
+
 struct lirs_policy {
   struct cache_nucleus nucleus;
-  struct queue q;
-  struct queue s;
+  struct iqueue_set queues;
+  struct iqueue q;
+  struct iqueue s;
 
   // queue for HIR entries in S
-  struct queue r;
+  struct iqueue r;
 
   // queue for ghost HIR entries in S
-  struct queue g;
+  struct iqueue g;
 
   cblock_t hir_limit;
   cblock_t lir_count;
@@ -24,10 +30,10 @@ struct lirs_policy {
 struct lirs_entry {
   struct entry e;
   // q_list is used for both HIR entries in q and g
-  struct queue_head q_list;
-  struct queue_head s_list;
+  struct iqueue_head q_list;
+  struct iqueue_head s_list;
 
-  struct queue_head r_list;
+  struct iqueue_head r_list;
 
   bool is_HIR;
 };
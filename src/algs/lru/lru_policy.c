@@ -30,6 +30,7 @@
  * 4.4       lru_map_api()
  * 4.5       lru_destroy_api()
  * 4.6       lru_next_victim_api()
+ * 4.7       lru_map_range_api()
  * 5.0     LRU Creation Functions
  * 5.1       lru_init()
  * 5.2       lru_create()
@@ -58,14 +59,15 @@
  *   NOTE: Currently also used by the lru_wrapper as well for information
  *         gathering.
  *
- * tools/queue.h:
- *   A circular, doubly-linked list for a queue.
+ * tools/iqueue.h:
+ *   A doubly-linked list for a queue, linking entries by their index in the
+ *   entry_pool.
  */
 #include "lru_policy.h"
 #include "cache_nucleus_internal.h"
 #include "common.h"
 #include "lru_policy_struct.h"
-#include "tools/queue.h"
+#include "tools/iqueue.h"
 
 /** 3.0 The Transaction Model
  *
@@ -163,7 +165,7 @@ void lru_transaction_set(struct lru_policy *lru, struct lru_transaction *lt) {
 bool lru_transaction_is_legal(struct lru_policy *lru,
                               struct lru_transaction *lt) {
   if (lt->evict) {
-    return queue_length(&lru->lru_q) > 0;
+    return iqueue_length(&lru->lru_q) > 0;
   }
   return true;
 }
@@ -187,10 +189,11 @@ bool lru_transaction_is_legal(struct lru_policy *lru,
  *       called to be removed due to an external issue.
  */
 void lru_remove_entry(struct cache_nucleus *cn, struct entry *e) {
+  struct lru_policy *lru = to_lru_policy(cn);
   struct lru_entry *le = to_lru_entry(e);
 
   if (!e->migrating) {
-    queue_remove(&le->lru_list);
+    iqueue_remove(&lru->queues, &le->lru_list);
     inc_demotions(&cn->stats);
   }
   cache_nucleus_remove(cn, e);
@@ -206,7 +209,7 @@ void lru_remove_entry(struct cache_nucleus *cn, struct entry *e) {
 void lru_evict(struct lru_policy *lru, struct cache_nucleus_result *result) {
   struct cache_nucleus *cn = &lru->nucleus;
   struct lru_entry *le =
-      queue_pop_entry(&lru->lru_q, struct lru_entry, lru_list);
+      iqueue_pop_entry(&lru->lru_q, struct lru_entry, lru_list);
   struct entry *demoted = &le->e;
 
   result->old_oblock = demoted->oblock;
@@ -247,8 +250,8 @@ void lru_hit(struct lru_policy *lru, oblock_t oblock,
   result->cblock = infer_cblock(&cn->cache_pool, e);
 
   if (!e->migrating) {
-    queue_remove(&le->lru_list);
-    queue_push(&lru->lru_q, &le->lru_list);
+    iqueue_remove(&lru->queues, &le->lru_list);
+    iqueue_push(&lru->lru_q, &le->lru_list);
   }
 }
 
@@ -324,7 +327,7 @@ void lru_insert_api(struct cache_nucleus *cn, oblock_t oblock,
   struct entry *e = insert_in_cache_at(cn, oblock, cblock, NULL);
   struct lru_entry *le = to_lru_entry(e);
 
-  queue_push(&lru->lru_q, &le->lru_list);
+  iqueue_push(&lru->lru_q, &le->lru_list);
 }
 
 /** 4.3 lru_migrated_api()
@@ -340,7 +343,7 @@ void lru_migrated_api(struct cache_nucleus *cn, oblock_t oblock) {
   struct lru_entry *le = to_lru_entry(e);
 
   migrated_entry(&cn->cache_pool, e);
-  queue_push(&lru->lru_q, &le->lru_list);
+  iqueue_push(&lru->lru_q, &le->lru_list);
 
   inc_promotions(&cn->stats);
 }
@@ -435,7 +438,7 @@ enum cache_nucleus_operation lru_next_victim_api(struct cache_nucleus *cn,
 
     if (lt.evict) {
       struct lru_entry *le =
-          queue_peek_entry(&lru->lru_q, struct lru_entry, lru_list);
+          iqueue_peek_entry(&lru->lru_q, struct lru_entry, lru_list);
       *next_victim_p = &le->e;
       return CACHE_NUCLEUS_REPLACE;
     }
@@ -444,6 +447,69 @@ enum cache_nucleus_operation lru_next_victim_api(struct cache_nucleus *cn,
   return CACHE_NUCLEUS_FAIL;
 }
 
+/** 4.7 lru_map_range_api()
+ *
+ * Process a range of block addresses, each "mapped" to the cache as
+ * lru_map_api() would, with whatever it places in the cache migrating right
+ * away as lru_migrated_api() would have it.
+ *
+ * This is what default_map_range() would do, but without going through the
+ * cache_nucleus API (and its function pointers) for every block: the blocks
+ * are looked up once in the hashtable, and a new entry goes straight into
+ * LRU's queue instead of migrating first.
+ *
+ * NOTE: As with lru_map_api(), an access is only illegal (and counted as a
+ *       miss) when the cache is full of entries that are still migrating.
+ */
+int lru_map_range_api(struct cache_nucleus *cn, oblock_t oblock,
+                      block_t nr_blocks, block_t stride, bool write,
+                      unsigned time,
+                      struct cache_nucleus_range_result *result) {
+  struct lru_policy *lru = to_lru_policy(cn);
+  block_t i;
+
+  for (i = 0; i < nr_blocks; i++, oblock += stride) {
+    struct entry *e = hash_lookup(&cn->ht, oblock);
+    struct lru_entry *le;
+
+    cn->time = time + i;
+
+    if (e != NULL) {
+      le = to_lru_entry(e);
+      if (!e->migrating) {
+        iqueue_remove(&lru->queues, &le->lru_list);
+        iqueue_push(&lru->lru_q, &le->lru_list);
+      }
+      inc_hits(&cn->stats);
+      ++result->hits;
+    } else {
+      ++result->misses;
+      if (cache_is_full(cn)) {
+        struct cache_nucleus_result r = {0};
+
+        if (iqueue_empty(&lru->lru_q)) {
+          continue;
+        }
+        lru_evict(lru, &r);
+        if (r.dirty_eviction) {
+          ++result->dirty_evictions;
+        }
+      }
+
+      e = insert_in_cache(cn, oblock, NULL);
+      le = to_lru_entry(e);
+      iqueue_push(&lru->lru_q, &le->lru_list);
+      inc_promotions(&cn->stats);
+      inc_misses(&cn->stats);
+    }
+
+    inc_ios(&cn->stats);
+    e->dirty = e->dirty || write;
+  }
+
+  return 0;
+}
+
 /** 5.0 LRU Creation Functions
  *
  * These functions allocate and initialize LRU and it's associated structures.
@@ -487,14 +553,17 @@ int lru_init(struct lru_policy *lru, cblock_t cache_size) {
       default_remap, lru_destroy_api, default_get_stats, default_set_time,
       default_residency, default_cache_is_full, default_infer_cblock,
       lru_next_victim_api);
+  cn->map_range = lru_map_range_api;
 
-  queue_init(&lru->lru_q);
+  iqueue_set_init(&lru->queues, sizeof(struct lru_entry));
+  iqueue_init(&lru->lru_q, &lru->queues, struct lru_entry, lru_list);
 
   epool_create(&cn->cache_pool, cache_size, struct lru_entry, e);
-  if (!cn->cache_pool.entries_begin || !cn->cache_pool.entries) {
+  if (!cn->cache_pool.entries_begin) {
     LOG_DEBUG("epool_create for cache_pool failed");
     goto cache_epool_create_fail;
   }
+  iqueue_set_add_pool(&lru->queues, &cn->cache_pool);
 
   if (policy_init(cn, cache_size, 0, CACHE_NUCLEUS_SINGLE_THREAD)) {
     LOG_DEBUG("policy_init failed");
@@ -4,7 +4,7 @@
 #include "cache_nucleus_struct.h"
 #include "common.h"
 #include "entry.h"
-#include "tools/queue.h"
+#include "tools/iqueue.h"
 
 /** lru_policy:
  * Every policy should include cache_nucleus as a member to have a
@@ -15,13 +15,15 @@
  * check out the source code in src/include/cache_nucleus.h!
  *
  * Other than that, we include anything LRU specific in the struct,
- * which is just the LRU queue for tracking recency in this case!
+ * which is just the LRU queue for tracking recency in this case
+ * (and the iqueue_set its entries are linked through)!
  * If you want to know more about the queue implementation,
- * check out the source code in src/include/tools/queue.h!
+ * check out the source code in src/include/tools/iqueue.h!
  */
 struct lru_policy {
   struct cache_nucleus nucleus;
-  struct queue lru_q;
+  struct iqueue_set queues;
+  struct iqueue lru_q;
 };
 
 /** lru_entry:
@@ -30,12 +32,12 @@ struct lru_policy {
  * interact with entries without knowing anything about LRU!
  *
  * Other than that, we include anything LRU specific in the struct,
- * which is just a queue_head, which is how lru_entry's keep
+ * which is just an iqueue_head, which is how lru_entry's keep
  * track of where they are in the queue.
  */
 struct lru_entry {
   struct entry e;
-  struct queue_head lru_list;
+  struct iqueue_head lru_list;
 };
 
 /** to_lru_policy:
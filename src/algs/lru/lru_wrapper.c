@@ -43,10 +43,8 @@ void lru_wrapper_print(struct alg_wrapper *alg_w) {
   if (lru_w->lru_q) {
     LOG_PRINT_F(stderr, "lru_q: ");
     bool first = true;
-    struct list_head *lru_q_lh = &lru->lru_q.queue;
-    struct list_head *lru_e_lh = &queue_peek(&lru->lru_q)->list;
-    while (lru_e_lh != lru_q_lh) {
-      struct queue_head *qh = container_of(lru_e_lh, struct queue_head, list);
+    struct iqueue_head *qh = iqueue_peek(&lru->lru_q);
+    while (qh != NULL) {
       struct lru_entry *le = container_of(qh, struct lru_entry, lru_list);
 
       if (first) {
@@ -57,7 +55,7 @@ void lru_wrapper_print(struct alg_wrapper *alg_w) {
 
       LOG_PRINT_F(stderr, "(%lu)", le->e.oblock);
 
-      lru_e_lh = lru_e_lh->next;
+      qh = iqueue_next(&lru->lru_q, qh);
     }
     LOG_PRINT_F(stderr, "\n");
   }
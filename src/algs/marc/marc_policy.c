@@ -157,7 +157,7 @@ void marc_transaction_set(struct marc_policy *marc,
       mt->ghost_size = marc_ghost_decrease_size(marc, mt->ghost_size);
     } else {
       if (policy_cache_is_full(arc)) {
-        bool g_hit = hash_lookup(&cn->ht, mt->oblock) != NULL;
+        bool g_hit = hash_peek(&cn->ht, mt->oblock) != NULL;
         if (g_hit) {
           mt->ghost_remove = true;
         }
@@ -178,7 +178,7 @@ void marc_transaction_set(struct marc_policy *marc,
       if (mt->c_hit) {
         mt->ghost_size = marc_ghost_decrease_size(marc, mt->ghost_size);
       } else {
-        if (hash_lookup(&cn->ht, mt->oblock) != NULL) {
+        if (hash_peek(&cn->ht, mt->oblock) != NULL) {
           mt->ghost_remove = true;
         }
         mt->ghost_add = true;
@@ -203,13 +203,13 @@ bool marc_transaction_is_legal(struct marc_policy *marc,
 }
 
 void marc_remove_entry(struct marc_policy *marc, struct marc_entry *me) {
-  queue_remove(&me->marc_list);
+  iqueue_remove(&marc->queues, &me->marc_list);
   cache_nucleus_remove(&marc->nucleus, &me->e);
 }
 
 void marc_ghost_evict(struct marc_policy *marc) {
   struct marc_entry *me =
-      queue_peek_entry(&marc->ghost_q, struct marc_entry, marc_list);
+      iqueue_peek_entry(&marc->ghost_q, struct marc_entry, marc_list);
   marc_remove_entry(marc, me);
 }
 
@@ -253,8 +253,8 @@ void marc_transaction_commit(struct marc_policy *marc,
     struct entry *e = hash_lookup(&cn->ht, mt->oblock);
     struct marc_entry *me = to_marc_entry(e);
     marc->ghost_hits++;
-    queue_remove(&me->marc_list);
-    queue_push(&marc->ghost_q, &me->marc_list);
+    iqueue_remove(&marc->queues, &me->marc_list);
+    iqueue_push(&marc->ghost_q, &me->marc_list);
   } else if (mt->ghost_remove) {
     struct entry *e = hash_lookup(&cn->ht, mt->oblock);
     struct marc_entry *me = to_marc_entry(e);
@@ -262,7 +262,7 @@ void marc_transaction_commit(struct marc_policy *marc,
   } else if (mt->ghost_add) {
     struct entry *e = insert_in_meta(cn, mt->oblock);
     struct marc_entry *me = to_marc_entry(e);
-    queue_push(&marc->ghost_q, &me->marc_list);
+    iqueue_push(&marc->ghost_q, &me->marc_list);
   }
 
   if (!mt->filter) {
@@ -272,7 +272,7 @@ void marc_transaction_commit(struct marc_policy *marc,
     result->op = CACHE_NUCLEUS_FILTER;
   }
 
-  if (queue_length(&marc->ghost_q) > marc->ghost_size) {
+  if (iqueue_length(&marc->ghost_q) > marc->ghost_size) {
     marc_ghost_evict(marc);
   }
 }
@@ -418,7 +418,7 @@ int marc_init(struct marc_policy *marc, cblock_t cache_size, cblock_t meta_size,
       marc_next_victim_api);
 
   epool_create(&cn->meta_pool, cache_size, struct marc_entry, e);
-  if (!cn->meta_pool.entries_begin || !cn->meta_pool.entries) {
+  if (!cn->meta_pool.entries_begin) {
     LOG_DEBUG("epool_create for meta_pool failed.");
     goto meta_epool_create_fail;
   }
@@ -435,7 +435,9 @@ int marc_init(struct marc_policy *marc, cblock_t cache_size, cblock_t meta_size,
 
   marc->state = UNSTABLE;
 
-  queue_init(&marc->ghost_q);
+  iqueue_set_init(&marc->queues, sizeof(struct marc_entry));
+  iqueue_set_add_pool(&marc->queues, &cn->meta_pool);
+  iqueue_init(&marc->ghost_q, &marc->queues, struct marc_entry, marc_list);
   marc->ghost_size = cache_size;
   marc->ghost_hits = 0;
   marc->ghost_hits_old = 0;
@@ -2,7 +2,7 @@
 #define ALGS_MARC_MARC_POLICY_STRUCT_H
 
 #include "cache_nucleus_struct.h"
-#include "tools/queue.h"
+#include "tools/iqueue.h"
 #include "tools/window_stats.h"
 
 enum marc_state { UNSTABLE, STABLE, UNIQUE };
@@ -17,7 +17,8 @@ struct marc_policy {
 
   enum marc_state state;
 
-  struct queue ghost_q;
+  struct iqueue_set queues;
+  struct iqueue ghost_q;
   uint64_t ghost_size;
   uint64_t ghost_hits;
   uint64_t ghost_hits_old;
@@ -31,7 +32,7 @@ struct marc_policy {
 
 struct marc_entry {
   struct entry e;
-  struct queue_head marc_list;
+  struct iqueue_head marc_list;
 };
 
 static struct marc_policy *to_marc_policy(struct cache_nucleus *cn) {
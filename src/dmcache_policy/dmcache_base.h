@@ -128,7 +128,7 @@ static int dmcache_base_map(struct dm_cache_policy *dm_cache_p, oblock_t oblock,
             bp_result.op == CACHE_NUCLEUS_REPLACE) {
           e = policy_cache_lookup(bp, oblock);
           if (bp_result.op == CACHE_NUCLEUS_HIT) {
-            wb_remove(e);
+            wb_remove(&dmcb->wb_tracker, e);
           }
           wb_push_cache(&dmcb->wb_tracker, e);
         }
@@ -196,7 +196,7 @@ static void dmcache_base_set_dirty(struct dm_cache_policy *dm_cache_p,
     struct cache_nucleus *bp = dmcb->policy;
     struct entry *e = policy_cache_lookup(bp, oblock);
     LOG_ASSERT(e != NULL);
-    wb_remove(e);
+    wb_remove(&dmcb->wb_tracker, e);
     e->dirty = true;
     wb_push_cache(&dmcb->wb_tracker, e);
   }
@@ -212,7 +212,7 @@ static void dmcache_base_clear_dirty(struct dm_cache_policy *dm_cache_p,
     struct cache_nucleus *bp = dmcb->policy;
     struct entry *e = policy_cache_lookup(bp, oblock);
     LOG_ASSERT(e != NULL);
-    wb_remove(e);
+    wb_remove(&dmcb->wb_tracker, e);
     e->dirty = false;
     wb_push_cache(&dmcb->wb_tracker, e);
   }
@@ -246,7 +246,7 @@ static void dmcache_base_remove_mapping(struct dm_cache_policy *dm_cache_p,
     struct entry *e = policy_cache_lookup(bp, oblock);
     LOG_ASSERT(e != NULL);
 
-    wb_remove(e);
+    wb_remove(&dmcb->wb_tracker, e);
     policy_remove(bp, oblock, false);
   }
   mutex_unlock(&dmcb->lock);
@@ -262,8 +262,8 @@ static int dmcache_base_remove_cblock(struct dm_cache_policy *dm_cache_p,
   {
     struct entry *e = policy_cblock_lookup(bp, cblock);
     if (e != NULL) {
+      wb_remove(&dmcb->wb_tracker, e);
       policy_remove(bp, e->oblock, false);
-      wb_remove(e);
       r = 0;
     } else {
       r = -ENODATA;
@@ -323,7 +323,7 @@ static void dmcache_base_force_mapping(struct dm_cache_policy *dm_cache_p,
       policy_remap(bp, current_oblock, new_oblock);
       LOG_ASSERT(mapped_e != NULL);
 
-      wb_remove(mapped_e);
+      wb_remove(&dmcb->wb_tracker, mapped_e);
       mapped_e->dirty = true;
       wb_push_cache(&dmcb->wb_tracker, mapped_e);
     }
@@ -465,7 +465,7 @@ static int dmcache_base_init(struct dmcache_base *dmcb, cblock_t cache_size) {
   dmcb->use_tick = false;
 
   // writeback tracker
-  wb_init(&dmcb->wb_tracker);
+  wb_init(&dmcb->wb_tracker, dmcb->policy);
 
   return 0;
 }
@@ -4,7 +4,7 @@
 #include "common.h"
 #include "entry.h"
 #include "fomo_policy_struct.h"
-#include "tools/queue.h"
+#include "tools/iqueue.h"
 
 struct fomo_transaction {
   oblock_t oblock;
@@ -21,7 +21,7 @@ struct fomo_transaction {
 };
 
 void fomo_remove_entry(struct fomo_policy *fomo, struct fomo_entry *fe) {
-  queue_remove(&fe->fomo_list);
+  iqueue_remove(&fomo->queues, &fe->fomo_list);
   cache_nucleus_remove(&fomo->nucleus, &fe->e);
 }
 
@@ -55,7 +55,7 @@ void fomo_transaction_set(struct fomo_policy *fomo,
                           struct fomo_transaction *ft) {
   struct cache_nucleus *cn = &fomo->nucleus;
   struct cache_nucleus *internal_policy = fomo->internal_policy;
-  struct entry *fomo_e = hash_lookup(&cn->ht, ft->oblock);
+  struct entry *fomo_e = hash_peek(&cn->ht, ft->oblock);
   struct entry *internal_e = policy_cache_lookup(internal_policy, ft->oblock);
 
   ft->c_hit = internal_e != NULL;
@@ -146,24 +146,24 @@ void fomo_transaction_commit(struct fomo_policy *fomo,
       fomo_remove_entry(fomo, fe);
     } else {
       // move fomo entry to mru position
-      queue_remove(&fe->fomo_list);
-      queue_push(&fomo->fomo_mh, &fe->fomo_list);
+      iqueue_remove(&fomo->queues, &fe->fomo_list);
+      iqueue_push(&fomo->fomo_mh, &fe->fomo_list);
     }
   } else {
     struct entry *e;
     struct fomo_entry *fe;
 
     // evict from miss history if needed
-    if (queue_length(&fomo->fomo_mh) == fomo->ghost_size) {
+    if (iqueue_length(&fomo->fomo_mh) == fomo->ghost_size) {
       struct fomo_entry *lru_fe =
-          queue_peek_entry(&fomo->fomo_mh, struct fomo_entry, fomo_list);
+          iqueue_peek_entry(&fomo->fomo_mh, struct fomo_entry, fomo_list);
       fomo_remove_entry(fomo, lru_fe);
     }
 
     // add fomo entry at mru position
     e = insert_in_meta(cn, ft->oblock);
     fe = to_fomo_entry(e);
-    queue_push(&fomo->fomo_mh, &fe->fomo_list);
+    iqueue_push(&fomo->fomo_mh, &fe->fomo_list);
   }
 
   // either filter or allow the access to go to the cache
@@ -233,7 +233,7 @@ void fomo_remap(struct cache_nucleus *cn, oblock_t current_oblock,
 
   e = hash_lookup(&cn->ht, current_oblock);
   if (e != NULL) {
-    hash_remove(e);
+    hash_remove(&cn->ht, e);
     e->oblock = new_oblock;
     hash_insert(&cn->ht, e);
   }
@@ -299,6 +299,43 @@ enum cache_nucleus_operation fomo_next_victim(struct cache_nucleus *cn,
   return CACHE_NUCLEUS_FAIL;
 }
 
+/* Like default_map_range(), but going through FOMO's own map, set_time and
+ * migrated directly rather than through the cache_nucleus API for every block.
+ * The internal policy is still accessed a block at a time, as whether FOMO
+ * filters the next block depends on what the internal policy has cached.
+ */
+int fomo_map_range(struct cache_nucleus *cn, oblock_t oblock,
+                   block_t nr_blocks, block_t stride, bool write,
+                   unsigned time, struct cache_nucleus_range_result *result) {
+  block_t i;
+
+  for (i = 0; i < nr_blocks; i++, oblock += stride) {
+    struct cache_nucleus_result r = {0};
+    int err;
+
+    fomo_set_time(cn, time + i);
+    err = fomo_map(cn, oblock, write, &r);
+    if (err) {
+      return err;
+    }
+
+    if (r.op == CACHE_NUCLEUS_HIT) {
+      ++result->hits;
+    } else {
+      ++result->misses;
+    }
+    if (r.dirty_eviction) {
+      ++result->dirty_evictions;
+    }
+
+    if (r.op == CACHE_NUCLEUS_NEW || r.op == CACHE_NUCLEUS_REPLACE) {
+      fomo_migrated(cn, oblock);
+    }
+  }
+
+  return 0;
+}
+
 // init and create
 int fomo_init(struct fomo_policy *fomo, cblock_t cache_size, cblock_t meta_size,
               struct cache_nucleus *internal_policy) {
@@ -310,12 +347,14 @@ int fomo_init(struct fomo_policy *fomo, cblock_t cache_size, cblock_t meta_size,
       fomo_meta_lookup, fomo_cblock_lookup, fomo_remap, fomo_destroy,
       fomo_get_stats, fomo_set_time, fomo_residency, fomo_cache_is_full,
       fomo_infer_cblock, fomo_next_victim);
+  cn->map_range = fomo_map_range;
 
   fomo->internal_policy = internal_policy;
 
   fomo->state = FOMO_INSERT;
 
-  queue_init(&fomo->fomo_mh);
+  iqueue_set_init(&fomo->queues, sizeof(struct fomo_entry));
+  iqueue_init(&fomo->fomo_mh, &fomo->queues, struct fomo_entry, fomo_list);
 
   fomo->ghost_size = cache_size;
   fomo->period_size = max(cache_size / 100, 1u);
@@ -326,10 +365,11 @@ int fomo_init(struct fomo_policy *fomo, cblock_t cache_size, cblock_t meta_size,
   fomo->mh_hits_total = 0;
 
   epool_create(&cn->meta_pool, cache_size, struct fomo_entry, e);
-  if (!cn->meta_pool.entries_begin || !cn->meta_pool.entries) {
+  if (!cn->meta_pool.entries_begin) {
     LOG_DEBUG("epool_create for meta_pool failed");
     goto meta_epool_create_fail;
   }
+  iqueue_set_add_pool(&fomo->queues, &cn->meta_pool);
 
   if (policy_init(&fomo->nucleus, 0, cache_size, CACHE_NUCLEUS_SINGLE_THREAD)) {
     LOG_DEBUG("policy_init failed");
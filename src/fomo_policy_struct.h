@@ -1,6 +1,7 @@
 #ifndef FOMO_FOMO_POLICY_STRUCT_H
 #define FOMO_FOMO_POLICY_STRUCT_H
 
+#include "tools/iqueue.h"
 #include "tools/queue.h"
 
 enum fomo_state { FOMO_FILTER, FOMO_INSERT };
@@ -13,7 +14,8 @@ struct fomo_period {
 
 struct fomo_policy {
   struct cache_nucleus nucleus;
-  struct queue fomo_mh;
+  struct iqueue_set queues;
+  struct iqueue fomo_mh;
   cblock_t ghost_size;
   struct cache_nucleus *internal_policy;
   enum fomo_state state;
@@ -32,7 +34,7 @@ struct fomo_policy {
 
 struct fomo_entry {
   struct entry e;
-  struct queue_head fomo_list;
+  struct iqueue_head fomo_list;
 };
 
 static struct fomo_policy *to_fomo_policy(struct cache_nucleus *cn) {
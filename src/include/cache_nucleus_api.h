@@ -43,6 +43,9 @@ static void policy_migrated(struct cache_nucleus *cn, oblock_t oblock) {
 
 /** policy_cache_lookup:
  * Lookup cached entry with given oblock.
+ *
+ * \note Read-only: changes neither the policy nor its hashtable, so it can be
+ *       used to check an oblock without disturbing the policy.
  */
 static struct entry *policy_cache_lookup(struct cache_nucleus *cn,
                                          oblock_t oblock) {
@@ -75,6 +78,38 @@ static int policy_map(struct cache_nucleus *cn, oblock_t oblock, bool write,
   return cn->map(cn, oblock, write, result);
 }
 
+/** policy_map_range:
+ * Access nr_blocks oblocks, stride apart, starting at oblock, as if each had
+ * been given to policy_map() (at times time, time + 1, ...) and, should it
+ * have been placed in the cache, to policy_migrated() right after.
+ * The counts of what happened are added to result.
+ * Returns 0 if no problems occur, otherwise an error occurred.
+ * NOTE: This is for sequential accesses whose migrations can be treated as
+ *       completing immediately (such as in cache-sim without any delay).
+ */
+static int policy_map_range(struct cache_nucleus *cn, oblock_t oblock,
+                            block_t nr_blocks, block_t stride, bool write,
+                            unsigned time,
+                            struct cache_nucleus_range_result *result) {
+  return cn->map_range(cn, oblock, nr_blocks, stride, write, time, result);
+}
+
+/** policy_map_batch:
+ * Access the n oblocks (and writes) given, in order, as if each had been given
+ * to policy_map() (at times time, time + 1, ...) and, should it have been
+ * placed in the cache, to policy_migrated() right after.
+ * What happened to each access is put in results.
+ * Returns 0 if no problems occur, otherwise an error occurred.
+ * NOTE: Like policy_map_range(), this is for accesses whose migrations can be
+ *       treated as completing immediately. Knowing the upcoming accesses lets
+ *       the policy fetch their metadata from memory ahead of time.
+ */
+static int policy_map_batch(struct cache_nucleus *cn, const oblock_t *oblocks,
+                            const bool *writes, unsigned n, unsigned time,
+                            struct cache_nucleus_result *results) {
+  return cn->map_batch(cn, oblocks, writes, n, time, results);
+}
+
 /** policy_remap:
  * The entry identified with current_oblock will now be identified with
  * new_oblock.
@@ -7,6 +7,7 @@
 #include "policy_stats.h"
 #include "tools/epool.h"
 #include "tools/hashtable.h"
+#include "tools/iqueue.h"
 #include "tools/queue.h"
 #include "writeback_tracker.h"
 
@@ -127,8 +128,10 @@ static bool cache_is_full(struct cache_nucleus *bp) {
  * Remove entry from cache_nucleus
  */
 static void cache_nucleus_remove(struct cache_nucleus *bp, struct entry *e) {
-  wb_remove(e);
-  hash_remove(e);
+  if (bp->wb_queues) {
+    iqueue_remove(bp->wb_queues, &e->wb_list);
+  }
+  hash_remove(&bp->ht, e);
 
   if (in_pool(&bp->cache_pool, e)) {
     free_entry(&bp->cache_pool, e);
@@ -152,6 +155,20 @@ static void cache_nucleus_remove(struct cache_nucleus *bp, struct entry *e) {
     qh__ != NULL ? container_of(qh__, type, member) : NULL;                    \
   })
 
+#define iqueue_peek_entry(ptr, type, member)                                   \
+  ({                                                                           \
+    struct iqueue *q__ = (ptr);                                                \
+    struct iqueue_head *qh__ = (iqueue_peek(q__));                             \
+    qh__ != NULL ? container_of(qh__, type, member) : NULL;                    \
+  })
+
+#define iqueue_pop_entry(ptr, type, member)                                    \
+  ({                                                                           \
+    struct iqueue *q__ = (ptr);                                                \
+    struct iqueue_head *qh__ = (iqueue_pop(q__));                              \
+    qh__ != NULL ? container_of(qh__, type, member) : NULL;                    \
+  })
+
 #define heap_min_entry(ptr, type, member)                                      \
   ({                                                                           \
     struct heap *h__ = (ptr);                                                  \
@@ -211,10 +228,12 @@ queue_find_last_match(struct queue *q, struct cache_nucleus *bp,
 
 /** default_cache_lookup:
  * Lookup cached entry with given oblock
+ *
+ * \note Read-only: leaves the hashtable as it is (see hash_peek())
  */
 static struct entry *default_cache_lookup(struct cache_nucleus *bp,
                                           oblock_t oblock) {
-  struct entry *e = hash_lookup(&bp->ht, oblock);
+  struct entry *e = hash_peek(&bp->ht, oblock);
   if (in_cache(bp, e)) {
     return e;
   }
@@ -223,10 +242,12 @@ static struct entry *default_cache_lookup(struct cache_nucleus *bp,
 
 /** default_meta_lookup:
  * Lookup meta entry with given oblock
+ *
+ * \note Read-only: leaves the hashtable as it is (see hash_peek())
  */
 static struct entry *default_meta_lookup(struct cache_nucleus *bp,
                                          oblock_t oblock) {
-  struct entry *e = hash_lookup(&bp->ht, oblock);
+  struct entry *e = hash_peek(&bp->ht, oblock);
   if (in_meta(bp, e)) {
     return e;
   }
@@ -248,7 +269,7 @@ static void default_remap(struct cache_nucleus *bp, oblock_t current_oblock,
                           oblock_t new_oblock) {
   struct hashtable *ht = &bp->ht;
   struct entry *e = hash_lookup(ht, current_oblock);
-  hash_remove(e);
+  hash_remove(ht, e);
   e->oblock = new_oblock;
   hash_insert(ht, e);
 }
@@ -305,7 +326,99 @@ static cblock_t default_infer_cblock(struct cache_nucleus *bp,
   return infer_cblock(&bp->cache_pool, e);
 }
 
+/** default_map_range:
+ * Access a range of oblocks one at a time through the policy's own map,
+ * migrating whatever is placed in the cache right away
+ *
+ * Policies can provide a faster map_range for themselves, as long as it acts
+ * the same as this.
+ */
+static int default_map_range(struct cache_nucleus *bp, oblock_t oblock,
+                             block_t nr_blocks, block_t stride, bool write,
+                             unsigned time,
+                             struct cache_nucleus_range_result *result) {
+  block_t i;
+
+  for (i = 0; i < nr_blocks; i++, oblock += stride) {
+    struct cache_nucleus_result r = {0};
+    int err;
+
+    bp->set_time(bp, time + i);
+    err = bp->map(bp, oblock, write, &r);
+    if (err) {
+      return err;
+    }
+
+    if (r.op == CACHE_NUCLEUS_HIT) {
+      ++result->hits;
+    } else {
+      ++result->misses;
+    }
+    if (r.dirty_eviction) {
+      ++result->dirty_evictions;
+    }
+
+    if (r.op == CACHE_NUCLEUS_NEW || r.op == CACHE_NUCLEUS_REPLACE) {
+      bp->migrated(bp, oblock);
+    }
+  }
+
+  return 0;
+}
+
+// How many accesses ahead default_map_batch prefetches the hashtable
+// entries of its accesses (their buckets are prefetched twice as far ahead)
+#define CACHE_NUCLEUS_PREFETCH_DISTANCE 4
+
+/** default_map_batch:
+ * Access a batch of oblocks one at a time through the policy's own map,
+ * migrating whatever is placed in the cache right away
+ *
+ * While processing an access, the hashtable buckets and entries of the
+ * accesses after it are prefetched, since policies start their map with a
+ * hash_lookup() of the oblock.
+ */
+static int default_map_batch(struct cache_nucleus *bp, const oblock_t *oblocks,
+                             const bool *writes, unsigned n, unsigned time,
+                             struct cache_nucleus_result *results) {
+  const unsigned d = CACHE_NUCLEUS_PREFETCH_DISTANCE;
+  unsigned i;
+
+  for (i = 0; i < n && i < 2 * d; i++) {
+    hash_prefetch(&bp->ht, oblocks[i]);
+  }
+
+  for (i = 0; i < n; i++) {
+    struct cache_nucleus_result r = {0};
+    int err;
+
+    if (i + 2 * d < n) {
+      hash_prefetch(&bp->ht, oblocks[i + 2 * d]);
+    }
+    if (i + d < n) {
+      hash_prefetch_entry(&bp->ht, oblocks[i + d]);
+    }
+
+    bp->set_time(bp, time + i);
+    err = bp->map(bp, oblocks[i], writes[i], &r);
+    results[i] = r;
+    if (err) {
+      return err;
+    }
+
+    if (r.op == CACHE_NUCLEUS_NEW || r.op == CACHE_NUCLEUS_REPLACE) {
+      bp->migrated(bp, oblocks[i]);
+    }
+  }
+
+  return 0;
+}
+
 // Policy init functions
+/** NOTE: map_range and map_batch are set to default_map_range and
+ *       default_map_batch, policies with their own should set them after
+ *       calling cache_nucleus_init_api()
+ */
 static inline void cache_nucleus_init_api(
     struct cache_nucleus *bp, policy_map_f map, policy_remove_f remove,
     policy_insert_f insert, policy_migrated_f migrated,
@@ -316,6 +429,8 @@ static inline void cache_nucleus_init_api(
     policy_cache_is_full_f cache_is_full, policy_infer_cblock_f infer_cblock,
     policy_next_victim_f next_victim) {
   bp->map = map;
+  bp->map_range = default_map_range;
+  bp->map_batch = default_map_batch;
   bp->remove = remove;
   bp->insert = insert;
   bp->migrated = migrated;
@@ -360,6 +475,7 @@ static int policy_init(struct cache_nucleus *bp, cblock_t cache_size,
   bp->meta_size = meta_size;
   bp->thread_support = thread_support;
   bp->time = 0;
+  bp->wb_queues = NULL;
 
   return r;
 }
@@ -6,8 +6,8 @@
 #include "policy_stats.h"
 #include "tools/epool.h"
 #include "tools/hashtable.h"
+#include "tools/iqueue.h"
 #include "tools/queue.h"
-#include "writeback_tracker.h"
 
 /** Operation enum for policy communication
  * CACHE_NUCLEUS_HIT      Access resulted in a hit
@@ -54,11 +54,30 @@ struct cache_nucleus_result {
   bool dirty_eviction;
 };
 
+/** Access results of a whole range of oblocks
+ * hits             accesses that resulted in a hit
+ * misses           accesses that resulted in a miss (FILTER/NEW/REPLACE/FAIL)
+ * dirty_evictions  accesses that resulted in a dirty eviction
+ */
+struct cache_nucleus_range_result {
+  block_t hits;
+  block_t misses;
+  block_t dirty_evictions;
+};
+
 // API functions
 struct cache_nucleus;
 
 typedef int (*policy_map_f)(struct cache_nucleus *bp, oblock_t oblock,
                             bool write, struct cache_nucleus_result *result);
+typedef int (*policy_map_range_f)(struct cache_nucleus *bp, oblock_t oblock,
+                                  block_t nr_blocks, block_t stride,
+                                  bool write, unsigned time,
+                                  struct cache_nucleus_range_result *result);
+typedef int (*policy_map_batch_f)(struct cache_nucleus *bp,
+                                  const oblock_t *oblocks, const bool *writes,
+                                  unsigned n, unsigned time,
+                                  struct cache_nucleus_result *results);
 typedef void (*policy_remove_f)(struct cache_nucleus *bp, oblock_t oblock,
                                 bool remove_to_history);
 typedef void (*policy_insert_f)(struct cache_nucleus *bp, oblock_t oblock,
@@ -102,11 +121,16 @@ struct cache_nucleus {
 
   struct hashtable ht;
 
+  // queues of a writeback_tracker its entries are in, if any
+  struct iqueue_set *wb_queues;
+
   // NOTE: time is set externally
   unsigned time;
 
   // cache_nucleus API function pointers
   policy_map_f map;
+  policy_map_range_f map_range;
+  policy_map_batch_f map_batch;
   policy_remove_f remove;
   policy_insert_f insert;
   policy_migrated_f migrated;
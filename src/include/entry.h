@@ -4,7 +4,12 @@
 #include "common.h"
 #include "kernel/hash.h"
 #include "kernel/list.h"
-#include "tools/queue.h"
+#include "tools/iqueue.h"
+
+// the kernel has no SSE2 for the open-addressing hashtable (see hashtable.h)
+#if defined(__KERNEL__) && !defined(HASHTABLE_CHAINED)
+#define HASHTABLE_CHAINED
+#endif
 
 /** A cache entry.
  *
@@ -13,27 +18,42 @@
  * intended to be included within an algorithm-specific struct to provide
  * "C-style polymorphism".
  *
- * ht_list - A hlist_node for hashtable use
- * wb_list - A list_head (essentially) for writeback_tracker queue use
- *           (used externally to base_policy)
- * pool_list - A list_head for entry_pool use
+ * It is kept small, as there is one for every block of a cache: links are
+ * 32-bit indices in the entry pools rather than pointers, and the flags take
+ * the bits of wb_list.queue that queue ids don't use (see iqueue_head). That's
+ * 24 bytes (40 with the chaining hashtable) before any of the fields of a
+ * policy's entries.
+ *
  * oblock - Origin device block address
+ * ht_list - A hlist_node for hashtable use (only the chaining hashtable links
+ *           its entries, see hashtable.h)
+ * wb_list - An iqueue_head for writeback_tracker queue use (used externally
+ *           to base_policy). While the entry is free, it is in no writeback
+ *           queue, and wb_list links it in the entry_pool's free list instead
  * time - Track the last time accessed (used externally to base_policy)
  * dirty - Track whether the entry is dirty
  * allocated - Track whether the entry has been allocated or not
  * migrating - States whether the entry is in the process of migrating
  */
 struct entry {
-  struct hlist_node ht_list;
-  struct queue_head wb_list;
-  struct list_head pool_list;
   oblock_t oblock;
+#ifdef HASHTABLE_CHAINED
+  struct hlist_node ht_list;
+#endif
+  union {
+    struct iqueue_head wb_list;
+    // the flags, in the bits of wb_list.queue above the id of the queue
+    struct {
+      uint32_t __wb_links[2];
+      unsigned __wb_queue : IQUEUE_ID_BITS;
 
-  unsigned time;
+      bool dirty : 1;
+      bool allocated : 1;
+      bool migrating : 1;
+    };
+  };
 
-  bool dirty : 1;
-  bool allocated : 1;
-  bool migrating : 1;
+  unsigned time;
 };
 
 #endif /* INCLUDE_BASE_ENTRY_H */
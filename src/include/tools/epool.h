@@ -4,17 +4,7 @@
 #include "common.h"
 #include "entry.h"
 #include "kernel/hash.h"
-#include "kernel/list.h"
-#include "tools/queue.h"
-
-static struct list_head *list_pop(struct list_head *lh) {
-  struct list_head *r = lh->next;
-
-  LOG_ASSERT(r);
-  list_del_init(r);
-
-  return r;
-}
+#include "tools/iqueue.h"
 
 struct entry;
 
@@ -29,25 +19,32 @@ struct entry;
  * structure is within the policy-specific entry for allowing public access
  * to the "general" entry information while hiding the policy-specific bits.
  *
- * entries_begin - Pointer to the first "general" entry
- * entries_end - Pointer to the final "general" entry
- * free - List of free, "unallocated" entries
- * migrating - List of "migrating" entries
+ * The policy-specific entries being laid out one after the other, the entry at
+ * an index is found from their size (stride) and where the "general" entry is
+ * in them (offset), rather than through an array of pointers to them.
+ * Free entries are linked by their (pool) index through their wb_list, as they
+ * can't be in a writeback queue.
+ *
+ * entries_begin - Pointer to the first policy-specific entry
+ * entries_end - Pointer past the last policy-specific entry
+ * stride - Size of the policy-specific entries
+ * offset - Offset of the "general" entry in the policy-specific entries
+ * free - Index of the first free, "unallocated" entry, IQUEUE_NIL if none
  * nr_allocated - Number of "allocated" entries
  * nr_migrating - Number of "migrating" entries
  * nr_entries - Number of total entries in the pool
- * entries - Array of pointers to "general" entries
+ * starting_index - Cache block address of the first entry
  */
 struct entry_pool {
   void *entries_begin;
   void *entries_end;
-  struct list_head free;
-  struct list_head migrating;
+  size_t stride;
+  size_t offset;
+  uint32_t free;
   unsigned nr_allocated;
   unsigned nr_migrating;
   unsigned nr_entries;
   unsigned starting_index;
-  struct entry **entries;
 };
 
 /** Allocate memory and create the pool for entries
@@ -63,12 +60,11 @@ struct entry_pool {
  *
  * After the call is done, the entry_pool (_epool) should have:
  * - entries_begin point to the first policy-specific entry
- * - entries_end point to the last policy-specific entry
+ * - entries_end point past the last policy-specific entry
+ * - stride and offset set from the policy-specific entry
  * - nr_entries be set to _nr_entries
- * - entries pointing to the "general" entry part of all policy-specific entries
  *
- * \warning Caller \a NEEDS to check after for null entries_begin and/or
- *          ep->entries
+ * \warning Caller \a NEEDS to check after for null entries_begin
  *
  * All that's left is to call epool_init() to put all the entries in the free
  * list to be grabbed on demand.
@@ -89,19 +85,56 @@ struct entry_pool {
   {                                                                            \
     struct entry_pool *ep_ = (_epool);                                         \
     unsigned nr_ = (_nr_entries);                                              \
-    unsigned i_;                                                               \
     ep_->entries_begin = mem_alloc(sizeof(_type) * nr_);                       \
     ep_->entries_end = ((_type *)ep_->entries_begin) + nr_;                    \
+    ep_->stride = sizeof(_type);                                               \
+    ep_->offset = offsetof(_type, _member);                                    \
+    ep_->free = IQUEUE_NIL;                                                    \
     ep_->nr_entries = nr_;                                                     \
     ep_->starting_index = 0;                                                   \
-    ep_->entries = mem_alloc(sizeof(*ep_->entries) * nr_);                     \
-    if (ep_->entries_begin && ep_->entries) {                                  \
-      for (i_ = 0; i_ < nr_; i_++) {                                           \
-        ep_->entries[i_] = &((_type *)ep_->entries_begin)[i_]._member;         \
-      }                                                                        \
-    }                                                                          \
   }
 
+/** The "general" entry at index i of the pool (not counting starting_index)
+ */
+static struct entry *__epool_entry(struct entry_pool *ep, uint32_t i) {
+  return (struct entry *)((uintptr_t)ep->entries_begin +
+                          (uintptr_t)i * ep->stride + ep->offset);
+}
+
+/** The index in the pool (not counting starting_index) of the "general" entry
+ */
+static uint32_t __epool_index(struct entry_pool *ep, struct entry *e) {
+  return (uint32_t)(((uintptr_t)e - ep->offset -
+                     (uintptr_t)ep->entries_begin) /
+                    ep->stride);
+}
+
+/** Push the entry onto the head of the free list
+ */
+static void __epool_free_push(struct entry_pool *ep, struct entry *e) {
+  uint32_t i = __epool_index(ep, e);
+
+  e->wb_list.prev = IQUEUE_NIL;
+  e->wb_list.next = ep->free;
+  if (ep->free != IQUEUE_NIL) {
+    __epool_entry(ep, ep->free)->wb_list.prev = i;
+  }
+  ep->free = i;
+}
+
+/** Remove the entry from the free list
+ */
+static void __epool_free_del(struct entry_pool *ep, struct entry *e) {
+  if (e->wb_list.prev == IQUEUE_NIL) {
+    ep->free = e->wb_list.next;
+  } else {
+    __epool_entry(ep, e->wb_list.prev)->wb_list.next = e->wb_list.next;
+  }
+  if (e->wb_list.next != IQUEUE_NIL) {
+    __epool_entry(ep, e->wb_list.next)->wb_list.prev = e->wb_list.prev;
+  }
+}
+
 /** Get the entry at a particular index
  */
 static struct entry *epool_at(struct entry_pool *ep, cblock_t index) {
@@ -109,15 +142,15 @@ static struct entry *epool_at(struct entry_pool *ep, cblock_t index) {
   if (converted_index >= ep->nr_entries)
     return NULL;
 
-  return ep->entries[converted_index];
+  return __epool_entry(ep, (uint32_t)converted_index);
 }
 
 /** Initializes an entry_pool
  *
  * \note Called after an #epool_create()
  *
- * Initalizes the entry_pool by taking the "general" entries pointed at by the
- * entries array and adding them all to a re-initialized free list.
+ * Initalizes the entry_pool by adding all of its entries to a re-initialized
+ * free list.
  *
  * TODO talk about starting_index
  *
@@ -126,15 +159,15 @@ static struct entry *epool_at(struct entry_pool *ep, cblock_t index) {
 static void epool_init(struct entry_pool *ep, unsigned starting_index) {
   unsigned i;
 
-  INIT_LIST_HEAD(&ep->free);
-  INIT_LIST_HEAD(&ep->migrating);
+  ep->free = IQUEUE_NIL;
   for (i = 0; i < ep->nr_entries; i++) {
-    struct entry *e = epool_at(ep, i);
+    struct entry *e = __epool_entry(ep, i);
 
+#ifdef HASHTABLE_CHAINED
     INIT_HLIST_NODE(&e->ht_list);
-    INIT_LIST_HEAD(&e->wb_list.list);
-    e->wb_list.parent_queue = NULL;
-    list_add(&e->pool_list, &ep->free);
+#endif
+    e->wb_list.queue = 0;
+    __epool_free_push(ep, e);
 
     e->dirty = false;
     e->allocated = false;
@@ -151,17 +184,25 @@ static void epool_exit(struct entry_pool *ep) {
   if (ep->entries_begin != NULL) {
     mem_free(ep->entries_begin);
   }
-  if (ep->entries != NULL) {
-    mem_free(ep->entries);
-  }
+}
+
+/** Add the entries of the entry_pool to the iqueue_set
+ *
+ * \warning The iqueue_set has to be of entries of the entry_pool's stride
+ */
+static void iqueue_set_add_pool(struct iqueue_set *s, struct entry_pool *ep) {
+  LOG_ASSERT(ep->stride == s->stride);
+  iqueue_set_add(s, ep->entries_begin, ep->nr_entries);
 }
 
 /** "Allocates" the given entry from the entry_pool
  */
 static void alloc_this_entry(struct entry_pool *ep, struct entry *e) {
-  list_del_init(&e->pool_list);
+  __epool_free_del(ep, e);
+#ifdef HASHTABLE_CHAINED
   INIT_HLIST_NODE(&e->ht_list);
-  queue_head_init(&e->wb_list);
+#endif
+  e->wb_list.queue = 0;
   e->allocated = true;
   ++ep->nr_allocated;
 }
@@ -174,10 +215,10 @@ static void alloc_this_entry(struct entry_pool *ep, struct entry *e) {
 static struct entry *alloc_entry(struct entry_pool *ep) {
   struct entry *e;
 
-  if (list_empty(&ep->free))
+  if (ep->free == IQUEUE_NIL)
     return NULL;
 
-  e = list_entry(list_pop(&ep->free), struct entry, pool_list);
+  e = __epool_entry(ep, ep->free);
   alloc_this_entry(ep, e);
   return e;
 }
@@ -207,7 +248,9 @@ static struct entry *epool_find(struct entry_pool *ep, cblock_t cblock) {
 
 /** Is the entry_pool free list empty?
  */
-static bool epool_empty(struct entry_pool *ep) { return list_empty(&ep->free); }
+static bool epool_empty(struct entry_pool *ep) {
+  return ep->free == IQUEUE_NIL;
+}
 
 /** Is the entry from this entry_pool?
  *
@@ -223,31 +266,20 @@ static bool in_pool(struct entry_pool *ep, void *e) {
  * Using the memory address of the entry, infer the cache block address of the
  * entry.
  *
- * \note We have to cast to uintptr_t in order to do arithmetic.
- *       We're not allowed to do that with (void *) and division is not allowed
- *       with other pointers.
- *       This allows a clean, understandable cast that is an
- *       unsigned integer usable as a cache block address at the end.
- *
  * \warning If entry is \a not from the entry_pool the program fails.
  */
 static cblock_t infer_cblock(struct entry_pool *ep, struct entry *e) {
-  uintptr_t entries_begin;
-  uintptr_t space_between;
   LOG_ASSERT(ep != NULL);
   LOG_ASSERT(in_pool(ep, e));
-  entries_begin = (uintptr_t)ep->entries[0];
-  space_between = ((uintptr_t)ep->entries[1]) - entries_begin;
-  return ((((uintptr_t)e) - entries_begin) / space_between) +
-         ep->starting_index;
+  return __epool_index(ep, e) + ep->starting_index;
 }
 
 /** "Reserve" the entry from the entry_pool
  *
- * Moves the entry to the entry_pool's migrating list
+ * Marks the entry as migrating
  *
  * \warning Make sure that necessary algorithm information is still
- *          in the entry for when it is removed from the migrating list
+ *          in the entry for when it has migrated
  */
 static void migrating_entry(struct entry_pool *ep, struct entry *e) {
   LOG_ASSERT(ep != NULL);
@@ -256,12 +288,9 @@ static void migrating_entry(struct entry_pool *ep, struct entry *e) {
   LOG_ASSERT(e->allocated);
   e->migrating = true;
   ++ep->nr_migrating;
-  list_add(&e->pool_list, &ep->migrating);
 }
 
 /** Entry has "migrated", or finished "migrating"
- *
- * Removes the entry from the entry_pool's migrating list
  */
 static void migrated_entry(struct entry_pool *ep, struct entry *e) {
   LOG_ASSERT(ep != NULL);
@@ -271,7 +300,6 @@ static void migrated_entry(struct entry_pool *ep, struct entry *e) {
   LOG_ASSERT(e->migrating);
   e->migrating = false;
   --ep->nr_migrating;
-  list_del_init(&e->pool_list);
 }
 
 /** "Free" the entry from the entry_pool
@@ -280,20 +308,23 @@ static void migrated_entry(struct entry_pool *ep, struct entry *e) {
  *
  * \warning If entry is \a not from the entry_pool \b or if the entry_pool
  *          doesn't have any entries allocated the program fails.
+ * \warning The entry must no longer be in a writeback queue
  */
 static void free_entry(struct entry_pool *ep, struct entry *e) {
   LOG_ASSERT(ep != NULL);
   LOG_ASSERT(in_pool(ep, e));
   LOG_ASSERT(ep->nr_allocated > 0);
+  LOG_ASSERT(e->wb_list.queue == 0);
   ep->nr_allocated--;
   e->allocated = false;
   if (e->migrating) {
     ep->nr_migrating--;
     e->migrating = false;
-    list_del_init(&e->pool_list);
   }
+#ifdef HASHTABLE_CHAINED
   INIT_HLIST_NODE(&e->ht_list);
-  list_add(&e->pool_list, &ep->free);
+#endif
+  __epool_free_push(ep, e);
 }
 
 #endif /* INCLUDE_TOOL_EPOOL_H */
@@ -24,6 +24,21 @@ static unsigned next_power(unsigned n, unsigned min) {
 
 struct entry;
 
+/* Two hashtables of entries, keyed by oblock, are behind the hash_*()
+ * functions:
+ *
+ * - An open-addressing hashtable (the default), in the style of the Swiss
+ *   tables of Abseil: the entries are referenced from a contiguous array of
+ *   slots, along with a control byte per slot holding 7 bits of the hash of
+ *   its entry's oblock. A lookup compares the control bytes of a group of 16
+ *   slots at once (with SSE2), only reading the entries whose 7 bits match,
+ *   so it usually touches the control bytes, the slot and the entry found,
+ *   rather than chasing the chain of a bucket through scattered entries.
+ * - A chaining hashtable of hlist buckets, for the kernel (where SSE2 isn't
+ *   available) or when compiled with -DHASHTABLE_CHAINED.
+ */
+#if defined(__KERNEL__) || defined(HASHTABLE_CHAINED)
+
 /** A hashtable struct that is general but used for entries
  *
  * This hashtable implementation only requires that the struct stored as the
@@ -32,6 +47,11 @@ struct entry;
  *
  * \note This implementation is a chaining hashtable, so conflicts simply get
  *       chained together within the same hashtable "bucket".
+ * \note The number of buckets follows the number of entries (see
+ *       __ht_check_load()), without ever going below the number ht_init()
+ *       started with. Rather than rehashing every entry at once, a resize
+ *       keeps the old buckets around and moves HT_MIGRATE_BUCKETS of them into
+ *       the new buckets on every insert or remove, while lookups search both.
  *
  * \warning While this is a generalized hashtable, the functions accompanying
  *          it are written with entries in mind.
@@ -40,13 +60,27 @@ struct entry;
  * hash_bits - A bitmask for the bits to guarantee that it has a place in the
  *             hashtable
  * table - Array of lists (a.k.a an array of "buckets")
+ * nr_items - Number of entries in the hashtable
+ * min_buckets - Number of buckets ht_init() started with
+ * old_nr_buckets/old_hash_bits/old_table - Buckets being moved into table
+ *                                          during a resize (NULL if none)
+ * migrate_pos - Next bucket of old_table to be moved
  */
 struct hashtable {
   unsigned nr_buckets;
   block_t hash_bits;
   struct hlist_head *table;
+  unsigned nr_items;
+  unsigned min_buckets;
+  unsigned old_nr_buckets;
+  block_t old_hash_bits;
+  struct hlist_head *old_table;
+  unsigned migrate_pos;
 };
 
+// Buckets moved from the old buckets on every insert or remove of a resize
+#define HT_MIGRATE_BUCKETS 4
+
 /** Initalize the hashtable
  *
  * \note In order to have a bitmask for hashing for placing the entries in the
@@ -63,39 +97,164 @@ static int ht_init(struct hashtable *ht, block_t cache_size) {
   if (ht->table == NULL)
     return -ENOSPC;
 
+  ht->nr_items = 0;
+  ht->min_buckets = ht->nr_buckets;
+  ht->old_table = NULL;
   return 0;
 }
 
+/** Move up to nr buckets of the old buckets into the current ones, freeing
+ * the old buckets once they're all moved
+ */
+static void __ht_migrate(struct hashtable *ht, unsigned nr) {
+  struct hlist_head *bucket;
+  struct entry *e;
+
+  for (; nr > 0 && ht->migrate_pos < ht->old_nr_buckets; nr--) {
+    bucket = ht->old_table + ht->migrate_pos++;
+    while (bucket->first != NULL) {
+      e = hlist_entry(bucket->first, struct entry, ht_list);
+      hlist_del(&e->ht_list);
+      hlist_add_head(&e->ht_list,
+                     ht->table +
+                         hash_64(from_oblock(e->oblock), ht->hash_bits));
+    }
+  }
+
+  if (ht->migrate_pos == ht->old_nr_buckets) {
+    mem_free(ht->old_table);
+    ht->old_table = NULL;
+  }
+}
+
+/** Start moving the entries into nr_buckets new buckets
+ *
+ * \note If unable to allocate the new buckets, the hashtable simply stays as
+ *       it is, with longer (or fewer) chains.
+ */
+static void __ht_resize(struct hashtable *ht, unsigned nr_buckets) {
+  struct hlist_head *table = mem_alloc(sizeof(*table) * nr_buckets);
+
+  if (table == NULL) {
+    return;
+  }
+
+  ht->old_nr_buckets = ht->nr_buckets;
+  ht->old_hash_bits = ht->hash_bits;
+  ht->old_table = ht->table;
+  ht->migrate_pos = 0;
+
+  ht->nr_buckets = nr_buckets;
+  ht->hash_bits = ffs(nr_buckets) - 1;
+  ht->table = table;
+}
+
+/** Move on with a resize, or start one if the hashtable averages more than 2
+ * entries per bucket (twice as many buckets), or less than 1 entry per 2
+ * buckets (half as many buckets)
+ */
+static void __ht_check_load(struct hashtable *ht) {
+  if (ht->old_table != NULL) {
+    __ht_migrate(ht, HT_MIGRATE_BUCKETS);
+  } else if (ht->nr_items > 2 * ht->nr_buckets) {
+    __ht_resize(ht, 2 * ht->nr_buckets);
+  } else if (ht->nr_items < ht->nr_buckets / 2 &&
+             ht->nr_buckets > ht->min_buckets) {
+    __ht_resize(ht, ht->nr_buckets / 2);
+  }
+}
+
 /** Insert an entry into the hashtable
  */
 static void hash_insert(struct hashtable *ht, struct entry *e) {
   unsigned h = hash_64(from_oblock(e->oblock), ht->hash_bits);
   hlist_add_head(&e->ht_list, ht->table + h);
+
+  ++ht->nr_items;
+  __ht_check_load(ht);
 }
 
-/** Lookup an entry from the hashtable
+/** Lookup an entry from the hashtable, without changing the hashtable
  *
- * \note As seen from the implementation, when found, the entry is put first
- *       in the bucket to make the next lookup for it faster.
+ * \note Lookups that don't change the state of a policy (such as
+ *       default_cache_lookup()) use this rather than hash_lookup(), so they
+ *       don't write to (and dirty the cache lines of) the buckets.
  *
  * \return Pointer to the entry we're looking for if found, NULL if not.
  */
-static struct entry *hash_lookup(struct hashtable *ht, oblock_t oblock) {
+static struct entry *hash_peek(const struct hashtable *ht, oblock_t oblock) {
   unsigned h = hash_64(from_oblock(oblock), ht->hash_bits);
-  struct hlist_head *bucket = ht->table + h;
   struct entry *e;
 
-  hlist_for_each_entry(e, bucket, ht_list) {
+  hlist_for_each_entry(e, ht->table + h, ht_list) {
     if (e->oblock == oblock) {
-      hlist_del(&e->ht_list);
-      hlist_add_head(&e->ht_list, bucket);
       return e;
     }
   }
 
+  if (ht->old_table != NULL) {
+    h = hash_64(from_oblock(oblock), ht->old_hash_bits);
+    hlist_for_each_entry(e, ht->old_table + h, ht_list) {
+      if (e->oblock == oblock) {
+        return e;
+      }
+    }
+  }
+
   return NULL;
 }
 
+/** Lookup an entry from the hashtable
+ *
+ * \note As seen from the implementation, when found, the entry is put first
+ *       in the bucket to make the next lookup for it faster (moving it out
+ *       of the old buckets, during a resize).
+ *
+ * \return Pointer to the entry we're looking for if found, NULL if not.
+ */
+static struct entry *hash_lookup(struct hashtable *ht, oblock_t oblock) {
+  struct entry *e = hash_peek(ht, oblock);
+
+  if (e != NULL) {
+    struct hlist_head *bucket =
+        ht->table + hash_64(from_oblock(oblock), ht->hash_bits);
+
+    hlist_del(&e->ht_list);
+    hlist_add_head(&e->ht_list, bucket);
+  }
+
+  return e;
+}
+
+/** Prefetch the bucket that oblock hashes to
+ *
+ * \note Buckets (and the entries chained in them) of large hashtables are
+ *       rarely in the CPU caches, so a lookup usually waits on two dependent
+ *       cache misses: the bucket and then its first entry. Prefetching the
+ *       bucket a few lookups ahead with hash_prefetch(), and its first entry a
+ *       little later with hash_prefetch_entry(), hides both.
+ */
+static void hash_prefetch(struct hashtable *ht, oblock_t oblock) {
+  unsigned h = hash_64(from_oblock(oblock), ht->hash_bits);
+  __builtin_prefetch(ht->table + h);
+}
+
+/** Prefetch the first entry in the bucket that oblock hashes to
+ *
+ * \note The bucket should have been prefetched (see hash_prefetch()) some time
+ *       before, otherwise this waits on it.
+ */
+static void hash_prefetch_entry(struct hashtable *ht, oblock_t oblock) {
+  unsigned h = hash_64(from_oblock(oblock), ht->hash_bits);
+  struct hlist_node *first = ht->table[h].first;
+
+  if (first != NULL) {
+    struct entry *e = hlist_entry(first, struct entry, ht_list);
+    __builtin_prefetch(e);
+    __builtin_prefetch(&e->oblock);
+  }
+}
+
 /** Remove an entry from the hashtable
  *
  * \note Since the hlist_node in the entry is essentially a doubly-linked list
@@ -103,7 +262,12 @@ static struct entry *hash_lookup(struct hashtable *ht, oblock_t oblock) {
  *       \a voila: the entry is safely removed from the hashtable it was in
  *       without making any other entries unreachable.
  */
-static void hash_remove(struct entry *e) { hlist_del(&e->ht_list); }
+static void hash_remove(struct hashtable *ht, struct entry *e) {
+  hlist_del(&e->ht_list);
+
+  --ht->nr_items;
+  __ht_check_load(ht);
+}
 
 /** Exit (or free) the hashtable
  *
@@ -112,6 +276,415 @@ static void hash_remove(struct entry *e) { hlist_del(&e->ht_list); }
  *       However, this should be done only when a policy and therefore all
  *       associated entries are being freed as well.
  */
-static void hash_exit(struct hashtable *ht) { mem_free(ht->table); }
+static void hash_exit(struct hashtable *ht) {
+  mem_free(ht->table);
+  mem_free(ht->old_table);
+}
+
+#else /* open-addressing hashtable */
+
+#include <stdint.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Slots compared at once, and control bytes of the slots without an entry
+#define HT_GROUP_SIZE 16
+#define HT_EMPTY ((uint8_t)0x80)
+#define HT_DELETED ((uint8_t)0xfe)
+
+// Groups moved from the old table on every insert or remove of a resize
+#define HT_MIGRATE_GROUPS 4
+
+/** ht_table
+ * Slots of an open-addressing hashtable
+ *
+ * \note Slots are probed a group at a time, starting from the group the hash
+ *       of the oblock gives and moving on by 1, 2, 3... groups (which visits
+ *       every group of a power of 2 of them), until a group with an empty
+ *       slot ends the search.
+ * \note No more than 7/8 of the slots are ever used, so probes stay short and
+ *       there always are empty slots to end them.
+ *
+ * nr_slots - Size of the table, a power of 2 of at least HT_GROUP_SIZE
+ * group_bits/group_mask - log2 of the number of groups, and the number of
+ *                         groups - 1
+ * nr_items - Number of entries in the table
+ * growth_left - Number of empty slots that can be used before resizing
+ * ctrl - Control byte of every slot: HT_EMPTY, HT_DELETED, or the 7 bits of
+ *        the hash of its entry's oblock (see __ht_h2())
+ * slots - Entry of every slot
+ */
+struct ht_table {
+  unsigned nr_slots;
+  unsigned group_bits;
+  unsigned group_mask;
+  unsigned nr_items;
+  unsigned growth_left;
+  uint8_t *ctrl;
+  struct entry **slots;
+};
+
+/** A hashtable of entries, with open addressing
+ *
+ * \note The table is resized once its slots run out (twice as large, or as
+ *       large to clear the deleted slots), or when less than 1/8 of them are
+ *       used (smaller, but never smaller than ht_init() made it). Rather than
+ *       moving every entry at once, a resize keeps the old table around and
+ *       moves HT_MIGRATE_GROUPS groups of it into the new table on every
+ *       insert or remove, while lookups search both.
+ *
+ * table - Current table, where entries are inserted
+ * old - Table being moved into table during a resize (ctrl is NULL if none)
+ * migrate_pos - Next group of old to be moved
+ * min_slots - Number of slots ht_init() started with
+ */
+struct hashtable {
+  struct ht_table table;
+  struct ht_table old;
+  unsigned migrate_pos;
+  unsigned min_slots;
+};
+
+static uint64_t __ht_hash(oblock_t oblock) {
+  return from_oblock(oblock) * GOLDEN_RATIO_64;
+}
+
+/** 7 bits of the hash kept in the control byte (the highest, best mixed ones)
+ */
+static uint8_t __ht_h2(uint64_t hash) { return hash >> 57; }
+
+/** First group probed, from the bits of the hash below those of __ht_h2()
+ */
+static unsigned __ht_group(const struct ht_table *t, uint64_t hash) {
+  return (hash >> (57 - t->group_bits)) & t->group_mask;
+}
+
+/** Bitmask of the slots of the group whose control byte is c
+ */
+static unsigned __ht_match(const uint8_t *ctrl, uint8_t c) {
+#ifdef __SSE2__
+  __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)c)));
+#else
+  unsigned mask = 0;
+  unsigned i;
+
+  for (i = 0; i < HT_GROUP_SIZE; i++) {
+    if (ctrl[i] == c) {
+      mask |= 1u << i;
+    }
+  }
+  return mask;
+#endif
+}
+
+/** Bitmask of the slots of the group without an entry (empty or deleted)
+ */
+static unsigned __ht_match_free(const uint8_t *ctrl) {
+#ifdef __SSE2__
+  // both HT_EMPTY and HT_DELETED have their highest bit set, unlike hashes
+  return _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)ctrl));
+#else
+  unsigned mask = 0;
+  unsigned i;
+
+  for (i = 0; i < HT_GROUP_SIZE; i++) {
+    if (ctrl[i] & 0x80) {
+      mask |= 1u << i;
+    }
+  }
+  return mask;
+#endif
+}
+
+/** Allocate an empty table of nr_slots slots
+ *
+ * \return 0 if no errors occur, or -ENOSPC if unable to allocate memory
+ */
+static int __ht_table_alloc(struct ht_table *t, unsigned nr_slots) {
+  t->ctrl = mem_alloc(sizeof(*t->ctrl) * nr_slots);
+  t->slots = mem_alloc(sizeof(*t->slots) * nr_slots);
+  if (t->ctrl == NULL || t->slots == NULL) {
+    mem_free(t->ctrl);
+    mem_free(t->slots);
+    t->ctrl = NULL;
+    return -ENOSPC;
+  }
+  memset(t->ctrl, HT_EMPTY, sizeof(*t->ctrl) * nr_slots);
+
+  t->nr_slots = nr_slots;
+  t->group_bits = ffs(nr_slots / HT_GROUP_SIZE) - 1;
+  t->group_mask = nr_slots / HT_GROUP_SIZE - 1;
+  t->nr_items = 0;
+  t->growth_left = nr_slots - nr_slots / 8;
+  return 0;
+}
+
+static void __ht_table_free(struct ht_table *t) {
+  mem_free(t->ctrl);
+  mem_free(t->slots);
+  t->ctrl = NULL;
+  t->slots = NULL;
+}
+
+/** Put the entry in the first slot without an entry on its probe sequence
+ */
+static void __ht_table_place(struct ht_table *t, struct entry *e) {
+  uint64_t hash = __ht_hash(e->oblock);
+  unsigned g = __ht_group(t, hash);
+  unsigned step = 0;
+  unsigned mask;
+  unsigned i;
+
+  while (!(mask = __ht_match_free(t->ctrl + g * HT_GROUP_SIZE))) {
+    g = (g + ++step) & t->group_mask;
+  }
+
+  i = g * HT_GROUP_SIZE + __builtin_ctz(mask);
+  if (t->ctrl[i] == HT_EMPTY) {
+    --t->growth_left;
+  }
+  t->ctrl[i] = __ht_h2(hash);
+  t->slots[i] = e;
+  ++t->nr_items;
+}
+
+/** Entry of the table with the given oblock, or NULL if none
+ */
+static struct entry *__ht_table_find(const struct ht_table *t,
+                                     oblock_t oblock) {
+  uint64_t hash = __ht_hash(oblock);
+  uint8_t h2 = __ht_h2(hash);
+  unsigned g = __ht_group(t, hash);
+  unsigned step = 0;
+  const uint8_t *ctrl;
+  struct entry *e;
+  unsigned mask;
+
+  for (;;) {
+    ctrl = t->ctrl + g * HT_GROUP_SIZE;
+    for (mask = __ht_match(ctrl, h2); mask; mask &= mask - 1) {
+      e = t->slots[g * HT_GROUP_SIZE + __builtin_ctz(mask)];
+      if (e->oblock == oblock) {
+        return e;
+      }
+    }
+    if (__ht_match(ctrl, HT_EMPTY)) {
+      return NULL;
+    }
+    g = (g + ++step) & t->group_mask;
+  }
+}
+
+/** Free the slot at index i
+ *
+ * \note The slot is marked deleted, so that the probes going through its
+ *       group go on past it, unless the group has an empty slot (which ends
+ *       those probes anyway), in which case the slot is simply emptied.
+ */
+static void __ht_table_clear(struct ht_table *t, unsigned i) {
+  if (__ht_match(t->ctrl + (i & ~(HT_GROUP_SIZE - 1)), HT_EMPTY)) {
+    t->ctrl[i] = HT_EMPTY;
+    ++t->growth_left;
+  } else {
+    t->ctrl[i] = HT_DELETED;
+  }
+  t->slots[i] = NULL;
+  --t->nr_items;
+}
+
+/** Remove the entry from the table
+ *
+ * \return 0 if removed, or 1 if not in the table
+ */
+static int __ht_table_remove(struct ht_table *t, struct entry *e) {
+  uint64_t hash = __ht_hash(e->oblock);
+  uint8_t h2 = __ht_h2(hash);
+  unsigned g = __ht_group(t, hash);
+  unsigned step = 0;
+  const uint8_t *ctrl;
+  unsigned mask;
+  unsigned i;
+
+  for (;;) {
+    ctrl = t->ctrl + g * HT_GROUP_SIZE;
+    for (mask = __ht_match(ctrl, h2); mask; mask &= mask - 1) {
+      i = g * HT_GROUP_SIZE + __builtin_ctz(mask);
+      if (t->slots[i] == e) {
+        __ht_table_clear(t, i);
+        return 0;
+      }
+    }
+    if (__ht_match(ctrl, HT_EMPTY)) {
+      return 1;
+    }
+    g = (g + ++step) & t->group_mask;
+  }
+}
+
+/** Move up to nr groups of the old table into the current one, freeing the
+ * old table once it's all moved
+ *
+ * \note The moved slots are marked deleted rather than emptied, so that the
+ *       probes of the entries left in the old table go on past them.
+ */
+static void __ht_migrate(struct hashtable *ht, unsigned nr) {
+  struct ht_table *old = &ht->old;
+  unsigned i;
+  unsigned end;
+
+  for (; nr > 0 && ht->migrate_pos <= old->group_mask; nr--) {
+    i = ht->migrate_pos++ * HT_GROUP_SIZE;
+    for (end = i + HT_GROUP_SIZE; i < end; i++) {
+      if (!(old->ctrl[i] & 0x80)) {
+        __ht_table_place(&ht->table, old->slots[i]);
+        old->ctrl[i] = HT_DELETED;
+        --old->nr_items;
+      }
+    }
+  }
+
+  if (ht->migrate_pos > old->group_mask) {
+    __ht_table_free(old);
+  }
+}
+
+/** Start moving the entries into a new table, finishing any resize already
+ * going on first
+ *
+ * \note The new table is sized for the entries to use 1/4 to 1/2 of its
+ *       slots (but no smaller than ht_init() made it), and always has room
+ *       for the inserts made until the old table is all moved (one per
+ *       HT_MIGRATE_GROUPS groups of it), so it never runs out of slots before.
+ */
+static void __ht_resize(struct hashtable *ht) {
+  unsigned nr_items;
+  unsigned need;
+
+  if (ht->old.ctrl != NULL) {
+    __ht_migrate(ht, ht->old.group_mask + 1);
+  }
+
+  nr_items = ht->table.nr_items;
+  need = max(2 * nr_items,
+             nr_items + ht->table.nr_slots / HT_GROUP_SIZE / HT_MIGRATE_GROUPS);
+  ht->old = ht->table;
+  ht->migrate_pos = 0;
+  if (__ht_table_alloc(&ht->table,
+                       next_power(need + need / 7 + 1, ht->min_slots))) {
+    LOG_FATAL("Unable to allocate memory to resize the hashtable");
+  }
+}
+
+/** Initalize the hashtable
+ *
+ * \note The hashtable is sized to hold cache_size entries within 7/8 of its
+ *       slots, and resized as entries come and go.
+ *
+ * \return 0 if no errors occur, or -ENOSPC if unable to allocate memory
+ */
+static int ht_init(struct hashtable *ht, block_t cache_size) {
+  unsigned size = from_cblock(cache_size);
+
+  ht->min_slots = next_power(size + size / 7 + 1, HT_GROUP_SIZE);
+  ht->old.ctrl = NULL;
+  ht->old.slots = NULL;
+  return __ht_table_alloc(&ht->table, ht->min_slots);
+}
+
+/** Insert an entry into the hashtable
+ */
+static void hash_insert(struct hashtable *ht, struct entry *e) {
+  if (ht->old.ctrl != NULL) {
+    __ht_migrate(ht, HT_MIGRATE_GROUPS);
+  }
+  if (ht->table.growth_left == 0) {
+    __ht_resize(ht);
+  }
+  __ht_table_place(&ht->table, e);
+}
+
+/** Lookup an entry from the hashtable, without changing the hashtable
+ *
+ * \return Pointer to the entry we're looking for if found, NULL if not.
+ */
+static struct entry *hash_peek(const struct hashtable *ht, oblock_t oblock) {
+  struct entry *e = __ht_table_find(&ht->table, oblock);
+
+  if (e == NULL && ht->old.ctrl != NULL) {
+    e = __ht_table_find(&ht->old, oblock);
+  }
+  return e;
+}
+
+/** Lookup an entry from the hashtable
+ *
+ * \note Lookups never change an open-addressing hashtable, so this is
+ *       hash_peek().
+ *
+ * \return Pointer to the entry we're looking for if found, NULL if not.
+ */
+static struct entry *hash_lookup(struct hashtable *ht, oblock_t oblock) {
+  return hash_peek(ht, oblock);
+}
+
+/** Prefetch the group of slots that oblock hashes to
+ *
+ * \note Large hashtables are rarely in the CPU caches, so a lookup usually
+ *       waits on two dependent cache misses: the group and then the entry.
+ *       Prefetching the group a few lookups ahead with hash_prefetch(), and
+ *       the entry a little later with hash_prefetch_entry(), hides both.
+ */
+static void hash_prefetch(struct hashtable *ht, oblock_t oblock) {
+  unsigned g = __ht_group(&ht->table, __ht_hash(oblock));
+
+  __builtin_prefetch(ht->table.ctrl + g * HT_GROUP_SIZE);
+  __builtin_prefetch(ht->table.slots + g * HT_GROUP_SIZE);
+  __builtin_prefetch(ht->table.slots + g * HT_GROUP_SIZE + HT_GROUP_SIZE - 1);
+}
+
+/** Prefetch the entries of the first group probed for oblock that may be it
+ *
+ * \note The group should have been prefetched (see hash_prefetch()) some time
+ *       before, otherwise this waits on it.
+ */
+static void hash_prefetch_entry(struct hashtable *ht, oblock_t oblock) {
+  uint64_t hash = __ht_hash(oblock);
+  unsigned g = __ht_group(&ht->table, hash);
+  unsigned mask;
+
+  for (mask = __ht_match(ht->table.ctrl + g * HT_GROUP_SIZE, __ht_h2(hash));
+       mask; mask &= mask - 1) {
+    __builtin_prefetch(
+        &ht->table.slots[g * HT_GROUP_SIZE + __builtin_ctz(mask)]->oblock);
+  }
+}
+
+/** Remove an entry from the hashtable
+ */
+static void hash_remove(struct hashtable *ht, struct entry *e) {
+  if (__ht_table_remove(&ht->table, e) && ht->old.ctrl != NULL) {
+    __ht_table_remove(&ht->old, e);
+  }
+
+  if (ht->old.ctrl != NULL) {
+    __ht_migrate(ht, HT_MIGRATE_GROUPS);
+  } else if (ht->table.nr_items < ht->table.nr_slots / 8 &&
+             ht->table.nr_slots > ht->min_slots) {
+    __ht_resize(ht);
+  }
+}
+
+/** Exit (or free) the hashtable
+ */
+static void hash_exit(struct hashtable *ht) {
+  __ht_table_free(&ht->table);
+  __ht_table_free(&ht->old);
+}
+
+#endif /* open-addressing hashtable */
 
 #endif /* INCLUDE_TOOL_HASHTABLE_H */
@@ -0,0 +1,325 @@
+#ifndef INCLUDE_TOOLS_IQUEUE_H
+#define INCLUDE_TOOLS_IQUEUE_H
+
+#include "common.h"
+
+/* Index-linked queues
+ *
+ * A queue_head is a list_head and a pointer to its queue, 24 bytes for every
+ * queue an entry can be in (and LIRS entries are in three). But the entries of
+ * a policy all live in its entry pools, so rather than pointers, its queues
+ * link them by their 32-bit index in the pools: an iqueue_head is 12 bytes.
+ *
+ * The queues linking the entries of the same pools are kept in an iqueue_set,
+ * which maps indices to entries: the entries of the first pool added to it are
+ * indexed from 0, the entries of the second one (if any) following them. An
+ * iqueue_head knows the queue it's in by its id in the set, 0 being none, so
+ * entries fresh out of mem_alloc() are in no queue.
+ *
+ * Apart from iqueue_remove() and iqueue_swap() needing the set, iqueues work as
+ * queues do (see queue.h).
+ */
+
+// no item (before the head or after the tail of a queue)
+#define IQUEUE_NIL ((uint32_t)-1)
+// most queues in an iqueue_set
+#define IQUEUE_SET_QUEUES 8
+// bits of the id of the queue an item is in (see iqueue_head)
+#define IQUEUE_ID_BITS 4
+#if IQUEUE_SET_QUEUES >= (1 << IQUEUE_ID_BITS)
+#error "IQUEUE_ID_BITS can't hold the id of every queue of an iqueue_set"
+#endif
+// most entry pools in an iqueue_set (the cache and meta pools)
+#define IQUEUE_SET_POOLS 2
+
+struct iqueue;
+
+/** iqueue_set
+ * Entry pools and the queues linking their entries
+ *
+ * begin/end - The (policy-specific) entries of each pool
+ * first - Index of the first entry of each pool, IQUEUE_NIL if there's no pool
+ * nr_pools - Number of pools added
+ * stride - Size of the (policy-specific) entries
+ * queues - The queues of the set, queue of id i at i - 1
+ * nr_queues - Number of queues of the set
+ */
+struct iqueue_set {
+  uintptr_t begin[IQUEUE_SET_POOLS];
+  uintptr_t end[IQUEUE_SET_POOLS];
+  uint32_t first[IQUEUE_SET_POOLS];
+  unsigned nr_pools;
+  size_t stride;
+  struct iqueue *queues[IQUEUE_SET_QUEUES];
+  unsigned nr_queues;
+};
+
+/** Index-linked queue
+ */
+struct iqueue {
+  struct iqueue_set *set; ///< Set the queue is in
+  size_t offset;          ///< Offset of the iqueue_head in the entries
+  uint32_t head;          ///< Index of the head of the queue
+  uint32_t tail;          ///< Index of the tail of the queue
+  unsigned len;           ///< Length of the queue
+  unsigned id;            ///< Id of the queue in its set
+};
+
+/** Index-linked queue entry
+ *
+ * \note Only the IQUEUE_ID_BITS lower bits of the word of queue are used, the
+ *       others are left to the items (struct entry keeps its flags there), so
+ *       iqueues never write the iqueue_head as a whole.
+ */
+struct iqueue_head {
+  uint32_t prev;                   ///< Index of the previous item
+  uint32_t next;                   ///< Index of the next item
+  unsigned queue : IQUEUE_ID_BITS; ///< Id of the queue it's in, 0 if none
+};
+
+/** Initialize the iqueue_set of entries of the given size
+ *
+ * \note The pools are added after they're created, with iqueue_set_add_pool()
+ *       (see epool.h)
+ */
+static void iqueue_set_init(struct iqueue_set *s, size_t stride) {
+  unsigned i;
+
+  for (i = 0; i < IQUEUE_SET_POOLS; ++i) {
+    s->begin[i] = 0;
+    s->end[i] = 0;
+    s->first[i] = IQUEUE_NIL;
+  }
+  s->nr_pools = 0;
+  s->stride = stride;
+  s->nr_queues = 0;
+}
+
+/** Add nr_entries (policy-specific) entries from begin to the iqueue_set
+ *
+ * \note Entry pools are added with iqueue_set_add_pool() (see epool.h)
+ */
+static void iqueue_set_add(struct iqueue_set *s, void *begin,
+                           unsigned nr_entries) {
+  uint32_t first = 0;
+
+  LOG_ASSERT(s->nr_pools < IQUEUE_SET_POOLS);
+
+  if (s->nr_pools > 0) {
+    first = s->first[s->nr_pools - 1] +
+            (s->end[s->nr_pools - 1] - s->begin[s->nr_pools - 1]) / s->stride;
+  }
+  LOG_ASSERT(nr_entries < IQUEUE_NIL - first);
+
+  s->begin[s->nr_pools] = (uintptr_t)begin;
+  s->end[s->nr_pools] = (uintptr_t)begin + s->stride * nr_entries;
+  s->first[s->nr_pools] = first;
+  ++s->nr_pools;
+}
+
+/** The iqueue_head of the queue at index i
+ */
+static struct iqueue_head *__iqueue_at(struct iqueue *q, uint32_t i) {
+  struct iqueue_set *s = q->set;
+  // indices of the second pool (if any) follow those of the first one
+  unsigned p = i >= s->first[1];
+
+  return (struct iqueue_head *)(s->begin[p] +
+                                (uintptr_t)(i - s->first[p]) * s->stride +
+                                q->offset);
+}
+
+/** The index of the entry of an iqueue_head of the queue
+ */
+static uint32_t __iqueue_index(struct iqueue *q, struct iqueue_head *item) {
+  struct iqueue_set *s = q->set;
+  uintptr_t e = (uintptr_t)item - q->offset;
+  unsigned p = e >= s->begin[1] && e < s->end[1];
+
+  LOG_ASSERT(e >= s->begin[p] && e < s->end[p]);
+  return s->first[p] + (uint32_t)((e - s->begin[p]) / s->stride);
+}
+
+/** The queue the item is in, or NULL if none
+ */
+static struct iqueue *__iqueue_of(struct iqueue_set *s,
+                                  struct iqueue_head *item) {
+  return item->queue ? s->queues[item->queue - 1] : NULL;
+}
+
+/** Initialize the iqueue, of the iqueue_heads at offset in the entries of s
+ */
+static void __iqueue_init(struct iqueue *q, struct iqueue_set *s,
+                          size_t offset) {
+  LOG_ASSERT(s->nr_queues < IQUEUE_SET_QUEUES);
+
+  q->set = s;
+  q->offset = offset;
+  q->head = IQUEUE_NIL;
+  q->tail = IQUEUE_NIL;
+  q->len = 0;
+  s->queues[s->nr_queues++] = q;
+  q->id = s->nr_queues;
+}
+
+/** Initialize the iqueue, linking entries of s through their member
+ *
+ * _q - Pointer to the iqueue
+ * _s - Pointer to the iqueue_set
+ * _type - The type of the policy-specific entry
+ * _member - The iqueue_head member of the policy-specific entry
+ */
+#define iqueue_init(_q, _s, _type, _member)                                    \
+  __iqueue_init((_q), (_s), offsetof(_type, _member))
+
+/** Is the iqueue empty?
+ * \return true if queue is empty, false otherwise
+ */
+static bool iqueue_empty(struct iqueue *q) { return q->len == 0; }
+
+/** Push an item onto the iqueue
+ * \note The item is pushed onto the tail of the queue
+ */
+static void iqueue_push(struct iqueue *q, struct iqueue_head *item) {
+  uint32_t i = __iqueue_index(q, item);
+
+  LOG_ASSERT(item->queue == 0);
+
+  item->prev = q->tail;
+  item->next = IQUEUE_NIL;
+  item->queue = q->id;
+  if (q->tail == IQUEUE_NIL) {
+    q->head = i;
+  } else {
+    __iqueue_at(q, q->tail)->next = i;
+  }
+  q->tail = i;
+  ++q->len;
+}
+
+/** Remove an item from its iqueue, if it's in one
+ */
+static void iqueue_remove(struct iqueue_set *s, struct iqueue_head *item) {
+  struct iqueue *q = __iqueue_of(s, item);
+
+  if (q) {
+    if (item->prev == IQUEUE_NIL) {
+      q->head = item->next;
+    } else {
+      __iqueue_at(q, item->prev)->next = item->next;
+    }
+    if (item->next == IQUEUE_NIL) {
+      q->tail = item->prev;
+    } else {
+      __iqueue_at(q, item->next)->prev = item->prev;
+    }
+
+    --q->len;
+    item->queue = 0;
+  }
+}
+
+/** Point the neighbours of an item just swapped in at index i, which was at
+ * index other, to it
+ */
+static void __iqueue_relink(struct iqueue_set *s, struct iqueue_head *item,
+                            uint32_t i, uint32_t other) {
+  struct iqueue *q = __iqueue_of(s, item);
+
+  if (q == NULL) {
+    return;
+  }
+
+  // the item it's swapped with was next to it
+  if (item->prev == i) {
+    item->prev = other;
+  }
+  if (item->next == i) {
+    item->next = other;
+  }
+
+  if (item->prev == IQUEUE_NIL) {
+    q->head = i;
+  } else {
+    __iqueue_at(q, item->prev)->next = i;
+  }
+  if (item->next == IQUEUE_NIL) {
+    q->tail = i;
+  } else {
+    __iqueue_at(q, item->next)->prev = i;
+  }
+}
+
+/** Replace an item in its iqueue with another (of the same queues), and the
+ * other in its iqueue with the item
+ */
+static void iqueue_swap(struct iqueue_set *s, struct iqueue_head *item_old,
+                        struct iqueue_head *item_new) {
+  struct iqueue *q = __iqueue_of(s, item_old);
+  uint32_t prev = item_old->prev;
+  uint32_t next = item_old->next;
+  unsigned queue = item_old->queue;
+  uint32_t i_old;
+  uint32_t i_new;
+
+  if (q == NULL) {
+    q = __iqueue_of(s, item_new);
+  }
+  if (q == NULL || item_old == item_new) {
+    return;
+  }
+
+  i_old = __iqueue_index(q, item_old);
+  i_new = __iqueue_index(q, item_new);
+
+  item_old->prev = item_new->prev;
+  item_old->next = item_new->next;
+  item_old->queue = item_new->queue;
+  item_new->prev = prev;
+  item_new->next = next;
+  item_new->queue = queue;
+
+  __iqueue_relink(s, item_old, i_old, i_new);
+  __iqueue_relink(s, item_new, i_new, i_old);
+}
+
+/** Peek the item at the head of the iqueue
+ * \return Item at the head of the queue or NULL if queue was empty
+ */
+static struct iqueue_head *iqueue_peek(struct iqueue *q) {
+  return q->head == IQUEUE_NIL ? NULL : __iqueue_at(q, q->head);
+}
+
+/** The item after the given one in the iqueue
+ * \return Next item or NULL if the item is the tail of the queue
+ */
+static struct iqueue_head *iqueue_next(struct iqueue *q,
+                                       struct iqueue_head *item) {
+  return item->next == IQUEUE_NIL ? NULL : __iqueue_at(q, item->next);
+}
+
+/** Pop the item at the head of the iqueue
+ * \return Popped item or NULL if queue was empty
+ */
+static struct iqueue_head *iqueue_pop(struct iqueue *q) {
+  struct iqueue_head *item;
+
+  item = iqueue_peek(q);
+  if (item) {
+    iqueue_remove(q->set, item);
+  }
+
+  return item;
+}
+
+/** The length of the iqueue
+ */
+static unsigned iqueue_length(struct iqueue *q) { return q->len; }
+
+/** Check if item is in the given iqueue
+ */
+static bool in_iqueue(struct iqueue *q, struct iqueue_head *item) {
+  return item->queue == q->id;
+}
+
+#endif /* INCLUDE_TOOLS_IQUEUE_H */
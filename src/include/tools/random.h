@@ -8,9 +8,19 @@
 #include <stdlib.h>
 #endif /* !__KERNEL__ */
 
+/* Userspace keeps its own random_r() state so that several random_state's can
+ * live in one process (e.g. one per simulated cache) without sharing the
+ * global random() sequence.
+ *
+ * \warning random_data points into state_buf, so a random_state must not be
+ *          copied after prandom_init_seed()
+ */
 struct random_state {
 #ifdef __KERNEL__
   struct rnd_state rnd_state;
+#else
+  struct random_data data;
+  char state_buf[128];
 #endif
   unsigned prev_random;
   unsigned seed;
@@ -22,7 +32,9 @@ static void prandom_init_seed(struct random_state *random_state,
 #ifdef __KERNEL__
   prandom_seed_state(&random_state->rnd_state, seed);
 #else
-  srandom(seed);
+  random_state->data.state = NULL;
+  initstate_r(seed, random_state->state_buf, sizeof(random_state->state_buf),
+              &random_state->data);
 #endif
 }
 
@@ -31,7 +43,9 @@ static unsigned random_int(struct random_state *random_state) {
 #ifdef __KERNEL__
   random_val = prandom_u32_state(&random_state->rnd_state);
 #else
-  random_val = (unsigned)random();
+  int32_t r;
+  random_r(&random_state->data, &r);
+  random_val = (unsigned)r;
 #endif
   random_state->prev_random = random_val;
   return random_val;
@@ -1,8 +1,10 @@
 #ifndef WRITEBACK_TRACKER_H
 #define WRITEBACK_TRACKER_H
 
+#include "cache_nucleus_struct.h"
 #include "entry.h"
-#include "tools/queue.h"
+#include "tools/epool.h"
+#include "tools/iqueue.h"
 
 /** Tracks dirty, clean, and meta entries for writeback
  *
@@ -11,45 +13,71 @@
  * must be written back (get it?) to update the origin device since the cache
  * will no longer keep the most up-to-date version of the entry.
  *
+ * The queues link the entries of the cache_nucleus's entry pools by index (see
+ * iqueue.h), so the tracker only works with the entries of the cache_nucleus
+ * it was initialized with.
+ *
+ * queues - The entry pools of the cache_nucleus and the queues below
  * clean - Entries that match their origin device counterpart
  * dirty - Entries that are more up-to-date thatn their origin device
  *         counterpart
  * meta - Entries that are not in the cache, but still tracked
  */
 struct writeback_tracker {
-  struct queue clean;
-  struct queue dirty;
-  struct queue meta;
+  struct iqueue_set queues;
+  struct iqueue clean;
+  struct iqueue dirty;
+  struct iqueue meta;
 };
 
-static void wb_init(struct writeback_tracker *wb_tracker) {
-  queue_init(&wb_tracker->clean);
-  queue_init(&wb_tracker->dirty);
-  queue_init(&wb_tracker->meta);
+/** Initialize the writeback_tracker of the entries of the cache_nucleus
+ *
+ * \note The cache_nucleus removes its entries from the writeback queues as
+ *       they're freed, through its wb_queues
+ */
+static void wb_init(struct writeback_tracker *wb_tracker,
+                    struct cache_nucleus *bp) {
+  size_t offset = bp->cache_pool.offset + offsetof(struct entry, wb_list);
+
+  iqueue_set_init(&wb_tracker->queues, bp->cache_pool.stride);
+  if (bp->cache_pool.nr_entries > 0) {
+    iqueue_set_add_pool(&wb_tracker->queues, &bp->cache_pool);
+  }
+  if (bp->meta_pool.nr_entries > 0) {
+    iqueue_set_add_pool(&wb_tracker->queues, &bp->meta_pool);
+  }
+  __iqueue_init(&wb_tracker->clean, &wb_tracker->queues, offset);
+  __iqueue_init(&wb_tracker->dirty, &wb_tracker->queues, offset);
+  __iqueue_init(&wb_tracker->meta, &wb_tracker->queues, offset);
+
+  bp->wb_queues = &wb_tracker->queues;
 }
 
 /** Push entry to cache queue (dirty or clean based on entry)
  */
 static void wb_push_cache(struct writeback_tracker *wb_tracker,
                           struct entry *e) {
-  queue_push(e->dirty ? &wb_tracker->dirty : &wb_tracker->clean, &e->wb_list);
+  iqueue_push(e->dirty ? &wb_tracker->dirty : &wb_tracker->clean,
+              &e->wb_list);
 }
 
 /** Push entry to meta queue
  */
 static void wb_push_meta(struct writeback_tracker *wb_tracker,
                          struct entry *e) {
-  queue_push(&wb_tracker->meta, &e->wb_list);
+  iqueue_push(&wb_tracker->meta, &e->wb_list);
 }
 
 /** Remove entry from writeback queue
  */
-static void wb_remove(struct entry *e) { queue_remove(&e->wb_list); }
+static void wb_remove(struct writeback_tracker *wb_tracker, struct entry *e) {
+  iqueue_remove(&wb_tracker->queues, &e->wb_list);
+}
 
 /** Remove and retrieve least recently used dirty entry from queue
  */
 static struct entry *wb_pop_dirty(struct writeback_tracker *wb_tracker) {
-  struct queue_head *h = queue_pop(&wb_tracker->dirty);
+  struct iqueue_head *h = iqueue_pop(&wb_tracker->dirty);
   if (!h)
     return NULL;
 
@@ -5,13 +5,13 @@
 #include "entry.h"
 #include "mstar_logic.h"
 #include "mstar_policy_struct.h"
-#include "tools/queue.h"
+#include "tools/iqueue.h"
 
 void mstar_only_remove(struct mstar_policy *mstar, struct mstar_entry *me) {
   struct entry *e;
   LOG_ASSERT(me != NULL);
   e = &me->e;
-  queue_remove(&me->mstar_list);
+  iqueue_remove(&mstar->queues, &me->mstar_list);
   // removes entry from hashtable and epool
   cache_nucleus_remove(&mstar->nucleus, &me->e);
 }
@@ -46,13 +46,13 @@ void mstar_migrated(struct cache_nucleus *cn, oblock_t oblock) {
 // eviction is m*'s meta_pool only
 void mstar_evict(struct mstar_policy *mstar) {
   struct mstar_entry *me =
-      queue_pop_entry(&mstar->mstar_g, struct mstar_entry, mstar_list);
+      iqueue_pop_entry(&mstar->mstar_g, struct mstar_entry, mstar_list);
   LOG_ASSERT(me != NULL);
   mstar_only_remove(mstar, me);
 }
 
 void mstar_ghost_length_control(struct mstar_policy *mstar) {
-  if (queue_length(&mstar->mstar_g) > mstar->ghost_size) {
+  if (iqueue_length(&mstar->mstar_g) > mstar->ghost_size) {
     mstar_evict(mstar);
   }
 }
@@ -93,7 +93,7 @@ int mstar_ghost_miss(struct mstar_policy *mstar, oblock_t oblock, bool write,
     struct entry *e = insert_in_meta(&mstar->nucleus, oblock);
     struct mstar_entry *me = to_mstar_entry(e);
 
-    queue_push(&mstar->mstar_g, &me->mstar_list);
+    iqueue_push(&mstar->mstar_g, &me->mstar_list);
 
     mstar_increase_ghost_size(mstar);
 
@@ -129,7 +129,7 @@ int mstar_ghost_hit(struct mstar_policy *mstar, oblock_t oblock, bool write,
       e = insert_in_meta(cn, oblock);
       me = to_mstar_entry(e);
 
-      queue_push(&mstar->mstar_g, &me->mstar_list);
+      iqueue_push(&mstar->mstar_g, &me->mstar_list);
     }
 
     mstar_increase_ghost_size(mstar);
@@ -162,7 +162,7 @@ int mstar_map(struct cache_nucleus *cn, oblock_t oblock, bool write,
   struct mstar_policy *mstar = to_mstar_policy(cn);
   struct cache_nucleus *internal_policy = mstar->internal_policy;
   struct entry *internal_entry = policy_cache_lookup(internal_policy, oblock);
-  struct entry *ghost_entry = hash_lookup(&cn->ht, oblock);
+  struct entry *ghost_entry = hash_peek(&cn->ht, oblock);
 
   bool cache_hit = internal_entry != NULL;
   bool ghost_hit = ghost_entry != NULL;
@@ -210,7 +210,7 @@ void mstar_remap(struct cache_nucleus *cn, oblock_t current_oblock,
   struct hashtable *ht = &mstar->nucleus.ht;
 
   struct entry *e = hash_lookup(ht, current_oblock);
-  hash_remove(e);
+  hash_remove(ht, e);
   e->oblock = new_oblock;
   hash_insert(ht, e);
 
@@ -265,7 +265,7 @@ enum cache_nucleus_operation mstar_next_victim(struct cache_nucleus *cn,
                                                oblock_t oblock,
                                                struct entry **next_victim_p) {
   struct mstar_policy *mstar = to_mstar_policy(cn);
-  struct entry *meta_e = hash_lookup(&cn->ht, oblock);
+  struct entry *meta_e = hash_peek(&cn->ht, oblock);
   bool meta_hit = meta_e != NULL;
 
   struct cache_nucleus *internal_policy = mstar->internal_policy;
@@ -296,16 +296,19 @@ int mstar_init(struct mstar_policy *mstar, cblock_t cache_size,
   mstar->internal_policy = internal_policy;
 
   // TODO mstar meta lru queue
-  queue_init(&mstar->mstar_g);
+  iqueue_set_init(&mstar->queues, sizeof(struct mstar_entry));
+  iqueue_init(&mstar->mstar_g, &mstar->queues, struct mstar_entry,
+              mstar_list);
 
   // NOTE: set ghost_size to max (aka 90% cache size)
   mstar->ghost_size = (9u * cache_size) / 10u;
 
   epool_create(&cn->meta_pool, cache_size, struct mstar_entry, e);
-  if (!cn->meta_pool.entries_begin || !cn->meta_pool.entries) {
+  if (!cn->meta_pool.entries_begin) {
     LOG_DEBUG("epool_create for meta_pool failed");
     goto meta_epool_create_fail;
   }
+  iqueue_set_add_pool(&mstar->queues, &cn->meta_pool);
 
   if (mstar_logic_init(&mstar->logic, adaptive, cache_size)) {
     LOG_DEBUG("init_logic failed");
@@ -9,7 +9,8 @@
  */
 struct mstar_policy {
   struct cache_nucleus nucleus;
-  struct queue mstar_g;
+  struct iqueue_set queues;
+  struct iqueue mstar_g;
   cblock_t ghost_size;
   struct cache_nucleus *internal_policy;
   struct mstar_logic logic;
@@ -20,7 +21,7 @@ struct mstar_policy {
  */
 struct mstar_entry {
   struct entry e;
-  struct queue_head mstar_list;
+  struct iqueue_head mstar_list;
 };
 
 static struct mstar_policy *to_mstar_policy(struct cache_nucleus *cn) {
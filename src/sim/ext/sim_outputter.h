@@ -14,6 +14,9 @@ struct sim_outputter {
 
   uint64_t output_interval;
 
+  // prefix for printed stats, set when several policies share one run
+  const char *label;
+
   // uint64_t sampling_rate;
 
   // pointers to whatever we will interact/print from
@@ -24,33 +27,79 @@ void sim_outputter_init(struct sim_outputter *out, enum sim_output_mode mode,
                         uint64_t output_interval) {
   out->mode = mode;
   out->output_interval = output_interval;
+  out->label = NULL;
   // out->sampling_rate = sampling_rate;
 }
 
+/** Are the stats going to be printed after the access at io?
+ */
+bool sim_outputter_due(struct sim_outputter *out, int64_t io, bool complete) {
+  return complete ||
+         (out->output_interval != 0 && io % out->output_interval == 0);
+}
+
+/** Print the default stats (of one cache, or summed over several)
+ */
+void sim_outputter_print_stats(struct sim_outputter *out,
+                               struct policy_stats *stats,
+                               struct sim_stats_struct *sim_stats) {
+  if (out->label != NULL) {
+    LOG_PRINT_F(LOG_STDOUT, "%s ", out->label);
+  }
+
+  LOG_PRINT("%u %u %u %u %u %u %u %u %u %u %u", stats->hits, stats->misses,
+            stats->filters, stats->promotions, stats->demotions,
+            stats->private_stat, sim_stats->read_hits, sim_stats->read_misses,
+            sim_stats->write_hits, sim_stats->write_misses,
+            sim_stats->dirty_evicts);
+}
+
 // TODO remove io and instead use alg_w->nucleus->time?
 void sim_outputter_print(struct sim_outputter *out, struct alg_wrapper *alg_w,
                          struct sim_stats_struct *sim_stats, int64_t io,
                          bool complete) {
   struct policy_stats stats;
 
-  if (!complete && (out->output_interval == 0 || io % out->output_interval)) {
+  if (!sim_outputter_due(out, io, complete)) {
     return;
   }
 
   switch (out->mode) {
   case WATCHER:
+    if (out->label != NULL) {
+      LOG_PRINT_F(LOG_STDOUT, "%s ", out->label);
+    }
     alg_wrapper_print(alg_w);
     break;
   default:
     stats_init(&stats);
     policy_get_stats(alg_w->nucleus, &stats);
-    LOG_PRINT("%u %u %u %u %u %u %u %u %u %u %u", stats.hits, stats.misses,
-              stats.filters, stats.promotions, stats.demotions,
-              stats.private_stat, sim_stats->read_hits, sim_stats->read_misses,
-              sim_stats->write_hits, sim_stats->write_misses,
-              sim_stats->dirty_evicts);
+    sim_outputter_print_stats(out, &stats, sim_stats);
     break;
   }
 }
 
+/** Print the stats of a tenant, after the stats of the whole cache
+ *
+ * output: tenant [TENANT] [hits] [misses] [filters] [promotions] [read hits]
+ *         [read misses] [write hits] [write misses] [dirty evicts]
+ */
+void sim_outputter_print_tenant(struct sim_outputter *out, unsigned tenant,
+                                struct sim_tenant_stats *stats, int64_t io,
+                                bool complete) {
+  if (!sim_outputter_due(out, io, complete) || out->mode != DEFAULT) {
+    return;
+  }
+
+  if (out->label != NULL) {
+    LOG_PRINT_F(LOG_STDOUT, "%s ", out->label);
+  }
+
+  LOG_PRINT("tenant %u %u %u %u %u %u %u %u %u %u", tenant, stats->hits,
+            stats->misses, stats->filters, stats->promotions,
+            stats->sim.read_hits, stats->sim.read_misses,
+            stats->sim.write_hits, stats->sim.write_misses,
+            stats->sim.dirty_evicts);
+}
+
 #endif /* SIM_EXT_SIM_OUTPUTTER_H */
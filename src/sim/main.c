@@ -1,36 +1,36 @@
 #include "ext/sim_outputter.h"
-#include "kernel/hash.h"
 #include "policy_registry/policy_registry.h"
 #include "policy_registry/wrapper_registry.h"
 #include "sim_args.h"
 #include "sim_freq_count.h"
 #include "sim_hoard_count.h"
+#include "sim_instance.h"
 #include "sim_lir_hir_count.h"
 #include "sim_migration_tracker.h"
 #include "sim_options.h"
+#include "sim_pipeline.h"
 #include "sim_policy.h"
 #include "sim_recency_classifier.h"
 #include "sim_stats_struct.h"
+#include "sim_sweep.h"
+#include "sim_trace_buffer.h"
+#include "sim_volumes.h"
 #include "tools/logs.h"
 #include "tools/random.h"
+#include "trace_reader/trace_block.h"
+#include "trace_reader/trace_decompress.h"
+#include "trace_reader/trace_filter.h"
+#include "trace_reader/trace_merge.h"
+#include "trace_reader/trace_multi.h"
+#include "trace_reader/trace_parallel.h"
 #include "trace_reader/trace_reader.h"
-
-struct sim_outputter sim_outputter = {
-    .mode = DEFAULT,
-    .output_interval = 0,
-};
-
-struct sim_stats_struct sim_stats = {
-    .write_hits = 0,
-    .write_misses = 0,
-    .read_hits = 0,
-    .read_misses = 0,
-    .dirty_evicts = 0,
-};
+#include "trace_reader/trace_sampling.h"
+#include "trace_reader/trace_window.h"
 
 struct sim_options options = {
     .fp = NULL,
-    .policy_name = "",
+    .policy_names = NULL,
+    .nr_policies = 0,
     .cache_size = 0,
     .trace_name = "",
     .duration_hrs = 0,
@@ -39,8 +39,20 @@ struct sim_options options = {
     .output_mode = DEFAULT,
     .freq_count_min = 0,
     .sampling_rate = 1,
+    .presampled = false,
     .migration_delay = 0,
     .watch_str = "",
+    .sizes = NULL,
+    .nr_sizes = 0,
+    .pipeline = false,
+    .decode_threads = 1,
+    .tenants = NULL,
+    .nr_tenants = 0,
+    .per_volume = false,
+    .volume_size = NULL,
+    .volume_sizes = NULL,
+    .nr_volume_sizes = 0,
+    .block_size = 0,
 };
 
 // TODO do I add these features back in?
@@ -48,179 +60,327 @@ struct sim_options options = {
 // struct hoard_tracker h_tracker;
 // struct recency_classifier r_class;
 // struct lir_hir_tracker lh_tracker;
-struct migration_tracker m_tracker;
 
-struct random_state random_remove;
+// One simulated cache per policy given, all fed by the same trace reads
+struct sim_instance *instances;
+
+// Producer reading the trace ahead of the simulation (only with --pipeline)
+struct sim_pipeline pipeline;
+
+// Rest of the extent being sampled (only with --sampling-rate)
+struct trace_reader_result sampled_extent;
 
-bool remove_now(int time) {
-  if (options.remove_rate == 0) {
-    return false;
+void sim_prep(int argc, char **argv) {
+  options.fp = stdin;
+
+  handle_args(argc, argv, &options);
+
+  // several trace files (or tenants) are opened as they are read, by
+  // trace_multi (or trace_merge)
+  if (options.files.nr_paths > 1 || options.nr_tenants > 0) {
+    options.fp = NULL;
+    return;
   }
 
-  if (options.remove_rate > 0) {
-    return time % options.remove_rate == 0;
+  options.fp = trace_decompress_open(options.fp);
+  if (!options.fp) {
+    LOG_FATAL("Unable to open the trace");
   }
+}
+
+struct trace_reader *trace_prep() {
+  trace_reader_create_f create = find_trace_reader(options.trace_name);
+  bool window = trace_window_used(&options.window);
+  // a window applies the duration itself, from the start of the window
+  unsigned duration_hrs = window ? 0 : options.duration_hrs;
+  struct trace_reader *reader;
 
-  return random_int(&random_remove) % (-options.remove_rate) == 0;
+  if (options.nr_tenants > 0) {
+    reader = trace_merge_create(options.tenants, options.nr_tenants,
+                                options.trace_name, duration_hrs,
+                                options.decode_threads, &options.filter,
+                                options.block_size);
+  } else if (options.files.nr_paths > 1) {
+    reader = trace_multi_create(create, &options.files, duration_hrs,
+                                options.decode_threads);
+  } else {
+    reader = trace_parallel_create(create, options.fp, duration_hrs,
+                                   options.decode_threads);
+  }
+  if (reader && window) {
+    reader = trace_window_create(reader, &options.window, options.duration_hrs);
+  }
+  // the requests of the tenants are filtered before being merged
+  if (reader && trace_filter_used(&options.filter) &&
+      options.nr_tenants == 0) {
+    reader = trace_filter_create(reader, &options.filter);
+  }
+  // the tenants are mapped onto cache blocks before being merged
+  if (reader && options.block_size > 0 && options.nr_tenants == 0) {
+    reader = trace_block_create(reader, options.block_size);
+  }
+  if (!reader) {
+    LOG_FATAL("Unable to create the trace reader");
+  }
+  options.block_stride = reader->block_stride;
+
+  // a sampled trace is simulated at the sampling rate it was sampled at
+  if (reader->sampling_rate > 1) {
+    if (options.sampling_rate != 1 &&
+        options.sampling_rate != reader->sampling_rate) {
+      LOG_FATAL("The trace was sampled at a sampling rate of %lu",
+                reader->sampling_rate);
+    }
+    options.sampling_rate = reader->sampling_rate;
+    options.presampled = true;
+  }
+  return reader;
 }
 
-void sim_prep(int argc, char **argv) {
+void policy_prep() {
   unsigned i;
 
-  options.fp = stdin;
+  instances = mem_alloc(sizeof(*instances) * options.nr_policies);
+  if (!instances) {
+    LOG_FATAL("Unable to allocate simulation instances");
+  }
 
-  handle_args(argc, argv, &options);
+  for (i = 0; i < options.nr_policies; i++) {
+    // only label the output when there's more than one policy, so that the
+    // single policy output stays as it always has been
+    char *label = options.nr_policies > 1 ? options.policy_names[i] : NULL;
 
-  m_tracker.delay = options.migration_delay;
-  if (options.migration_delay > 0 &&
-      migration_tracker_init(&m_tracker, options.migration_delay)) {
-    LOG_FATAL("unable to allocate for migration_tracker");
+    if (sim_instance_init(&instances[i], options.policy_names[i],
+                          options.cache_size / options.sampling_rate,
+                          options.metadata_size / options.sampling_rate,
+                          &options, label)) {
+      LOG_FATAL("Base policy wrapper creation failed");
+    }
   }
+}
+
+/** Read the next extent to simulate, applying the sampling filter
+ *
+ * Sampling is decided per access, so with sampling every extent is split into
+ * the single accesses that pass the filter (see trace_sampling.h). A trace
+ * that was sampled when written is only made up of those already.
+ */
+int sim_read(struct trace_reader *reader,
+             struct trace_reader_result *read_result) {
+  int r;
+
+  if (options.sampling_rate == 1 || options.presampled) {
+    return reader->read(reader, read_result);
+  } else {
+    unsigned T = trace_sampling_threshold(options.sampling_rate);
+
+    do {
+      while (sampled_extent.nr_blocks == 0) {
+        r = reader->read(reader, &sampled_extent);
+        if (r) {
+          return r;
+        }
+      }
+
+      read_result->oblock = trace_sampling_hash(sampled_extent.oblock);
+      read_result->nr_blocks = 1;
+      read_result->write = sampled_extent.write;
 
-  // TODO rename window_size to output_interval?
-  uint64_t output_interval = options.window_size;
-  sim_outputter_init(&sim_outputter, options.output_mode, output_interval);
+      sampled_extent.oblock += options.block_stride;
+      --sampled_extent.nr_blocks;
+    } while (read_result->oblock > T);
 
-  // TODO make sure this is gonna be okay to do
-  prandom_init_seed(&random_remove, 123);
+    // sampled accesses stay in the range of their tenant (see trace_merge.h)
+    if (options.nr_tenants > 0) {
+      read_result->oblock |= (oblock_t)trace_merge_tenant(sampled_extent.oblock)
+                             << TRACE_MERGE_TENANT_SHIFT;
+    }
+  }
+
+  return 0;
 }
 
-struct trace_reader *trace_prep() {
-  struct trace_reader *reader = find_trace_reader(options.trace_name);
-  reader->init(options.fp, options.duration_hrs);
-  return reader;
+void pipeline_prep(struct trace_reader *reader) {
+  if (sim_pipeline_init(&pipeline, reader, sim_read)) {
+    LOG_FATAL("Unable to start the trace pipeline");
+  }
 }
 
-struct alg_wrapper *policy_prep() {
-  struct alg_wrapper *alg_w = create_wrapper(
-      options.policy_name, options.cache_size / options.sampling_rate,
-      options.metadata_size / options.sampling_rate);
-  if (!alg_w) {
-    LOG_FATAL("Base policy wrapper creation failed");
+/** Get the next extent to simulate, either from the pipeline or by reading
+ * the trace directly
+ */
+int sim_next(struct trace_reader *reader,
+             struct trace_reader_result *read_result) {
+  if (options.pipeline) {
+    return sim_pipeline_read(&pipeline, read_result);
   }
-  alg_wrapper_init(alg_w, options.watch_str);
-  return alg_w;
+  return sim_read(reader, read_result);
 }
 
-void sim_map(struct cache_nucleus *bp, struct trace_reader_result *read_result,
-             struct cache_nucleus_result *result) {
-  struct entry *e = policy_cache_lookup(bp, read_result->oblock);
-  if (e != NULL && e->migrating) {
-    result->op == CACHE_NUCLEUS_HIT;
-    if (read_result->write) {
-      ++sim_stats.write_hits;
-    } else {
-      ++sim_stats.read_hits;
-    }
-    return;
+void sim_print(unsigned time, bool complete) {
+  unsigned i;
+
+  for (i = 0; i < options.nr_policies; i++) {
+    sim_instance_print(&instances[i], time, complete);
   }
+}
 
-  if (sim_policy_map(bp, read_result->oblock, read_result->write, result)) {
-    LOG_FATAL("Error occurred while processing entry");
+/** Number of accesses, starting with the one at time, up to (and including)
+ * the next one after which stats are printed
+ */
+block_t sim_until_print(unsigned time, block_t nr_blocks) {
+  block_t left;
+
+  if (options.window_size == 0) {
+    return nr_blocks;
   }
 
-  if (result->op == CACHE_NUCLEUS_HIT) {
-    if (read_result->write) {
-      ++sim_stats.write_hits;
-    } else {
-      ++sim_stats.read_hits;
-    }
-  } else {
-    if (read_result->write) {
-      ++sim_stats.write_misses;
-    } else {
-      ++sim_stats.read_misses;
+  left = options.window_size - (time - 1) % options.window_size;
+  return nr_blocks < left ? nr_blocks : left;
+}
+
+/** Simulate an extent, starting at time, printing stats whenever the output
+ * interval is reached within it
+ */
+void sim_access(struct trace_reader_result *read_result, unsigned *time) {
+  struct trace_reader_result chunk = *read_result;
+  block_t left = read_result->nr_blocks;
+  unsigned i;
+
+  while (left > 0) {
+    chunk.nr_blocks = sim_until_print(*time, left);
+
+    for (i = 0; i < options.nr_policies; i++) {
+      sim_instance_access(&instances[i], &options, &chunk, *time);
     }
+
+    *time += chunk.nr_blocks;
+    sim_print(*time - 1, false);
+
+    chunk.oblock += chunk.nr_blocks * options.block_stride;
+    left -= chunk.nr_blocks;
   }
+}
 
-  if (result->dirty_eviction) {
-    ++sim_stats.dirty_evicts;
+void sim_exit(struct trace_reader *reader) {
+  unsigned i;
+
+  for (i = 0; i < options.nr_policies; i++) {
+    sim_instance_exit(&instances[i]);
+  }
+  mem_free(instances);
+  if (options.pipeline) {
+    sim_pipeline_exit(&pipeline);
+  }
+  trace_reader_exit(reader);
+  if (options.fp) {
+    fclose(options.fp);
   }
 }
 
-int sim_access(struct trace_reader *reader, struct cache_nucleus *bp,
-               unsigned time) {
-  struct cache_nucleus_result result = {0};
+/** Decode the whole trace once and simulate every requested cache size over
+ * it in parallel
+ */
+void sim_sweep(struct trace_reader *reader) {
+  struct sim_trace_buffer tb;
   struct trace_reader_result read_result = {0};
-  int r;
-  int i;
 
-  if (options.sampling_rate == 1) {
-    r = reader->read(&read_result);
-    if (r) {
-      return r;
+  sim_trace_buffer_init(&tb);
+  while (!sim_next(reader, &read_result)) {
+    if (sim_trace_buffer_push(&tb, &read_result)) {
+      LOG_FATAL("Unable to allocate memory for the decoded trace");
     }
-  } else {
-    unsigned P = (2 << 30);
-    unsigned T = P / options.sampling_rate;
-
-    do {
-      r = reader->read(&read_result);
-      if (r) {
-        return r;
-      }
-      read_result.oblock = hash_64(read_result.oblock, ffs(P) - 1);
-    } while (read_result.oblock > T);
+  }
+  if (options.pipeline) {
+    sim_pipeline_exit(&pipeline);
   }
 
-  sim_policy_set_time(bp, time);
-  sim_map(bp, &read_result, &result);
+  sim_sweep_run(&options, &tb);
 
-  if (options.migration_delay == 0) {
-    if (result.op == CACHE_NUCLEUS_NEW || result.op == CACHE_NUCLEUS_REPLACE) {
-      sim_policy_migrated(bp, read_result.oblock);
-    }
-  } else {
-    oblock_t migrated;
-    if (migration_next(&m_tracker, time, &migrated)) {
-      struct entry *e = policy_cache_lookup(bp, migrated);
-      if (e != NULL) {
-        sim_policy_migrated(bp, migrated);
-      }
-    }
+  sim_trace_buffer_exit(&tb);
+  trace_reader_exit(reader);
+  if (options.fp) {
+    fclose(options.fp);
+  }
+}
 
-    if (result.op == CACHE_NUCLEUS_NEW || result.op == CACHE_NUCLEUS_REPLACE) {
-      migration_add(&m_tracker, time, read_result.oblock);
+/** Decode the whole trace once, splitting it by volume, and simulate every
+ * volume with its own caches in parallel
+ *
+ * Requests are read whole to know their volume, so sampling is applied here
+ * rather than by sim_read().
+ */
+void sim_per_volume(struct trace_reader *reader) {
+  struct sim_volumes vs;
+  struct trace_request request;
+  struct trace_reader_result read_result;
+  unsigned T = trace_sampling_threshold(options.sampling_rate);
+  block_t i;
+
+  sim_volumes_init(&vs, &options);
+  while (!reader->read_request(reader, &request)) {
+    read_result.oblock = request.oblock;
+    read_result.nr_blocks = request.nr_blocks;
+    read_result.write = request.write;
+
+    if (options.sampling_rate == 1 || options.presampled) {
+      if (sim_volumes_push(&vs, request.volume, &read_result)) {
+        LOG_FATAL("Unable to allocate memory for the decoded trace");
+      }
+      continue;
     }
-  }
 
-  if (remove_now(time)) {
-    struct entry *e = policy_cache_lookup(bp, read_result.oblock);
-    if (e != NULL) {
-      migration_remove(&m_tracker, read_result.oblock);
-      policy_remove(bp, read_result.oblock, true);
+    for (i = 0; i < request.nr_blocks; i++) {
+      read_result.oblock = trace_sampling_hash(request.oblock);
+      read_result.nr_blocks = 1;
+      request.oblock += options.block_stride;
+      if (read_result.oblock <= T &&
+          sim_volumes_push(&vs, request.volume, &read_result)) {
+        LOG_FATAL("Unable to allocate memory for the decoded trace");
+      }
     }
   }
 
-  return 0;
-}
+  sim_volumes_run(&vs);
 
-void sim_exit(struct cache_nucleus *bp) {
-  sim_policy_destroy(bp);
-  fclose(options.fp);
+  sim_volumes_exit(&vs);
+  trace_reader_exit(reader);
+  if (options.fp) {
+    fclose(options.fp);
+  }
 }
 
 int main(int argc, char **argv) {
   struct trace_reader *reader;
-  struct alg_wrapper *alg_w;
-  struct cache_nucleus *bp;
+  struct trace_reader_result read_result = {0};
 
   unsigned time = 1;
 
   sim_prep(argc, argv);
   reader = trace_prep();
-  alg_w = policy_prep();
-  bp = alg_w->nucleus;
+  if (options.pipeline) {
+    pipeline_prep(reader);
+  }
+
+  if (options.per_volume) {
+    sim_per_volume(reader);
+    return 0;
+  }
+
+  if (options.nr_sizes > 0) {
+    sim_sweep(reader);
+    return 0;
+  }
 
-  while (!sim_access(reader, bp, time)) {
-    sim_outputter_print(&sim_outputter, alg_w, &sim_stats, time, false);
+  policy_prep();
 
-    ++time;
+  while (!sim_next(reader, &read_result)) {
+    sim_access(&read_result, &time);
   }
 
-  sim_outputter_print(&sim_outputter, alg_w, &sim_stats, time, true);
+  sim_print(time, true);
 
-  sim_exit(bp);
+  sim_exit(reader);
 
   return 0;
 }
@@ -2,19 +2,86 @@
 #define SIM_SIM_ARGS_H
 
 #include "sim_options.h"
+#include "trace_reader/trace_block.h"
+#include "trace_reader/trace_multi.h"
 #include "trace_reader/trace_reader.h"
 #include <ctype.h>
 #include <getopt.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 
+/** Check that a cache size is a positive number (of entries, or a fraction of
+ * the working set size below 1)
+ */
+void handle_size(char *size) {
+  double value;
+  char end;
+
+  if (sscanf(size, "%lf%c", &value, &end) != 1 || value <= 0) {
+    LOG_FATAL("Cache size given was not a positive number `%s`", size);
+  }
+}
+
+/** Split the --sizes argument into its comma separated sizes
+ */
+void handle_sizes(char *arg, struct sim_options *options) {
+  char *sizes = strdup(arg);
+  char *size;
+  unsigned i;
+
+  LOG_ASSERT(sizes != NULL);
+
+  options->nr_sizes = 1;
+  for (i = 0; sizes[i] != '\0'; i++) {
+    if (sizes[i] == ',') {
+      ++options->nr_sizes;
+    }
+  }
+
+  options->sizes = mem_alloc(sizeof(*options->sizes) * options->nr_sizes);
+  LOG_ASSERT(options->sizes != NULL);
+
+  for (i = 0, size = strtok(sizes, ","); size != NULL;
+       size = strtok(NULL, ",")) {
+    handle_size(size);
+    options->sizes[i++] = size;
+  }
+
+  if (i != options->nr_sizes) {
+    LOG_FATAL("Empty cache size in `%s`", arg);
+  }
+}
+
+/** Add a --volume-size argument, VOLUME=SIZE
+ */
+void handle_volume_size(char *arg, struct sim_options *options) {
+  char *size = strrchr(arg, '=');
+
+  if (size == NULL || size == arg) {
+    LOG_FATAL("Volume size given was not VOLUME=SIZE `%s`", arg);
+  }
+  handle_size(size + 1);
+
+  options->volume_sizes =
+      realloc(options->volume_sizes, sizeof(*options->volume_sizes) *
+                                         (options->nr_volume_sizes + 1));
+  LOG_ASSERT(options->volume_sizes != NULL);
+  options->volume_sizes[options->nr_volume_sizes++] = arg;
+}
+
 void handle_optional_args(int argc, char **argv, struct sim_options *options) {
   char c;
 
   static struct option long_options[] = {
       {"file", required_argument, 0, 'f'},
+      {"manifest", required_argument, 0, '+'},
+      {"tenant", required_argument, 0, '%'},
       {"help", no_argument, 0, '`'},
       {"duration", required_argument, 0, 'd'},
+      {"start", required_argument, 0, '@'},
+      {"skip-ios", required_argument, 0, '['},
+      {"max-ios", required_argument, 0, ']'},
       {"metadata-size", required_argument, 0, 'm'},
       {"window-size", required_argument, 0, 'w'},
       {"freq-count", required_argument, 0, 'c'},
@@ -25,6 +92,18 @@ void handle_optional_args(int argc, char **argv, struct sim_options *options) {
       {"migration-delay", required_argument, 0, ','},
       {"remove-rate", required_argument, 0, '<'},
       {"watch", required_argument, 0, '>'},
+      {"sizes", required_argument, 0, '^'},
+      {"pipeline", no_argument, 0, '|'},
+      {"decode-threads", required_argument, 0, '#'},
+      {"block-size", required_argument, 0, '*'},
+      {"per-volume", no_argument, 0, '='},
+      {"volume-size", required_argument, 0, '~'},
+      {"reads-only", no_argument, 0, '{'},
+      {"writes-only", no_argument, 0, '}'},
+      {"lba-range", required_argument, 0, '('},
+      {"time-window", required_argument, 0, ')'},
+      {"pid", required_argument, 0, '$'},
+      {"process", required_argument, 0, '&'},
       {0, 0, 0, 0},
   };
   int option_index = 0;
@@ -34,27 +113,78 @@ void handle_optional_args(int argc, char **argv, struct sim_options *options) {
                           &option_index)) != -1) {
     switch (c) {
     case 'f':
-      options->fp = fopen(optarg, "r");
-      if (!options->fp) {
-        LOG_FATAL("File %s could not be opened. Errno = %d", optarg, errno);
-      }
+      trace_files_add(&options->files, optarg);
+      break;
+    case '+':
+      trace_files_add_manifest(&options->files, optarg);
+      break;
+    case '%':
+      options->tenants =
+          realloc(options->tenants,
+                  sizeof(*options->tenants) * (options->nr_tenants + 1));
+      LOG_ASSERT(options->tenants != NULL);
+      options->tenants[options->nr_tenants++] = optarg;
       break;
     case '`':
       LOG_PRINT(
           "Usage: ./cache-sim [ALGORITHM] [CACHE_SIZE] [TRACE_FORMAT] "
           "[OPTION]...\n"
+          "  or:  ./cache-sim [ALGORITHM] [TRACE_FORMAT] --sizes [SIZES] "
+          "[OPTION]...\n"
           "Simulate a cache of size CACHE_SIZE, running ALGORITHM over a "
           "TRACE_FORMAT.\n\n"
-          "  ALGORITHM        caching algorithm (such as lru)\n"
+          "  ALGORITHM        caching algorithm (such as lru), or a comma\n"
+          "                   separated list of them (such as lru,fomo_arc)\n"
+          "                   to simulate them all over a single pass of\n"
+          "                   the trace\n"
           "  CACHE_SIZE       size of the cache in entries\n"
           "  TRACE_FORMAT     format of the trace being processed\n\n"
           "With no -f or --file OPTION, read standard input.\n\n"
-          "  -f, --file       file of TRACE_TYPE to open and simulate for\n"
+          "  -f, --file       file of TRACE_TYPE to open and simulate for.\n"
+          "                   Given several times, the files are read one\n"
+          "                   after the other as a single trace\n"
+          "      --manifest   file listing (one per line) trace files to\n"
+          "                   read as with -f\n"
+          "      --tenant     [FORMAT:]FILE, trace of a tenant of a cache\n"
+          "                   shared by several tenants (in TRACE_FORMAT\n"
+          "                   unless FORMAT is given). Given several times,\n"
+          "                   the traces are replayed at the same time,\n"
+          "                   each in its own range of blocks, and stats\n"
+          "                   are also printed per tenant\n"
+          "                   output: tenant [TENANT] [hits] [misses]\n"
+          "                   [filters] [promotions] [read hits]\n"
+          "                   [read misses] [write hits] [write misses]\n"
+          "                   [dirty evicts]\n"
           "  -d, --duration   amount of the trace, based on time, that\n"
           "                   is going to be processed\n"
           "                   Supported time designations:\n"
           "                     XXh   XX hours\n"
           "                     XXd   XX days\n"
+          "      --start      start the trace this long (as with --duration)\n"
+          "                   after its first request\n"
+          "      --skip-ios   skip the given number of requests from the\n"
+          "                   start of the trace\n"
+          "      --max-ios    simulate at most the given number of requests\n"
+          "      --block-size map the accesses of the trace onto cache\n"
+          "                   blocks of the given size in bytes (or KiB\n"
+          "                   with K, or MiB with M), accessing each cache\n"
+          "                   block a request touches once\n"
+          "      --reads-only only simulate the reads of the trace\n"
+          "      --writes-only\n"
+          "                   only simulate the writes of the trace\n"
+          "      --lba-range  FIRST-LAST, only simulate the accesses to the\n"
+          "                   addresses from FIRST to LAST (in the\n"
+          "                   addresses of the trace, such as sectors for\n"
+          "                   fiu or bytes for msr)\n"
+          "      --time-window\n"
+          "                   FROM-TO, only simulate the requests from FROM\n"
+          "                   to TO after the first request (in seconds,\n"
+          "                   or minutes, hours or days with m, h or d,\n"
+          "                   such as 30m-2h)\n"
+          "      --pid        only simulate the requests of the process of\n"
+          "                   the given pid (fiu and visa)\n"
+          "      --process    only simulate the requests of the processes\n"
+          "                   of the given name (fiu and visa)\n"
           "  -m, --metadata-size\n"
           "                   set the size of the metadata for the algorithm\n"
           "                   should the algorithm support it\n"
@@ -86,6 +216,29 @@ void handle_optional_args(int argc, char **argv, struct sim_options *options) {
           "                   If = 0, it will be disabled.\n"
           "                   If < 0, random removal will be enabled,\n"
           "                   where there is a 1/x chance to remove.\n"
+          "      --sizes      comma separated list of cache sizes to\n"
+          "                   simulate in parallel (one thread per size)\n"
+          "                   over a single in-memory copy of the trace,\n"
+          "                   replacing CACHE_SIZE. Sizes below 1 are\n"
+          "                   fractions of the trace's working set size.\n"
+          "                   output: [SIZE] [ENTRIES] [ALGORITHM] [stats]\n"
+          "      --pipeline   read (and sample) the trace on a separate\n"
+          "                   thread, ahead of the simulation\n"
+          "      --per-volume simulate a cache of its own for every volume\n"
+          "                   of the trace (msr host and disk), in\n"
+          "                   parallel (one thread per core). CACHE_SIZE\n"
+          "                   is the size of each cache, where sizes below\n"
+          "                   1 are fractions of the volume's working set\n"
+          "                   size. Stats are printed per volume, then\n"
+          "                   summed over every volume\n"
+          "                   output: [VOLUME] [ENTRIES] [ALGORITHM] [stats]\n"
+          "                   then: total [ENTRIES] [ALGORITHM] [stats]\n"
+          "      --volume-size\n"
+          "                   VOLUME=SIZE, size of the cache of VOLUME\n"
+          "                   (such as hm_0) with --per-volume\n"
+          "      --decode-threads\n"
+          "                   decode the trace file on the given number of\n"
+          "                   threads, in chunks (basic, fiu and msr)\n"
           "      --help       display this help and exit\n\n"
           "Examples:\n"
           "  ./cache-sim lru 10 basic\n"
@@ -93,7 +246,23 @@ void handle_optional_args(int argc, char **argv, struct sim_options *options) {
           "      basic trace format\n"
           "  ./cache-sim lru 10 basic -f example.trace\n"
           "      Run lru cache (of size 10 entries) with example.trace (which\n"
-          "      is a basic trace format)\n\n");
+          "      is a basic trace format)\n"
+          "  ./cache-sim lru 10 msr -f day1.trace -f day2.trace\n"
+          "      Run lru cache (of size 10 entries) over day1.trace followed\n"
+          "      by day2.trace (which are msr trace formats)\n"
+          "  ./cache-sim lru,arc,fomo_arc 10 basic -f example.trace\n"
+          "      Run lru, arc and fomo_arc caches (each of size 10 entries)\n"
+          "      side by side over example.trace, printing one line of\n"
+          "      stats per algorithm, prefixed by its name\n"
+          "  ./cache-sim arc 1000 msr --tenant a.trace --tenant fiu:b.trace\n"
+          "      Run an arc cache (of size 1000 entries) shared by the\n"
+          "      msr trace a.trace and the fiu trace b.trace\n"
+          "  ./cache-sim lru,arc msr -f example.trace --sizes 0.01,0.1,1000\n"
+          "      Run lru and arc caches of 1%% and 10%% of the working set\n"
+          "      size and of 1000 entries over example.trace\n"
+          "  ./cache-sim lru 0.1 msr -f example.trace --per-volume\n"
+          "      Run an lru cache of 10%% of the working set size of each\n"
+          "      volume of example.trace\n\n");
       exit(0);
       break;
     case 'd':
@@ -128,6 +297,68 @@ void handle_optional_args(int argc, char **argv, struct sim_options *options) {
       options->watch_str = optarg;
       options->output_mode = WATCHER;
       break;
+    case '^':
+      handle_sizes(optarg, options);
+      break;
+    case '|':
+      options->pipeline = true;
+      break;
+    case '*':
+      if (trace_block_parse_size(optarg, &options->block_size)) {
+        LOG_FATAL("Block size given was not a size in bytes `%s`", optarg);
+      }
+      break;
+    case '=':
+      options->per_volume = true;
+      break;
+    case '~':
+      handle_volume_size(optarg, options);
+      break;
+    case '#':
+      sscanf(optarg, "%u", &options->decode_threads);
+      LOG_ASSERT(options->decode_threads > 0u);
+      break;
+    case '@':
+      sscanf(optarg, "%u%c", &options->window.start_hrs, &duration_time);
+      switch (duration_time) {
+      case 'd':
+        options->window.start_hrs *= 24;
+      case 'h':
+        break;
+      default:
+        LOG_FATAL("Unknown start time %c", duration_time);
+      }
+      break;
+    case '[':
+      sscanf(optarg, "%lu", &options->window.skip_ios);
+      break;
+    case ']':
+      sscanf(optarg, "%lu", &options->window.max_ios);
+      break;
+    case '{':
+      options->filter.reads_only = true;
+      break;
+    case '}':
+      options->filter.writes_only = true;
+      break;
+    case '(':
+      if (trace_filter_parse_lba_range(&options->filter, optarg)) {
+        LOG_FATAL("Address range given was not FIRST-LAST `%s`", optarg);
+      }
+      break;
+    case ')':
+      if (trace_filter_parse_time_window(&options->filter, optarg)) {
+        LOG_FATAL("Time window given was not FROM-TO `%s`", optarg);
+      }
+      break;
+    case '$':
+      sscanf(optarg, "%u", &options->filter.pid_value);
+      options->filter.pid = true;
+      break;
+    case '&':
+      options->filter.process_value = trace_process_id(optarg, strlen(optarg));
+      options->filter.process = true;
+      break;
     case '?':
       if (isprint(optopt)) {
         LOG_FATAL("Unknown option `-%c`", optopt);
@@ -138,19 +369,121 @@ void handle_optional_args(int argc, char **argv, struct sim_options *options) {
       LOG_FATAL("Should've expected the unknown unknown");
     }
   }
+
+  if (options->nr_tenants > 0 && options->files.nr_paths > 0) {
+    LOG_FATAL("--tenant gives the traces to simulate, instead of -f");
+  }
+
+  // a single file is read as it is, several are read through trace_multi
+  if (options->files.nr_paths == 1) {
+    options->fp = fopen(options->files.paths[0], "r");
+    if (!options->fp) {
+      LOG_FATAL("File %s could not be opened. Errno = %d",
+                options->files.paths[0], errno);
+    }
+  }
 }
 
-void handle_required_args(int argc, char **argv, struct sim_options *options) {
+/** Split the ALGORITHM argument into its comma separated policy names
+ */
+void handle_policy_names(char *arg, struct sim_options *options) {
+  char *names = strdup(arg);
+  char *name;
+  unsigned i;
+
+  LOG_ASSERT(names != NULL);
+
+  options->nr_policies = 1;
+  for (i = 0; names[i] != '\0'; i++) {
+    if (names[i] == ',') {
+      ++options->nr_policies;
+    }
+  }
+
+  options->policy_names =
+      mem_alloc(sizeof(*options->policy_names) * options->nr_policies);
+  LOG_ASSERT(options->policy_names != NULL);
+
+  for (i = 0, name = strtok(names, ","); name != NULL;
+       name = strtok(NULL, ",")) {
+    if (find_policy(name) == NULL) {
+      LOG_FATAL("Unknown caching algorithm %s", name);
+    }
+    options->policy_names[i++] = name;
+  }
+
+  if (i != options->nr_policies) {
+    LOG_FATAL("Empty caching algorithm name in `%s`", arg);
+  }
+}
+
+/** Required arguments when sweeping over several cache sizes (--sizes),
+ * where CACHE_SIZE is not given
+ */
+void handle_sweep_required_args(int argc, char **argv,
+                                struct sim_options *options) {
+  if (argc < 2) {
+    LOG_FATAL("Missing non-optional arguments\n"
+              "Try 'cache-sim --help' for more information.");
+  }
+
+  if (options->window_size != 0 || options->output_mode != DEFAULT) {
+    LOG_FATAL("--sizes only supports printing the stats when the run ends");
+  }
+
+  handle_policy_names(argv[0], options);
+
+  options->trace_name = argv[1];
+  if (!find_trace_reader(options->trace_name)) {
+    LOG_FATAL("Unknown trace type %s", options->trace_name);
+  }
+}
+
+void handle_per_volume_required_args(int argc, char **argv,
+                                     struct sim_options *options) {
   if (argc < 3) {
     LOG_FATAL("Missing non-optional arguments\n"
               "Try 'cache-sim --help' for more information.");
   }
 
-  options->policy_name = argv[0];
-  if (find_policy(options->policy_name) == NULL) {
-    LOG_FATAL("Unknown caching algorithm %s", options->policy_name);
+  if (options->window_size != 0 || options->output_mode != DEFAULT) {
+    LOG_FATAL("--per-volume only supports printing the stats when the run "
+              "ends");
+  }
+  if (options->nr_sizes > 0 || options->nr_tenants > 0 || options->pipeline) {
+    LOG_FATAL("--per-volume can't be used with --sizes, --tenant or "
+              "--pipeline");
+  }
+
+  handle_policy_names(argv[0], options);
+
+  handle_size(argv[1]);
+  options->volume_size = argv[1];
+
+  options->trace_name = argv[2];
+  if (!find_trace_reader(options->trace_name)) {
+    LOG_FATAL("Unknown trace type %s", options->trace_name);
+  }
+}
+
+void handle_required_args(int argc, char **argv, struct sim_options *options) {
+  if (options->per_volume) {
+    handle_per_volume_required_args(argc, argv, options);
+    return;
+  }
+
+  if (options->nr_sizes > 0) {
+    handle_sweep_required_args(argc, argv, options);
+    return;
   }
 
+  if (argc < 3) {
+    LOG_FATAL("Missing non-optional arguments\n"
+              "Try 'cache-sim --help' for more information.");
+  }
+
+  handle_policy_names(argv[0], options);
+
   if (sscanf(argv[1], "%u", &options->cache_size) != 1) {
     LOG_FATAL("Cache size given was not a number `%s`", argv[1]);
   }
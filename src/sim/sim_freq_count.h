@@ -48,7 +48,7 @@ static void freq_tracker_update(struct freq_tracker *f_tracker, oblock_t oblock,
 
   case CACHE_NUCLEUS_REPLACE:
     e = hash_lookup(&f_tracker->ht, result->old_oblock);
-    hash_remove(e);
+    hash_remove(&f_tracker->ht, e);
     free_entry(&f_tracker->cache_pool, e);
 
   case CACHE_NUCLEUS_NEW:
@@ -80,7 +80,7 @@ static int freq_tracker_init(struct freq_tracker *f_tracker,
 
   epool_create(&f_tracker->cache_pool, cache_size, struct freq_tracker_entry,
                e);
-  if (!f_tracker->cache_pool.entries_begin || !f_tracker->cache_pool.entries) {
+  if (!f_tracker->cache_pool.entries_begin) {
     LOG_DEBUG("epool_create for cache_pool failed");
     r = -ENOSPC;
     goto cache_epool_create_fail;
@@ -5,11 +5,11 @@
 #include "common.h"
 #include "entry.h"
 #include "tools/hashtable.h"
-#include "tools/queue.h"
+#include "tools/iqueue.h"
 
 struct hoard_tracker_entry {
   struct entry e;
-  struct queue_head list;
+  struct iqueue_head list;
   unsigned freq;
   bool in_cache;
 };
@@ -17,7 +17,8 @@ struct hoard_tracker_entry {
 struct hoard_tracker {
   struct hashtable ht;
   struct entry_pool entry_pool;
-  struct queue q;
+  struct iqueue_set queues;
+  struct iqueue q;
   unsigned count;
   cblock_t cache_size;
 };
@@ -36,7 +37,7 @@ static void hoard_tracker_update(struct hoard_tracker *h_tracker,
                                  struct cache_nucleus_result *result) {
   struct hoard_tracker_entry *he;
   struct entry *e;
-  struct queue *q = &h_tracker->q;
+  struct iqueue *q = &h_tracker->q;
 
   e = hash_lookup(&h_tracker->ht, oblock);
 
@@ -50,14 +51,14 @@ static void hoard_tracker_update(struct hoard_tracker *h_tracker,
     LOG_ASSERT(e != NULL);
     he = to_hoard_tracker_entry(e);
     LOG_ASSERT(he->in_cache);
-    if (!in_queue(q, &he->list)) {
+    if (!in_iqueue(q, &he->list)) {
       if (he->freq > 1) {
         --h_tracker->count;
       }
     } else {
-      queue_remove(&he->list);
+      iqueue_remove(&h_tracker->queues, &he->list);
     }
-    queue_push(&h_tracker->q, &he->list);
+    iqueue_push(&h_tracker->q, &he->list);
     ++he->freq;
     break;
   case CACHE_NUCLEUS_FILTER:
@@ -72,11 +73,11 @@ static void hoard_tracker_update(struct hoard_tracker *h_tracker,
       hash_insert(&h_tracker->ht, e);
     } else {
       he = to_hoard_tracker_entry(e);
-      if (in_queue(q, &he->list)) {
-        queue_remove(&he->list);
+      if (in_iqueue(q, &he->list)) {
+        iqueue_remove(&h_tracker->queues, &he->list);
       }
     }
-    queue_push(q, &he->list);
+    iqueue_push(q, &he->list);
     break;
   case CACHE_NUCLEUS_REPLACE:
     // mark evicted not in cache, free entry if not in queue
@@ -85,11 +86,11 @@ static void hoard_tracker_update(struct hoard_tracker *h_tracker,
       struct hoard_tracker_entry *evicted_he;
       LOG_ASSERT(evicted != NULL);
       evicted_he = to_hoard_tracker_entry(evicted);
-      if (!in_queue(q, &evicted_he->list)) {
+      if (!in_iqueue(q, &evicted_he->list)) {
         if (evicted_he->freq > 1) {
           --h_tracker->count;
         }
-        hash_remove(evicted);
+        hash_remove(&h_tracker->ht, evicted);
         free_entry(&h_tracker->entry_pool, evicted);
       } else {
         evicted_he->in_cache = false;
@@ -99,8 +100,8 @@ static void hoard_tracker_update(struct hoard_tracker *h_tracker,
   case CACHE_NUCLEUS_NEW:
     if (e != NULL) {
       he = to_hoard_tracker_entry(e);
-      LOG_ASSERT(in_queue(q, &he->list));
-      queue_remove(&he->list);
+      LOG_ASSERT(in_iqueue(q, &he->list));
+      iqueue_remove(&h_tracker->queues, &he->list);
     } else {
       e = alloc_entry(&h_tracker->entry_pool);
       he = to_hoard_tracker_entry(e);
@@ -109,13 +110,13 @@ static void hoard_tracker_update(struct hoard_tracker *h_tracker,
     }
     he->freq = 1;
     he->in_cache = true;
-    queue_push(q, &he->list);
+    iqueue_push(q, &he->list);
     break;
   }
 
   // evict from queue
-  if (queue_length(q) > 2 * h_tracker->cache_size) {
-    struct queue_head *e_qh = queue_pop(q);
+  if (iqueue_length(q) > 2 * h_tracker->cache_size) {
+    struct iqueue_head *e_qh = iqueue_pop(q);
     struct hoard_tracker_entry *e_he =
         container_of(e_qh, struct hoard_tracker_entry, list);
     if (e_he->in_cache) {
@@ -123,7 +124,7 @@ static void hoard_tracker_update(struct hoard_tracker *h_tracker,
         ++h_tracker->count;
       }
     } else {
-      hash_remove(&e_he->e);
+      hash_remove(&h_tracker->ht, &e_he->e);
       free_entry(&h_tracker->entry_pool, &e_he->e);
     }
   }
@@ -145,14 +146,17 @@ static int hoard_tracker_init(struct hoard_tracker *h_tracker,
 
   epool_create(&h_tracker->entry_pool, 3 * cache_size + 1,
                struct hoard_tracker_entry, e);
-  if (!h_tracker->entry_pool.entries_begin || !h_tracker->entry_pool.entries) {
+  if (!h_tracker->entry_pool.entries_begin) {
     LOG_DEBUG("epool_create for cache_pool failed");
     r = -ENOSPC;
     goto cache_epool_create_fail;
   }
   epool_init(&h_tracker->entry_pool, 0);
 
-  queue_init(&h_tracker->q);
+  iqueue_set_init(&h_tracker->queues, sizeof(struct hoard_tracker_entry));
+  iqueue_set_add_pool(&h_tracker->queues, &h_tracker->entry_pool);
+  iqueue_init(&h_tracker->q, &h_tracker->queues, struct hoard_tracker_entry,
+              list);
 
   h_tracker->count = 0;
 
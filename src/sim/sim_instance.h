@@ -0,0 +1,382 @@
+#ifndef SIM_SIM_INSTANCE_H
+#define SIM_SIM_INSTANCE_H
+
+#include "alg_wrapper.h"
+#include "cache_nucleus.h"
+#include "ext/sim_outputter.h"
+#include "sim_migration_tracker.h"
+#include "sim_options.h"
+#include "sim_policy.h"
+#include "sim_stats_struct.h"
+#include "tools/random.h"
+#include "trace_reader/trace_merge.h"
+#include "trace_reader/trace_reader_structs.h"
+
+#define SIM_INSTANCE_BATCH_SIZE 256
+
+/** A single simulated cache
+ *
+ * cache-sim can run several policies over the same trace in one pass. Each
+ * policy gets its own sim_instance so that everything that depends on the
+ * policy's decisions (stats, migrations, removals, output) stays separate,
+ * while the trace itself is only read once.
+ *
+ * Without delayed migrations or removals, accesses don't have to be simulated
+ * one by one: extents go to policy_map_range() and single accesses are
+ * gathered into batches for policy_map_batch(). Batches are simulated when
+ * they fill up, before anything else is simulated and before stats are
+ * printed.
+ *
+ * policy_name - Name of the policy (or wrapper combination) being simulated
+ * alg_w - Wrapper of the policy being simulated
+ * stats - Simulator-side stats (read/write hits and misses, dirty evicts)
+ * outputter - Where and how often this instance's stats are printed
+ * m_tracker - Delayed migrations (only used with --migration-delay)
+ * random_remove - Random state for --remove-rate < 0
+ * batch_* - Single accesses waiting to be given to policy_map_batch()
+ *           together, the first of which happens at batch_time
+ * tenant_stats/nr_tenants - Stats of each tenant (only with --tenant), for
+ *                           which every access is simulated on its own so
+ *                           that its result can be counted
+ */
+struct sim_instance {
+  char *policy_name;
+  struct alg_wrapper *alg_w;
+  struct sim_stats_struct stats;
+  struct sim_outputter outputter;
+  struct migration_tracker m_tracker;
+  struct random_state random_remove;
+
+  oblock_t batch_oblocks[SIM_INSTANCE_BATCH_SIZE];
+  bool batch_writes[SIM_INSTANCE_BATCH_SIZE];
+  struct cache_nucleus_result batch_results[SIM_INSTANCE_BATCH_SIZE];
+  unsigned batch_len;
+  unsigned batch_time;
+
+  struct sim_tenant_stats *tenant_stats;
+  unsigned nr_tenants;
+};
+
+static bool sim_instance_remove_now(struct sim_instance *inst,
+                                    struct sim_options *options,
+                                    unsigned time) {
+  if (options->remove_rate == 0) {
+    return false;
+  }
+
+  if (options->remove_rate > 0) {
+    return time % options->remove_rate == 0;
+  }
+
+  return random_int(&inst->random_remove) % (-options->remove_rate) == 0;
+}
+
+/** Count the result of an access in the stats of its tenant
+ */
+static void sim_instance_count_tenant(struct sim_instance *inst,
+                                      oblock_t oblock, bool write,
+                                      struct cache_nucleus_result *result) {
+  struct sim_tenant_stats *stats =
+      &inst->tenant_stats[trace_merge_tenant(oblock)];
+
+  if (result->op == CACHE_NUCLEUS_HIT) {
+    ++stats->hits;
+    if (write) {
+      ++stats->sim.write_hits;
+    } else {
+      ++stats->sim.read_hits;
+    }
+  } else {
+    ++stats->misses;
+    if (write) {
+      ++stats->sim.write_misses;
+    } else {
+      ++stats->sim.read_misses;
+    }
+  }
+
+  if (result->op == CACHE_NUCLEUS_FILTER) {
+    ++stats->filters;
+  } else if (result->op == CACHE_NUCLEUS_NEW ||
+             result->op == CACHE_NUCLEUS_REPLACE) {
+    ++stats->promotions;
+  }
+
+  if (result->dirty_eviction) {
+    ++stats->sim.dirty_evicts;
+  }
+}
+
+static void sim_instance_count(struct sim_instance *inst, oblock_t oblock,
+                               bool write,
+                               struct cache_nucleus_result *result) {
+  struct sim_stats_struct *sim_stats = &inst->stats;
+
+  if (inst->nr_tenants > 0) {
+    sim_instance_count_tenant(inst, oblock, write, result);
+  }
+
+  if (result->op == CACHE_NUCLEUS_HIT) {
+    if (write) {
+      ++sim_stats->write_hits;
+    } else {
+      ++sim_stats->read_hits;
+    }
+  } else {
+    if (write) {
+      ++sim_stats->write_misses;
+    } else {
+      ++sim_stats->read_misses;
+    }
+  }
+
+  if (result->dirty_eviction) {
+    ++sim_stats->dirty_evicts;
+  }
+}
+
+static void sim_instance_map(struct sim_instance *inst, oblock_t oblock,
+                             bool write, struct cache_nucleus_result *result) {
+  struct cache_nucleus *bp = inst->alg_w->nucleus;
+  struct sim_stats_struct *sim_stats = &inst->stats;
+  struct entry *e = policy_cache_lookup(bp, oblock);
+  if (e != NULL && e->migrating) {
+    result->op == CACHE_NUCLEUS_HIT;
+    if (write) {
+      ++sim_stats->write_hits;
+    } else {
+      ++sim_stats->read_hits;
+    }
+    if (inst->nr_tenants > 0) {
+      struct cache_nucleus_result hit = {0};
+      hit.op = CACHE_NUCLEUS_HIT;
+      sim_instance_count_tenant(inst, oblock, write, &hit);
+    }
+    return;
+  }
+
+  if (sim_policy_map(bp, oblock, write, result)) {
+    LOG_FATAL("Error occurred while processing entry");
+  }
+
+  sim_instance_count(inst, oblock, write, result);
+}
+
+/** Process a single access
+ */
+static void sim_instance_access_block(struct sim_instance *inst,
+                                      struct sim_options *options,
+                                      oblock_t oblock, bool write,
+                                      unsigned time) {
+  struct cache_nucleus *bp = inst->alg_w->nucleus;
+  struct migration_tracker *m_tracker = &inst->m_tracker;
+  struct cache_nucleus_result result = {0};
+
+  sim_policy_set_time(bp, time);
+  sim_instance_map(inst, oblock, write, &result);
+
+  if (options->migration_delay == 0) {
+    if (result.op == CACHE_NUCLEUS_NEW || result.op == CACHE_NUCLEUS_REPLACE) {
+      sim_policy_migrated(bp, oblock);
+    }
+  } else {
+    oblock_t migrated;
+    if (migration_next(m_tracker, time, &migrated)) {
+      struct entry *e = policy_cache_lookup(bp, migrated);
+      if (e != NULL) {
+        sim_policy_migrated(bp, migrated);
+      }
+    }
+
+    if (result.op == CACHE_NUCLEUS_NEW || result.op == CACHE_NUCLEUS_REPLACE) {
+      migration_add(m_tracker, time, oblock);
+    }
+  }
+
+  if (sim_instance_remove_now(inst, options, time)) {
+    struct entry *e = policy_cache_lookup(bp, oblock);
+    if (e != NULL) {
+      migration_remove(m_tracker, oblock);
+      policy_remove(bp, oblock, true);
+    }
+  }
+}
+
+/** Process a whole extent of accesses at once (see policy_map_range())
+ *
+ * Only valid when migrations complete immediately and nothing is removed.
+ */
+static void sim_instance_access_range(struct sim_instance *inst,
+                                      struct sim_options *options,
+                                      struct trace_reader_result *read_result,
+                                      unsigned time) {
+  struct cache_nucleus *bp = inst->alg_w->nucleus;
+  struct sim_stats_struct *sim_stats = &inst->stats;
+  struct cache_nucleus_range_result result = {0};
+
+  if (sim_policy_map_range(bp, read_result->oblock, read_result->nr_blocks,
+                           options->block_stride, read_result->write, time,
+                           &result)) {
+    LOG_FATAL("Error occurred while processing entry");
+  }
+
+  if (read_result->write) {
+    sim_stats->write_hits += result.hits;
+    sim_stats->write_misses += result.misses;
+  } else {
+    sim_stats->read_hits += result.hits;
+    sim_stats->read_misses += result.misses;
+  }
+  sim_stats->dirty_evicts += result.dirty_evictions;
+}
+
+/** Simulate the batched single accesses (see policy_map_batch())
+ */
+static void sim_instance_flush(struct sim_instance *inst) {
+  struct cache_nucleus *bp = inst->alg_w->nucleus;
+  unsigned i;
+
+  if (inst->batch_len == 0) {
+    return;
+  }
+
+  if (sim_policy_map_batch(bp, inst->batch_oblocks, inst->batch_writes,
+                           inst->batch_len, inst->batch_time,
+                           inst->batch_results)) {
+    LOG_FATAL("Error occurred while processing entry");
+  }
+
+  for (i = 0; i < inst->batch_len; i++) {
+    sim_instance_count(inst, inst->batch_oblocks[i], inst->batch_writes[i],
+                       &inst->batch_results[i]);
+  }
+  inst->batch_len = 0;
+}
+
+/** Add a single access to the batch, simulating the batch if it's full
+ */
+static void sim_instance_batch(struct sim_instance *inst, oblock_t oblock,
+                               bool write, unsigned time) {
+  if (inst->batch_len > 0 && time != inst->batch_time + inst->batch_len) {
+    sim_instance_flush(inst);
+  }
+  if (inst->batch_len == 0) {
+    inst->batch_time = time;
+  }
+
+  inst->batch_oblocks[inst->batch_len] = oblock;
+  inst->batch_writes[inst->batch_len] = write;
+  if (++inst->batch_len == SIM_INSTANCE_BATCH_SIZE) {
+    sim_instance_flush(inst);
+  }
+}
+
+/** Process an extent of accesses that has already been read from the trace,
+ * the first of which happens at the given time
+ */
+static void sim_instance_access(struct sim_instance *inst,
+                                struct sim_options *options,
+                                struct trace_reader_result *read_result,
+                                unsigned time) {
+  oblock_t oblock = read_result->oblock;
+  block_t i;
+
+  if (options->migration_delay == 0 && options->remove_rate == 0) {
+    if (read_result->nr_blocks == 1) {
+      sim_instance_batch(inst, read_result->oblock, read_result->write, time);
+      return;
+    }
+    if (inst->nr_tenants > 0) {
+      for (i = 0; i < read_result->nr_blocks; i++) {
+        sim_instance_batch(inst, oblock, read_result->write, time + i);
+        oblock += options->block_stride;
+      }
+      return;
+    }
+    sim_instance_flush(inst);
+    sim_instance_access_range(inst, options, read_result, time);
+    return;
+  }
+
+  for (i = 0; i < read_result->nr_blocks; i++) {
+    sim_instance_access_block(inst, options, oblock, read_result->write,
+                              time + i);
+    oblock += options->block_stride;
+  }
+}
+
+static void sim_instance_print(struct sim_instance *inst, unsigned time,
+                               bool complete) {
+  unsigned i;
+
+  if (sim_outputter_due(&inst->outputter, time, complete)) {
+    sim_instance_flush(inst);
+  }
+  sim_outputter_print(&inst->outputter, inst->alg_w, &inst->stats, time,
+                      complete);
+  for (i = 0; i < inst->nr_tenants; i++) {
+    sim_outputter_print_tenant(&inst->outputter, i, &inst->tenant_stats[i],
+                               time, complete);
+  }
+}
+
+/** Create the policy for the instance and reset its stats
+ *
+ * \param label Prefix for printed stats (NULL to print stats only)
+ */
+static int sim_instance_init(struct sim_instance *inst, char *policy_name,
+                             cblock_t cache_size, cblock_t meta_size,
+                             struct sim_options *options, const char *label) {
+  inst->policy_name = policy_name;
+  memset(&inst->stats, 0, sizeof(inst->stats));
+  inst->batch_len = 0;
+
+  inst->nr_tenants = options->nr_tenants;
+  inst->tenant_stats = NULL;
+  if (inst->nr_tenants > 0) {
+    inst->tenant_stats =
+        mem_alloc(sizeof(*inst->tenant_stats) * inst->nr_tenants);
+    if (!inst->tenant_stats) {
+      LOG_DEBUG("unable to allocate tenant stats");
+      return -ENOSPC;
+    }
+  }
+
+  inst->alg_w = create_wrapper(policy_name, cache_size, meta_size);
+  if (!inst->alg_w) {
+    LOG_DEBUG("create_wrapper failed for %s", policy_name);
+    mem_free(inst->tenant_stats);
+    return -ENOSPC;
+  }
+  alg_wrapper_init(inst->alg_w, options->watch_str);
+
+  memset(&inst->m_tracker, 0, sizeof(inst->m_tracker));
+  inst->m_tracker.delay = options->migration_delay;
+  if (options->migration_delay > 0 &&
+      migration_tracker_init(&inst->m_tracker, options->migration_delay)) {
+    LOG_DEBUG("unable to allocate for migration_tracker");
+    sim_policy_destroy(inst->alg_w->nucleus);
+    mem_free(inst->tenant_stats);
+    return -ENOSPC;
+  }
+
+  // TODO rename window_size to output_interval?
+  sim_outputter_init(&inst->outputter, options->output_mode,
+                     options->window_size);
+  inst->outputter.label = label;
+
+  // TODO make sure this is gonna be okay to do
+  prandom_init_seed(&inst->random_remove, 123);
+
+  return 0;
+}
+
+static void sim_instance_exit(struct sim_instance *inst) {
+  if (inst->m_tracker.delay > 0) {
+    migration_tracker_exit(&inst->m_tracker);
+  }
+  sim_policy_destroy(inst->alg_w->nucleus);
+  mem_free(inst->tenant_stats);
+}
+
+#endif /* SIM_SIM_INSTANCE_H */
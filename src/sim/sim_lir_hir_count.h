@@ -5,11 +5,11 @@
 #include "common.h"
 #include "entry.h"
 #include "tools/hashtable.h"
-#include "tools/queue.h"
+#include "tools/iqueue.h"
 
 struct lir_hir_entry {
   struct entry e;
-  struct queue_head list;
+  struct iqueue_head list;
   unsigned freq;
   bool in_cache;
 };
@@ -17,7 +17,8 @@ struct lir_hir_entry {
 struct lir_hir_tracker {
   struct hashtable ht;
   struct entry_pool entry_pool;
-  struct queue q;
+  struct iqueue_set queues;
+  struct iqueue q;
   unsigned lir_count;
   unsigned hir_count;
 };
@@ -44,7 +45,7 @@ static void lir_hir_tracker_update(struct lir_hir_tracker *lh_tracker,
 
   if (!in_last_n) {
     if (epool_empty(&lh_tracker->entry_pool)) {
-      struct queue_head *evict_qh = queue_pop(&lh_tracker->q);
+      struct iqueue_head *evict_qh = iqueue_pop(&lh_tracker->q);
       struct lir_hir_entry *evict_lhe =
           container_of(evict_qh, struct lir_hir_entry, list);
       struct entry *evict_e = &evict_lhe->e;
@@ -58,7 +59,7 @@ static void lir_hir_tracker_update(struct lir_hir_tracker *lh_tracker,
       evict_lhe->in_cache = false;
       evict_lhe->freq = 0;
 
-      hash_remove(evict_e);
+      hash_remove(&lh_tracker->ht, evict_e);
       free_entry(&lh_tracker->entry_pool, evict_e);
     }
 
@@ -71,9 +72,9 @@ static void lir_hir_tracker_update(struct lir_hir_tracker *lh_tracker,
     lhe->freq = 0;
   } else {
     lhe = to_lir_hir_entry(e);
-    queue_remove(&lhe->list);
+    iqueue_remove(&lh_tracker->queues, &lhe->list);
   }
-  queue_push(&lh_tracker->q, &lhe->list);
+  iqueue_push(&lh_tracker->q, &lhe->list);
 
   switch (result->op) {
   case CACHE_NUCLEUS_HIT:
@@ -135,15 +136,16 @@ static int lir_hir_tracker_init(struct lir_hir_tracker *lh_tracker,
   }
 
   epool_create(&lh_tracker->entry_pool, cache_size, struct lir_hir_entry, e);
-  if (!lh_tracker->entry_pool.entries_begin ||
-      !lh_tracker->entry_pool.entries) {
+  if (!lh_tracker->entry_pool.entries_begin) {
     LOG_DEBUG("epool_create for entry_pool failed");
     r = -ENOSPC;
     goto entry_pool_create_fail;
   }
   epool_init(&lh_tracker->entry_pool, 0);
 
-  queue_init(&lh_tracker->q);
+  iqueue_set_init(&lh_tracker->queues, sizeof(struct lir_hir_entry));
+  iqueue_set_add_pool(&lh_tracker->queues, &lh_tracker->entry_pool);
+  iqueue_init(&lh_tracker->q, &lh_tracker->queues, struct lir_hir_entry, list);
 
   lh_tracker->lir_count = 0;
   lh_tracker->hir_count = 0;
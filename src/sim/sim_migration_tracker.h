@@ -4,19 +4,20 @@
 #include "common.h"
 #include "entry.h"
 #include "tools/hashtable.h"
-#include "tools/queue.h"
+#include "tools/iqueue.h"
 
 struct migration_op {
   struct entry e;
   unsigned migrated_time;
-  struct queue_head list;
+  struct iqueue_head list;
 };
 
 struct migration_tracker {
   struct hashtable ht;
 
   struct entry_pool entry_pool;
-  struct queue q;
+  struct iqueue_set queues;
+  struct iqueue q;
 
   unsigned delay;
 };
@@ -31,8 +32,8 @@ static void migration_remove(struct migration_tracker *m_tracker,
   if (e != NULL) {
     struct migration_op *op = to_migration_op(e);
     op->migrated_time = 0;
-    queue_remove(&op->list);
-    hash_remove(e);
+    iqueue_remove(&m_tracker->queues, &op->list);
+    hash_remove(&m_tracker->ht, e);
     free_entry(&m_tracker->entry_pool, e);
   }
 }
@@ -48,14 +49,14 @@ static void migration_add(struct migration_tracker *m_tracker,
     op = to_migration_op(e);
     op->migrated_time = current_time + m_tracker->delay;
 
-    queue_push(&m_tracker->q, &op->list);
+    iqueue_push(&m_tracker->q, &op->list);
   }
 }
 
 static bool migration_next(struct migration_tracker *m_tracker,
                            unsigned current_time, oblock_t *oblock) {
-  if (queue_length(&m_tracker->q) > 0) {
-    struct queue_head *qh = queue_peek(&m_tracker->q);
+  if (iqueue_length(&m_tracker->q) > 0) {
+    struct iqueue_head *qh = iqueue_peek(&m_tracker->q);
     struct migration_op *next = container_of(qh, struct migration_op, list);
     if (next->migrated_time == current_time) {
       *oblock = next->e.oblock;
@@ -84,14 +85,16 @@ static int migration_tracker_init(struct migration_tracker *m_tracker,
   }
 
   epool_create(&m_tracker->entry_pool, 2 * delay, struct migration_op, e);
-  if (!m_tracker->entry_pool.entries_begin || !m_tracker->entry_pool.entries) {
+  if (!m_tracker->entry_pool.entries_begin) {
     LOG_DEBUG("epool_create for entry_pool failed");
     r = -ENOSPC;
     goto entry_pool_create_fail;
   }
   epool_init(&m_tracker->entry_pool, 0);
 
-  queue_init(&m_tracker->q);
+  iqueue_set_init(&m_tracker->queues, sizeof(struct migration_op));
+  iqueue_set_add_pool(&m_tracker->queues, &m_tracker->entry_pool);
+  iqueue_init(&m_tracker->q, &m_tracker->queues, struct migration_op, list);
 
   m_tracker->delay = delay;
 
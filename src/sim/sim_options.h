@@ -2,23 +2,53 @@
 #define SIM_SIM_OPTIONS_H
 
 #include "ext/sim_outputter.h"
+#include "trace_reader/trace_filter.h"
+#include "trace_reader/trace_multi.h"
+#include "trace_reader/trace_window.h"
 #include "types.h"
 #include <stdio.h>
 
 struct sim_options {
   FILE *fp;
-  char *policy_name;
+  // trace files given, read one after the other when there are several
+  struct trace_files files;
+  char **policy_names;
+  unsigned nr_policies;
   cblock_t cache_size;
   char *trace_name;
   uint64_t duration_hrs;
+  // part of the trace to be read, if not all of it
+  struct trace_window window;
+  // requests of the trace to be simulated, if not all of them
+  struct trace_filter filter;
   int64_t metadata_size;
   uint64_t window_size;
   enum sim_output_mode output_mode;
   uint64_t freq_count_min;
   uint64_t sampling_rate;
+  // was the trace already sampled (at sampling_rate) when it was written?
+  bool presampled;
   uint64_t migration_delay;
   int64_t remove_rate;
   char *watch_str;
+  char **sizes;
+  unsigned nr_sizes;
+  bool pipeline;
+  unsigned decode_threads;
+  // traces of the tenants ([FORMAT:]FILE) merged into one (only with --tenant)
+  char **tenants;
+  unsigned nr_tenants;
+  // one cache per volume of the trace (only with --per-volume), sized by
+  // volume_size (CACHE_SIZE) unless given by volume_sizes (VOLUME=SIZE)
+  bool per_volume;
+  char *volume_size;
+  char **volume_sizes;
+  unsigned nr_volume_sizes;
+  // size in bytes of the cache blocks the trace's accesses are mapped onto
+  // (0 to simulate the trace's own blocks)
+  uint64_t block_size;
+  // oblock increment between the accesses of an extent, set by the trace
+  block_t block_stride;
 };
 
 #endif /* SIM_SIM_OPTIONS_H */
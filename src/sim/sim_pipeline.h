@@ -0,0 +1,165 @@
+#ifndef SIM_SIM_PIPELINE_H
+#define SIM_SIM_PIPELINE_H
+
+#include "common.h"
+#include "trace_reader/trace_reader_structs.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+
+/** Pipelined trace decoding (--pipeline)
+ *
+ * Normally the trace is read (and parsed) and then simulated one extent at a
+ * time on a single thread, so the cost of both adds up. With a pipeline, a
+ * producer thread reads (and samples) the trace into batches of extents,
+ * handing them over to the simulation thread through a lock-free, single
+ * producer/single consumer ring. With a spare core, reading the trace is then
+ * hidden behind the simulation.
+ *
+ * The producer only ever writes head, and the consumer only ever writes tail,
+ * so the only synchronization needed is the release/acquire pair on each.
+ */
+
+#define SIM_PIPELINE_NR_BATCHES 8
+#define SIM_PIPELINE_BATCH_SIZE 4096
+// Number of times to check the ring before yielding the processor
+#define SIM_PIPELINE_SPIN_COUNT 128
+
+/** sim_pipeline_batch
+ * results - Extents, in trace order
+ * len - Number of extents in results
+ * last - Is this the last batch of the trace?
+ */
+struct sim_pipeline_batch {
+  struct trace_reader_result results[SIM_PIPELINE_BATCH_SIZE];
+  unsigned len;
+  bool last;
+};
+
+typedef int (*sim_pipeline_read_fn)(struct trace_reader *reader,
+                                    struct trace_reader_result *result);
+
+/** sim_pipeline
+ * thread - Producer thread
+ * reader/read - How the producer reads the next extent
+ * batches - The ring of batches
+ * head - Number of batches filled by the producer (producer only)
+ * tail - Number of batches consumed (consumer only)
+ * cur/pos - Batch being consumed and position of the next extent in it
+ */
+struct sim_pipeline {
+  pthread_t thread;
+  struct trace_reader *reader;
+  sim_pipeline_read_fn read;
+  struct sim_pipeline_batch *batches;
+
+  // keep head and tail on separate cache lines so they don't bounce around
+  uint64_t head __attribute__((aligned(64)));
+  uint64_t tail __attribute__((aligned(64)));
+
+  struct sim_pipeline_batch *cur;
+  unsigned pos;
+};
+
+static void __sim_pipeline_wait(unsigned *spins) {
+  if (++*spins >= SIM_PIPELINE_SPIN_COUNT) {
+    *spins = 0;
+    sched_yield();
+  }
+}
+
+static void *__sim_pipeline_produce(void *arg) {
+  struct sim_pipeline *p = arg;
+  uint64_t head = p->head;
+  unsigned spins = 0;
+
+  for (;;) {
+    struct sim_pipeline_batch *b;
+
+    while (head - __atomic_load_n(&p->tail, __ATOMIC_ACQUIRE) ==
+           SIM_PIPELINE_NR_BATCHES) {
+      __sim_pipeline_wait(&spins);
+    }
+
+    b = &p->batches[head % SIM_PIPELINE_NR_BATCHES];
+    b->len = 0;
+    b->last = false;
+    while (b->len < SIM_PIPELINE_BATCH_SIZE) {
+      if (p->read(p->reader, &b->results[b->len])) {
+        b->last = true;
+        break;
+      }
+      ++b->len;
+    }
+
+    __atomic_store_n(&p->head, ++head, __ATOMIC_RELEASE);
+    if (b->last) {
+      return NULL;
+    }
+  }
+}
+
+/** Read the next extent from the pipeline
+ *
+ * \return 0 if an extent was read, 1 once the end of the trace is reached
+ */
+static int sim_pipeline_read(struct sim_pipeline *p,
+                             struct trace_reader_result *result) {
+  unsigned spins = 0;
+
+  while (p->cur == NULL || p->pos == p->cur->len) {
+    if (p->cur != NULL) {
+      if (p->cur->last) {
+        return 1;
+      }
+      __atomic_store_n(&p->tail, p->tail + 1, __ATOMIC_RELEASE);
+    }
+
+    while (__atomic_load_n(&p->head, __ATOMIC_ACQUIRE) == p->tail) {
+      __sim_pipeline_wait(&spins);
+    }
+    p->cur = &p->batches[p->tail % SIM_PIPELINE_NR_BATCHES];
+    p->pos = 0;
+  }
+
+  *result = p->cur->results[p->pos++];
+  return 0;
+}
+
+/** Start the producer thread
+ *
+ * \return 0 if no errors occur, -ENOSPC if unable to allocate memory, or
+ *         the error of pthread_create
+ */
+static int sim_pipeline_init(struct sim_pipeline *p,
+                             struct trace_reader *reader,
+                             sim_pipeline_read_fn read) {
+  int r;
+
+  p->reader = reader;
+  p->read = read;
+  p->head = 0;
+  p->tail = 0;
+  p->cur = NULL;
+  p->pos = 0;
+
+  p->batches = mem_alloc(sizeof(*p->batches) * SIM_PIPELINE_NR_BATCHES);
+  if (!p->batches) {
+    return -ENOSPC;
+  }
+
+  r = pthread_create(&p->thread, NULL, __sim_pipeline_produce, p);
+  if (r) {
+    mem_free(p->batches);
+  }
+  return r;
+}
+
+/** Wait for the producer to finish (the whole trace must have been read)
+ */
+static void sim_pipeline_exit(struct sim_pipeline *p) {
+  pthread_join(p->thread, NULL);
+  mem_free(p->batches);
+}
+
+#endif /* SIM_SIM_PIPELINE_H */
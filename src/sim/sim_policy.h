@@ -8,6 +8,20 @@ static int sim_policy_map(struct cache_nucleus *bp, oblock_t oblock, bool write,
   return bp->map(bp, oblock, write, result);
 }
 
+static int sim_policy_map_range(struct cache_nucleus *bp, oblock_t oblock,
+                                block_t nr_blocks, block_t stride, bool write,
+                                unsigned time,
+                                struct cache_nucleus_range_result *result) {
+  return bp->map_range(bp, oblock, nr_blocks, stride, write, time, result);
+}
+
+static int sim_policy_map_batch(struct cache_nucleus *bp,
+                                const oblock_t *oblocks, const bool *writes,
+                                unsigned n, unsigned time,
+                                struct cache_nucleus_result *results) {
+  return bp->map_batch(bp, oblocks, writes, n, time, results);
+}
+
 static void sim_policy_migrated(struct cache_nucleus *bp, oblock_t oblock) {
   bp->migrated(bp, oblock);
 }
@@ -5,7 +5,7 @@
 #include "common.h"
 #include "entry.h"
 #include "tools/hashtable.h"
-#include "tools/queue.h"
+#include "tools/iqueue.h"
 
 /** TODO description
  * should start with ENTRY_ACCESSED = 0
@@ -21,7 +21,7 @@ enum recency_type {
 
 struct recency_classifier_entry {
   struct entry e;
-  struct queue_head list[NUM_RECENCY_TYPES];
+  struct iqueue_head list[NUM_RECENCY_TYPES];
   unsigned recency_flags;
 };
 
@@ -33,7 +33,8 @@ struct recency_classifier {
    * before evictions that may introduce removal of orphan entry/entries
    */
   struct entry_pool entry_pool;
-  struct queue q[NUM_RECENCY_TYPES];
+  struct iqueue_set queues;
+  struct iqueue q[NUM_RECENCY_TYPES];
 
   /* Include hit information as a bit on access
    * Ordered as such for future compatibility
@@ -71,17 +72,17 @@ static void
 recency_classifier_push_to_queue(struct recency_classifier *r_class,
                                  enum recency_type r_type,
                                  struct recency_classifier_entry *re) {
-  struct queue *q = &r_class->q[r_type];
-  struct queue_head *qh = &re->list[r_type];
+  struct iqueue *q = &r_class->q[r_type];
+  struct iqueue_head *qh = &re->list[r_type];
 
-  if (in_queue(q, qh)) {
-    queue_remove(qh);
+  if (in_iqueue(q, qh)) {
+    iqueue_remove(&r_class->queues, qh);
   }
-  queue_push(q, qh);
+  iqueue_push(q, qh);
   re->recency_flags |= recency_type_flag(r_type);
 
-  if (queue_length(q) > r_class->cache_size) {
-    struct queue_head *qh = queue_pop(q);
+  if (iqueue_length(q) > r_class->cache_size) {
+    struct iqueue_head *qh = iqueue_pop(q);
     // check if entry is orphan now
     struct recency_classifier_entry *evicted_re =
         container_of(qh, struct recency_classifier_entry, list[r_type]);
@@ -94,7 +95,7 @@ recency_classifier_push_to_queue(struct recency_classifier *r_class,
 
     if (evicted_re->recency_flags == 0) {
       struct entry *evicted_e = &evicted_re->e;
-      hash_remove(evicted_e);
+      hash_remove(&r_class->ht, evicted_e);
       free_entry(&r_class->entry_pool, evicted_e);
     }
   }
@@ -171,15 +172,18 @@ static int recency_classifier_init(struct recency_classifier *r_class,
 
   epool_create(&r_class->entry_pool, total_size,
                struct recency_classifier_entry, e);
-  if (!r_class->entry_pool.entries_begin || !r_class->entry_pool.entries) {
+  if (!r_class->entry_pool.entries_begin) {
     LOG_DEBUG("epool_create for entry_pool failed");
     r = -ENOSPC;
     goto entry_pool_create_fail;
   }
   epool_init(&r_class->entry_pool, 0);
 
+  iqueue_set_init(&r_class->queues, sizeof(struct recency_classifier_entry));
+  iqueue_set_add_pool(&r_class->queues, &r_class->entry_pool);
   for (i = 0; i < NUM_RECENCY_TYPES; ++i) {
-    queue_init(&r_class->q[i]);
+    iqueue_init(&r_class->q[i], &r_class->queues,
+                struct recency_classifier_entry, list[i]);
     r_class->count[i] = 0;
   }
 
@@ -11,4 +11,21 @@ struct sim_stats_struct {
   unsigned dirty_evicts;
 };
 
+/** Stats of one tenant of a multi-tenant run (see trace_merge.h), counted from
+ * the results of its own accesses
+ *
+ * hits/misses - Accesses that hit, and that didn't
+ * filters - Misses that weren't cached
+ * promotions - Misses that were cached (moved to the cache device)
+ * sim - Simulator-side stats of the tenant
+ */
+struct sim_tenant_stats {
+  unsigned hits;
+  unsigned misses;
+  unsigned filters;
+  unsigned promotions;
+
+  struct sim_stats_struct sim;
+};
+
 #endif /* SIM_SIM_STATS_STRUCT_H */
@@ -0,0 +1,160 @@
+#ifndef SIM_SIM_SWEEP_H
+#define SIM_SIM_SWEEP_H
+
+#include "common.h"
+#include "sim_instance.h"
+#include "sim_options.h"
+#include "sim_trace_buffer.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/** Cache size sweep (--sizes)
+ *
+ * Rather than running cache-sim once per cache size, with every run reading
+ * and parsing the whole trace again, the trace is decoded once into a
+ * sim_trace_buffer and one worker thread per cache size simulates every
+ * policy over it. Workers share nothing but the (read-only) buffer, so they
+ * scale with the number of cores.
+ *
+ * Once all workers are done, the stats are printed as a single table, one row
+ * per (size, policy) pair:
+ * [requested size] [cache size in entries] [policy] [stats...]
+ */
+
+#define SIM_SWEEP_LABEL_MAX_LENGTH 128
+
+/** sim_sweep_worker
+ * Simulates all policies for a single cache size
+ *
+ * thread - Thread doing the simulation
+ * name - First column of the rows of the worker (the size, for --sizes)
+ * size_str - Size as given by the user
+ * cache_size - Cache size in entries
+ * meta_size - Metadata size in entries
+ * options - Simulation options (shared, read-only)
+ * tb - Decoded trace (shared, read-only)
+ * instances - One sim_instance per policy
+ * labels - Row labels for the instances
+ */
+struct sim_sweep_worker {
+  pthread_t thread;
+  const char *name;
+  char *size_str;
+  cblock_t cache_size;
+  cblock_t meta_size;
+  struct sim_options *options;
+  struct sim_trace_buffer *tb;
+  struct sim_instance *instances;
+  char (*labels)[SIM_SWEEP_LABEL_MAX_LENGTH];
+};
+
+/** Convert a requested size into a number of cache entries
+ *
+ * Sizes below 1 are fractions of the working set size (which has already been
+ * sampled if sampling is used), while the rest are absolute sizes in entries.
+ */
+static cblock_t sim_sweep_cache_size(struct sim_options *options,
+                                     double size, uint64_t unique) {
+  if (size < 1.0) {
+    return max((cblock_t)(size * unique + 0.5), 1u);
+  }
+  return max((cblock_t)size / options->sampling_rate, 1u);
+}
+
+static void *sim_sweep_worker_run(void *arg) {
+  struct sim_sweep_worker *w = arg;
+  struct sim_options *options = w->options;
+  unsigned time = 1;
+  uint64_t i;
+  unsigned p;
+
+  for (i = 0; i < w->tb->len; i++) {
+    for (p = 0; p < options->nr_policies; p++) {
+      sim_instance_access(&w->instances[p], options, &w->tb->results[i],
+                          time);
+    }
+    time += w->tb->results[i].nr_blocks;
+  }
+
+  return NULL;
+}
+
+static void sim_sweep_worker_prep(struct sim_sweep_worker *w,
+                                  struct sim_options *options,
+                                  struct sim_trace_buffer *tb,
+                                  const char *name, char *size_str,
+                                  uint64_t unique) {
+  unsigned p;
+
+  w->options = options;
+  w->tb = tb;
+  w->name = name;
+  w->size_str = size_str;
+  w->cache_size = sim_sweep_cache_size(options, atof(size_str), unique);
+  if (options->metadata_size == -1) {
+    w->meta_size = w->cache_size;
+  } else {
+    w->meta_size = options->metadata_size / options->sampling_rate;
+  }
+
+  w->instances = mem_alloc(sizeof(*w->instances) * options->nr_policies);
+  w->labels = mem_alloc(sizeof(*w->labels) * options->nr_policies);
+  if (!w->instances || !w->labels) {
+    LOG_FATAL("Unable to allocate sweep worker for size %s", size_str);
+  }
+
+  for (p = 0; p < options->nr_policies; p++) {
+    snprintf(w->labels[p], SIM_SWEEP_LABEL_MAX_LENGTH, "%s %u %s", name,
+             w->cache_size, options->policy_names[p]);
+    if (sim_instance_init(&w->instances[p], options->policy_names[p],
+                          w->cache_size, w->meta_size, options,
+                          w->labels[p])) {
+      LOG_FATAL("Base policy wrapper creation failed");
+    }
+  }
+}
+
+/** Run every (size, policy) pair over the decoded trace and print the table
+ */
+static void sim_sweep_run(struct sim_options *options,
+                          struct sim_trace_buffer *tb) {
+  struct sim_sweep_worker *workers;
+  uint64_t unique = sim_trace_buffer_unique(tb, options->block_stride);
+  unsigned s;
+  unsigned p;
+
+  workers = mem_alloc(sizeof(*workers) * options->nr_sizes);
+  if (!workers) {
+    LOG_FATAL("Unable to allocate sweep workers");
+  }
+
+  for (s = 0; s < options->nr_sizes; s++) {
+    sim_sweep_worker_prep(&workers[s], options, tb, options->sizes[s],
+                          options->sizes[s], unique);
+  }
+
+  for (s = 0; s < options->nr_sizes; s++) {
+    if (pthread_create(&workers[s].thread, NULL, sim_sweep_worker_run,
+                       &workers[s])) {
+      LOG_FATAL("Unable to create sweep worker for size %s",
+                workers[s].size_str);
+    }
+  }
+
+  for (s = 0; s < options->nr_sizes; s++) {
+    pthread_join(workers[s].thread, NULL);
+  }
+
+  for (s = 0; s < options->nr_sizes; s++) {
+    for (p = 0; p < options->nr_policies; p++) {
+      sim_instance_print(&workers[s].instances[p], tb->nr_blocks + 1, true);
+      sim_instance_exit(&workers[s].instances[p]);
+    }
+    mem_free(workers[s].instances);
+    mem_free(workers[s].labels);
+  }
+  mem_free(workers);
+}
+
+#endif /* SIM_SIM_SWEEP_H */
@@ -0,0 +1,100 @@
+#ifndef SIM_SIM_TRACE_BUFFER_H
+#define SIM_SIM_TRACE_BUFFER_H
+
+#include "common.h"
+#include "trace_reader/trace_reader_structs.h"
+#include <stdlib.h>
+
+/** An in-memory copy of a decoded trace
+ *
+ * Reading (and parsing) the trace is often more expensive than simulating it,
+ * so when the same trace is going to be simulated many times over (such as
+ * for several cache sizes), it is decoded once into a sim_trace_buffer which
+ * is then shared read-only by everyone simulating it.
+ *
+ * results - Decoded extents, in trace order
+ * len - Number of decoded extents
+ * capacity - Number of extents results has space for
+ * nr_blocks - Number of accesses in all of the extents
+ */
+struct sim_trace_buffer {
+  struct trace_reader_result *results;
+  uint64_t len;
+  uint64_t capacity;
+  uint64_t nr_blocks;
+};
+
+static void sim_trace_buffer_init(struct sim_trace_buffer *tb) {
+  tb->results = NULL;
+  tb->len = 0;
+  tb->capacity = 0;
+  tb->nr_blocks = 0;
+}
+
+/** Append an extent to the sim_trace_buffer
+ *
+ * \return 0 if no errors occur, or -ENOSPC if unable to allocate memory
+ */
+static int sim_trace_buffer_push(struct sim_trace_buffer *tb,
+                                 struct trace_reader_result *result) {
+  if (tb->len == tb->capacity) {
+    uint64_t capacity = tb->capacity ? 2 * tb->capacity : 1 << 16;
+    struct trace_reader_result *results =
+        realloc(tb->results, sizeof(*results) * capacity);
+    if (results == NULL) {
+      return -ENOSPC;
+    }
+    tb->results = results;
+    tb->capacity = capacity;
+  }
+
+  tb->results[tb->len++] = *result;
+  tb->nr_blocks += result->nr_blocks;
+  return 0;
+}
+
+static int __sim_trace_buffer_oblock_cmp(const void *a, const void *b) {
+  oblock_t oblock_a = *(const oblock_t *)a;
+  oblock_t oblock_b = *(const oblock_t *)b;
+  return (oblock_a > oblock_b) - (oblock_a < oblock_b);
+}
+
+/** Count the unique oblocks (the working set size) of the buffered trace
+ *
+ * \return Working set size, or 0 if unable to allocate memory
+ */
+static uint64_t sim_trace_buffer_unique(struct sim_trace_buffer *tb,
+                                        block_t block_stride) {
+  oblock_t *oblocks = malloc(sizeof(*oblocks) * tb->nr_blocks);
+  uint64_t unique = 0;
+  uint64_t n = 0;
+  uint64_t i;
+  block_t b;
+
+  if (oblocks == NULL) {
+    return 0;
+  }
+
+  for (i = 0; i < tb->len; i++) {
+    for (b = 0; b < tb->results[i].nr_blocks; b++) {
+      oblocks[n++] = tb->results[i].oblock + b * block_stride;
+    }
+  }
+  qsort(oblocks, n, sizeof(*oblocks), __sim_trace_buffer_oblock_cmp);
+
+  for (i = 0; i < n; i++) {
+    if (i == 0 || oblocks[i] != oblocks[i - 1]) {
+      ++unique;
+    }
+  }
+
+  free(oblocks);
+  return unique;
+}
+
+static void sim_trace_buffer_exit(struct sim_trace_buffer *tb) {
+  free(tb->results);
+  sim_trace_buffer_init(tb);
+}
+
+#endif /* SIM_SIM_TRACE_BUFFER_H */
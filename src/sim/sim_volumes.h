@@ -0,0 +1,289 @@
+#ifndef SIM_SIM_VOLUMES_H
+#define SIM_SIM_VOLUMES_H
+
+#include "common.h"
+#include "ext/sim_outputter.h"
+#include "policy_stats.h"
+#include "sim_instance.h"
+#include "sim_options.h"
+#include "sim_stats_struct.h"
+#include "sim_sweep.h"
+#include "sim_trace_buffer.h"
+#include "trace_reader/trace_volume.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/** Per-volume simulation (--per-volume)
+ *
+ * Traces with several volumes (see trace_volume.h) are usually served by one
+ * cache per volume rather than by a single cache over all of them. The trace
+ * is decoded once, with the accesses of every volume going into a
+ * sim_trace_buffer of its own, and every volume is then simulated (with every
+ * policy) by a sim_sweep_worker with its own cache, on a pool of one thread
+ * per core.
+ *
+ * The cache of a volume is given by --volume-size, or else by CACHE_SIZE, where
+ * as with --sizes, sizes below 1 are fractions of the working set size of the
+ * volume.
+ *
+ * Once every volume is simulated, the stats are printed as a table, one row per
+ * (volume, policy) pair, followed by one row per policy of the stats summed
+ * over every volume:
+ * [volume] [cache size in entries] [policy] [stats...]
+ * total [sum of the cache sizes in entries] [policy] [stats...]
+ */
+
+/** sim_volumes
+ * options - Simulation options (shared, read-only)
+ * tbs - Decoded accesses of every volume
+ * uniques - Working set size of every volume
+ * workers - Worker of every volume
+ * nr_volumes - Number of volumes with accesses
+ * lock/next - Next volume for the thread pool to take
+ */
+struct sim_volumes {
+  struct sim_options *options;
+  struct sim_trace_buffer *tbs;
+  uint64_t *uniques;
+  struct sim_sweep_worker *workers;
+  unsigned nr_volumes;
+
+  pthread_mutex_t lock;
+  unsigned next;
+};
+
+static void sim_volumes_init(struct sim_volumes *vs,
+                             struct sim_options *options) {
+  vs->options = options;
+  vs->tbs = NULL;
+  vs->uniques = NULL;
+  vs->workers = NULL;
+  vs->nr_volumes = 0;
+  pthread_mutex_init(&vs->lock, NULL);
+}
+
+/** Append an extent of the given volume to its sim_trace_buffer
+ *
+ * \return 0 if no errors occur, or -ENOSPC if unable to allocate memory
+ */
+static int sim_volumes_push(struct sim_volumes *vs, unsigned volume,
+                            struct trace_reader_result *result) {
+  if (volume >= vs->nr_volumes) {
+    struct sim_trace_buffer *tbs =
+        realloc(vs->tbs, sizeof(*tbs) * (volume + 1));
+    if (tbs == NULL) {
+      return -ENOSPC;
+    }
+    vs->tbs = tbs;
+    for (; vs->nr_volumes <= volume; ++vs->nr_volumes) {
+      sim_trace_buffer_init(&vs->tbs[vs->nr_volumes]);
+    }
+  }
+
+  return sim_trace_buffer_push(&vs->tbs[volume], result);
+}
+
+/** Size the cache of the volume is to have, as given by the user
+ */
+static char *sim_volumes_size(struct sim_volumes *vs, const char *name) {
+  struct sim_options *options = vs->options;
+  size_t len = strlen(name);
+  unsigned i;
+
+  for (i = 0; i < options->nr_volume_sizes; i++) {
+    char *size = options->volume_sizes[i];
+    if (strncmp(size, name, len) == 0 && size[len] == '=') {
+      return size + len + 1;
+    }
+  }
+  return options->volume_size;
+}
+
+/** Take the next volume left to the thread pool
+ *
+ * \return 0 if taken, or not 0 if there's none left
+ */
+static int sim_volumes_take(struct sim_volumes *vs, unsigned *volume) {
+  int r = 1;
+
+  pthread_mutex_lock(&vs->lock);
+  if (vs->next < vs->nr_volumes) {
+    *volume = vs->next++;
+    r = 0;
+  }
+  pthread_mutex_unlock(&vs->lock);
+  return r;
+}
+
+static void *sim_volumes_count_work(void *arg) {
+  struct sim_volumes *vs = arg;
+  unsigned v;
+
+  while (!sim_volumes_take(vs, &v)) {
+    vs->uniques[v] =
+        sim_trace_buffer_unique(&vs->tbs[v], vs->options->block_stride);
+  }
+  return NULL;
+}
+
+static void *sim_volumes_simulate_work(void *arg) {
+  struct sim_volumes *vs = arg;
+  unsigned v;
+
+  while (!sim_volumes_take(vs, &v)) {
+    sim_sweep_worker_run(&vs->workers[v]);
+  }
+  return NULL;
+}
+
+/** Run work over every volume on a pool of one thread per core
+ */
+static void sim_volumes_pool(struct sim_volumes *vs, void *(*work)(void *)) {
+  long nr_threads = sysconf(_SC_NPROCESSORS_ONLN);
+  pthread_t *threads;
+  long t;
+
+  if (nr_threads < 1) {
+    nr_threads = 1;
+  }
+  if (nr_threads > vs->nr_volumes) {
+    nr_threads = vs->nr_volumes;
+  }
+
+  threads = mem_alloc(sizeof(*threads) * nr_threads);
+  if (!threads) {
+    LOG_FATAL("Unable to allocate volume threads");
+  }
+
+  vs->next = 0;
+  for (t = 0; t < nr_threads; t++) {
+    if (pthread_create(&threads[t], NULL, work, vs)) {
+      LOG_FATAL("Unable to create volume thread");
+    }
+  }
+  for (t = 0; t < nr_threads; t++) {
+    pthread_join(threads[t], NULL);
+  }
+  mem_free(threads);
+}
+
+/** Print the stats of every policy summed over every volume
+ */
+static void sim_volumes_print_total(struct sim_volumes *vs) {
+  struct sim_options *options = vs->options;
+  char label[SIM_SWEEP_LABEL_MAX_LENGTH];
+  struct sim_outputter out;
+  struct policy_stats total;
+  struct policy_stats stats;
+  struct sim_stats_struct sim_total;
+  struct sim_stats_struct *sim_stats;
+  uint64_t cache_size;
+  unsigned p;
+  unsigned v;
+
+  sim_outputter_init(&out, DEFAULT, 0);
+  out.label = label;
+
+  for (p = 0; p < options->nr_policies; p++) {
+    stats_init(&total);
+    memset(&sim_total, 0, sizeof(sim_total));
+    cache_size = 0;
+
+    for (v = 0; v < vs->nr_volumes; v++) {
+      stats_init(&stats);
+      policy_get_stats(vs->workers[v].instances[p].alg_w->nucleus, &stats);
+      total.hits += stats.hits;
+      total.misses += stats.misses;
+      total.filters += stats.filters;
+      total.promotions += stats.promotions;
+      total.demotions += stats.demotions;
+      total.private_stat += stats.private_stat;
+
+      sim_stats = &vs->workers[v].instances[p].stats;
+      sim_total.read_hits += sim_stats->read_hits;
+      sim_total.read_misses += sim_stats->read_misses;
+      sim_total.write_hits += sim_stats->write_hits;
+      sim_total.write_misses += sim_stats->write_misses;
+      sim_total.dirty_evicts += sim_stats->dirty_evicts;
+
+      cache_size += vs->workers[v].cache_size;
+    }
+
+    snprintf(label, sizeof(label), "total %lu %s", cache_size,
+             options->policy_names[p]);
+    sim_outputter_print_stats(&out, &total, &sim_total);
+  }
+}
+
+static int __sim_volumes_name_cmp(const void *a, const void *b) {
+  return strcmp(trace_volume_name(*(const unsigned *)a),
+                trace_volume_name(*(const unsigned *)b));
+}
+
+/** Simulate every volume with its own caches and print the table
+ */
+static void sim_volumes_run(struct sim_volumes *vs) {
+  struct sim_options *options = vs->options;
+  unsigned *order;
+  unsigned v;
+  unsigned p;
+
+  if (trace_volume_count() == 0) {
+    LOG_FATAL("--per-volume needs a trace with volumes (such as msr)");
+  }
+
+  vs->uniques = mem_alloc(sizeof(*vs->uniques) * vs->nr_volumes);
+  vs->workers = mem_alloc(sizeof(*vs->workers) * vs->nr_volumes);
+  order = mem_alloc(sizeof(*order) * vs->nr_volumes);
+  if (!vs->uniques || !vs->workers || !order) {
+    LOG_FATAL("Unable to allocate volume workers");
+  }
+
+  // the policies are created on a single thread, but the working set sizes
+  // (which sort every access of their volume) are counted in parallel
+  sim_volumes_pool(vs, sim_volumes_count_work);
+  for (v = 0; v < vs->nr_volumes; v++) {
+    const char *name = trace_volume_name(v);
+    sim_sweep_worker_prep(&vs->workers[v], options, &vs->tbs[v], name,
+                          sim_volumes_size(vs, name), vs->uniques[v]);
+    order[v] = v;
+  }
+
+  sim_volumes_pool(vs, sim_volumes_simulate_work);
+
+  // volumes are numbered as they were first decoded, so they are printed in
+  // the order of their names instead
+  qsort(order, vs->nr_volumes, sizeof(*order), __sim_volumes_name_cmp);
+  for (v = 0; v < vs->nr_volumes; v++) {
+    for (p = 0; p < options->nr_policies; p++) {
+      sim_instance_print(&vs->workers[order[v]].instances[p],
+                         vs->tbs[order[v]].nr_blocks + 1, true);
+    }
+  }
+  sim_volumes_print_total(vs);
+  mem_free(order);
+}
+
+static void sim_volumes_exit(struct sim_volumes *vs) {
+  unsigned v;
+  unsigned p;
+
+  for (v = 0; v < vs->nr_volumes; v++) {
+    if (vs->workers) {
+      for (p = 0; p < vs->options->nr_policies; p++) {
+        sim_instance_exit(&vs->workers[v].instances[p]);
+      }
+      mem_free(vs->workers[v].instances);
+      mem_free(vs->workers[v].labels);
+    }
+    sim_trace_buffer_exit(&vs->tbs[v]);
+  }
+  mem_free(vs->workers);
+  mem_free(vs->uniques);
+  free(vs->tbs);
+  pthread_mutex_destroy(&vs->lock);
+}
+
+#endif /* SIM_SIM_VOLUMES_H */
@@ -0,0 +1,119 @@
+#include "tools/logs.h"
+#include "trace_convert_args.h"
+#include "trace_reader/bin_trace_writer.h"
+#include "trace_reader/trace_block.h"
+#include "trace_reader/trace_decompress.h"
+#include "trace_reader/trace_filter.h"
+#include "trace_reader/trace_multi.h"
+#include "trace_reader/trace_parallel.h"
+#include "trace_reader/trace_reader.h"
+#include "trace_reader/trace_sampling.h"
+#include "trace_reader/trace_window.h"
+#include <stdio.h>
+
+/* trace-convert reads a trace of any supported format once and writes it out
+ * as a bin trace, which cache-sim and set-size can then replay without having
+ * to parse text (see trace_reader/bin_trace.h).
+ *
+ * The record count and hour index are written once the whole trace has been
+ * read, if the output is seekable (see trace_reader/bin_trace_writer.h).
+ *
+ * With a sampling rate, only the accesses cache-sim would sample at that
+ * sampling rate are written, each as a record of its own (see
+ * trace_reader/trace_sampling.h), and the sampling rate is recorded in the
+ * header, so that cache-sim simulates the trace at that sampling rate without
+ * reading (or parsing) the rest of the trace every time. A bin record per
+ * sampled access can take more space than the whole trace did, so sampled
+ * traces are best written with --compress.
+ *
+ * With --compress, a zbin trace is written instead, a few times smaller (see
+ * trace_reader/zbin_trace.h).
+ */
+
+struct trace_convert_options options = {
+    .fp = NULL,
+    .out = NULL,
+    .trace_name = NULL,
+    .duration_hrs = 0,
+    .decode_threads = 1,
+    .sampling_rate = 1,
+    .compress = false,
+    .block_size = 0,
+};
+
+int main(int argc, char **argv) {
+  struct trace_reader *reader;
+  struct trace_request request;
+  struct bin_trace_writer writer;
+  unsigned threshold;
+  oblock_t oblock;
+  block_t i;
+  bool window;
+
+  options.fp = stdin;
+  options.out = stdout;
+
+  handle_args(argc, argv, &options);
+  threshold = trace_sampling_threshold(options.sampling_rate);
+
+  // a window applies the duration itself, from the start of the window
+  window = trace_window_used(&options.window);
+
+  // several trace files are opened as they are read, by trace_multi
+  if (options.files.nr_paths > 1) {
+    reader = trace_multi_create(find_trace_reader(options.trace_name),
+                                &options.files,
+                                window ? 0 : options.duration_hrs,
+                                options.decode_threads);
+  } else {
+    options.fp = trace_decompress_open(options.fp);
+    LOG_ASSERT(options.fp != NULL);
+
+    reader = trace_parallel_create(find_trace_reader(options.trace_name),
+                                   options.fp,
+                                   window ? 0 : options.duration_hrs,
+                                   options.decode_threads);
+  }
+  if (reader != NULL && window) {
+    reader = trace_window_create(reader, &options.window, options.duration_hrs);
+  }
+  if (reader != NULL && trace_filter_used(&options.filter)) {
+    reader = trace_filter_create(reader, &options.filter);
+  }
+  if (reader != NULL && options.block_size > 0) {
+    reader = trace_block_create(reader, options.block_size);
+  }
+  LOG_ASSERT(reader != NULL);
+
+  if (options.sampling_rate > 1 && reader->sampling_rate > 1) {
+    LOG_FATAL("The trace was already sampled at a sampling rate of %lu",
+              reader->sampling_rate);
+  }
+
+  bin_trace_writer_init(&writer, options.out, reader->block_stride,
+                        reader->oblock_size,
+                        options.sampling_rate > 1 ? options.sampling_rate
+                                                  : reader->sampling_rate,
+                        options.compress);
+
+  while (!reader->read_request(reader, &request)) {
+    if (options.sampling_rate == 1) {
+      bin_trace_writer_add(&writer, request.oblock, request.nr_blocks,
+                           request.ts, request.write);
+      continue;
+    }
+
+    // sampling is decided per access, as in cache-sim
+    for (i = 0; i < request.nr_blocks; i++) {
+      oblock = trace_sampling_hash(request.oblock + i * reader->block_stride);
+      if (oblock <= threshold) {
+        bin_trace_writer_add(&writer, oblock, 1, request.ts, request.write);
+      }
+    }
+  }
+
+  bin_trace_writer_close(&writer);
+  trace_reader_exit(reader);
+
+  return 0;
+}
@@ -0,0 +1,232 @@
+#ifndef TRACE_CONVERT_TRACE_CONVERT_ARGS_H
+#define TRACE_CONVERT_TRACE_CONVERT_ARGS_H
+
+#include "trace_convert_options.h"
+#include "trace_reader/trace_block.h"
+#include "trace_reader/trace_multi.h"
+#include "trace_reader/trace_reader.h"
+#include <ctype.h>
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <unistd.h>
+
+void handle_optional_args(int argc, char **argv,
+                          struct trace_convert_options *options) {
+  char c;
+
+  static struct option long_options[] = {
+      {"file", required_argument, 0, 'f'},
+      {"manifest", required_argument, 0, '+'},
+      {"output", required_argument, 0, 'o'},
+      {"help", no_argument, 0, '`'},
+      {"duration", required_argument, 0, 'd'},
+      {"start", required_argument, 0, '@'},
+      {"skip-ios", required_argument, 0, '['},
+      {"max-ios", required_argument, 0, ']'},
+      {"decode-threads", required_argument, 0, '#'},
+      {"sampling-rate", required_argument, 0, 's'},
+      {"block-size", required_argument, 0, '*'},
+      {"reads-only", no_argument, 0, '{'},
+      {"writes-only", no_argument, 0, '}'},
+      {"lba-range", required_argument, 0, '('},
+      {"time-window", required_argument, 0, ')'},
+      {"pid", required_argument, 0, '$'},
+      {"process", required_argument, 0, '&'},
+      {"compress", no_argument, 0, 'z'},
+      {0, 0, 0, 0},
+  };
+  int option_index = 0;
+  char duration_time;
+
+  while ((c = getopt_long(argc, argv, "d:f:o:s:z", long_options,
+                          &option_index)) != -1) {
+    switch (c) {
+    case 'f':
+      trace_files_add(&options->files, optarg);
+      break;
+    case '+':
+      trace_files_add_manifest(&options->files, optarg);
+      break;
+    case 'o':
+      options->out = fopen(optarg, "w");
+      if (!options->out) {
+        LOG_FATAL("File %s could not be opened. Errno = %d", optarg, errno);
+      }
+      break;
+    case '`':
+      LOG_PRINT(
+          "Usage: ./trace-convert [TRACE_FORMAT] [OPTION]...\n"
+          "Convert a trace into the bin trace format.\n"
+          "  TRACE_FORMAT     format of the trace being converted\n\n"
+          "With no -f or --file OPTION, read standard input.\n"
+          "With no -o or --output OPTION, write standard output.\n\n"
+          "  -f, --file       file of TRACE_TYPE to convert. Given several\n"
+          "                   times, the files are converted one after the\n"
+          "                   other into a single trace\n"
+          "      --manifest   file listing (one per line) trace files to\n"
+          "                   convert as with -f\n"
+          "  -o, --output     file to write the bin trace to\n"
+          "  -d, --duration   amount of the trace, based on time, that\n"
+          "                   is going to be converted\n"
+          "                   Supported time designations:\n"
+          "                     XXh   XX hours\n"
+          "                     XXd   XX days\n"
+          "      --start      start the trace this long (as with --duration)\n"
+          "                   after its first request\n"
+          "      --skip-ios   skip the given number of requests from the\n"
+          "                   start of the trace\n"
+          "      --max-ios    convert at most the given number of requests\n"
+          "      --block-size map the accesses of the trace onto cache\n"
+          "                   blocks of the given size in bytes (or KiB\n"
+          "                   with K, or MiB with M), accessing each cache\n"
+          "                   block a request touches once\n"
+          "      --reads-only only convert the reads of the trace\n"
+          "      --writes-only\n"
+          "                   only convert the writes of the trace\n"
+          "      --lba-range  FIRST-LAST, only convert the accesses to the\n"
+          "                   addresses from FIRST to LAST (in the\n"
+          "                   addresses of the trace, such as sectors for\n"
+          "                   fiu or bytes for msr)\n"
+          "      --time-window\n"
+          "                   FROM-TO, only convert the requests from FROM\n"
+          "                   to TO after the first request (in seconds,\n"
+          "                   or minutes, hours or days with m, h or d,\n"
+          "                   such as 30m-2h)\n"
+          "      --pid        only convert the requests of the process of\n"
+          "                   the given pid (fiu and visa)\n"
+          "      --process    only convert the requests of the processes\n"
+          "                   of the given name (fiu and visa)\n"
+          "  -s, --sampling-rate\n"
+          "                   only keep the accesses sampled at the given\n"
+          "                   sampling rate, as cache-sim would, writing a\n"
+          "                   smaller trace that cache-sim simulates at\n"
+          "                   that sampling rate (with -z, a zbin trace\n"
+          "                   a fraction of the size of a bin trace)\n"
+          "  -z, --compress   write a compressed zbin trace rather than a\n"
+          "                   bin trace\n"
+          "      --decode-threads\n"
+          "                   decode the trace file on the given number of\n"
+          "                   threads, in chunks (basic, fiu and msr)\n"
+          "      --help       display this help and exit\n\n"
+          "Examples:\n"
+          "  ./trace-convert msr -f example.trace -o example.bin\n"
+          "      Convert MSR trace example.trace into example.bin\n"
+          "  ./cache-sim lru 1000 bin -f example.bin\n"
+          "      Simulate the converted trace\n"
+          "  ./trace-convert msr -f example.trace -s 100 -o sampled.bin\n"
+          "      Convert example.trace, keeping 1 in 100 of its oblocks\n"
+          "  ./trace-convert msr -f example.trace -s 100 -z -o sampled.zbin\n"
+          "      Convert example.trace, sampled, into compressed sampled.zbin\n"
+          "  ./trace-convert msr -f example.trace -z -o example.zbin\n"
+          "      Convert example.trace into compressed example.zbin\n\n");
+      exit(0);
+      break;
+    case 'd':
+      sscanf(optarg, "%lu%c", &options->duration_hrs, &duration_time);
+      switch (duration_time) {
+      case 'd':
+        options->duration_hrs *= 24;
+      case 'h':
+        break;
+      default:
+        LOG_FATAL("Unknown duration time %c", duration_time);
+      }
+      break;
+    case '#':
+      sscanf(optarg, "%u", &options->decode_threads);
+      LOG_ASSERT(options->decode_threads > 0u);
+      break;
+    case 's':
+      sscanf(optarg, "%lu", &options->sampling_rate);
+      LOG_ASSERT(options->sampling_rate > 0u);
+      break;
+    case 'z':
+      options->compress = true;
+      break;
+    case '*':
+      if (trace_block_parse_size(optarg, &options->block_size)) {
+        LOG_FATAL("Block size given was not a size in bytes `%s`", optarg);
+      }
+      break;
+    case '@':
+      sscanf(optarg, "%u%c", &options->window.start_hrs, &duration_time);
+      switch (duration_time) {
+      case 'd':
+        options->window.start_hrs *= 24;
+      case 'h':
+        break;
+      default:
+        LOG_FATAL("Unknown start time %c", duration_time);
+      }
+      break;
+    case '[':
+      sscanf(optarg, "%lu", &options->window.skip_ios);
+      break;
+    case ']':
+      sscanf(optarg, "%lu", &options->window.max_ios);
+      break;
+    case '{':
+      options->filter.reads_only = true;
+      break;
+    case '}':
+      options->filter.writes_only = true;
+      break;
+    case '(':
+      if (trace_filter_parse_lba_range(&options->filter, optarg)) {
+        LOG_FATAL("Address range given was not FIRST-LAST `%s`", optarg);
+      }
+      break;
+    case ')':
+      if (trace_filter_parse_time_window(&options->filter, optarg)) {
+        LOG_FATAL("Time window given was not FROM-TO `%s`", optarg);
+      }
+      break;
+    case '$':
+      sscanf(optarg, "%u", &options->filter.pid_value);
+      options->filter.pid = true;
+      break;
+    case '&':
+      options->filter.process_value = trace_process_id(optarg, strlen(optarg));
+      options->filter.process = true;
+      break;
+    case '?':
+      if (isprint(optopt)) {
+        LOG_FATAL("Unknown option `-%c`", optopt);
+      } else {
+        LOG_FATAL("Unknown option character `\\x%x`", optopt);
+      }
+    default:
+      LOG_FATAL("Should've expected the unknown unknown");
+    }
+  }
+
+  // a single file is read as it is, several are read through trace_multi
+  if (options->files.nr_paths == 1) {
+    options->fp = fopen(options->files.paths[0], "r");
+    if (!options->fp) {
+      LOG_FATAL("File %s could not be opened. Errno = %d",
+                options->files.paths[0], errno);
+    }
+  }
+}
+
+void handle_required_args(int argc, char **argv,
+                          struct trace_convert_options *options) {
+  if (argc < 1) {
+    LOG_FATAL("Missing non-optional arguments\n"
+              "Try 'trace-convert --help' for more information.");
+  }
+
+  options->trace_name = argv[0];
+  if (!find_trace_reader(options->trace_name)) {
+    LOG_FATAL("Unknown trace type %s", options->trace_name);
+  }
+}
+
+void handle_args(int argc, char **argv, struct trace_convert_options *options) {
+  handle_optional_args(argc, argv, options);
+  handle_required_args(argc - optind, argv + optind, options);
+}
+
+#endif /* TRACE_CONVERT_TRACE_CONVERT_ARGS_H */
@@ -0,0 +1,30 @@
+#ifndef TRACE_CONVERT_TRACE_CONVERT_OPTIONS_H
+#define TRACE_CONVERT_TRACE_CONVERT_OPTIONS_H
+
+#include "trace_reader/trace_filter.h"
+#include "trace_reader/trace_multi.h"
+#include "trace_reader/trace_window.h"
+#include "types.h"
+#include <stdio.h>
+
+struct trace_convert_options {
+  FILE *fp;
+  // trace files given, read one after the other when there are several
+  struct trace_files files;
+  FILE *out;
+  char *trace_name;
+  uint64_t duration_hrs;
+  // part of the trace to be read, if not all of it
+  struct trace_window window;
+  // requests of the trace to be read, if not all of them
+  struct trace_filter filter;
+  unsigned decode_threads;
+  uint64_t sampling_rate;
+  // write a compressed zbin trace rather than a bin trace
+  bool compress;
+  // size in bytes of the cache blocks the trace's accesses are mapped onto
+  // (0 to simulate the trace's own blocks)
+  uint64_t block_size;
+};
+
+#endif /* TRACE_CONVERT_TRACE_CONVERT_OPTIONS_H */
@@ -0,0 +1,66 @@
+#include "tools/logs.h"
+#include "tools/random.h"
+#include "trace_gen_args.h"
+#include "trace_gen_workload.h"
+#include "trace_reader/bin_trace_writer.h"
+#include <stdio.h>
+
+/* trace-gen generates synthetic workloads (see trace_gen_workload.h) as bin
+ * (or, with --compress, zbin) traces, written to a file or streamed into
+ * cache-sim or set-size through a pipe, so that traces of any size, with known
+ * access patterns, are at hand for benchmarks and for tuning the policies.
+ *
+ * A mix of workloads takes turns every --phase-ios requests, such as Zipf
+ * requests interrupted by a scan, to test how a policy adapts to the changing
+ * phases of a trace.
+ *
+ * The trace only depends on the options (and --seed), so it can be generated
+ * again rather than kept. Requests are of a single block, with a block stride
+ * of 1, and whether a request is a write is drawn from its own random state,
+ * so a different --write-ratio doesn't change the blocks accessed.
+ */
+
+struct trace_gen_options options = {
+    .out = NULL,
+    .workloads = NULL,
+    .nr_workloads = 0,
+    .phase_ios = 100000,
+    .ios = 1000000,
+    .blocks = 100000,
+    .write_ratio = 0,
+    .seed = 1,
+    .iops = 1000,
+    .compress = false,
+};
+
+int main(int argc, char **argv) {
+  struct bin_trace_writer writer;
+  struct random_state blocks;
+  struct random_state writes;
+  struct trace_gen_workload *w;
+  uint64_t i;
+  bool write;
+
+  options.out = stdout;
+
+  handle_args(argc, argv, &options);
+
+  prandom_init_seed(&blocks, options.seed);
+  prandom_init_seed(&writes, options.seed + 1);
+
+  bin_trace_writer_init(&writer, options.out, 1, 0, 1, options.compress);
+
+  for (i = 0; i < options.ios; i++) {
+    w = &options.workloads[(i / options.phase_ios) % options.nr_workloads];
+    write = options.write_ratio > 0 &&
+            trace_gen_random_double(&writes) < options.write_ratio;
+
+    bin_trace_writer_add(&writer, trace_gen_workload_next(w, &blocks), 1,
+                         i * 1000000000 / options.iops, write);
+  }
+
+  bin_trace_writer_close(&writer);
+  mem_free(options.workloads);
+
+  return 0;
+}
@@ -0,0 +1,150 @@
+#ifndef TRACE_GEN_TRACE_GEN_ARGS_H
+#define TRACE_GEN_TRACE_GEN_ARGS_H
+
+#include "trace_gen_options.h"
+#include "trace_gen_workload.h"
+#include <ctype.h>
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <unistd.h>
+
+void handle_optional_args(int argc, char **argv,
+                          struct trace_gen_options *options) {
+  char c;
+
+  static struct option long_options[] = {
+      {"output", required_argument, 0, 'o'},
+      {"help", no_argument, 0, '`'},
+      {"ios", required_argument, 0, 'n'},
+      {"blocks", required_argument, 0, 'b'},
+      {"write-ratio", required_argument, 0, 'w'},
+      {"seed", required_argument, 0, '='},
+      {"iops", required_argument, 0, '~'},
+      {"phase-ios", required_argument, 0, 'p'},
+      {"compress", no_argument, 0, 'z'},
+      {0, 0, 0, 0},
+  };
+  int option_index = 0;
+
+  while ((c = getopt_long(argc, argv, "b:n:o:p:w:z", long_options,
+                          &option_index)) != -1) {
+    switch (c) {
+    case 'o':
+      options->out = fopen(optarg, "w");
+      if (!options->out) {
+        LOG_FATAL("File %s could not be opened. Errno = %d", optarg, errno);
+      }
+      break;
+    case '`':
+      LOG_PRINT(
+          "Usage: ./trace-gen [WORKLOAD]... [OPTION]...\n"
+          "Generate a synthetic bin trace.\n"
+          "  WORKLOAD         workload to generate, one of:\n"
+          "                     zipf[:ALPHA]  blocks accessed with Zipf\n"
+          "                                   probabilities of exponent\n"
+          "                                   ALPHA (default: 1), block 0\n"
+          "                                   being the hottest\n"
+          "                     uniform       blocks accessed uniformly at\n"
+          "                                   random\n"
+          "                     loop[:N]      blocks 0 to N - 1 (default:\n"
+          "                                   --blocks) accessed in order,\n"
+          "                                   over and over again\n"
+          "                     scan          blocks past --blocks accessed\n"
+          "                                   in order, each once\n"
+          "                   Given several workloads, they take turns every\n"
+          "                   --phase-ios requests, each going on where it\n"
+          "                   left off\n\n"
+          "With no -o or --output OPTION, write standard output.\n\n"
+          "  -o, --output     file to write the bin trace to\n"
+          "  -n, --ios        number of requests to generate\n"
+          "                   (default: 1000000)\n"
+          "  -b, --blocks     number of blocks of zipf, uniform and loop\n"
+          "                   (default: 100000)\n"
+          "  -p, --phase-ios  number of requests of every phase of a mix\n"
+          "                   of workloads (default: 100000)\n"
+          "  -w, --write-ratio\n"
+          "                   share of the requests that are writes, from 0\n"
+          "                   to 1 (default: 0)\n"
+          "      --seed       seed of the generator, the same seed (and\n"
+          "                   options) generating the same trace\n"
+          "                   (default: 1)\n"
+          "      --iops       requests per second the timestamps of the\n"
+          "                   requests are spaced by (default: 1000)\n"
+          "  -z, --compress   write a compressed zbin trace rather than a\n"
+          "                   bin trace\n"
+          "      --help       display this help and exit\n\n"
+          "Examples:\n"
+          "  ./trace-gen zipf:0.9 -n 10000000 -o zipf.bin\n"
+          "      Write 10M requests to 100K blocks, with Zipf probabilities\n"
+          "      of exponent 0.9, into zipf.bin\n"
+          "  ./trace-gen zipf scan -p 50000 | ./cache-sim fomo_lru 1000 bin\n"
+          "      Simulate FOMO (over LRU) over Zipf requests,\n"
+          "      interrupted by a scan every 50000 requests\n\n");
+      exit(0);
+      break;
+    case 'n':
+      sscanf(optarg, "%lu", &options->ios);
+      break;
+    case 'b':
+      sscanf(optarg, "%lu", &options->blocks);
+      LOG_ASSERT(options->blocks > 0u);
+      break;
+    case 'p':
+      sscanf(optarg, "%lu", &options->phase_ios);
+      LOG_ASSERT(options->phase_ios > 0u);
+      break;
+    case 'w':
+      sscanf(optarg, "%lf", &options->write_ratio);
+      LOG_ASSERT(options->write_ratio >= 0 && options->write_ratio <= 1);
+      break;
+    case '=':
+      sscanf(optarg, "%u", &options->seed);
+      break;
+    case 'z':
+      options->compress = true;
+      break;
+    case '~':
+      sscanf(optarg, "%lu", &options->iops);
+      LOG_ASSERT(options->iops > 0u);
+      break;
+    case '?':
+      if (isprint(optopt)) {
+        LOG_FATAL("Unknown option `-%c`", optopt);
+      } else {
+        LOG_FATAL("Unknown option character `\\x%x`", optopt);
+      }
+    default:
+      LOG_FATAL("Should've expected the unknown unknown");
+    }
+  }
+}
+
+void handle_required_args(int argc, char **argv,
+                          struct trace_gen_options *options) {
+  int i;
+
+  if (argc < 1) {
+    LOG_FATAL("Missing non-optional arguments\n"
+              "Try 'trace-gen --help' for more information.");
+  }
+
+  options->nr_workloads = argc;
+  options->workloads = mem_alloc(sizeof(*options->workloads) * argc);
+  if (!options->workloads) {
+    LOG_FATAL("Unable to allocate memory for the workloads");
+  }
+  for (i = 0; i < argc; i++) {
+    if (trace_gen_workload_parse(&options->workloads[i], argv[i],
+                                 options->blocks)) {
+      LOG_FATAL("Unknown workload %s", argv[i]);
+    }
+  }
+}
+
+void handle_args(int argc, char **argv, struct trace_gen_options *options) {
+  handle_optional_args(argc, argv, options);
+  handle_required_args(argc - optind, argv + optind, options);
+}
+
+#endif /* TRACE_GEN_TRACE_GEN_ARGS_H */
@@ -0,0 +1,27 @@
+#ifndef TRACE_GEN_TRACE_GEN_OPTIONS_H
+#define TRACE_GEN_TRACE_GEN_OPTIONS_H
+
+#include "trace_gen_workload.h"
+#include "types.h"
+#include <stdio.h>
+
+struct trace_gen_options {
+  FILE *out;
+  // workloads, taking turns every phase_ios requests when there are several
+  struct trace_gen_workload *workloads;
+  unsigned nr_workloads;
+  uint64_t phase_ios;
+  // number of requests to generate
+  uint64_t ios;
+  // number of blocks of the zipf, uniform and loop workloads
+  uint64_t blocks;
+  // share of the requests that are writes, from 0 to 1
+  double write_ratio;
+  unsigned seed;
+  // requests per second, spacing the timestamps of the requests
+  uint64_t iops;
+  // write a compressed zbin trace rather than a bin trace
+  bool compress;
+};
+
+#endif /* TRACE_GEN_TRACE_GEN_OPTIONS_H */
@@ -0,0 +1,219 @@
+#ifndef TRACE_GEN_TRACE_GEN_WORKLOAD_H
+#define TRACE_GEN_TRACE_GEN_WORKLOAD_H
+
+#include "common.h"
+#include "tools/random.h"
+#include "types.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+/* The workloads trace-gen generates, each a stream of blocks:
+ *
+ * zipf[:ALPHA] - Blocks 0 to blocks - 1, block k being accessed with a
+ *                probability proportional to 1 / (k + 1)^ALPHA (1 if not
+ *                given), so block 0 is the hottest
+ * uniform      - Blocks 0 to blocks - 1, all equally likely
+ * loop[:N]     - Blocks 0 to N - 1 (blocks if not given) in order, over and
+ *                over again
+ * scan         - Blocks from blocks upwards in order, each accessed once, as
+ *                a scan polluting the cache with blocks never reused
+ *
+ * Zipf samples are drawn in constant time, with no table of the blocks, by
+ * rejection-inversion (W. Hormann and G. Derflinger, "Rejection-inversion to
+ * generate variates from monotone discrete distributions", 1996), so any
+ * number of blocks and any ALPHA > 0 can be generated.
+ */
+
+#define TRACE_GEN_WORKLOAD_NAME_MAX_LENGTH 16
+
+enum trace_gen_workload_type {
+  TRACE_GEN_ZIPF,
+  TRACE_GEN_UNIFORM,
+  TRACE_GEN_LOOP,
+  TRACE_GEN_SCAN,
+};
+
+/** trace_gen_zipf
+ * Constants of rejection-inversion for a Zipf distribution
+ *
+ * exponent - ALPHA
+ * h_integral_x1/h_integral_n - H(1.5) - 1 and H(n + 0.5), the range of H
+ *                              the samples are drawn from
+ * s - Samples within s of their rank are always accepted
+ */
+struct trace_gen_zipf {
+  double exponent;
+  double h_integral_x1;
+  double h_integral_n;
+  double s;
+};
+
+/** trace_gen_workload
+ * type - Workload generated
+ * blocks - Number of blocks of the workload (or, for scan, the first one)
+ * pos - Next block of loop and scan
+ * zipf - Constants of zipf
+ */
+struct trace_gen_workload {
+  enum trace_gen_workload_type type;
+  uint64_t blocks;
+  uint64_t pos;
+  struct trace_gen_zipf zipf;
+};
+
+/** A random number of 62 bits
+ */
+static uint64_t trace_gen_random(struct random_state *random) {
+  uint64_t high = random_int(random);
+
+  return (high << 31) | random_int(random);
+}
+
+/** A random number in [0, 1)
+ */
+static double trace_gen_random_double(struct random_state *random) {
+  return (trace_gen_random(random) >> 9) * (1.0 / ((uint64_t)1 << 53));
+}
+
+/** log1p(x) / x, accurate around 0
+ */
+static double __trace_gen_helper1(double x) {
+  return fabs(x) > 1e-8 ? log1p(x) / x : 1 - x * (0.5 - x / 3);
+}
+
+/** expm1(x) / x, accurate around 0
+ */
+static double __trace_gen_helper2(double x) {
+  return fabs(x) > 1e-8 ? expm1(x) / x : 1 + x * 0.5 * (1 + x / 3);
+}
+
+/** H(x), the integral of h(x) = x^-exponent (up to a constant)
+ */
+static double __trace_gen_h_integral(struct trace_gen_zipf *zipf, double x) {
+  double log_x = log(x);
+
+  return __trace_gen_helper2((1 - zipf->exponent) * log_x) * log_x;
+}
+
+static double __trace_gen_h(struct trace_gen_zipf *zipf, double x) {
+  return exp(-zipf->exponent * log(x));
+}
+
+static double __trace_gen_h_integral_inverse(struct trace_gen_zipf *zipf,
+                                             double x) {
+  double t = x * (1 - zipf->exponent);
+
+  if (t < -1) {
+    t = -1;
+  }
+  return exp(__trace_gen_helper1(t) * x);
+}
+
+static void __trace_gen_zipf_init(struct trace_gen_zipf *zipf, uint64_t n,
+                                  double exponent) {
+  zipf->exponent = exponent;
+  zipf->h_integral_x1 = __trace_gen_h_integral(zipf, 1.5) - 1;
+  zipf->h_integral_n = __trace_gen_h_integral(zipf, n + 0.5);
+  zipf->s = 2 - __trace_gen_h_integral_inverse(
+                    zipf, __trace_gen_h_integral(zipf, 2.5) -
+                              __trace_gen_h(zipf, 2));
+}
+
+/** A rank from 1 to n, drawn from the Zipf distribution
+ */
+static uint64_t __trace_gen_zipf_next(struct trace_gen_zipf *zipf, uint64_t n,
+                                      struct random_state *random) {
+  double u;
+  double x;
+  uint64_t k;
+
+  for (;;) {
+    u = zipf->h_integral_n +
+        trace_gen_random_double(random) *
+            (zipf->h_integral_x1 - zipf->h_integral_n);
+    x = __trace_gen_h_integral_inverse(zipf, u);
+
+    k = (uint64_t)(x + 0.5);
+    if (k < 1) {
+      k = 1;
+    } else if (k > n) {
+      k = n;
+    }
+
+    if (k - x <= zipf->s ||
+        u >= __trace_gen_h_integral(zipf, k + 0.5) - __trace_gen_h(zipf, k)) {
+      return k;
+    }
+  }
+}
+
+/** Parse a workload given as NAME[:PARAMETER], over the given number of blocks
+ *
+ * \return 0 if parsed, or not 0 if it isn't a workload
+ */
+static int trace_gen_workload_parse(struct trace_gen_workload *w,
+                                    const char *arg, uint64_t blocks) {
+  char name[TRACE_GEN_WORKLOAD_NAME_MAX_LENGTH + 1];
+  const char *colon = strchr(arg, ':');
+  size_t len = colon ? (size_t)(colon - arg) : strlen(arg);
+  double alpha = 1;
+  char end;
+
+  if (len > TRACE_GEN_WORKLOAD_NAME_MAX_LENGTH) {
+    return 1;
+  }
+  memcpy(name, arg, len);
+  name[len] = '\0';
+
+  w->blocks = blocks;
+  w->pos = 0;
+
+  if (strcmp(name, "zipf") == 0) {
+    if (colon && (sscanf(colon + 1, "%lf%c", &alpha, &end) != 1 ||
+                  alpha <= 0)) {
+      return 1;
+    }
+    w->type = TRACE_GEN_ZIPF;
+    __trace_gen_zipf_init(&w->zipf, blocks, alpha);
+  } else if (strcmp(name, "loop") == 0) {
+    if (colon && (sscanf(colon + 1, "%lu%c", &w->blocks, &end) != 1 ||
+                  w->blocks == 0)) {
+      return 1;
+    }
+    w->type = TRACE_GEN_LOOP;
+  } else if (colon) {
+    return 1;
+  } else if (strcmp(name, "uniform") == 0) {
+    w->type = TRACE_GEN_UNIFORM;
+  } else if (strcmp(name, "scan") == 0) {
+    w->type = TRACE_GEN_SCAN;
+    w->pos = blocks;
+  } else {
+    return 1;
+  }
+  return 0;
+}
+
+/** Next block of the workload
+ */
+static oblock_t trace_gen_workload_next(struct trace_gen_workload *w,
+                                        struct random_state *random) {
+  oblock_t block;
+
+  switch (w->type) {
+  case TRACE_GEN_ZIPF:
+    return __trace_gen_zipf_next(&w->zipf, w->blocks, random) - 1;
+  case TRACE_GEN_UNIFORM:
+    return trace_gen_random(random) % w->blocks;
+  case TRACE_GEN_LOOP:
+    block = w->pos;
+    w->pos = (w->pos + 1) % w->blocks;
+    return block;
+  case TRACE_GEN_SCAN:
+  default:
+    return w->pos++;
+  }
+}
+
+#endif /* TRACE_GEN_TRACE_GEN_WORKLOAD_H */
@@ -1,6 +1,8 @@
 #ifndef TRACE_READER_BASIC_TRACE_H
 #define TRACE_READER_BASIC_TRACE_H
 
+#include "common.h"
+#include "trace_reader/trace_buffer.h"
 #include "trace_reader/trace_reader_structs.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -10,36 +12,122 @@
  * another, it cannot support the duration_hrs feature.
  */
 
-static int basic_trace_init(FILE *file, unsigned duration_hrs);
-static int basic_trace_read(struct trace_reader_result *result);
+/** basic_struct
+ * Tracks trace information
+ */
+struct basic_struct {
+  struct trace_reader reader;
+  struct trace_buffer tb;
+};
 
-struct trace_reader basic_trace = {
+static int basic_trace_read(struct trace_reader *reader,
+                            struct trace_reader_result *result);
+static int basic_trace_read_request(struct trace_reader *reader,
+                                    struct trace_request *request);
+static void basic_trace_set_range(struct trace_reader *reader, off_t start,
+                                  off_t end);
+static void basic_trace_exit(struct trace_reader *reader);
+
+static const struct trace_reader basic_trace = {
     .features = {0},
     .file = NULL,
-    .init = basic_trace_init,
+    .block_stride = 1,
+    .oblock_size = 0,
+    .sampling_rate = 1,
+    .eof = false,
     .read = basic_trace_read,
+    .read_request = basic_trace_read_request,
+    .set_range = basic_trace_set_range,
+    .seek = NULL,
+    .exit = basic_trace_exit,
 };
 
-static int basic_trace_init(FILE *file, unsigned duration_hrs) {
-  basic_trace.file = file;
-  basic_trace.features.use_duration = false; // not supported
-  return 0;
+/** Create a trace_reader for the trace in file
+ *
+ * \return The trace_reader, or NULL if unable to allocate memory
+ */
+static struct trace_reader *basic_trace_create(FILE *file,
+                                               unsigned duration_hrs) {
+  struct basic_struct *basic_info =
+      (struct basic_struct *)mem_alloc(sizeof(*basic_info));
+
+  if (basic_info == NULL) {
+    return NULL;
+  }
+
+  basic_info->reader = basic_trace;
+  basic_info->reader.file = file;
+  basic_info->reader.features.use_duration = false; // not supported
+
+  if (trace_buffer_init(&basic_info->tb, file)) {
+    mem_free(basic_info);
+    return NULL;
+  }
+  return &basic_info->reader;
 }
 
-static int basic_trace_read(struct trace_reader_result *result) {
-  FILE *file = basic_trace.file;
+static void basic_trace_set_range(struct trace_reader *reader, off_t start,
+                                  off_t end) {
+  struct basic_struct *basic_info =
+      container_of(reader, struct basic_struct, reader);
+
+  trace_buffer_set_range(&basic_info->tb, start, end);
+  reader->eof = false;
+}
+
+static void basic_trace_exit(struct trace_reader *reader) {
+  struct basic_struct *basic_info =
+      container_of(reader, struct basic_struct, reader);
+
+  trace_buffer_exit(&basic_info->tb);
+  mem_free(basic_info);
+}
+
+static int basic_trace_read_request(struct trace_reader *reader,
+                                    struct trace_request *request) {
+  struct basic_struct *basic_info =
+      container_of(reader, struct basic_struct, reader);
+  char *line;
   oblock_t oblock;
 
-  if (fscanf(file, "%lu", &oblock) != 1) {
-    if (feof(file)) {
-      LOG_DEBUG("end of file reached");
+  if (trace_buffer_next_line(&basic_info->tb, &line)) {
+    if (basic_info->tb.error) {
+      LOG_DEBUG("couldn't read file properly. error %d",
+                basic_info->tb.error);
     } else {
-      LOG_DEBUG("couldn't read file properly. error %d", ferror(file));
+      LOG_DEBUG("end of file reached");
+      reader->eof = true;
     }
     return 1;
   }
 
-  result->oblock = oblock;
+  if (trace_parse_u64(&line, &oblock)) {
+    LOG_DEBUG("couldn't parse line");
+    return 1;
+  }
+
+  request->oblock = oblock;
+  request->nr_blocks = 1;
+  request->write = false;
+  request->ts = 0;
+  request->volume = 0;
+  request->pid = 0;
+  request->process = 0;
+
+  return 0;
+}
+
+static int basic_trace_read(struct trace_reader *reader,
+                            struct trace_reader_result *result) {
+  struct trace_request request;
+
+  if (basic_trace_read_request(reader, &request)) {
+    return 1;
+  }
+
+  result->oblock = request.oblock;
+  result->nr_blocks = request.nr_blocks;
+  result->write = request.write;
 
   return 0;
 }
@@ -0,0 +1,362 @@
+#ifndef TRACE_READER_BIN_TRACE_H
+#define TRACE_READER_BIN_TRACE_H
+
+#include "common.h"
+#include "trace_reader/trace_reader_structs.h"
+#include "types.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* The bin traces are a compact, fixed-record binary format that any other
+ * trace format can be converted into (see trace-convert). Since every record
+ * has the same size and needs no parsing, replaying a converted trace is only
+ * bound by memory bandwidth: regular files are mmap'd and walked in place,
+ * while anything else (such as a pipe on standard input) is read with fread.
+ *
+ * Records hold whole requests (as given by trace_reader's read_request()),
+ * made up of nr_blocks accesses, block_stride apart, like in the original
+ * trace format.
+ *
+ * Format (native byte order):
+ * [bin_trace_header] [bin_trace_record]... [hour index]
+ *
+ * Timestamps are in nanoseconds, regardless of the original trace format, so
+ * the bin traces support the duration feature.
+ *
+ * A bin trace may also have been sampled when written, in which case its
+ * records are the single sampled accesses (to the hashes of their oblocks),
+ * and cache-sim simulates it at the sampling rate it was sampled at.
+ *
+ * When the number of records is known, the records may be followed by an hour
+ * index of nr_hours uint64_t, where entry h is the number of the first record
+ * (in trace order) at least h hours after the first record. Any hour (and any
+ * record) of a mmap'd bin trace can then be jumped to without reading the
+ * records before it (see seek() in trace_reader).
+ */
+
+#define BIN_TRACE_MAGIC "FOMOBIN"
+#define BIN_TRACE_VERSION 1
+// nanosecond -> second -> minute -> hour
+static const long long BIN_HOUR_LENGTH = 1000000000L * 60 * 60;
+
+/** bin_trace_header
+ * magic - BIN_TRACE_MAGIC, including the terminating null character
+ * version - BIN_TRACE_VERSION of the writer
+ * record_size - Size of a bin_trace_record
+ * block_stride - oblock increment between accesses of a request, as given by
+ *                the original trace format
+ * nr_records - Number of records following the header, or 0 if unknown (such
+ *              as when the trace was written to a pipe)
+ * nr_hours - Number of entries in the hour index following the records, or 0
+ *            if there is none
+ * sampling_rate - Rate the trace was sampled at when written (see
+ *                 trace_sampling.h), or 0 (or 1) if it wasn't sampled
+ * oblock_size - Bytes per oblock address, as given by the original trace
+ *               format (0 if not in bytes)
+ */
+struct bin_trace_header {
+  char magic[8];
+  uint32_t version;
+  uint32_t record_size;
+  uint64_t block_stride;
+  uint64_t nr_records;
+  uint64_t nr_hours;
+  uint64_t sampling_rate;
+  uint64_t oblock_size;
+  uint64_t reserved[1];
+};
+
+/** bin_trace_record
+ * oblock - First origin block device address of the request
+ * ts - Timestamp in nanoseconds
+ * nr_blocks - Number of accesses of the request
+ * flags - BIN_TRACE_WRITE if the request is a write
+ */
+struct bin_trace_record {
+  uint64_t oblock;
+  uint64_t ts;
+  uint32_t nr_blocks;
+  uint32_t flags;
+};
+
+#define BIN_TRACE_WRITE 0x1
+
+/** bin_struct
+ * Tracks trace information
+ *
+ * records/nr_records/next - mmap'd records (NULL if not mmap'd), their count
+ *                           (0 if unknown) and index of the next record to
+ *                           read
+ * hour_index/nr_hours - mmap'd hour index (NULL if there is none)
+ * map/map_size - The whole mmap'd file, for munmap
+ */
+struct bin_struct {
+  struct trace_reader reader;
+  bool starting_time_set;
+  uint64_t starting_time;
+  uint64_t ending_time;
+
+  struct bin_trace_record *records;
+  uint64_t nr_records;
+  uint64_t next;
+  uint64_t *hour_index;
+  uint64_t nr_hours;
+  void *map;
+  size_t map_size;
+};
+
+static int bin_trace_read(struct trace_reader *reader,
+                          struct trace_reader_result *result);
+static int bin_trace_read_request(struct trace_reader *reader,
+                                  struct trace_request *request);
+static int bin_trace_seek(struct trace_reader *reader, unsigned start_hrs,
+                          uint64_t skip_ios);
+static void bin_trace_exit(struct trace_reader *reader);
+
+static const struct trace_reader bin_trace = {
+    .features = {0},
+    .file = NULL,
+    .block_stride = 1,
+    .oblock_size = 0,
+    .sampling_rate = 1,
+    .eof = false,
+    .read = bin_trace_read,
+    .read_request = bin_trace_read_request,
+    .set_range = NULL,
+    .seek = bin_trace_seek,
+    .exit = bin_trace_exit,
+};
+
+static void bin_trace_header_init(struct bin_trace_header *header,
+                                  block_t block_stride, uint64_t nr_records) {
+  memset(header, 0, sizeof(*header));
+  memcpy(header->magic, BIN_TRACE_MAGIC, sizeof(header->magic));
+  header->version = BIN_TRACE_VERSION;
+  header->record_size = sizeof(struct bin_trace_record);
+  header->block_stride = block_stride;
+  header->nr_records = nr_records;
+}
+
+static bool bin_trace_header_valid(struct bin_trace_header *header) {
+  return memcmp(header->magic, BIN_TRACE_MAGIC, sizeof(header->magic)) == 0 &&
+         header->version == BIN_TRACE_VERSION &&
+         header->record_size == sizeof(struct bin_trace_record) &&
+         header->block_stride > 0;
+}
+
+/** mmap the whole trace if it is a regular file
+ *
+ * \return 0 if mmap'd, not 0 if the trace has to be read with fread instead
+ */
+static int bin_trace_map(struct bin_struct *bin_info, FILE *file) {
+  struct stat st;
+  char *map;
+  int fd = fileno(file);
+
+  if (fd < 0 || fstat(fd, &st) || !S_ISREG(st.st_mode) ||
+      (size_t)st.st_size < sizeof(struct bin_trace_header)) {
+    return 1;
+  }
+
+  map = (char *)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (map == MAP_FAILED) {
+    return 1;
+  }
+  madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+  bin_info->map = map;
+  bin_info->map_size = st.st_size;
+  bin_info->records =
+      (struct bin_trace_record *)(map + sizeof(struct bin_trace_header));
+  bin_info->nr_records = (st.st_size - sizeof(struct bin_trace_header)) /
+                         sizeof(struct bin_trace_record);
+  return 0;
+}
+
+/** Find the hour index following the mmap'd records, if there is one
+ */
+static void bin_trace_map_hour_index(struct bin_struct *bin_info,
+                                     struct bin_trace_header *header) {
+  size_t offset = sizeof(struct bin_trace_header) +
+                  header->nr_records * sizeof(struct bin_trace_record);
+
+  if (header->nr_hours == 0 ||
+      offset + header->nr_hours * sizeof(uint64_t) > bin_info->map_size) {
+    return;
+  }
+
+  bin_info->hour_index = (uint64_t *)((char *)bin_info->map + offset);
+  bin_info->nr_hours = header->nr_hours;
+}
+
+/** Create a trace_reader for the trace in file
+ *
+ * \return The trace_reader, or NULL if unable to allocate memory
+ */
+static struct trace_reader *bin_trace_create(FILE *file,
+                                             unsigned duration_hrs) {
+  struct bin_trace_header header;
+  struct bin_struct *bin_info =
+      (struct bin_struct *)mem_alloc(sizeof(*bin_info));
+
+  if (bin_info == NULL) {
+    return NULL;
+  }
+
+  bin_info->reader = bin_trace;
+  bin_info->reader.file = file;
+
+  if (duration_hrs > 0) {
+    bin_info->reader.features.use_duration = true;
+    bin_info->reader.features.duration_hrs = duration_hrs;
+  } else {
+    bin_info->reader.features.use_duration = false;
+  }
+
+  bin_info->starting_time_set = false;
+  bin_info->records = NULL;
+  bin_info->nr_records = 0;
+  bin_info->next = 0;
+  bin_info->hour_index = NULL;
+  bin_info->nr_hours = 0;
+  bin_info->map = NULL;
+
+  if (!bin_trace_map(bin_info, file)) {
+    memcpy(&header, bin_info->map, sizeof(header));
+  } else if (fread(&header, sizeof(header), 1, file) != 1) {
+    LOG_FATAL("couldn't read bin trace header");
+  }
+
+  if (!bin_trace_header_valid(&header)) {
+    LOG_FATAL("not a (supported) bin trace");
+  }
+
+  bin_info->reader.block_stride = header.block_stride;
+  bin_info->reader.oblock_size = header.oblock_size;
+  if (header.sampling_rate > 1) {
+    bin_info->reader.sampling_rate = header.sampling_rate;
+  }
+  if (bin_info->records == NULL) {
+    // when read with fread, the records end where the hour index starts
+    bin_info->nr_records = header.nr_records;
+  } else if (header.nr_records > 0 &&
+             header.nr_records <= bin_info->nr_records) {
+    bin_info->nr_records = header.nr_records;
+    bin_trace_map_hour_index(bin_info, &header);
+  }
+
+  return &bin_info->reader;
+}
+
+static void bin_trace_exit(struct trace_reader *reader) {
+  struct bin_struct *bin_info = container_of(reader, struct bin_struct, reader);
+
+  if (bin_info->map != NULL) {
+    munmap(bin_info->map, bin_info->map_size);
+  }
+  mem_free(bin_info);
+}
+
+static int bin_trace_read_request(struct trace_reader *reader,
+                                  struct trace_request *request) {
+  struct bin_struct *bin_info = container_of(reader, struct bin_struct, reader);
+  struct bin_trace_record record;
+  struct bin_trace_record *r = &record;
+
+  if (bin_info->records != NULL) {
+    if (bin_info->next == bin_info->nr_records) {
+      LOG_DEBUG("end of file reached");
+      reader->eof = true;
+      return 1;
+    }
+    r = &bin_info->records[bin_info->next++];
+  } else if ((bin_info->nr_records > 0 &&
+              bin_info->next == bin_info->nr_records) ||
+             fread(&record, sizeof(record), 1, reader->file) != 1) {
+    if (bin_info->nr_records > 0 || feof(reader->file)) {
+      LOG_DEBUG("end of file reached");
+      reader->eof = true;
+    } else {
+      LOG_DEBUG("couldn't read file properly. error %d", ferror(reader->file));
+    }
+    return 1;
+  } else {
+    ++bin_info->next;
+  }
+
+  request->oblock = r->oblock;
+  request->nr_blocks = r->nr_blocks;
+  request->write = r->flags & BIN_TRACE_WRITE;
+  request->ts = r->ts;
+  request->volume = 0;
+  request->pid = 0;
+  request->process = 0;
+
+  if (reader->features.use_duration) {
+    if (!bin_info->starting_time_set) {
+      bin_info->starting_time = r->ts;
+      bin_info->ending_time =
+          r->ts + (BIN_HOUR_LENGTH * reader->features.duration_hrs);
+      bin_info->starting_time_set = true;
+    }
+    if (r->ts > bin_info->ending_time) {
+      LOG_DEBUG("end of duration reached");
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+/** Jump to the first record at least start_hrs hours after the first record,
+ * and skip_ios records past it, before any record has been read
+ *
+ * \return 0 if done, or not 0 if the trace isn't mmap'd (or has no hour
+ *         index to find start_hrs with)
+ */
+static int bin_trace_seek(struct trace_reader *reader, unsigned start_hrs,
+                          uint64_t skip_ios) {
+  struct bin_struct *bin_info = container_of(reader, struct bin_struct, reader);
+  uint64_t next = 0;
+
+  if (bin_info->records == NULL ||
+      (start_hrs > 0 && bin_info->hour_index == NULL)) {
+    return 1;
+  }
+
+  if (start_hrs >= bin_info->nr_hours) {
+    // no record is that many hours after the first one
+    next = bin_info->nr_records;
+  } else if (start_hrs > 0) {
+    next = bin_info->hour_index[start_hrs];
+  }
+
+  if (skip_ios > bin_info->nr_records - next) {
+    next = bin_info->nr_records;
+  } else {
+    next += skip_ios;
+  }
+
+  bin_info->next = next;
+  return 0;
+}
+
+static int bin_trace_read(struct trace_reader *reader,
+                          struct trace_reader_result *result) {
+  struct trace_request request;
+
+  if (bin_trace_read_request(reader, &request)) {
+    return 1;
+  }
+
+  result->oblock = request.oblock;
+  result->nr_blocks = request.nr_blocks;
+  result->write = request.write;
+
+  return 0;
+}
+
+#endif
@@ -0,0 +1,160 @@
+#ifndef TRACE_READER_BIN_TRACE_WRITER_H
+#define TRACE_READER_BIN_TRACE_WRITER_H
+
+#include "common.h"
+#include "trace_reader/bin_trace.h"
+#include "trace_reader/zbin_trace.h"
+#include "types.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Writes bin traces (see bin_trace.h), or compressed zbin traces (see
+ * zbin_trace.h), for the tools producing them (trace-convert and trace-gen).
+ *
+ * The number of records is only known once every record has been written, so
+ * it is written into the header afterwards if the output is seekable, along
+ * with the hour index following the records of a bin trace. Otherwise, it is
+ * left as 0 (read until EOF), without an hour index, which couldn't be told
+ * apart from the records.
+ */
+
+/** bin_trace_writer
+ * out - Where the bin trace is written
+ * header - Header of the bin trace, as written on close
+ * zbin/enc - Header and encoder of the zbin trace, if compressed (NULL if not)
+ * hours/nr_hours/capacity - Hour index: entry h is the number of the first
+ *                           record at least h hours after the first record
+ * starting_time - Time of the first record
+ */
+struct bin_trace_writer {
+  FILE *out;
+  struct bin_trace_header header;
+  struct zbin_trace_header zbin;
+  struct zbin_trace_encoder *enc;
+  uint64_t *hours;
+  uint64_t nr_hours;
+  uint64_t capacity;
+  uint64_t starting_time;
+};
+
+static void __bin_trace_writer_header(struct bin_trace_writer *w) {
+  size_t r;
+
+  if (w->enc != NULL) {
+    w->zbin.nr_records = w->header.nr_records;
+    r = fwrite(&w->zbin, sizeof(w->zbin), 1, w->out);
+  } else {
+    r = fwrite(&w->header, sizeof(w->header), 1, w->out);
+  }
+  if (r != 1) {
+    LOG_FATAL("couldn't write bin trace header. error %d", ferror(w->out));
+  }
+}
+
+/** Start a bin trace (zbin trace if compressed) of requests block_stride
+ * apart, of oblock_size bytes per oblock address (0 if not in bytes), sampled
+ * at sampling_rate (1 if not)
+ */
+static void bin_trace_writer_init(struct bin_trace_writer *w, FILE *out,
+                                  block_t block_stride, uint64_t oblock_size,
+                                  uint64_t sampling_rate, bool compressed) {
+  w->out = out;
+  w->enc = NULL;
+  w->hours = NULL;
+  w->nr_hours = 0;
+  w->capacity = 0;
+  w->starting_time = 0;
+
+  bin_trace_header_init(&w->header, block_stride, 0);
+  w->header.oblock_size = oblock_size;
+  w->header.sampling_rate = sampling_rate;
+
+  if (compressed) {
+    w->enc = (struct zbin_trace_encoder *)mem_alloc(sizeof(*w->enc));
+    if (w->enc == NULL || zbin_trace_encoder_init(w->enc)) {
+      LOG_FATAL("Unable to allocate memory for the zbin trace encoder");
+    }
+    zbin_trace_header_init(&w->zbin, block_stride);
+    w->zbin.oblock_size = oblock_size;
+    w->zbin.sampling_rate = sampling_rate;
+  }
+  __bin_trace_writer_header(w);
+}
+
+static void __bin_trace_writer_hour(struct bin_trace_writer *w, uint64_t ts) {
+  uint64_t record = w->header.nr_records;
+
+  if (record == 0) {
+    w->starting_time = ts;
+  }
+
+  while (ts >= w->starting_time + w->nr_hours * BIN_HOUR_LENGTH) {
+    if (w->nr_hours == w->capacity) {
+      w->capacity = w->capacity ? 2 * w->capacity : 1024;
+      w->hours = (uint64_t *)realloc(w->hours, sizeof(*w->hours) * w->capacity);
+      if (w->hours == NULL) {
+        LOG_FATAL("Unable to allocate memory for the hour index");
+      }
+    }
+    w->hours[w->nr_hours++] = record;
+  }
+}
+
+/** Write a record of nr_blocks accesses from oblock, at time ts
+ */
+static void bin_trace_writer_add(struct bin_trace_writer *w, oblock_t oblock,
+                                 block_t nr_blocks, uint64_t ts, bool write) {
+  struct bin_trace_record record;
+
+  if (w->enc != NULL) {
+    zbin_trace_encoder_add(w->enc, w->out, w->header.block_stride, oblock,
+                           nr_blocks, ts, write);
+    ++w->header.nr_records;
+    return;
+  }
+
+  record.oblock = oblock;
+  record.ts = ts;
+  record.nr_blocks = nr_blocks;
+  record.flags = write ? BIN_TRACE_WRITE : 0;
+  if (fwrite(&record, sizeof(record), 1, w->out) != 1) {
+    LOG_FATAL("couldn't write bin trace record. error %d", ferror(w->out));
+  }
+
+  __bin_trace_writer_hour(w, ts);
+  ++w->header.nr_records;
+}
+
+/** Write the hour index and the final header (if the output is seekable), and
+ * close the output
+ */
+static void bin_trace_writer_close(struct bin_trace_writer *w) {
+  if (w->enc != NULL) {
+    zbin_trace_encoder_flush(w->enc, w->out);
+  }
+
+  // Pipes can't be rewound, in which case the record count stays unknown
+  if (fseek(w->out, 0, SEEK_CUR) == 0) {
+    if (fwrite(w->hours, sizeof(*w->hours), w->nr_hours, w->out) !=
+        w->nr_hours) {
+      LOG_FATAL("couldn't write bin trace hour index. error %d",
+                ferror(w->out));
+    }
+    if (fseek(w->out, 0, SEEK_SET) == 0) {
+      w->header.nr_hours = w->nr_hours;
+      __bin_trace_writer_header(w);
+    }
+  }
+
+  free(w->hours);
+  if (w->enc != NULL) {
+    zbin_trace_encoder_exit(w->enc);
+    mem_free(w->enc);
+  }
+  if (fclose(w->out)) {
+    LOG_FATAL("couldn't close output. errno %d", errno);
+  }
+}
+
+#endif /* TRACE_READER_BIN_TRACE_WRITER_H */
@@ -1,10 +1,14 @@
 #ifndef TRACE_READER_FIU_TRACE_H
 #define TRACE_READER_FIU_TRACE_H
 
+#include "common.h"
+#include "trace_reader/trace_buffer.h"
+#include "trace_reader/trace_process.h"
 #include "trace_reader/trace_reader_structs.h"
 #include "types.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 /* The FIU traces use logical block address (lba) and size (based on blocks of
  * size 512 bytes). Since the FIU traces also are based on filesystem accesses,
@@ -34,96 +38,159 @@ static const long long FIU_HOUR_LENGTH = 1000000000L * 60 * 60;
  * Tracks trace information
  */
 struct fiu_struct {
-  oblock_t addr;
-  bool write;
-  block_t pages_left;
+  struct trace_reader reader;
   bool starting_time_set;
   uint64_t starting_time;
   uint64_t ending_time;
+  struct trace_buffer tb;
 };
 
-struct fiu_struct fiu_info = {
-    .addr = 0,
-    .write = false,
-    .pages_left = 0,
-};
-
-static int fiu_trace_init(FILE *file, unsigned duration_hrs);
-static int fiu_trace_read(struct trace_reader_result *result);
+static int fiu_trace_read(struct trace_reader *reader,
+                          struct trace_reader_result *result);
+static int fiu_trace_read_request(struct trace_reader *reader,
+                                  struct trace_request *request);
+static void fiu_trace_set_range(struct trace_reader *reader, off_t start,
+                                off_t end);
+static void fiu_trace_exit(struct trace_reader *reader);
 
-struct trace_reader fiu_trace = {
+static const struct trace_reader fiu_trace = {
     .features = {0},
     .file = NULL,
-    .init = fiu_trace_init,
+    .block_stride = FIU_BLOCKS_PER_PAGE,
+    .oblock_size = FIU_BLOCK_SIZE,
+    .sampling_rate = 1,
+    .eof = false,
     .read = fiu_trace_read,
+    .read_request = fiu_trace_read_request,
+    .set_range = fiu_trace_set_range,
+    .seek = NULL,
+    .exit = fiu_trace_exit,
 };
 
-static int fiu_trace_init(FILE *file, unsigned duration_hrs) {
-  fiu_trace.file = file;
+/** Create a trace_reader for the trace in file
+ *
+ * \return The trace_reader, or NULL if unable to allocate memory
+ */
+static struct trace_reader *fiu_trace_create(FILE *file,
+                                             unsigned duration_hrs) {
+  struct fiu_struct *fiu_info =
+      (struct fiu_struct *)mem_alloc(sizeof(*fiu_info));
+
+  if (fiu_info == NULL) {
+    return NULL;
+  }
+
+  fiu_info->reader = fiu_trace;
+  fiu_info->reader.file = file;
 
   if (duration_hrs > 0) {
-    fiu_trace.features.use_duration = true;
-    fiu_trace.features.duration_hrs = duration_hrs;
+    fiu_info->reader.features.use_duration = true;
+    fiu_info->reader.features.duration_hrs = duration_hrs;
   } else {
-    fiu_trace.features.use_duration = false;
+    fiu_info->reader.features.use_duration = false;
   }
 
-  fiu_info.starting_time_set = false;
-  return 0;
+  fiu_info->starting_time_set = false;
+
+  if (trace_buffer_init(&fiu_info->tb, file)) {
+    mem_free(fiu_info);
+    return NULL;
+  }
+  return &fiu_info->reader;
 }
 
-static int fiu_trace_read(struct trace_reader_result *result) {
-  FILE *file = fiu_trace.file;
+static void fiu_trace_set_range(struct trace_reader *reader, off_t start,
+                                off_t end) {
+  struct fiu_struct *fiu_info = container_of(reader, struct fiu_struct, reader);
 
-  if (fiu_info.pages_left > 0) {
-    fiu_info.addr += FIU_BLOCKS_PER_PAGE;
-    --fiu_info.pages_left;
-  } else {
-    block_t size = 0;
-    block_t align;
-    char io[20];
-    uint64_t ts;
-
-    while (size == 0) {
-      if (fscanf(file, "%lu %*d %*s %lu %lu %s %*d %*d %*s\n", &ts,
-                 &fiu_info.addr, &size, io) != 4) {
-        if (feof(file)) {
-          LOG_DEBUG("end of file reached");
-        } else {
-          LOG_DEBUG("couldn't read file properly. error %d", ferror(file));
-        }
-        return 1;
+  trace_buffer_set_range(&fiu_info->tb, start, end);
+  reader->eof = false;
+  fiu_info->starting_time_set = false;
+}
+
+static void fiu_trace_exit(struct trace_reader *reader) {
+  struct fiu_struct *fiu_info = container_of(reader, struct fiu_struct, reader);
+
+  trace_buffer_exit(&fiu_info->tb);
+  mem_free(fiu_info);
+}
+
+static int fiu_trace_read_request(struct trace_reader *reader,
+                                  struct trace_request *request) {
+  struct fiu_struct *fiu_info = container_of(reader, struct fiu_struct, reader);
+  char *line;
+  block_t size = 0;
+  block_t align;
+  oblock_t addr;
+  char *io;
+  char *process;
+  unsigned pid;
+  uint64_t ts;
+
+  while (size == 0) {
+    if (trace_buffer_next_line(&fiu_info->tb, &line)) {
+      if (fiu_info->tb.error) {
+        LOG_DEBUG("couldn't read file properly. error %d", fiu_info->tb.error);
+      } else {
+        LOG_DEBUG("end of file reached");
+        reader->eof = true;
       }
+      return 1;
     }
 
-    // align block address
-    // remainder blocks from realignment added to size
-    align = fiu_info.addr % FIU_BLOCKS_PER_PAGE;
-    fiu_info.addr -= align;
-    size += align;
-
-    fiu_info.write = io[0] == 'W';
-    fiu_info.pages_left = (size / FIU_BLOCKS_PER_PAGE) - 1;
-    if (size % FIU_BLOCKS_PER_PAGE != 0) {
-      ++fiu_info.pages_left;
+    // [ts] [pid] [process] [lba] [size] [Write or Read] ...
+    if (trace_parse_u64(&line, &ts) || trace_parse_u32(&line, &pid) ||
+        trace_parse_token(&line, &process) || trace_parse_u64(&line, &addr) ||
+        trace_parse_u64(&line, &size) || trace_parse_token(&line, &io)) {
+      LOG_DEBUG("couldn't parse line");
+      return 1;
     }
+  }
 
-    if (fiu_trace.features.use_duration) {
-      if (!fiu_info.starting_time_set) {
-        fiu_info.starting_time = ts;
-        fiu_info.ending_time =
-            ts + (FIU_HOUR_LENGTH * fiu_trace.features.duration_hrs);
-        fiu_info.starting_time_set = true;
-      }
-      if (ts > fiu_info.ending_time) {
-        LOG_DEBUG("end of duration reached");
-        return 1;
-      }
+  // align block address
+  // remainder blocks from realignment added to size
+  align = addr % FIU_BLOCKS_PER_PAGE;
+  addr -= align;
+  size += align;
+
+  request->oblock = addr;
+  request->write = io[0] == 'W';
+  request->nr_blocks = size / FIU_BLOCKS_PER_PAGE;
+  if (size % FIU_BLOCKS_PER_PAGE != 0) {
+    ++request->nr_blocks;
+  }
+  request->ts = ts;
+  request->volume = 0;
+  request->pid = pid;
+  request->process = trace_process_id(process, strcspn(process, " \t\r"));
+
+  if (reader->features.use_duration) {
+    if (!fiu_info->starting_time_set) {
+      fiu_info->starting_time = ts;
+      fiu_info->ending_time =
+          ts + (FIU_HOUR_LENGTH * reader->features.duration_hrs);
+      fiu_info->starting_time_set = true;
     }
+    if (ts > fiu_info->ending_time) {
+      LOG_DEBUG("end of duration reached");
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+static int fiu_trace_read(struct trace_reader *reader,
+                          struct trace_reader_result *result) {
+  struct trace_request request;
+
+  if (fiu_trace_read_request(reader, &request)) {
+    return 1;
   }
 
-  result->oblock = fiu_info.addr;
-  result->write = fiu_info.write;
+  result->oblock = request.oblock;
+  result->nr_blocks = request.nr_blocks;
+  result->write = request.write;
 
   return 0;
 }
@@ -1,10 +1,14 @@
 #ifndef TRACE_READER_MSR_TRACE_H
 #define TRACE_READER_MSR_TRACE_H
 
+#include "common.h"
+#include "trace_reader/trace_buffer.h"
 #include "trace_reader/trace_reader_structs.h"
+#include "trace_reader/trace_volume.h"
 #include "types.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 /* The MSR traces have addresses and size in bytes.
  * We find with that the traces were originally collected in blocks, but later
@@ -20,6 +24,9 @@
  * as "Windows Filetime", which is essentially in the scale of 100 nanoseconds,
  * which is the only detail needed for support.
  *
+ * A trace may hold the requests of several volumes, each (Hostname, DiskNumber)
+ * being a volume of its own, named Hostname_DiskNumber (see trace_volume.h).
+ *
  * Paper:
  * Write Off-Loading: Practical Power Management for Enterprise Storage
  * Dushyanth Narayanan, Austin Donnelly, and Antony Rowstron
@@ -32,96 +39,193 @@ static const block_t MSR_BLOCK_SIZE = 512;
 // 100 nanosecond -> second -> minute -> hour
 static const long long MSR_HOUR_LENGTH = 10000000L * 60 * 60;
 
+/** msr_struct
+ * Tracks trace information
+ *
+ * volume_name/volume - Volume of the last request read, and its number, which
+ *                      most requests share with the request before them
+ */
 struct msr_struct {
-  oblock_t addr;
-  bool write;
-  block_t blocks_left;
+  struct trace_reader reader;
   bool starting_time_set;
   uint64_t starting_time;
   uint64_t ending_time;
+  struct trace_buffer tb;
+  char volume_name[TRACE_VOLUME_NAME_MAX_LENGTH];
+  unsigned volume;
 };
 
-struct msr_struct msr_info = {
-    .addr = 0,
-    .write = false,
-    .blocks_left = 0,
-};
-
-static int msr_trace_init(FILE *file, unsigned duration_hrs);
-static int msr_trace_read(struct trace_reader_result *result);
+static int msr_trace_read(struct trace_reader *reader,
+                          struct trace_reader_result *result);
+static int msr_trace_read_request(struct trace_reader *reader,
+                                  struct trace_request *request);
+static void msr_trace_set_range(struct trace_reader *reader, off_t start,
+                                off_t end);
+static void msr_trace_exit(struct trace_reader *reader);
 
-struct trace_reader msr_trace = {
+static const struct trace_reader msr_trace = {
     .features = {0},
     .file = NULL,
-    .init = msr_trace_init,
+    .block_stride = MSR_BLOCK_SIZE,
+    .oblock_size = 1,
+    .sampling_rate = 1,
+    .eof = false,
     .read = msr_trace_read,
+    .read_request = msr_trace_read_request,
+    .set_range = msr_trace_set_range,
+    .seek = NULL,
+    .exit = msr_trace_exit,
 };
 
-static int msr_trace_init(FILE *file, unsigned duration_hrs) {
-  msr_trace.file = file;
+/** Create a trace_reader for the trace in file
+ *
+ * \return The trace_reader, or NULL if unable to allocate memory
+ */
+static struct trace_reader *msr_trace_create(FILE *file,
+                                             unsigned duration_hrs) {
+  struct msr_struct *msr_info =
+      (struct msr_struct *)mem_alloc(sizeof(*msr_info));
+
+  if (msr_info == NULL) {
+    return NULL;
+  }
+
+  msr_info->reader = msr_trace;
+  msr_info->reader.file = file;
 
   if (duration_hrs > 0) {
-    msr_trace.features.use_duration = true;
-    msr_trace.features.duration_hrs = duration_hrs;
+    msr_info->reader.features.use_duration = true;
+    msr_info->reader.features.duration_hrs = duration_hrs;
   } else {
-    msr_trace.features.use_duration = false;
+    msr_info->reader.features.use_duration = false;
   }
 
-  msr_info.starting_time_set = false;
-  return 0;
+  msr_info->starting_time_set = false;
+  msr_info->volume_name[0] = '\0';
+
+  if (trace_buffer_init(&msr_info->tb, file)) {
+    mem_free(msr_info);
+    return NULL;
+  }
+  return &msr_info->reader;
 }
 
-static int msr_trace_read(struct trace_reader_result *result) {
-  FILE *file = msr_trace.file;
+static void msr_trace_set_range(struct trace_reader *reader, off_t start,
+                                off_t end) {
+  struct msr_struct *msr_info = container_of(reader, struct msr_struct, reader);
 
-  if (msr_info.blocks_left > 0) {
-    msr_info.addr += MSR_BLOCK_SIZE;
-    --msr_info.blocks_left;
-  } else {
-    block_t size = 0;
-    block_t align;
-    char io;
-    uint64_t ts;
-
-    while (size == 0) {
-      if (fscanf(file, "%lu,%*[^,],%*[^,],%c%*[^,],%lu,%lu,%*s\n", &ts, &io,
-                 &msr_info.addr, &size) != 4) {
-        if (feof(file)) {
-          LOG_DEBUG("end of file reached");
-        } else {
-          LOG_DEBUG("couldn't read file properly. error %d", ferror(file));
-        }
-        return 1;
+  trace_buffer_set_range(&msr_info->tb, start, end);
+  reader->eof = false;
+  msr_info->starting_time_set = false;
+}
+
+static void msr_trace_exit(struct trace_reader *reader) {
+  struct msr_struct *msr_info = container_of(reader, struct msr_struct, reader);
+
+  trace_buffer_exit(&msr_info->tb);
+  mem_free(msr_info);
+}
+
+/** Number of the volume of the given host and disk
+ */
+static unsigned __msr_trace_volume(struct msr_struct *msr_info,
+                                   const char *host, const char *disk) {
+  char *name = msr_info->volume_name;
+  size_t host_len = strlen(host);
+
+  // same volume as the last request
+  if (strncmp(name, host, host_len) == 0 && name[host_len] == '_' &&
+      strcmp(name + host_len + 1, disk) == 0) {
+    return msr_info->volume;
+  }
+
+  if (host_len + 1 + strlen(disk) >= TRACE_VOLUME_NAME_MAX_LENGTH) {
+    LOG_FATAL("Volume name too long %s_%s", host, disk);
+  }
+  sprintf(name, "%s_%s", host, disk);
+  msr_info->volume = trace_volume_id(name);
+  return msr_info->volume;
+}
+
+static int msr_trace_read_request(struct trace_reader *reader,
+                                  struct trace_request *request) {
+  struct msr_struct *msr_info = container_of(reader, struct msr_struct, reader);
+  char *line;
+  char *host;
+  char *disk;
+  char *type;
+  block_t size = 0;
+  block_t align;
+  oblock_t addr;
+  uint64_t ts;
+
+  while (size == 0) {
+    if (trace_buffer_next_line(&msr_info->tb, &line)) {
+      if (msr_info->tb.error) {
+        LOG_DEBUG("couldn't read file properly. error %d", msr_info->tb.error);
+      } else {
+        LOG_DEBUG("end of file reached");
+        reader->eof = true;
       }
+      return 1;
     }
 
-    // align address
-    align = msr_info.addr % MSR_BLOCK_SIZE;
-    msr_info.addr -= align;
-    size += align;
-
-    msr_info.write = io == 'W';
-    msr_info.blocks_left = (size / MSR_BLOCK_SIZE) - 1;
-    if (size % MSR_BLOCK_SIZE != 0) {
-      ++msr_info.blocks_left;
+    // Timestamp,Hostname,DiskNumber,Type,Offset,Size,ResponseTime
+    if (trace_parse_u64(&line, &ts) || trace_parse_char(&line, ',') ||
+        trace_parse_field(&line, ',', &host) ||
+        trace_parse_field(&line, ',', &disk) ||
+        trace_parse_field(&line, ',', &type) ||
+        trace_parse_u64(&line, &addr) || trace_parse_char(&line, ',') ||
+        trace_parse_u64(&line, &size)) {
+      LOG_DEBUG("couldn't parse line");
+      return 1;
     }
+  }
 
-    if (msr_trace.features.use_duration) {
-      if (!msr_info.starting_time_set) {
-        msr_info.starting_time = ts;
-        msr_info.ending_time =
-            ts + (MSR_HOUR_LENGTH * msr_trace.features.duration_hrs);
-        msr_info.starting_time_set = true;
-      }
-      if (ts > msr_info.ending_time) {
-        LOG_DEBUG("end of duration reached");
-        return 1;
-      }
+  // align address
+  align = addr % MSR_BLOCK_SIZE;
+  addr -= align;
+  size += align;
+
+  request->oblock = addr;
+  request->write = type[0] == 'W';
+  request->nr_blocks = size / MSR_BLOCK_SIZE;
+  if (size % MSR_BLOCK_SIZE != 0) {
+    ++request->nr_blocks;
+  }
+  // 100 nanoseconds -> nanoseconds
+  request->ts = ts * 100;
+  request->volume = __msr_trace_volume(msr_info, host, disk);
+  request->pid = 0;
+  request->process = 0;
+
+  if (reader->features.use_duration) {
+    if (!msr_info->starting_time_set) {
+      msr_info->starting_time = ts;
+      msr_info->ending_time =
+          ts + (MSR_HOUR_LENGTH * reader->features.duration_hrs);
+      msr_info->starting_time_set = true;
     }
+    if (ts > msr_info->ending_time) {
+      LOG_DEBUG("end of duration reached");
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+static int msr_trace_read(struct trace_reader *reader,
+                          struct trace_reader_result *result) {
+  struct trace_request request;
+
+  if (msr_trace_read_request(reader, &request)) {
+    return 1;
   }
 
-  result->oblock = msr_info.addr;
-  result->write = msr_info.write;
+  result->oblock = request.oblock;
+  result->nr_blocks = request.nr_blocks;
+  result->write = request.write;
 
   return 0;
 }
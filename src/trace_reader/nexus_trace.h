@@ -1,6 +1,8 @@
 #ifndef TRACE_READER_NEXUS_TRACE_H
 #define TRACE_READER_NEXUS_TRACE_H
 
+#include "common.h"
+#include "trace_reader/trace_buffer.h"
 #include "trace_reader/trace_reader_structs.h"
 #include "types.h"
 #include <stdio.h>
@@ -31,102 +33,162 @@ static const long long NEXUS_HOUR_LENGTH = 1000000000L * 60 * 60;
  * Tracks trace information
  */
 struct nexus_struct {
-  oblock_t addr;
+  struct trace_reader reader;
   bool write;
-  block_t pages_left;
   bool starting_time_set;
   uint64_t starting_time;
   uint64_t ending_time;
+  struct trace_buffer tb;
 };
 
-struct nexus_struct nexus_info = {
-    .addr = 0,
-    .write = false,
-    .pages_left = 0,
-};
-
-static int nexus_trace_init(FILE *file, unsigned duration_hrs);
-static int nexus_trace_read(struct trace_reader_result *result);
+static int nexus_trace_read(struct trace_reader *reader,
+                            struct trace_reader_result *result);
+static int nexus_trace_read_request(struct trace_reader *reader,
+                                    struct trace_request *request);
+static void nexus_trace_exit(struct trace_reader *reader);
 
-struct trace_reader nexus_trace = {
+static const struct trace_reader nexus_trace = {
     .features = {0},
     .file = NULL,
-    .init = nexus_trace_init,
+    .block_stride = NEXUS_BLOCKS_PER_PAGE,
+    .oblock_size = NEXUS_BLOCK_SIZE,
+    .sampling_rate = 1,
+    .eof = false,
     .read = nexus_trace_read,
+    .read_request = nexus_trace_read_request,
+    .set_range = NULL,
+    .seek = NULL,
+    .exit = nexus_trace_exit,
 };
 
-static int nexus_trace_init(FILE *file, unsigned duration_hrs) {
-  nexus_trace.file = file;
+/** Create a trace_reader for the trace in file
+ *
+ * \return The trace_reader, or NULL if unable to allocate memory
+ */
+static struct trace_reader *nexus_trace_create(FILE *file,
+                                               unsigned duration_hrs) {
+  struct nexus_struct *nexus_info =
+      (struct nexus_struct *)mem_alloc(sizeof(*nexus_info));
+
+  if (nexus_info == NULL) {
+    return NULL;
+  }
+
+  nexus_info->reader = nexus_trace;
+  nexus_info->reader.file = file;
 
   if (duration_hrs > 0) {
-    nexus_trace.features.use_duration = true;
-    nexus_trace.features.duration_hrs = duration_hrs;
+    nexus_info->reader.features.use_duration = true;
+    nexus_info->reader.features.duration_hrs = duration_hrs;
   } else {
-    nexus_trace.features.use_duration = false;
+    nexus_info->reader.features.use_duration = false;
   }
 
-  nexus_info.starting_time_set = false;
-  return 0;
+  nexus_info->write = false;
+  nexus_info->starting_time_set = false;
+
+  if (trace_buffer_init(&nexus_info->tb, file)) {
+    mem_free(nexus_info);
+    return NULL;
+  }
+  return &nexus_info->reader;
 }
 
-static int nexus_trace_read(struct trace_reader_result *result) {
-  FILE *file = nexus_trace.file;
+static void nexus_trace_exit(struct trace_reader *reader) {
+  struct nexus_struct *nexus_info =
+      container_of(reader, struct nexus_struct, reader);
 
-  if (nexus_info.pages_left > 0) {
-    nexus_info.addr += NEXUS_BLOCKS_PER_PAGE;
-    --nexus_info.pages_left;
-  } else {
-    block_t size = 0;
-    block_t align;
-    unsigned int write = 0;
-    float ts;
-
-    while (size == 0) {
-      if (fscanf(file, "%lu\t\t%lu\t\t%*u\t\t%u\t\t%f\t\t%*f\t\t%*f\t\t%*f\n",
-                 &nexus_info.addr, &size, &write, &ts) != 4) {
-        if (feof(file)) {
-          LOG_DEBUG("end of file reached");
-        } else {
-          LOG_DEBUG("couldn't read file properly. error %d", ferror(file));
-        }
-        return 1;
+  trace_buffer_exit(&nexus_info->tb);
+  mem_free(nexus_info);
+}
+
+static int nexus_trace_read_request(struct trace_reader *reader,
+                                    struct trace_request *request) {
+  struct nexus_struct *nexus_info =
+      container_of(reader, struct nexus_struct, reader);
+  char *line;
+  block_t size = 0;
+  block_t align;
+  oblock_t addr;
+  unsigned int write = 0;
+  float ts;
+
+  while (size == 0) {
+    if (trace_buffer_next_line(&nexus_info->tb, &line)) {
+      if (nexus_info->tb.error) {
+        LOG_DEBUG("couldn't read file properly. error %d",
+                  nexus_info->tb.error);
+      } else {
+        LOG_DEBUG("end of file reached");
+        reader->eof = true;
       }
+      return 1;
+    }
+
+    // [addr] [size in sectors] [size in bytes] [type] [generate time] ...
+    if (trace_parse_u64(&line, &addr) || trace_parse_u64(&line, &size) ||
+        trace_parse_skip(&line) || trace_parse_u32(&line, &write) ||
+        trace_parse_float(&line, &ts)) {
+      LOG_DEBUG("couldn't parse line");
+      return 1;
     }
+  }
 
-    // align block address
-    // remainder blocks from realignment added to size
-    align = nexus_info.addr % NEXUS_BLOCKS_PER_PAGE;
-    nexus_info.addr -= align;
-    size += align;
+  // align block address
+  // remainder blocks from realignment added to size
+  align = addr % NEXUS_BLOCKS_PER_PAGE;
+  addr -= align;
+  size += align;
 
-    if (write == 5 || write == 3) {
-      nexus_info.write = true;
+  // NOTE: once a write has been seen, every following access is treated as
+  //       a write as well
+  if (write == 5 || write == 3) {
+    nexus_info->write = true;
+  }
+
+  request->oblock = addr;
+  request->write = nexus_info->write;
+  request->nr_blocks = size / NEXUS_BLOCKS_PER_PAGE;
+
+  // Note: we commented this out since the size in nexus traces has an
+  // adittional sector
+  //      added by the MMC driver that we should not consider
+  // if (size % NEXUS_BLOCKS_PER_PAGE != 0) {
+  //  ++request->nr_blocks;
+  //}
+
+  request->ts = ts;
+  request->volume = 0;
+  request->pid = 0;
+  request->process = 0;
+
+  if (reader->features.use_duration) {
+    if (!nexus_info->starting_time_set) {
+      nexus_info->starting_time = ts;
+      nexus_info->ending_time =
+          ts + (NEXUS_HOUR_LENGTH * reader->features.duration_hrs);
+      nexus_info->starting_time_set = true;
     }
-    nexus_info.pages_left = (size / NEXUS_BLOCKS_PER_PAGE) - 1;
-
-    // Note: we commented this out since the size in nexus traces has an
-    // adittional sector
-    //      added by the MMC driver that we should not consider
-    // if (size % NEXUS_BLOCKS_PER_PAGE != 0) {
-    //  ++nexus_info.pages_left;
-    //}
-
-    if (nexus_trace.features.use_duration) {
-      if (!nexus_info.starting_time_set) {
-        nexus_info.starting_time = ts;
-        nexus_info.ending_time =
-            ts + (NEXUS_HOUR_LENGTH * nexus_trace.features.duration_hrs);
-        nexus_info.starting_time_set = true;
-      }
-      if (ts > nexus_info.ending_time) {
-        LOG_DEBUG("end of duration reached");
-        return 1;
-      }
+    if (ts > nexus_info->ending_time) {
+      LOG_DEBUG("end of duration reached");
+      return 1;
     }
   }
 
-  result->oblock = nexus_info.addr;
-  result->write = nexus_info.write;
+  return 0;
+}
+
+static int nexus_trace_read(struct trace_reader *reader,
+                            struct trace_reader_result *result) {
+  struct trace_request request;
+
+  if (nexus_trace_read_request(reader, &request)) {
+    return 1;
+  }
+
+  result->oblock = request.oblock;
+  result->nr_blocks = request.nr_blocks;
+  result->write = request.write;
 
   return 0;
 }
@@ -0,0 +1,162 @@
+#ifndef TRACE_READER_TRACE_BLOCK_H
+#define TRACE_READER_TRACE_BLOCK_H
+
+#include "common.h"
+#include "trace_reader/trace_reader_structs.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Every trace format has its own access granularity (512 byte sectors for MSR,
+ * 4 KiB pages for FIU, ...), while real caches (such as dm-cache) are made of
+ * much larger blocks, of 64 KiB to 1 MiB. A trace_block reader maps the bytes
+ * accessed by every request of a trace onto the cache blocks of the given size
+ * they fall in, so that every cache block a request touches is accessed once,
+ * however many of the trace's accesses it holds.
+ *
+ * oblocks stay in the address unit of the trace (so the oblock of an access
+ * is the address of the first byte of its cache block, in that unit), with a
+ * block stride of a cache block.
+ *
+ * Only formats giving their addresses in bytes (or sectors of some bytes) can
+ * be mapped onto cache blocks, and not once sampled, since the oblocks of
+ * sampled traces are hashes (see trace_sampling.h).
+ */
+
+/** Parse a block size in bytes, optionally in KiB (K) or MiB (M)
+ *
+ * \return 0 if parsed, or not 0 if it isn't a positive block size
+ */
+static int trace_block_parse_size(const char *arg, uint64_t *block_size) {
+  char unit = '\0';
+  char end;
+  int r = sscanf(arg, "%lu%c%c", block_size, &unit, &end);
+
+  if (r < 1 || r > 2 || *block_size == 0) {
+    return 1;
+  }
+
+  switch (unit) {
+  case 'M':
+    *block_size *= 1024;
+  case 'K':
+    *block_size *= 1024;
+  case '\0':
+    return 0;
+  default:
+    return 1;
+  }
+}
+
+/** trace_block_struct
+ * Tracks trace information
+ *
+ * trace - trace_reader of the trace being mapped onto cache blocks
+ */
+struct trace_block_struct {
+  struct trace_reader reader;
+  struct trace_reader *trace;
+};
+
+static int trace_block_read(struct trace_reader *reader,
+                            struct trace_reader_result *result);
+static int trace_block_read_request(struct trace_reader *reader,
+                                    struct trace_request *request);
+static void trace_block_exit(struct trace_reader *reader);
+
+static const struct trace_reader trace_block = {
+    .features = {0},
+    .file = NULL,
+    .block_stride = 1,
+    .oblock_size = 0,
+    .sampling_rate = 1,
+    .eof = false,
+    .read = trace_block_read,
+    .read_request = trace_block_read_request,
+    .set_range = NULL,
+    .seek = NULL,
+    .exit = trace_block_exit,
+};
+
+/** Create a trace_reader mapping the requests of trace onto cache blocks of
+ * block_size bytes, which must be a multiple of the trace's own blocks
+ *
+ * NOTE: The trace_block reader takes over trace, freeing it on exit.
+ *
+ * \return The trace_reader, or NULL if unable to allocate memory
+ */
+static struct trace_reader *trace_block_create(struct trace_reader *trace,
+                                               uint64_t block_size) {
+  struct trace_block_struct *tb;
+
+  if (trace->oblock_size == 0 || trace->sampling_rate > 1) {
+    LOG_FATAL("The trace's blocks can't be mapped onto a block size");
+  }
+  if (block_size % (trace->oblock_size * trace->block_stride) != 0) {
+    LOG_FATAL("The block size must be a multiple of %lu bytes",
+              trace->oblock_size * trace->block_stride);
+  }
+
+  tb = (struct trace_block_struct *)mem_alloc(sizeof(*tb));
+  if (tb == NULL) {
+    return NULL;
+  }
+
+  tb->reader = trace_block;
+  tb->reader.features = trace->features;
+  tb->reader.file = trace->file;
+  tb->reader.block_stride = block_size / trace->oblock_size;
+  tb->reader.oblock_size = trace->oblock_size;
+  tb->trace = trace;
+
+  return &tb->reader;
+}
+
+static int trace_block_read_request(struct trace_reader *reader,
+                                    struct trace_request *request) {
+  struct trace_block_struct *tb =
+      container_of(reader, struct trace_block_struct, reader);
+  struct trace_reader *trace = tb->trace;
+  block_t stride = reader->block_stride;
+  oblock_t end;
+  oblock_t first;
+
+  if (trace->read_request(trace, request)) {
+    reader->eof = trace->eof;
+    return 1;
+  }
+
+  // cache blocks from the one of the first address accessed up to the one
+  // holding the end of the request
+  end = request->oblock + (oblock_t)request->nr_blocks * trace->block_stride;
+  first = request->oblock / stride;
+
+  request->oblock = first * stride;
+  request->nr_blocks = (end + stride - 1) / stride - first;
+
+  return 0;
+}
+
+static int trace_block_read(struct trace_reader *reader,
+                            struct trace_reader_result *result) {
+  struct trace_request request;
+
+  if (trace_block_read_request(reader, &request)) {
+    return 1;
+  }
+
+  result->oblock = request.oblock;
+  result->nr_blocks = request.nr_blocks;
+  result->write = request.write;
+
+  return 0;
+}
+
+static void trace_block_exit(struct trace_reader *reader) {
+  struct trace_block_struct *tb =
+      container_of(reader, struct trace_block_struct, reader);
+
+  tb->trace->exit(tb->trace);
+  mem_free(tb);
+}
+
+#endif /* TRACE_READER_TRACE_BLOCK_H */
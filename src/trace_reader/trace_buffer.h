@@ -0,0 +1,401 @@
+#ifndef TRACE_READER_TRACE_BUFFER_H
+#define TRACE_READER_TRACE_BUFFER_H
+
+#include "common.h"
+#include "types.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Reading the text traces with fscanf spends most of its time in libc (format
+ * string interpretation, locale handling and per-character stream locking)
+ * rather than on the trace itself. Instead, the text trace readers read their
+ * trace in large chunks with read() into a trace_buffer, take it a line at a
+ * time and parse the fields in place with the trace_parse_*() functions below.
+ *
+ * Every trace_parse_*() function advances *p past what it parsed and returns 0,
+ * or returns not 0 if what is at *p can't be parsed. Like their fscanf
+ * conversions, the numbers and tokens skip leading blanks, while delimiters
+ * and delimited fields don't.
+ */
+
+#define TRACE_BUFFER_SIZE (1 << 20)
+
+/** trace_buffer
+ * file - The trace
+ * fd - File descriptor of the trace, or -1 if it has to be read through stdio
+ *      (see trace_decompress_open())
+ * data - TRACE_BUFFER_SIZE bytes of the trace (plus a terminating '\0')
+ * pos - Position of the first unread byte in data
+ * len - Number of bytes in data
+ * eof - Has the end of the trace been read into data?
+ * error - errno of a failed read(), or 0
+ * offset - File offset of the next byte to read (when reading a range)
+ * end - File offset to stop reading at, or -1 to read the file up to its end
+ *       (see trace_buffer_set_range())
+ */
+struct trace_buffer {
+  FILE *file;
+  int fd;
+  char *data;
+  size_t pos;
+  size_t len;
+  bool eof;
+  int error;
+  off_t offset;
+  off_t end;
+};
+
+/** Prepare to read file through a trace_buffer
+ *
+ * NOTE: file is read directly (with read() on its file descriptor) from then
+ *       on, so it shouldn't be read through stdio anymore. Only a file without
+ *       a file descriptor is read with fread().
+ *
+ * \return 0 if no errors occur, or -ENOSPC if unable to allocate memory
+ */
+static int trace_buffer_init(struct trace_buffer *tb, FILE *file) {
+  tb->file = file;
+  tb->fd = fileno(file);
+  tb->pos = 0;
+  tb->len = 0;
+  tb->eof = false;
+  tb->error = 0;
+  tb->offset = 0;
+  tb->end = -1;
+  tb->data = (char *)mem_alloc(TRACE_BUFFER_SIZE + 1);
+  if (tb->data == NULL) {
+    return -ENOSPC;
+  }
+  tb->data[0] = '\0';
+  return 0;
+}
+
+/** Free the trace_buffer (the file itself is left open)
+ */
+static void trace_buffer_exit(struct trace_buffer *tb) {
+  if (tb->data != NULL) {
+    mem_free(tb->data);
+  }
+  tb->data = NULL;
+}
+
+/** Read only the bytes of the file from offset start up to end from then on,
+ * dropping whatever is left in data
+ *
+ * Ranges are read with pread(), so any number of trace_buffers can read
+ * ranges of the same file at once. start should be the start of a line.
+ */
+static void trace_buffer_set_range(struct trace_buffer *tb, off_t start,
+                                   off_t end) {
+  tb->pos = 0;
+  tb->len = 0;
+  tb->eof = false;
+  tb->error = 0;
+  tb->offset = start;
+  tb->end = end;
+  tb->data[0] = '\0';
+}
+
+/** Move the unread bytes to the front of data and fill the rest of it
+ *
+ * \return Number of bytes added
+ */
+static size_t trace_buffer_fill(struct trace_buffer *tb) {
+  size_t added = 0;
+
+  if (tb->pos > 0) {
+    memmove(tb->data, tb->data + tb->pos, tb->len - tb->pos);
+    tb->len -= tb->pos;
+    tb->pos = 0;
+  }
+
+  while (!tb->eof && tb->len < TRACE_BUFFER_SIZE) {
+    size_t count = TRACE_BUFFER_SIZE - tb->len;
+    ssize_t r;
+
+    if (tb->fd < 0) {
+      r = fread(tb->data + tb->len, 1, count, tb->file);
+      if (r == 0 && ferror(tb->file)) {
+        errno = EIO;
+        r = -1;
+      }
+    } else if (tb->end < 0) {
+      r = read(tb->fd, tb->data + tb->len, count);
+    } else {
+      if ((off_t)count > tb->end - tb->offset) {
+        count = tb->end - tb->offset;
+      }
+      r = count ? pread(tb->fd, tb->data + tb->len, count, tb->offset) : 0;
+    }
+
+    if (r < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      tb->error = errno;
+      tb->eof = true;
+    } else if (r == 0) {
+      tb->eof = true;
+    } else {
+      tb->len += r;
+      tb->offset += r;
+      added += r;
+    }
+  }
+
+  tb->data[tb->len] = '\0';
+  return added;
+}
+
+static bool __trace_buffer_is_space(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' ||
+         c == '\f';
+}
+
+/** Get the next non-blank line of the trace
+ *
+ * The line is '\0' terminated in place (without its '\n') and stays valid
+ * until the next call.
+ *
+ * \return 0 if a line was read, or 1 once the end of the trace is reached
+ *         (or reading it failed, as given by error)
+ */
+static int trace_buffer_next_line(struct trace_buffer *tb, char **line) {
+  char *nl;
+
+  // skip blank lines (and leading blanks), as fscanf would
+  for (;;) {
+    while (tb->pos < tb->len && __trace_buffer_is_space(tb->data[tb->pos])) {
+      ++tb->pos;
+    }
+    if (tb->pos < tb->len) {
+      break;
+    }
+    if (tb->eof) {
+      return 1;
+    }
+    trace_buffer_fill(tb);
+  }
+
+  nl = (char *)memchr(tb->data + tb->pos, '\n', tb->len - tb->pos);
+  while (nl == NULL && !tb->eof) {
+    size_t searched = tb->len - tb->pos;
+
+    if (tb->pos == 0 && tb->len == TRACE_BUFFER_SIZE) {
+      LOG_DEBUG("line longer than %d bytes, splitting it", TRACE_BUFFER_SIZE);
+      break;
+    }
+    trace_buffer_fill(tb);
+    nl = (char *)memchr(tb->data + tb->pos + searched, '\n',
+                        tb->len - tb->pos - searched);
+  }
+
+  *line = tb->data + tb->pos;
+  if (nl == NULL) {
+    // last line without a '\n', data[len] is already '\0'
+    tb->pos = tb->len;
+  } else {
+    *nl = '\0';
+    tb->pos = nl - tb->data + 1;
+  }
+  return 0;
+}
+
+static void trace_parse_blanks(char **p) {
+  while (**p == ' ' || **p == '\t' || **p == '\r') {
+    ++*p;
+  }
+}
+
+// largest value that can still take another decimal digit without overflowing
+#define TRACE_PARSE_U64_MAX_DIV10 (UINT64_MAX / 10)
+
+/** Parse an unsigned decimal integer (%lu)
+ *
+ * Unlike fscanf, values that don't fit in 64 bits aren't parsed at all rather
+ * than being silently wrapped around.
+ */
+static int trace_parse_u64(char **p, uint64_t *value) {
+  char *s;
+  uint64_t v = 0;
+  unsigned digit;
+
+  trace_parse_blanks(p);
+  s = *p;
+  if (*s == '+') {
+    ++s;
+  }
+  if (*s < '0' || *s > '9') {
+    return 1;
+  }
+
+  while (*s >= '0' && *s <= '9') {
+    digit = *s - '0';
+    if (v > TRACE_PARSE_U64_MAX_DIV10 ||
+        (v == TRACE_PARSE_U64_MAX_DIV10 && digit > UINT64_MAX % 10)) {
+      return 1;
+    }
+    v = v * 10 + digit;
+    ++s;
+  }
+
+  *value = v;
+  *p = s;
+  return 0;
+}
+
+/** Parse an unsigned decimal integer (%u)
+ */
+static int trace_parse_u32(char **p, unsigned *value) {
+  uint64_t v;
+
+  if (trace_parse_u64(p, &v)) {
+    return 1;
+  }
+  *value = (unsigned)v;
+  return 0;
+}
+
+/** Parse a whitespace delimited token (%s), returning where it starts
+ */
+static int trace_parse_token(char **p, char **token) {
+  trace_parse_blanks(p);
+  if (**p == '\0') {
+    return 1;
+  }
+
+  *token = *p;
+  while (**p != '\0' && !__trace_buffer_is_space(**p)) {
+    ++*p;
+  }
+  return 0;
+}
+
+/** Skip a whitespace delimited field (%*s, %*d, ...)
+ */
+static int trace_parse_skip(char **p) {
+  char *token;
+  return trace_parse_token(p, &token);
+}
+
+/** Parse a field ending with the delimiter c (%[^c]c), returning where it
+ * starts. The delimiter is replaced by '\0'.
+ */
+static int trace_parse_field(char **p, char c, char **field) {
+  char *s = *p;
+
+  while (*s != '\0' && *s != c) {
+    ++s;
+  }
+  if (*s != c) {
+    return 1;
+  }
+
+  *field = *p;
+  *s = '\0';
+  *p = s + 1;
+  return 0;
+}
+
+/** Skip a field ending with the delimiter c (%*[^c]c)
+ */
+static int trace_parse_skip_field(char **p, char c) {
+  char *field;
+  return trace_parse_field(p, c, &field);
+}
+
+/** Parse the delimiter c
+ */
+static int trace_parse_char(char **p, char c) {
+  if (**p != c) {
+    return 1;
+  }
+  ++*p;
+  return 0;
+}
+
+static const double __trace_parse_pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+/** Parse a decimal floating point number (%lf)
+ *
+ * Plain decimals (such as 1234.5678) of up to 15 significant digits are
+ * exactly representable as an integer over a power of 10, so their division
+ * gives the correctly rounded result strtod would. Anything else (exponents,
+ * more digits, inf/nan) is left to strtod.
+ */
+static int trace_parse_double(char **p, double *value) {
+  char *s;
+  char *end;
+  uint64_t m = 0;
+  unsigned digits = 0;
+  unsigned frac = 0;
+  bool negative = false;
+
+  trace_parse_blanks(p);
+  s = *p;
+  if (*s == '-' || *s == '+') {
+    negative = *s == '-';
+    ++s;
+  }
+
+  while (*s >= '0' && *s <= '9') {
+    m = m * 10 + (*s++ - '0');
+    ++digits;
+  }
+  if (*s == '.') {
+    ++s;
+    while (*s >= '0' && *s <= '9') {
+      m = m * 10 + (*s++ - '0');
+      ++digits;
+      ++frac;
+    }
+  }
+
+  if (digits > 0 && digits <= 15 && *s != 'e' && *s != 'E') {
+    *value = (double)m / __trace_parse_pow10[frac];
+    if (negative) {
+      *value = -*value;
+    }
+    *p = s;
+    return 0;
+  }
+
+  *value = strtod(*p, &end);
+  if (end == *p) {
+    return 1;
+  }
+  *p = end;
+  return 0;
+}
+
+/** Parse a decimal floating point number (%f)
+ *
+ * Rounding the correctly rounded double to a float gives the correctly rounded
+ * float, unless the double lies exactly halfway between two floats, in which
+ * case strtof has to decide.
+ */
+static int trace_parse_float(char **p, float *value) {
+  char *s = *p;
+  double d;
+  uint64_t bits;
+
+  if (trace_parse_double(p, &d)) {
+    return 1;
+  }
+
+  memcpy(&bits, &d, sizeof(bits));
+  if ((bits & 0x1fffffffULL) == 0x10000000ULL) {
+    *value = strtof(s, NULL);
+  } else {
+    *value = (float)d;
+  }
+  return 0;
+}
+
+#endif /* TRACE_READER_TRACE_BUFFER_H */
@@ -0,0 +1,366 @@
+#ifndef TRACE_READER_TRACE_DECOMPRESS_H
+#define TRACE_READER_TRACE_DECOMPRESS_H
+
+#include "common.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <lzma.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+
+/* Traces are often archived compressed. Rather than having to decompress them
+ * to disk first (or through another process into standard input), a trace
+ * opened with trace_decompress_open() is checked for the magic bytes of gzip
+ * and xz and, if compressed, decompressed in large blocks on a helper thread,
+ * which writes the trace into a pipe that is read in place of the original
+ * file. Every trace format can then read compressed traces as they are.
+ *
+ * Uncompressed regular files are checked without reading them, and are read
+ * directly as always. Anything else (such as a pipe on standard input) has to
+ * be read to be checked. When uncompressed, it is read through a stdio stream
+ * (see fopencookie()) giving back the bytes read to check it before reading
+ * the rest of it straight from its file descriptor, without a helper thread.
+ */
+
+// fopencookie() is a GNU extension
+#ifndef _GNU_SOURCE
+#error "trace_decompress.h needs _GNU_SOURCE to be defined when compiling"
+#endif
+
+#define TRACE_DECOMPRESS_BLOCK_SIZE (1 << 20)
+
+enum trace_compression {
+  TRACE_UNCOMPRESSED,
+  TRACE_GZIP,
+  TRACE_XZ,
+};
+
+static const unsigned char TRACE_GZIP_MAGIC[] = {0x1f, 0x8b};
+static const unsigned char TRACE_XZ_MAGIC[] = {0xfd, '7', 'z', 'X', 'Z', 0x00};
+
+/** trace_decompress_struct
+ * Tracks the decompression of a trace
+ *
+ * file/fd - The original trace, closed once it has been decompressed (or read)
+ * out - Write end of the pipe the decompressed trace is written into
+ * compression - How the trace is compressed
+ * magic/magic_len - Bytes already read from fd to check the magic bytes,
+ *                   which are decompressed (or read) before the rest of it
+ */
+struct trace_decompress_struct {
+  FILE *file;
+  int fd;
+  int out;
+  enum trace_compression compression;
+  unsigned char magic[sizeof(TRACE_XZ_MAGIC)];
+  size_t magic_len;
+};
+
+static enum trace_compression __trace_compression(unsigned char *magic,
+                                                  size_t len) {
+  if (len >= sizeof(TRACE_GZIP_MAGIC) &&
+      memcmp(magic, TRACE_GZIP_MAGIC, sizeof(TRACE_GZIP_MAGIC)) == 0) {
+    return TRACE_GZIP;
+  }
+  if (len >= sizeof(TRACE_XZ_MAGIC) &&
+      memcmp(magic, TRACE_XZ_MAGIC, sizeof(TRACE_XZ_MAGIC)) == 0) {
+    return TRACE_XZ;
+  }
+  return TRACE_UNCOMPRESSED;
+}
+
+/** Read the next block of the original trace
+ *
+ * \return Number of bytes read, or 0 at the end of the trace
+ */
+static size_t __trace_decompress_read(struct trace_decompress_struct *td,
+                                      unsigned char *buf) {
+  ssize_t r;
+
+  if (td->magic_len > 0) {
+    size_t len = td->magic_len;
+    memcpy(buf, td->magic, len);
+    td->magic_len = 0;
+    return len;
+  }
+
+  do {
+    r = read(td->fd, buf, TRACE_DECOMPRESS_BLOCK_SIZE);
+  } while (r < 0 && errno == EINTR);
+
+  if (r < 0) {
+    LOG_FATAL("couldn't read compressed trace. errno %d", errno);
+  }
+  return r;
+}
+
+/** Write a decompressed block into the pipe
+ *
+ * \return 0 if written, or not 0 if the trace isn't being read anymore
+ */
+static int __trace_decompress_write(struct trace_decompress_struct *td,
+                                    unsigned char *buf, size_t len) {
+  while (len > 0) {
+    ssize_t r = write(td->out, buf, len);
+    if (r < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return 1;
+    }
+    buf += r;
+    len -= r;
+  }
+  return 0;
+}
+
+static void __trace_decompress_gzip(struct trace_decompress_struct *td,
+                                    unsigned char *in, unsigned char *out) {
+  z_stream strm;
+  size_t len;
+  int r;
+
+  memset(&strm, 0, sizeof(strm));
+  // 15 window bits, +32 to expect a gzip (or zlib) header
+  if (inflateInit2(&strm, 15 + 32) != Z_OK) {
+    LOG_FATAL("unable to start gzip decompression");
+  }
+
+  for (;;) {
+    if (strm.avail_in == 0) {
+      strm.avail_in = __trace_decompress_read(td, in);
+      strm.next_in = in;
+      if (strm.avail_in == 0) {
+        break;
+      }
+    }
+
+    strm.next_out = out;
+    strm.avail_out = TRACE_DECOMPRESS_BLOCK_SIZE;
+    r = inflate(&strm, Z_NO_FLUSH);
+    if (r == Z_STREAM_END) {
+      // gzip files may be several gzip members one after the other
+      inflateReset(&strm);
+    } else if (r != Z_OK && r != Z_BUF_ERROR) {
+      LOG_FATAL("corrupt gzip trace. error %d", r);
+    }
+
+    len = TRACE_DECOMPRESS_BLOCK_SIZE - strm.avail_out;
+    if (__trace_decompress_write(td, out, len)) {
+      break;
+    }
+  }
+
+  inflateEnd(&strm);
+}
+
+static void __trace_decompress_xz(struct trace_decompress_struct *td,
+                                  unsigned char *in, unsigned char *out) {
+  lzma_stream strm = LZMA_STREAM_INIT;
+  lzma_action action = LZMA_RUN;
+  size_t len;
+  lzma_ret r;
+
+  if (lzma_stream_decoder(&strm, UINT64_MAX, LZMA_CONCATENATED) != LZMA_OK) {
+    LOG_FATAL("unable to start xz decompression");
+  }
+
+  for (;;) {
+    if (strm.avail_in == 0 && action == LZMA_RUN) {
+      strm.avail_in = __trace_decompress_read(td, in);
+      strm.next_in = in;
+      if (strm.avail_in == 0) {
+        action = LZMA_FINISH;
+      }
+    }
+
+    strm.next_out = out;
+    strm.avail_out = TRACE_DECOMPRESS_BLOCK_SIZE;
+    r = lzma_code(&strm, action);
+    if (r != LZMA_OK && r != LZMA_STREAM_END) {
+      LOG_FATAL("corrupt xz trace. error %d", r);
+    }
+
+    len = TRACE_DECOMPRESS_BLOCK_SIZE - strm.avail_out;
+    if (__trace_decompress_write(td, out, len) || r == LZMA_STREAM_END) {
+      break;
+    }
+  }
+
+  lzma_end(&strm);
+}
+
+static void *__trace_decompress_work(void *arg) {
+  struct trace_decompress_struct *td = (struct trace_decompress_struct *)arg;
+  unsigned char *in = (unsigned char *)malloc(TRACE_DECOMPRESS_BLOCK_SIZE);
+  unsigned char *out = (unsigned char *)malloc(TRACE_DECOMPRESS_BLOCK_SIZE);
+  sigset_t sigpipe;
+
+  if (in == NULL || out == NULL) {
+    LOG_FATAL("unable to allocate decompression buffers");
+  }
+
+  // when the trace stops being read early (such as with a duration), the
+  // pipe is closed under us, which should only stop the decompression
+  sigemptyset(&sigpipe);
+  sigaddset(&sigpipe, SIGPIPE);
+  pthread_sigmask(SIG_BLOCK, &sigpipe, NULL);
+
+  switch (td->compression) {
+  case TRACE_GZIP:
+    __trace_decompress_gzip(td, in, out);
+    break;
+  case TRACE_XZ:
+    __trace_decompress_xz(td, in, out);
+    break;
+  default:
+    break;
+  }
+
+  close(td->out);
+  fclose(td->file);
+  free(in);
+  free(out);
+  mem_free(td);
+  return NULL;
+}
+
+/** Read an uncompressed trace whose magic bytes were read to check them,
+ * giving them back before reading the rest of it
+ */
+static ssize_t __trace_decompress_replay_read(void *cookie, char *buf,
+                                              size_t size) {
+  struct trace_decompress_struct *td = (struct trace_decompress_struct *)cookie;
+  ssize_t r;
+
+  if (td->magic_len > 0) {
+    size_t len = size < td->magic_len ? size : td->magic_len;
+
+    memcpy(buf, td->magic, len);
+    memmove(td->magic, td->magic + len, td->magic_len - len);
+    td->magic_len -= len;
+    return len;
+  }
+
+  do {
+    r = read(td->fd, buf, size);
+  } while (r < 0 && errno == EINTR);
+  return r;
+}
+
+static int __trace_decompress_replay_close(void *cookie) {
+  struct trace_decompress_struct *td = (struct trace_decompress_struct *)cookie;
+
+  fclose(td->file);
+  mem_free(td);
+  return 0;
+}
+
+/** Open a stream reading the uncompressed trace from its magic bytes on
+ */
+static FILE *__trace_decompress_replay(struct trace_decompress_struct *td) {
+  cookie_io_functions_t io = {0};
+  FILE *replay;
+
+  io.read = __trace_decompress_replay_read;
+  io.close = __trace_decompress_replay_close;
+  replay = fopencookie(td, "r", io);
+  if (replay == NULL) {
+    mem_free(td);
+    return NULL;
+  }
+  setvbuf(replay, NULL, _IOFBF, TRACE_DECOMPRESS_BLOCK_SIZE);
+  return replay;
+}
+
+/** Check the magic bytes at the start of the (unread) file, reading them only
+ * if file can't be read at an offset
+ *
+ * \return 0 if they were checked without being read, or not 0 if they were
+ *         read into td->magic
+ */
+static int __trace_decompress_peek(struct trace_decompress_struct *td) {
+  off_t offset = lseek(td->fd, 0, SEEK_CUR);
+  ssize_t r;
+
+  if (offset >= 0) {
+    r = pread(td->fd, td->magic, sizeof(td->magic), offset);
+    td->compression = __trace_compression(td->magic, r > 0 ? r : 0);
+    return 0;
+  }
+
+  while (td->magic_len < sizeof(td->magic)) {
+    r = read(td->fd, td->magic + td->magic_len,
+             sizeof(td->magic) - td->magic_len);
+    if (r < 0 && errno == EINTR) {
+      continue;
+    }
+    if (r <= 0) {
+      break;
+    }
+    td->magic_len += r;
+  }
+  td->compression = __trace_compression(td->magic, td->magic_len);
+  return 1;
+}
+
+/** Open a trace for reading, decompressing it if it is compressed
+ *
+ * NOTE: Unless file itself is returned, file now belongs to the helper thread
+ *       decompressing it (or to the returned stream, for an uncompressed trace
+ *       that had to be read to be checked), and is closed by it. Closing the
+ *       returned FILE stops the decompression.
+ * NOTE: The stream returned for an uncompressed trace that had to be read to
+ *       be checked has no file descriptor (fileno() is -1), so it can only be
+ *       read through stdio.
+ *
+ * \return file if it can be read as it is, otherwise the decompressed trace
+ *         (or NULL if unable to start decompressing it)
+ */
+static FILE *trace_decompress_open(FILE *file) {
+  struct trace_decompress_struct *td;
+  pthread_t thread;
+  FILE *decompressed;
+  int fds[2];
+
+  td = (struct trace_decompress_struct *)mem_alloc(sizeof(*td));
+  if (td == NULL) {
+    return NULL;
+  }
+  td->file = file;
+  td->fd = fileno(file);
+
+  if (__trace_decompress_peek(td) == 0 &&
+      td->compression == TRACE_UNCOMPRESSED) {
+    mem_free(td);
+    return file;
+  }
+  if (td->compression == TRACE_UNCOMPRESSED) {
+    return __trace_decompress_replay(td);
+  }
+
+  if (pipe(fds)) {
+    mem_free(td);
+    return NULL;
+  }
+#ifdef F_SETPIPE_SZ
+  fcntl(fds[1], F_SETPIPE_SZ, TRACE_DECOMPRESS_BLOCK_SIZE);
+#endif
+  td->out = fds[1];
+
+  decompressed = fdopen(fds[0], "r");
+  if (decompressed == NULL ||
+      pthread_create(&thread, NULL, __trace_decompress_work, td)) {
+    LOG_FATAL("unable to start decompressing the trace");
+  }
+  pthread_detach(thread);
+
+  return decompressed;
+}
+
+#endif /* TRACE_READER_TRACE_DECOMPRESS_H */
@@ -0,0 +1,306 @@
+#ifndef TRACE_READER_TRACE_FILTER_H
+#define TRACE_READER_TRACE_FILTER_H
+
+#include "common.h"
+#include "trace_reader/trace_process.h"
+#include "trace_reader/trace_reader_structs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Often only part of the requests of a trace are of interest: only its reads,
+ * the requests to a range of addresses, a window of time, or the requests of a
+ * single process. A trace_filter reader only reads such requests from a trace,
+ * dropping the others whole, before they are ever split into accesses (so
+ * filtered out requests cost next to nothing, however large):
+ *
+ * reads_only/writes_only - Only the reads, or only the writes
+ * lba_range - Only the accesses to the addresses from first_lba to last_lba
+ *             (in the addresses of the trace, such as 512 byte sectors for
+ *             FIU or bytes for MSR), requests partly in the range being cut
+ *             down to the accesses in it
+ * time_window - Only the requests from time_from (included) to time_to (not
+ *               included), in nanoseconds from the first request read (of
+ *               the window, if any), the trace ending at the first request
+ *               past time_to
+ * pid/process - Only the requests of the given process, by pid or by name (see
+ *               trace_process.h), for traces with processes (FIU and VISA)
+ */
+
+// nanoseconds in a second
+static const long long TRACE_FILTER_SECOND_LENGTH = 1000000000LL;
+
+/** trace_filter
+ * Requests to be read (see above), where every filter not used is false
+ */
+struct trace_filter {
+  bool reads_only;
+  bool writes_only;
+  bool lba_range;
+  oblock_t first_lba;
+  oblock_t last_lba;
+  bool time_window;
+  uint64_t time_from;
+  uint64_t time_to;
+  bool pid;
+  unsigned pid_value;
+  bool process;
+  uint64_t process_value;
+};
+
+/** Is any filter used?
+ */
+static bool trace_filter_used(struct trace_filter *filter) {
+  return filter->reads_only || filter->writes_only || filter->lba_range ||
+         filter->time_window || filter->pid || filter->process;
+}
+
+/** Parse an address range given as FIRST-LAST
+ *
+ * \return 0 if parsed, or not 0 if it isn't an address range
+ */
+static int trace_filter_parse_lba_range(struct trace_filter *filter,
+                                        const char *arg) {
+  char end;
+
+  if (sscanf(arg, "%lu-%lu%c", &filter->first_lba, &filter->last_lba,
+             &end) != 2 ||
+      filter->first_lba > filter->last_lba) {
+    return 1;
+  }
+  filter->lba_range = true;
+  return 0;
+}
+
+/** Parse a time given in seconds, or in minutes (m), hours (h) or days (d)
+ */
+static const char *__trace_filter_parse_time(const char *arg, uint64_t *ns) {
+  char *end;
+  double time = strtod(arg, &end);
+
+  if (end == arg || time < 0) {
+    return NULL;
+  }
+
+  switch (*end) {
+  case 'd':
+    time *= 24;
+  case 'h':
+    time *= 60;
+  case 'm':
+    time *= 60;
+  case 's':
+    ++end;
+  default:
+    break;
+  }
+  *ns = (uint64_t)(time * TRACE_FILTER_SECOND_LENGTH);
+  return end;
+}
+
+/** Parse a time window given as FROM-TO (such as 30m-2h)
+ *
+ * \return 0 if parsed, or not 0 if it isn't a time window
+ */
+static int trace_filter_parse_time_window(struct trace_filter *filter,
+                                          const char *arg) {
+  const char *p = __trace_filter_parse_time(arg, &filter->time_from);
+
+  if (p == NULL || *p != '-') {
+    return 1;
+  }
+  p = __trace_filter_parse_time(p + 1, &filter->time_to);
+  if (p == NULL || *p != '\0' || filter->time_from >= filter->time_to) {
+    return 1;
+  }
+  filter->time_window = true;
+  return 0;
+}
+
+/** trace_filter_struct
+ * Tracks trace information
+ *
+ * trace - trace_reader of the trace being filtered
+ * filter - Requests to be read
+ * starting_time_set/starting_time - Time of the first request read
+ * done - Has the end of the time window (or of the trace) been reached?
+ */
+struct trace_filter_struct {
+  struct trace_reader reader;
+  struct trace_reader *trace;
+  struct trace_filter filter;
+  bool starting_time_set;
+  uint64_t starting_time;
+  bool done;
+};
+
+static int trace_filter_read(struct trace_reader *reader,
+                             struct trace_reader_result *result);
+static int trace_filter_read_request(struct trace_reader *reader,
+                                     struct trace_request *request);
+static void trace_filter_exit(struct trace_reader *reader);
+
+static const struct trace_reader trace_filter = {
+    .features = {0},
+    .file = NULL,
+    .block_stride = 1,
+    .oblock_size = 0,
+    .sampling_rate = 1,
+    .eof = false,
+    .read = trace_filter_read,
+    .read_request = trace_filter_read_request,
+    .set_range = NULL,
+    .seek = NULL,
+    .exit = trace_filter_exit,
+};
+
+/** Create a trace_reader only reading the requests of trace that pass filter
+ *
+ * NOTE: The trace_filter reader takes over trace, freeing it on exit.
+ *
+ * \return The trace_reader, or NULL if unable to allocate memory
+ */
+static struct trace_reader *trace_filter_create(struct trace_reader *trace,
+                                                struct trace_filter *filter) {
+  struct trace_filter_struct *tf;
+
+  if (filter->reads_only && filter->writes_only) {
+    LOG_FATAL("Only reads and only writes leave no requests to read");
+  }
+  if (filter->lba_range && trace->sampling_rate > 1) {
+    LOG_FATAL("The addresses of a sampled trace can't be filtered");
+  }
+
+  tf = (struct trace_filter_struct *)mem_alloc(sizeof(*tf));
+  if (tf == NULL) {
+    return NULL;
+  }
+
+  tf->reader = trace_filter;
+  tf->reader.features = trace->features;
+  tf->reader.file = trace->file;
+  tf->reader.block_stride = trace->block_stride;
+  tf->reader.oblock_size = trace->oblock_size;
+  tf->reader.sampling_rate = trace->sampling_rate;
+  tf->trace = trace;
+  tf->filter = *filter;
+  tf->starting_time_set = false;
+  tf->done = false;
+
+  return &tf->reader;
+}
+
+/** Cut the request down to its accesses in the address range
+ *
+ * \return 0 if it has any, or not 0 if none of them are
+ */
+static int __trace_filter_lba_range(struct trace_filter *filter,
+                                    block_t stride,
+                                    struct trace_request *request) {
+  oblock_t last;
+  oblock_t skip;
+
+  if (request->nr_blocks == 0) {
+    return 1;
+  }
+
+  last = request->oblock + (oblock_t)(request->nr_blocks - 1) * stride;
+  if (request->oblock > filter->last_lba ||
+      last < filter->first_lba) {
+    return 1;
+  }
+
+  if (request->oblock < filter->first_lba) {
+    // accesses starting before the range
+    skip = (filter->first_lba - request->oblock + stride - 1) / stride;
+    request->oblock += skip * stride;
+    request->nr_blocks -= skip;
+  }
+  if (last > filter->last_lba) {
+    request->nr_blocks -= (last - filter->last_lba + stride - 1) / stride;
+  }
+  return request->nr_blocks == 0;
+}
+
+static int trace_filter_read_request(struct trace_reader *reader,
+                                     struct trace_request *request) {
+  struct trace_filter_struct *tf =
+      container_of(reader, struct trace_filter_struct, reader);
+  struct trace_filter *filter = &tf->filter;
+  struct trace_reader *trace = tf->trace;
+  uint64_t time;
+
+  if (tf->done) {
+    return 1;
+  }
+
+  for (;;) {
+    if (trace->read_request(trace, request)) {
+      reader->eof = trace->eof;
+      tf->done = true;
+      return 1;
+    }
+
+    if ((filter->pid || filter->process) && request->process == 0) {
+      LOG_FATAL("The trace has no processes to filter (fiu and visa do)");
+    }
+
+    if (filter->time_window) {
+      if (!tf->starting_time_set) {
+        tf->starting_time = request->ts;
+        tf->starting_time_set = true;
+      }
+      // requests slightly out of order before the first one are at time 0
+      time = request->ts > tf->starting_time
+                 ? request->ts - tf->starting_time
+                 : 0;
+      if (time >= filter->time_to) {
+        LOG_DEBUG("end of time window reached");
+        tf->done = true;
+        return 1;
+      }
+      if (time < filter->time_from) {
+        continue;
+      }
+    }
+
+    if ((filter->reads_only && request->write) ||
+        (filter->writes_only && !request->write) ||
+        (filter->pid && request->pid != filter->pid_value) ||
+        (filter->process && request->process != filter->process_value)) {
+      continue;
+    }
+
+    if (filter->lba_range &&
+        __trace_filter_lba_range(filter, reader->block_stride, request)) {
+      continue;
+    }
+
+    return 0;
+  }
+}
+
+static int trace_filter_read(struct trace_reader *reader,
+                             struct trace_reader_result *result) {
+  struct trace_request request;
+
+  if (trace_filter_read_request(reader, &request)) {
+    return 1;
+  }
+
+  result->oblock = request.oblock;
+  result->nr_blocks = request.nr_blocks;
+  result->write = request.write;
+
+  return 0;
+}
+
+static void trace_filter_exit(struct trace_reader *reader) {
+  struct trace_filter_struct *tf =
+      container_of(reader, struct trace_filter_struct, reader);
+
+  tf->trace->exit(tf->trace);
+  mem_free(tf);
+}
+
+#endif /* TRACE_READER_TRACE_FILTER_H */
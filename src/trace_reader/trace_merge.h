@@ -0,0 +1,298 @@
+#ifndef TRACE_READER_TRACE_MERGE_H
+#define TRACE_READER_TRACE_MERGE_H
+
+#include "common.h"
+#include "tools/heap.h"
+#include "trace_reader/trace_block.h"
+#include "trace_reader/trace_decompress.h"
+#include "trace_reader/trace_filter.h"
+#include "trace_reader/trace_parallel.h"
+#include "trace_reader/trace_reader.h"
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+/* A single cache often fronts many volumes (tenants) at once. A trace_merge
+ * reader replays the traces of several tenants, each in any supported format,
+ * as if they were happening at the same time: each trace starts at time 0
+ * (its own first request), and their requests are merged by time with a k-way
+ * merge over a min-heap of the next request of every tenant.
+ *
+ * Every tenant gets its own disjoint range of oblocks, with the index of the
+ * tenant in the bits above TRACE_MERGE_TENANT_SHIFT, so the tenant of any
+ * access can be told from its oblock (see trace_merge_tenant()). Since the
+ * formats have different block strides, the oblocks of a tenant are its
+ * blocks (oblock / block_stride), and the merged trace has a block stride
+ * of 1.
+ *
+ * Traces that were sampled when written are merged as they are (their oblocks
+ * being hashes already), which all the tenants must then have been, at the
+ * same sampling rate.
+ */
+
+#define TRACE_MERGE_TENANT_SHIFT 48
+#define TRACE_MERGE_MAX_TENANTS (1u << (64 - TRACE_MERGE_TENANT_SHIFT))
+
+/** Tenant (index in the order the traces were given) of a merged oblock
+ */
+static unsigned trace_merge_tenant(oblock_t oblock) {
+  return oblock >> TRACE_MERGE_TENANT_SHIFT;
+}
+
+/** trace_merge_tenant_struct
+ * A tenant of the merged trace
+ *
+ * hh - Position in the heap, ordered by the time of next
+ * index - Index of the tenant
+ * path/file/reader - The trace of the tenant
+ * next - Next request of the tenant, already moved into its oblock range and
+ *        made relative to starting_time
+ * starting_time - Time of the first request of the tenant
+ */
+struct trace_merge_tenant_struct {
+  struct heap_head hh;
+  unsigned index;
+  const char *path;
+  FILE *file;
+  struct trace_reader *reader;
+  struct trace_request next;
+  uint64_t starting_time;
+};
+
+/** trace_merge_struct
+ * Tracks trace information
+ *
+ * tenants/nr_tenants - Every tenant, in the order they were given
+ * heap - Tenants with requests left, ordered by the time of their next one
+ */
+struct trace_merge_struct {
+  struct trace_reader reader;
+  struct trace_merge_tenant_struct *tenants;
+  unsigned nr_tenants;
+  struct heap heap;
+};
+
+static int trace_merge_read(struct trace_reader *reader,
+                            struct trace_reader_result *result);
+static int trace_merge_read_request(struct trace_reader *reader,
+                                    struct trace_request *request);
+static void trace_merge_exit(struct trace_reader *reader);
+
+static const struct trace_reader trace_merge = {
+    .features = {0},
+    .file = NULL,
+    .block_stride = 1,
+    .oblock_size = 0,
+    .sampling_rate = 1,
+    .eof = false,
+    .read = trace_merge_read,
+    .read_request = trace_merge_read_request,
+    .set_range = NULL,
+    .seek = NULL,
+    .exit = trace_merge_exit,
+};
+
+/** Order tenants by the time of their next request (and then by index, so
+ * that requests at the same time are always merged the same way)
+ */
+static int __trace_merge_compare(struct heap_head *a, struct heap_head *b) {
+  struct trace_merge_tenant_struct *t_a =
+      container_of(a, struct trace_merge_tenant_struct, hh);
+  struct trace_merge_tenant_struct *t_b =
+      container_of(b, struct trace_merge_tenant_struct, hh);
+
+  if (t_a->next.ts != t_b->next.ts) {
+    return t_a->next.ts < t_b->next.ts ? -1 : 1;
+  }
+  return t_a->index < t_b->index ? -1 : t_a->index > t_b->index;
+}
+
+/** Read the next request of the tenant into its next
+ *
+ * \return 0 if read, or not 0 once the trace of the tenant has been read
+ */
+static int __trace_merge_next(struct trace_merge_tenant_struct *t,
+                              bool first) {
+  struct trace_reader *reader = t->reader;
+  struct trace_request *next = &t->next;
+
+  if (reader->read_request(reader, next)) {
+    return 1;
+  }
+
+  if (first) {
+    t->starting_time = next->ts;
+  }
+  // requests slightly out of order before the first one start at 0 as well
+  next->ts = next->ts > t->starting_time ? next->ts - t->starting_time : 0;
+
+  if (reader->sampling_rate == 1) {
+    next->oblock /= reader->block_stride;
+  }
+  if ((next->oblock + next->nr_blocks) >> TRACE_MERGE_TENANT_SHIFT) {
+    LOG_FATAL("Trace %s has blocks beyond the range of a tenant", t->path);
+  }
+  next->oblock |= (oblock_t)t->index << TRACE_MERGE_TENANT_SHIFT;
+
+  return 0;
+}
+
+/** Open the trace of a tenant, given as [FORMAT:]FILE
+ */
+static void __trace_merge_open(struct trace_merge_tenant_struct *t,
+                               const char *tenant, const char *trace_name,
+                               unsigned duration_hrs, unsigned decode_threads,
+                               struct trace_filter *filter,
+                               uint64_t block_size) {
+  const char *colon = strchr(tenant, ':');
+  char format[TRACE_READER_NAME_MAX_LENGTH + 1];
+  trace_reader_create_f create = find_trace_reader(trace_name);
+
+  t->path = tenant;
+  if (colon != NULL && colon - tenant <= TRACE_READER_NAME_MAX_LENGTH) {
+    memcpy(format, tenant, colon - tenant);
+    format[colon - tenant] = '\0';
+    if (find_trace_reader(format) != NULL) {
+      create = find_trace_reader(format);
+      t->path = colon + 1;
+    }
+  }
+
+  t->file = fopen(t->path, "r");
+  if (!t->file) {
+    LOG_FATAL("File %s could not be opened. Errno = %d", t->path, errno);
+  }
+
+  t->file = trace_decompress_open(t->file);
+  if (!t->file) {
+    LOG_FATAL("Unable to open trace file %s", t->path);
+  }
+
+  t->reader = trace_parallel_create(create, t->file, duration_hrs,
+                                    decode_threads);
+  if (t->reader && trace_filter_used(filter)) {
+    t->reader = trace_filter_create(t->reader, filter);
+  }
+  if (t->reader && block_size > 0) {
+    t->reader = trace_block_create(t->reader, block_size);
+  }
+  if (!t->reader) {
+    LOG_FATAL("Unable to create the trace reader for %s", t->path);
+  }
+}
+
+/** Create a trace_reader merging the traces of the given tenants, each given
+ * as [FORMAT:]FILE, where FORMAT defaults to the trace format trace_name
+ *
+ * The duration applies to each of the tenants (which all start at time 0),
+ * and so do the filter of their requests (see trace_filter.h) and the block
+ * size their accesses are mapped onto (if not 0, see trace_block.h).
+ *
+ * \return The trace_reader, or NULL if unable to allocate memory
+ */
+static struct trace_reader *trace_merge_create(char **tenants,
+                                               unsigned nr_tenants,
+                                               const char *trace_name,
+                                               unsigned duration_hrs,
+                                               unsigned decode_threads,
+                                               struct trace_filter *filter,
+                                               uint64_t block_size) {
+  struct trace_merge_struct *tm;
+  struct trace_merge_tenant_struct *t;
+  unsigned i;
+
+  if (nr_tenants > TRACE_MERGE_MAX_TENANTS) {
+    LOG_FATAL("At most %u tenants are supported", TRACE_MERGE_MAX_TENANTS);
+  }
+
+  tm = (struct trace_merge_struct *)mem_alloc(sizeof(*tm));
+  if (tm == NULL) {
+    return NULL;
+  }
+  tm->tenants = (struct trace_merge_tenant_struct *)mem_alloc(
+      sizeof(*tm->tenants) * nr_tenants);
+  if (tm->tenants == NULL || heap_init(&tm->heap, nr_tenants)) {
+    mem_free(tm->tenants);
+    mem_free(tm);
+    return NULL;
+  }
+  heap_set_compare(&tm->heap, __trace_merge_compare);
+
+  tm->reader = trace_merge;
+  tm->nr_tenants = nr_tenants;
+
+  for (i = 0; i < nr_tenants; i++) {
+    t = &tm->tenants[i];
+    t->index = i;
+    __trace_merge_open(t, tenants[i], trace_name, duration_hrs,
+                       decode_threads, filter, block_size);
+
+    if (i == 0) {
+      tm->reader.sampling_rate = t->reader->sampling_rate;
+    } else if (t->reader->sampling_rate != tm->reader.sampling_rate) {
+      LOG_FATAL("Trace %s was sampled at a different sampling rate", t->path);
+    }
+
+    if (!__trace_merge_next(t, true)) {
+      heap_insert(&tm->heap, &t->hh, 0);
+    }
+  }
+
+  return &tm->reader;
+}
+
+static int trace_merge_read_request(struct trace_reader *reader,
+                                    struct trace_request *request) {
+  struct trace_merge_struct *tm =
+      container_of(reader, struct trace_merge_struct, reader);
+  struct heap_head *hh = heap_min(&tm->heap);
+  struct trace_merge_tenant_struct *t;
+
+  if (hh == NULL) {
+    LOG_DEBUG("end of every trace reached");
+    reader->eof = true;
+    return 1;
+  }
+
+  t = container_of(hh, struct trace_merge_tenant_struct, hh);
+  *request = t->next;
+
+  if (__trace_merge_next(t, false)) {
+    heap_delete(&tm->heap, hh);
+  } else {
+    heapify(&tm->heap, hh->index);
+  }
+
+  return 0;
+}
+
+static int trace_merge_read(struct trace_reader *reader,
+                            struct trace_reader_result *result) {
+  struct trace_request request;
+
+  if (trace_merge_read_request(reader, &request)) {
+    return 1;
+  }
+
+  result->oblock = request.oblock;
+  result->nr_blocks = request.nr_blocks;
+  result->write = request.write;
+
+  return 0;
+}
+
+static void trace_merge_exit(struct trace_reader *reader) {
+  struct trace_merge_struct *tm =
+      container_of(reader, struct trace_merge_struct, reader);
+  unsigned i;
+
+  for (i = 0; i < tm->nr_tenants; i++) {
+    tm->tenants[i].reader->exit(tm->tenants[i].reader);
+    fclose(tm->tenants[i].file);
+  }
+  heap_exit(&tm->heap);
+  mem_free(tm->tenants);
+  mem_free(tm);
+}
+
+#endif /* TRACE_READER_TRACE_MERGE_H */
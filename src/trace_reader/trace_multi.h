@@ -0,0 +1,322 @@
+#ifndef TRACE_READER_TRACE_MULTI_H
+#define TRACE_READER_TRACE_MULTI_H
+
+#include "common.h"
+#include "trace_reader/trace_decompress.h"
+#include "trace_reader/trace_parallel.h"
+#include "trace_reader/trace_reader_structs.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Traces often come split into several files (per day, per volume, ...). A
+ * trace_multi reader reads a list of trace files one after the other as a
+ * single trace, so a cache simulated over them stays warm across the files.
+ *
+ * While a file is being read, the next one is already opened on a helper
+ * thread: its decompression (see trace_decompress.h) starts, the kernel is
+ * asked to read it ahead (if it is a regular file) and its trace_reader is
+ * created, so moving on to the next file doesn't wait on the disk.
+ *
+ * The duration feature applies to the whole trace, counting from the first
+ * request of the first file. The first file applies it as it would on its own,
+ * while for the following files it is applied to the (nanosecond) time of
+ * their requests, rather than by their trace_readers.
+ */
+
+// nanosecond -> second -> minute -> hour
+static const long long TRACE_MULTI_HOUR_LENGTH = 1000000000LL * 60 * 60;
+
+/** trace_files
+ * Paths of the files of a trace, in the order they are read
+ */
+struct trace_files {
+  char **paths;
+  unsigned nr_paths;
+};
+
+/** Add a trace file to the list
+ */
+static void trace_files_add(struct trace_files *files, const char *path) {
+  char **paths;
+
+  if (access(path, R_OK)) {
+    LOG_FATAL("File %s could not be opened. Errno = %d", path, errno);
+  }
+
+  paths = (char **)realloc(files->paths,
+                           sizeof(*files->paths) * (files->nr_paths + 1));
+  if (paths == NULL || (paths[files->nr_paths] = strdup(path)) == NULL) {
+    LOG_FATAL("Unable to allocate trace file list");
+  }
+  files->paths = paths;
+  ++files->nr_paths;
+}
+
+/** Add the trace files listed in a manifest, one path per line (skipping
+ * blank lines), where relative paths are relative to the manifest
+ */
+static void trace_files_add_manifest(struct trace_files *files,
+                                     const char *manifest) {
+  FILE *file = fopen(manifest, "r");
+  const char *slash = strrchr(manifest, '/');
+  // length of the directory of the manifest, including its last '/'
+  size_t dir_len = slash ? slash - manifest + 1 : 0;
+  char line[4096];
+  char path[4096 * 2];
+
+  if (!file) {
+    LOG_FATAL("File %s could not be opened. Errno = %d", manifest, errno);
+  }
+
+  while (fgets(line, sizeof(line), file) != NULL) {
+    size_t len = strlen(line);
+
+    while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r' ||
+                       line[len - 1] == ' ' || line[len - 1] == '\t')) {
+      line[--len] = '\0';
+    }
+    if (len == 0) {
+      continue;
+    }
+
+    if (line[0] == '/' || dir_len == 0) {
+      trace_files_add(files, line);
+    } else {
+      memcpy(path, manifest, dir_len);
+      strcpy(path + dir_len, line);
+      trace_files_add(files, path);
+    }
+  }
+
+  fclose(file);
+}
+
+/** trace_multi_file
+ * An opened trace file and its trace_reader
+ */
+struct trace_multi_file {
+  FILE *file;
+  struct trace_reader *reader;
+};
+
+/** trace_multi_struct
+ * Tracks trace information
+ *
+ * create/decode_threads - How the trace_reader of each file is created
+ * files - Files of the trace
+ * next - Index of the next file to be opened
+ * current - File being read
+ * ahead/thread - Next file, being opened by thread (if next is a file)
+ * done - Has the end of the trace (or of its duration) been reached?
+ */
+struct trace_multi_struct {
+  struct trace_reader reader;
+  trace_reader_create_f create;
+  unsigned decode_threads;
+  struct trace_files *files;
+  unsigned next;
+
+  struct trace_multi_file current;
+  struct trace_multi_file ahead;
+  pthread_t thread;
+
+  bool done;
+  bool starting_time_set;
+  uint64_t ending_time;
+};
+
+static int trace_multi_read(struct trace_reader *reader,
+                            struct trace_reader_result *result);
+static int trace_multi_read_request(struct trace_reader *reader,
+                                    struct trace_request *request);
+static void trace_multi_exit(struct trace_reader *reader);
+
+static const struct trace_reader trace_multi = {
+    .features = {0},
+    .file = NULL,
+    .block_stride = 1,
+    .oblock_size = 0,
+    .sampling_rate = 1,
+    .eof = false,
+    .read = trace_multi_read,
+    .read_request = trace_multi_read_request,
+    .set_range = NULL,
+    .seek = NULL,
+    .exit = trace_multi_exit,
+};
+
+/** Open the file at path and create its trace_reader
+ */
+static void __trace_multi_open(struct trace_multi_struct *tm, const char *path,
+                               struct trace_multi_file *f,
+                               unsigned duration_hrs) {
+  f->file = fopen(path, "r");
+  if (!f->file) {
+    LOG_FATAL("File %s could not be opened. Errno = %d", path, errno);
+  }
+
+  // only a hint, so it doesn't matter if the file can't be read ahead
+  posix_fadvise(fileno(f->file), 0, 0, POSIX_FADV_WILLNEED);
+
+  f->file = trace_decompress_open(f->file);
+  if (!f->file) {
+    LOG_FATAL("Unable to open trace file %s", path);
+  }
+
+  f->reader = trace_parallel_create(tm->create, f->file, duration_hrs,
+                                    tm->decode_threads);
+  if (!f->reader) {
+    LOG_FATAL("Unable to create the trace reader for %s", path);
+  }
+}
+
+static void *__trace_multi_open_ahead(void *arg) {
+  struct trace_multi_struct *tm = (struct trace_multi_struct *)arg;
+
+  // past the first file, the duration is applied by trace_multi
+  __trace_multi_open(tm, tm->files->paths[tm->next], &tm->ahead, 0);
+  return NULL;
+}
+
+static void __trace_multi_start_ahead(struct trace_multi_struct *tm) {
+  if (tm->next < tm->files->nr_paths &&
+      pthread_create(&tm->thread, NULL, __trace_multi_open_ahead, tm)) {
+    LOG_FATAL("Unable to create trace read-ahead thread");
+  }
+}
+
+static void __trace_multi_close(struct trace_multi_file *f) {
+  f->reader->exit(f->reader);
+  fclose(f->file);
+}
+
+/** Move on to the next file, once the one being read has been read
+ */
+static void __trace_multi_next(struct trace_multi_struct *tm) {
+  __trace_multi_close(&tm->current);
+
+  pthread_join(tm->thread, NULL);
+  tm->current = tm->ahead;
+  ++tm->next;
+  if (tm->current.reader->block_stride != tm->reader.block_stride) {
+    LOG_FATAL("Trace file %s has a different block stride",
+              tm->files->paths[tm->next - 1]);
+  }
+  if (tm->current.reader->sampling_rate != tm->reader.sampling_rate) {
+    LOG_FATAL("Trace file %s was sampled at a different sampling rate",
+              tm->files->paths[tm->next - 1]);
+  }
+
+  __trace_multi_start_ahead(tm);
+}
+
+/** Create a trace_reader reading the given files as a single trace, using the
+ * readers made by create (decoding each file on decode_threads threads, see
+ * trace_parallel_create())
+ *
+ * NOTE: Unlike other trace_readers, the trace_multi reader opens (and closes)
+ *       the files itself, so its file is NULL.
+ *
+ * \return The trace_reader, or NULL if unable to allocate memory
+ */
+static struct trace_reader *trace_multi_create(trace_reader_create_f create,
+                                               struct trace_files *files,
+                                               unsigned duration_hrs,
+                                               unsigned decode_threads) {
+  struct trace_multi_struct *tm =
+      (struct trace_multi_struct *)mem_alloc(sizeof(*tm));
+
+  if (tm == NULL) {
+    return NULL;
+  }
+
+  tm->reader = trace_multi;
+  tm->create = create;
+  tm->decode_threads = decode_threads;
+  tm->files = files;
+  tm->done = false;
+  tm->starting_time_set = false;
+
+  __trace_multi_open(tm, files->paths[0], &tm->current, duration_hrs);
+  tm->next = 1;
+  tm->reader.features = tm->current.reader->features;
+  tm->reader.block_stride = tm->current.reader->block_stride;
+  tm->reader.oblock_size = tm->current.reader->oblock_size;
+  tm->reader.sampling_rate = tm->current.reader->sampling_rate;
+
+  __trace_multi_start_ahead(tm);
+
+  return &tm->reader;
+}
+
+static int trace_multi_read_request(struct trace_reader *reader,
+                                    struct trace_request *request) {
+  struct trace_multi_struct *tm =
+      container_of(reader, struct trace_multi_struct, reader);
+  struct trace_reader *current = tm->current.reader;
+
+  if (tm->done) {
+    return 1;
+  }
+
+  while (current->read_request(current, request)) {
+    // only the end of a file moves on to the next one
+    if (!current->eof || tm->next == tm->files->nr_paths) {
+      reader->eof = current->eof;
+      tm->done = true;
+      return 1;
+    }
+    __trace_multi_next(tm);
+    current = tm->current.reader;
+  }
+
+  if (reader->features.use_duration) {
+    if (!tm->starting_time_set) {
+      tm->ending_time = request->ts + (TRACE_MULTI_HOUR_LENGTH *
+                                       reader->features.duration_hrs);
+      tm->starting_time_set = true;
+    }
+    // the first file applies the duration itself
+    if (tm->next > 1 && request->ts > tm->ending_time) {
+      LOG_DEBUG("end of duration reached");
+      tm->done = true;
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+static int trace_multi_read(struct trace_reader *reader,
+                            struct trace_reader_result *result) {
+  struct trace_request request;
+
+  if (trace_multi_read_request(reader, &request)) {
+    return 1;
+  }
+
+  result->oblock = request.oblock;
+  result->nr_blocks = request.nr_blocks;
+  result->write = request.write;
+
+  return 0;
+}
+
+static void trace_multi_exit(struct trace_reader *reader) {
+  struct trace_multi_struct *tm =
+      container_of(reader, struct trace_multi_struct, reader);
+
+  if (tm->next < tm->files->nr_paths) {
+    pthread_join(tm->thread, NULL);
+    __trace_multi_close(&tm->ahead);
+  }
+  __trace_multi_close(&tm->current);
+  mem_free(tm);
+}
+
+#endif /* TRACE_READER_TRACE_MULTI_H */
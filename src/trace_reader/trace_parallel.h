@@ -0,0 +1,416 @@
+#ifndef TRACE_READER_TRACE_PARALLEL_H
+#define TRACE_READER_TRACE_PARALLEL_H
+
+#include "common.h"
+#include "trace_reader/trace_reader_structs.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Decoding a large text trace on a single thread takes as long as parsing
+ * every one of its lines, one after the other. Instead, a trace_parallel
+ * reader splits a trace (that is a regular file) into chunks of about
+ * TRACE_PARALLEL_CHUNK_SIZE bytes, starting at the beginning of a line, which
+ * are decoded into requests by several threads, each with its own reader of
+ * the trace's format (see set_range() in trace_reader). The decoded chunks are
+ * then read in their original order, exactly as the format's reader would
+ * have read them.
+ *
+ * Only TRACE_PARALLEL_CHUNKS_PER_THREAD chunks per thread are decoded ahead of
+ * the one being read, so however large the trace, only a few chunks of it are
+ * in memory at once.
+ *
+ * Decoding stops at the first line the format's reader can't parse, as it
+ * would have on its own, while the duration feature is applied as the chunks
+ * are read, since only then the time of the first request of the trace is
+ * known. The cut-off is applied to the (nanosecond) time of the requests.
+ */
+
+#define TRACE_PARALLEL_CHUNK_SIZE (16 << 20)
+#define TRACE_PARALLEL_CHUNKS_PER_THREAD 2
+// nanosecond -> second -> minute -> hour
+static const long long TRACE_PARALLEL_HOUR_LENGTH = 1000000000LL * 60 * 60;
+
+/** trace_parallel_chunk
+ * requests/len/capacity - Decoded requests, their count and how many requests
+ *                         there is space for
+ * decoded - Has the chunk been decoded (and not yet read)?
+ * cut - Did decoding stop before the end of the chunk (at a line that
+ *       couldn't be parsed)?
+ */
+struct trace_parallel_chunk {
+  struct trace_request *requests;
+  uint64_t len;
+  uint64_t capacity;
+  bool decoded;
+  bool cut;
+};
+
+struct trace_parallel_struct;
+
+/** trace_parallel_worker
+ * thread - Thread decoding chunks
+ * reader - Reader of the trace's format, used for its chunks
+ * tp - The trace_parallel reader the thread decodes chunks for
+ */
+struct trace_parallel_worker {
+  pthread_t thread;
+  struct trace_reader *reader;
+  struct trace_parallel_struct *tp;
+};
+
+/** trace_parallel_struct
+ * Tracks trace information
+ *
+ * offsets - Where each chunk starts in the file, followed by where the last
+ *           one ends
+ * chunks - Ring of nr_slots chunks being decoded or read, where chunk number c
+ *          is decoded into chunks[c % nr_slots]
+ * lock/cond - Protect (and signal changes to) next_chunk, chunk, stop and the
+ *             decoded flags of chunks
+ * next_chunk - Number of the next chunk to be decoded
+ * chunk/pos - Number of the chunk being read and position of the next request
+ *             in it
+ * ready - Has chunk been decoded?
+ * done - Has the end of the trace (or of its duration) been reached?
+ */
+struct trace_parallel_struct {
+  struct trace_reader reader;
+  struct trace_parallel_worker *workers;
+  unsigned nr_workers;
+
+  off_t *offsets;
+  uint64_t nr_chunks;
+  struct trace_parallel_chunk *chunks;
+  unsigned nr_slots;
+
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  uint64_t next_chunk;
+  bool stop;
+
+  uint64_t chunk;
+  uint64_t pos;
+  bool ready;
+  bool done;
+
+  bool starting_time_set;
+  uint64_t ending_time;
+};
+
+static int trace_parallel_read(struct trace_reader *reader,
+                               struct trace_reader_result *result);
+static int trace_parallel_read_request(struct trace_reader *reader,
+                                       struct trace_request *request);
+static void trace_parallel_exit(struct trace_reader *reader);
+
+static const struct trace_reader trace_parallel = {
+    .features = {0},
+    .file = NULL,
+    .block_stride = 1,
+    .oblock_size = 0,
+    .sampling_rate = 1,
+    .eof = false,
+    .read = trace_parallel_read,
+    .read_request = trace_parallel_read_request,
+    .set_range = NULL,
+    .seek = NULL,
+    .exit = trace_parallel_exit,
+};
+
+/** Find where the first line starting at or after offset starts
+ *
+ * \return Offset of the start of the line, or size if there is none
+ */
+static off_t __trace_parallel_line_start(int fd, off_t offset, off_t size) {
+  char buf[4096];
+  off_t o = offset - 1;
+
+  while (o < size) {
+    ssize_t r = pread(fd, buf, sizeof(buf), o);
+    char *nl;
+
+    if (r <= 0) {
+      break;
+    }
+    nl = (char *)memchr(buf, '\n', r);
+    if (nl != NULL) {
+      return o + (nl - buf) + 1;
+    }
+    o += r;
+  }
+  return size;
+}
+
+/** Decode a chunk, from the start of one line up to the start of another
+ */
+static void __trace_parallel_decode(struct trace_parallel_worker *w,
+                                    struct trace_parallel_chunk *chunk,
+                                    off_t start, off_t end) {
+  struct trace_reader *reader = w->reader;
+
+  chunk->len = 0;
+  chunk->cut = false;
+  reader->set_range(reader, start, end);
+
+  for (;;) {
+    if (chunk->len == chunk->capacity) {
+      uint64_t capacity = chunk->capacity ? 2 * chunk->capacity : 1 << 16;
+      struct trace_request *requests = (struct trace_request *)realloc(
+          chunk->requests, sizeof(*requests) * capacity);
+      if (requests == NULL) {
+        LOG_FATAL("unable to allocate decoded trace chunk");
+      }
+      chunk->requests = requests;
+      chunk->capacity = capacity;
+    }
+
+    if (reader->read_request(reader, &chunk->requests[chunk->len])) {
+      chunk->cut = !reader->eof;
+      return;
+    }
+    ++chunk->len;
+  }
+}
+
+static void *__trace_parallel_work(void *arg) {
+  struct trace_parallel_worker *w = (struct trace_parallel_worker *)arg;
+  struct trace_parallel_struct *tp = w->tp;
+
+  for (;;) {
+    struct trace_parallel_chunk *chunk;
+    uint64_t c;
+
+    // wait for the slot of the next chunk to be read
+    pthread_mutex_lock(&tp->lock);
+    while (!tp->stop && tp->next_chunk < tp->nr_chunks &&
+           tp->next_chunk - tp->chunk >= tp->nr_slots) {
+      pthread_cond_wait(&tp->cond, &tp->lock);
+    }
+    if (tp->stop || tp->next_chunk == tp->nr_chunks) {
+      pthread_mutex_unlock(&tp->lock);
+      return NULL;
+    }
+    c = tp->next_chunk++;
+    pthread_mutex_unlock(&tp->lock);
+
+    chunk = &tp->chunks[c % tp->nr_slots];
+    __trace_parallel_decode(w, chunk, tp->offsets[c], tp->offsets[c + 1]);
+
+    pthread_mutex_lock(&tp->lock);
+    chunk->decoded = true;
+    pthread_cond_broadcast(&tp->cond);
+    pthread_mutex_unlock(&tp->lock);
+  }
+}
+
+/** Split the rest of the file, from its current offset on, into chunks
+ */
+static void __trace_parallel_split(struct trace_parallel_struct *tp, int fd,
+                                   off_t size) {
+  off_t start = lseek(fd, 0, SEEK_CUR);
+  uint64_t c;
+
+  if (start < 0 || start > size) {
+    start = 0;
+  }
+
+  tp->nr_chunks = (size - start + TRACE_PARALLEL_CHUNK_SIZE - 1) /
+                  TRACE_PARALLEL_CHUNK_SIZE;
+  if (tp->nr_chunks == 0) {
+    tp->nr_chunks = 1;
+  }
+
+  tp->offsets = (off_t *)mem_alloc(sizeof(*tp->offsets) * (tp->nr_chunks + 1));
+  if (tp->offsets == NULL) {
+    LOG_FATAL("unable to allocate trace chunks");
+  }
+
+  tp->offsets[0] = start;
+  for (c = 1; c < tp->nr_chunks; c++) {
+    tp->offsets[c] = __trace_parallel_line_start(
+        fd, start + c * TRACE_PARALLEL_CHUNK_SIZE, size);
+  }
+  tp->offsets[tp->nr_chunks] = size;
+}
+
+/** Create a trace_reader decoding the trace in file on nr_threads threads,
+ * using the readers made by create
+ *
+ * If the trace can't be decoded in parallel (nr_threads is 1 or less, file
+ * isn't a regular file or the format doesn't support set_range()), this is
+ * simply a trace_reader made by create.
+ *
+ * \return The trace_reader, or NULL if create is unable to make one
+ */
+static struct trace_reader *trace_parallel_create(trace_reader_create_f create,
+                                                  FILE *file,
+                                                  unsigned duration_hrs,
+                                                  unsigned nr_threads) {
+  struct trace_parallel_struct *tp;
+  struct trace_reader *first = create(file, duration_hrs);
+  struct stat st;
+  unsigned i;
+
+  if (first == NULL || nr_threads <= 1 || first->set_range == NULL ||
+      fstat(fileno(file), &st) || !S_ISREG(st.st_mode)) {
+    return first;
+  }
+
+  tp = (struct trace_parallel_struct *)mem_alloc(sizeof(*tp));
+  if (tp == NULL) {
+    LOG_FATAL("unable to allocate parallel trace reader");
+  }
+
+  tp->reader = trace_parallel;
+  tp->reader.file = file;
+  tp->reader.features = first->features;
+  tp->reader.block_stride = first->block_stride;
+  tp->reader.oblock_size = first->oblock_size;
+  tp->reader.sampling_rate = first->sampling_rate;
+  tp->starting_time_set = false;
+
+  __trace_parallel_split(tp, fileno(file), st.st_size);
+
+  tp->nr_workers = nr_threads;
+  if (tp->nr_workers > tp->nr_chunks) {
+    tp->nr_workers = tp->nr_chunks;
+  }
+  tp->nr_slots = tp->nr_workers * TRACE_PARALLEL_CHUNKS_PER_THREAD;
+  tp->workers = (struct trace_parallel_worker *)mem_alloc(
+      sizeof(*tp->workers) * tp->nr_workers);
+  tp->chunks = (struct trace_parallel_chunk *)mem_alloc(sizeof(*tp->chunks) *
+                                                        tp->nr_slots);
+  if (tp->workers == NULL || tp->chunks == NULL) {
+    LOG_FATAL("unable to allocate parallel trace reader");
+  }
+
+  pthread_mutex_init(&tp->lock, NULL);
+  pthread_cond_init(&tp->cond, NULL);
+
+  for (i = 0; i < tp->nr_workers; i++) {
+    struct trace_parallel_worker *w = &tp->workers[i];
+
+    w->tp = tp;
+    w->reader = i == 0 ? first : create(file, duration_hrs);
+    if (w->reader == NULL) {
+      LOG_FATAL("unable to allocate trace reader");
+    }
+    // the duration is applied in order, as the chunks are read
+    w->reader->features.use_duration = false;
+
+    if (pthread_create(&w->thread, NULL, __trace_parallel_work, w)) {
+      LOG_FATAL("unable to create trace decoding thread");
+    }
+  }
+
+  return &tp->reader;
+}
+
+static int trace_parallel_read_request(struct trace_reader *reader,
+                                       struct trace_request *request) {
+  struct trace_parallel_struct *tp =
+      container_of(reader, struct trace_parallel_struct, reader);
+  struct trace_parallel_chunk *chunk = &tp->chunks[tp->chunk % tp->nr_slots];
+
+  if (tp->done) {
+    return 1;
+  }
+
+  while (!tp->ready || tp->pos == chunk->len) {
+    if (tp->ready) {
+      if (chunk->cut) {
+        tp->done = true;
+        return 1;
+      }
+
+      // hand the slot back for decoding
+      pthread_mutex_lock(&tp->lock);
+      chunk->decoded = false;
+      ++tp->chunk;
+      pthread_cond_broadcast(&tp->cond);
+      pthread_mutex_unlock(&tp->lock);
+
+      tp->pos = 0;
+      tp->ready = false;
+      chunk = &tp->chunks[tp->chunk % tp->nr_slots];
+    }
+
+    if (tp->chunk == tp->nr_chunks) {
+      LOG_DEBUG("end of file reached");
+      reader->eof = true;
+      tp->done = true;
+      return 1;
+    }
+
+    pthread_mutex_lock(&tp->lock);
+    while (!chunk->decoded) {
+      pthread_cond_wait(&tp->cond, &tp->lock);
+    }
+    pthread_mutex_unlock(&tp->lock);
+    tp->ready = true;
+  }
+
+  *request = chunk->requests[tp->pos++];
+
+  if (reader->features.use_duration) {
+    if (!tp->starting_time_set) {
+      tp->ending_time = request->ts + (TRACE_PARALLEL_HOUR_LENGTH *
+                                       reader->features.duration_hrs);
+      tp->starting_time_set = true;
+    }
+    if (request->ts > tp->ending_time) {
+      LOG_DEBUG("end of duration reached");
+      tp->done = true;
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+static int trace_parallel_read(struct trace_reader *reader,
+                               struct trace_reader_result *result) {
+  struct trace_request request;
+
+  if (trace_parallel_read_request(reader, &request)) {
+    return 1;
+  }
+
+  result->oblock = request.oblock;
+  result->nr_blocks = request.nr_blocks;
+  result->write = request.write;
+
+  return 0;
+}
+
+static void trace_parallel_exit(struct trace_reader *reader) {
+  struct trace_parallel_struct *tp =
+      container_of(reader, struct trace_parallel_struct, reader);
+  unsigned i;
+
+  pthread_mutex_lock(&tp->lock);
+  tp->stop = true;
+  pthread_cond_broadcast(&tp->cond);
+  pthread_mutex_unlock(&tp->lock);
+
+  for (i = 0; i < tp->nr_workers; i++) {
+    pthread_join(tp->workers[i].thread, NULL);
+    tp->workers[i].reader->exit(tp->workers[i].reader);
+  }
+  for (i = 0; i < tp->nr_slots; i++) {
+    free(tp->chunks[i].requests);
+  }
+
+  pthread_cond_destroy(&tp->cond);
+  pthread_mutex_destroy(&tp->lock);
+  mem_free(tp->chunks);
+  mem_free(tp->workers);
+  mem_free(tp->offsets);
+  mem_free(tp);
+}
+
+#endif /* TRACE_READER_TRACE_PARALLEL_H */
@@ -0,0 +1,32 @@
+#ifndef TRACE_READER_TRACE_PROCESS_H
+#define TRACE_READER_TRACE_PROCESS_H
+
+#include "types.h"
+#include <stddef.h>
+
+/* Some traces (such as the FIU and VISA traces) record the process making
+ * every request, by its pid and its name. Readers of such formats give the
+ * name as a 64-bit FNV-1a hash of it, so that requests can be told apart by
+ * process name (see trace_filter.h) without the readers keeping (or sharing)
+ * any table of names. Formats without processes give every request a pid and
+ * process of 0, which the hash of no name is.
+ */
+
+static const uint64_t TRACE_PROCESS_FNV_OFFSET = 14695981039346656037ULL;
+static const uint64_t TRACE_PROCESS_FNV_PRIME = 1099511628211ULL;
+
+/** Process of the name, len characters long
+ */
+static uint64_t trace_process_id(const char *name, size_t len) {
+  uint64_t hash = TRACE_PROCESS_FNV_OFFSET;
+  size_t i;
+
+  for (i = 0; i < len; i++) {
+    hash ^= (unsigned char)name[i];
+    hash *= TRACE_PROCESS_FNV_PRIME;
+  }
+  // 0 is left for requests without a process
+  return hash ? hash : 1;
+}
+
+#endif /* TRACE_READER_TRACE_PROCESS_H */
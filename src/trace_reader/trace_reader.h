@@ -6,11 +6,13 @@
 
 // List of trace readers
 #include "trace_reader/basic_trace.h"
+#include "trace_reader/bin_trace.h"
 #include "trace_reader/fiu_trace.h"
 #include "trace_reader/msr_trace.h"
 #include "trace_reader/nexus_trace.h"
 #include "trace_reader/visa_trace.h"
 #include "trace_reader/vscsi_trace.h"
+#include "trace_reader/zbin_trace.h"
 
 #define TRACE_READER_NAME_MAX_LENGTH 20
 
@@ -25,26 +27,55 @@ static bool __trace_reader_names_match(const char *name_a, const char *name_b) {
   return strncasecmp(name_a, name_b, TRACE_READER_NAME_MAX_LENGTH) == 0;
 }
 
-static struct trace_reader *find_trace_reader(const char *name) {
+/** Find the create function of the trace format called name
+ *
+ * \return The create function, or NULL if there's no such trace format
+ */
+static trace_reader_create_f find_trace_reader(const char *name) {
   if (__trace_reader_names_match(name, "basic")) {
-    return &basic_trace;
+    return basic_trace_create;
+  }
+  if (__trace_reader_names_match(name, "bin")) {
+    return bin_trace_create;
   }
   if (__trace_reader_names_match(name, "fiu")) {
-    return &fiu_trace;
+    return fiu_trace_create;
   }
   if (__trace_reader_names_match(name, "msr")) {
-    return &msr_trace;
+    return msr_trace_create;
   }
   if (__trace_reader_names_match(name, "nexus")) {
-    return &nexus_trace;
+    return nexus_trace_create;
   }
   if (__trace_reader_names_match(name, "visa")) {
-    return &visa_trace;
+    return visa_trace_create;
   }
   if (__trace_reader_names_match(name, "vscsi")) {
-    return &vscsi_trace;
+    return vscsi_trace_create;
+  }
+  if (__trace_reader_names_match(name, "zbin")) {
+    return zbin_trace_create;
   }
   return NULL;
 }
 
+/** Create a trace_reader for the trace in file, of the format called name
+ *
+ * \return The trace_reader, or NULL if there's no such trace format or unable
+ *         to allocate memory
+ */
+static struct trace_reader *create_trace_reader(const char *name, FILE *file,
+                                                unsigned duration_hrs) {
+  trace_reader_create_f create = find_trace_reader(name);
+
+  if (create == NULL) {
+    return NULL;
+  }
+  return create(file, duration_hrs);
+}
+
+static void trace_reader_exit(struct trace_reader *reader) {
+  reader->exit(reader);
+}
+
 #endif /* TRACE_READER_TRACE_READER_H */
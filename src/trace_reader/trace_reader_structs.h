@@ -3,6 +3,7 @@
 
 #include "types.h"
 #include <stdio.h>
+#include <sys/types.h>
 
 /* trace_reader and trace_reader_result are in a separate header file from
  * trace_reader.h due to circular dependencies caused by the find_trace_reader
@@ -12,10 +13,30 @@
  */
 
 /** Result of a trace_reader read call
+ *
+ * An extent of nr_blocks accesses, starting at oblock and incrementing by the
+ * trace_reader's block_stride, all of the same kind.
  */
 struct trace_reader_result {
-  oblock_t oblock; ///< The origin block device address to access
-  bool write;      ///< Is the access a write? (If not, it's a read)
+  oblock_t oblock;   ///< The first origin block device address to access
+  block_t nr_blocks; ///< Number of accesses in the extent
+  bool write;        ///< Are the accesses writes? (If not, they're reads)
+};
+
+/** A whole request from a trace
+ *
+ * Requests larger than the trace's access granularity are made up of
+ * nr_blocks accesses, starting at oblock and incrementing by the
+ * trace_reader's block_stride.
+ */
+struct trace_request {
+  oblock_t oblock;    ///< First (aligned) origin block device address
+  block_t nr_blocks;  ///< Number of accesses the request is made up of
+  bool write;         ///< Is the request a write? (If not, it's a read)
+  uint64_t ts;        ///< Timestamp of the request in nanoseconds
+  unsigned volume;    ///< Volume of the request (see trace_volume.h)
+  unsigned pid;       ///< Process making the request, or 0 if not given
+  uint64_t process;   ///< Name of the process (see trace_process.h), or 0
 };
 
 /** trace_reader features support
@@ -33,22 +54,57 @@ struct trace_reader_features {
  * A custom trace_reader is intended to be created for each unique trace format,
  * to be indicated by the user.
  *
- * trace_reader includes the FILE pointer since there's only one instance/trace
- * being read at one time, so it should be fine.
+ * Every trace being read has its own trace_reader, made by the create function
+ * of its format (see find_trace_reader()) and freed with exit(), so any number
+ * of traces can be read at once, even from different threads. Formats keep
+ * the state of a trace in a struct embedding its trace_reader, which they get
+ * back with container_of().
  *
- * With init(), this is intended to be extended to support any extra features
- * that may appear as the project continues. With duration_hrs, since hours are
- * the smallest supported unit of time for cache-sim.
+ * The create function is intended to be extended to support any extra
+ * features that may appear as the project continues. With duration_hrs, since
+ * hours are the smallest supported unit of time for cache-sim.
  * If duration_hrs is 0, it is assumed that duration is not to be used.
+ *
+ * read() returns the accesses of one request at a time as an extent, while
+ * read_request() also returns the time of the request, which is what tools
+ * that convert traces want. A trace_reader should only be read using one of
+ * the two.
+ *
+ * Formats whose lines can be decoded on their own may support set_range(),
+ * restricting the reader to a byte range of a (regular) file, so that a large
+ * trace can be decoded in parallel (see trace_parallel.h). Since the duration
+ * of such a trace is then applied to the time of its requests, the formats
+ * have to give it in exactly the same nanoseconds their own duration uses.
+ *
+ * Formats that can find a request without reading the ones before it may
+ * support seek(), jumping straight to the window of the trace that is to be
+ * read (see trace_window.h).
  */
 struct trace_reader {
   struct trace_reader_features features; ///< Features of a trace_reader
   FILE *file;                            ///< File being read
+  block_t block_stride; ///< oblock increment between accesses of a request
+  block_t oblock_size;  ///< Bytes per oblock address (0 if not in bytes)
+  uint64_t sampling_rate; ///< Rate the trace was already sampled at (or 1)
+  bool eof; ///< Did reading stop at the end of the trace (or of the range)?
 
-  int (*init)(FILE *file,
-              unsigned duration_hrs); ///< Function to init the reader
-  int (*read)(
-      struct trace_reader_result *result); ///< Function to read from the trace
+  int (*read)(struct trace_reader *reader,
+              struct trace_reader_result *result); ///< Read from the trace
+  int (*read_request)(
+      struct trace_reader *reader,
+      struct trace_request *request); ///< Read a whole request
+  void (*set_range)(struct trace_reader *reader, off_t start,
+                    off_t end); ///< Only read from start to end (or NULL)
+  int (*seek)(struct trace_reader *reader, unsigned start_hrs,
+              uint64_t skip_ios); ///< Jump to a window of the trace (or NULL)
+  void (*exit)(struct trace_reader *reader); ///< Free the reader (not file)
 };
 
+/** Create a trace_reader for the trace in file
+ *
+ * \return The trace_reader, or NULL if unable to allocate memory
+ */
+typedef struct trace_reader *(*trace_reader_create_f)(FILE *file,
+                                                      unsigned duration_hrs);
+
 #endif
@@ -0,0 +1,33 @@
+#ifndef TRACE_READER_TRACE_SAMPLING_H
+#define TRACE_READER_TRACE_SAMPLING_H
+
+#include "kernel/hash.h"
+#include "types.h"
+
+/* Spatial sampling (--sampling-rate) keeps the accesses whose oblock hashes
+ * below a threshold, so every access to a sampled oblock is kept, and 1 in
+ * every sampling rate oblocks is sampled. The sampled accesses are to the
+ * hash of their oblock, rather than to the oblock itself.
+ *
+ * The filter is applied either by cache-sim as the trace is read, or once by
+ * trace-convert, writing a (much smaller) sampled bin trace which records the
+ * sampling rate it was sampled at (see bin_trace.h).
+ */
+
+// Sampled oblocks are hashed into [0, TRACE_SAMPLING_RANGE)
+#define TRACE_SAMPLING_BITS 31
+#define TRACE_SAMPLING_RANGE (1u << TRACE_SAMPLING_BITS)
+
+/** Highest hash of a sampled oblock, for the given sampling rate
+ */
+static unsigned trace_sampling_threshold(uint64_t sampling_rate) {
+  return TRACE_SAMPLING_RANGE / sampling_rate;
+}
+
+/** Hash of oblock, which is sampled if not above the threshold
+ */
+static oblock_t trace_sampling_hash(oblock_t oblock) {
+  return hash_64(oblock, TRACE_SAMPLING_BITS);
+}
+
+#endif /* TRACE_READER_TRACE_SAMPLING_H */
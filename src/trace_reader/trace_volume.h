@@ -0,0 +1,76 @@
+#ifndef TRACE_READER_TRACE_VOLUME_H
+#define TRACE_READER_TRACE_VOLUME_H
+
+#include "common.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Some traces (such as the MSR traces) record the requests of several volumes
+ * in one file, each volume with its own address space. Readers of such
+ * formats name the volume of every request (for MSR, Hostname_DiskNumber) and
+ * give it as the number of that name in a table shared by every reader of the
+ * run, so that readers decoding parts of a trace in parallel (see
+ * trace_parallel.h) number the volumes the same way.
+ *
+ * Volumes are numbered in the order they are first seen, which with parallel
+ * decoding isn't always the order of the trace. Formats without volumes give
+ * every request volume 0, without naming it.
+ */
+
+#define TRACE_VOLUME_NAME_MAX_LENGTH 64
+
+/** trace_volume_table
+ * lock - Taken to look up (or add) a name
+ * names/nr_volumes - Name of every volume seen so far, by number
+ */
+struct trace_volume_table {
+  pthread_mutex_t lock;
+  char **names;
+  unsigned nr_volumes;
+};
+
+static struct trace_volume_table trace_volumes = {PTHREAD_MUTEX_INITIALIZER,
+                                                  NULL, 0};
+
+/** Number of the volume with the given name, numbering it if it's new
+ */
+static unsigned trace_volume_id(const char *name) {
+  char **names;
+  unsigned i;
+
+  pthread_mutex_lock(&trace_volumes.lock);
+  for (i = 0; i < trace_volumes.nr_volumes; i++) {
+    if (strcmp(trace_volumes.names[i], name) == 0) {
+      pthread_mutex_unlock(&trace_volumes.lock);
+      return i;
+    }
+  }
+
+  names = (char **)realloc(trace_volumes.names,
+                           sizeof(*names) * (trace_volumes.nr_volumes + 1));
+  if (names == NULL || (names[i] = strdup(name)) == NULL) {
+    LOG_FATAL("Unable to allocate volume table");
+  }
+  trace_volumes.names = names;
+  ++trace_volumes.nr_volumes;
+  pthread_mutex_unlock(&trace_volumes.lock);
+
+  return i;
+}
+
+/** Number of volumes named so far (0 if the trace has no volumes)
+ *
+ * NOTE: Only reliable once the trace has been read.
+ */
+static unsigned trace_volume_count(void) { return trace_volumes.nr_volumes; }
+
+/** Name of the given volume
+ *
+ * NOTE: Only reliable once the trace has been read.
+ */
+static const char *trace_volume_name(unsigned volume) {
+  return trace_volumes.names[volume];
+}
+
+#endif /* TRACE_READER_TRACE_VOLUME_H */
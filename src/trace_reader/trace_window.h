@@ -0,0 +1,227 @@
+#ifndef TRACE_READER_TRACE_WINDOW_H
+#define TRACE_READER_TRACE_WINDOW_H
+
+#include "common.h"
+#include "trace_reader/trace_reader_structs.h"
+#include <stdlib.h>
+
+/* Rather than a whole trace, only a window of it may be of interest, such as
+ * a few hours in the middle of a week-long trace. A trace_window reader reads
+ * the requests of such a window from a trace: starting at the first request at
+ * least start_hrs hours after the first request of the trace, skipping the
+ * skip_ios requests following it, and stopping after max_ios requests.
+ *
+ * Formats supporting seek() (such as bin traces with an hour index) jump
+ * straight to the start of the window. For the rest, the requests before the
+ * window are read (but nothing more) to find it.
+ *
+ * The duration feature then counts from the first request of the window, so
+ * it is applied to the (nanosecond) time of the requests by trace_window,
+ * rather than by the trace_reader of the trace.
+ */
+
+// nanosecond -> second -> minute -> hour
+static const long long TRACE_WINDOW_HOUR_LENGTH = 1000000000LL * 60 * 60;
+
+/** trace_window
+ * start_hrs - Hours from the first request of the trace to start at
+ * skip_ios - Number of requests to skip from there
+ * max_ios - Maximum number of requests to read, or 0 for no maximum
+ */
+struct trace_window {
+  unsigned start_hrs;
+  uint64_t skip_ios;
+  uint64_t max_ios;
+};
+
+/** Is anything other than the whole trace to be read?
+ */
+static bool trace_window_used(struct trace_window *window) {
+  return window->start_hrs > 0 || window->skip_ios > 0 || window->max_ios > 0;
+}
+
+/** trace_window_struct
+ * Tracks trace information
+ *
+ * trace - trace_reader of the whole trace
+ * window - Window of the trace to be read
+ * started - Has the start of the window been found?
+ * nr_read - Number of requests of the window read so far
+ * done - Has the end of the window (or of the trace) been reached?
+ */
+struct trace_window_struct {
+  struct trace_reader reader;
+  struct trace_reader *trace;
+  struct trace_window window;
+  bool started;
+  uint64_t nr_read;
+  bool done;
+
+  bool starting_time_set;
+  uint64_t ending_time;
+};
+
+static int trace_window_read(struct trace_reader *reader,
+                             struct trace_reader_result *result);
+static int trace_window_read_request(struct trace_reader *reader,
+                                     struct trace_request *request);
+static void trace_window_exit(struct trace_reader *reader);
+
+static const struct trace_reader trace_window = {
+    .features = {0},
+    .file = NULL,
+    .block_stride = 1,
+    .oblock_size = 0,
+    .sampling_rate = 1,
+    .eof = false,
+    .read = trace_window_read,
+    .read_request = trace_window_read_request,
+    .set_range = NULL,
+    .seek = NULL,
+    .exit = trace_window_exit,
+};
+
+/** Create a trace_reader reading only the given window of trace (which must
+ * have been created without a duration)
+ *
+ * NOTE: The trace_window reader takes over trace, freeing it on exit.
+ *
+ * \return The trace_reader, or NULL if unable to allocate memory
+ */
+static struct trace_reader *trace_window_create(struct trace_reader *trace,
+                                                struct trace_window *window,
+                                                unsigned duration_hrs) {
+  struct trace_window_struct *tw =
+      (struct trace_window_struct *)mem_alloc(sizeof(*tw));
+
+  if (tw == NULL) {
+    return NULL;
+  }
+
+  tw->reader = trace_window;
+  tw->reader.file = trace->file;
+  tw->reader.block_stride = trace->block_stride;
+  tw->reader.oblock_size = trace->oblock_size;
+  tw->reader.sampling_rate = trace->sampling_rate;
+
+  if (duration_hrs > 0) {
+    tw->reader.features.use_duration = true;
+    tw->reader.features.duration_hrs = duration_hrs;
+  } else {
+    tw->reader.features.use_duration = false;
+  }
+
+  tw->trace = trace;
+  tw->window = *window;
+  tw->started = false;
+  tw->nr_read = 0;
+  tw->done = false;
+  tw->starting_time_set = false;
+
+  return &tw->reader;
+}
+
+/** Find the start of the window, reading its first request
+ *
+ * \return 0 if found, or 1 if the trace ended before it
+ */
+static int __trace_window_start(struct trace_window_struct *tw,
+                                struct trace_request *request) {
+  struct trace_reader *trace = tw->trace;
+  uint64_t skip_ios = tw->window.skip_ios;
+  uint64_t start_time;
+
+  if (trace->seek != NULL &&
+      !trace->seek(trace, tw->window.start_hrs, skip_ios)) {
+    return trace->read_request(trace, request);
+  }
+
+  if (trace->read_request(trace, request)) {
+    return 1;
+  }
+
+  start_time =
+      request->ts + (TRACE_WINDOW_HOUR_LENGTH * tw->window.start_hrs);
+  while (request->ts < start_time) {
+    if (trace->read_request(trace, request)) {
+      return 1;
+    }
+  }
+
+  for (; skip_ios > 0; --skip_ios) {
+    if (trace->read_request(trace, request)) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+static int trace_window_read_request(struct trace_reader *reader,
+                                     struct trace_request *request) {
+  struct trace_window_struct *tw =
+      container_of(reader, struct trace_window_struct, reader);
+  int r;
+
+  if (tw->done) {
+    return 1;
+  }
+
+  if (!tw->started) {
+    tw->started = true;
+    r = __trace_window_start(tw, request);
+  } else if (tw->window.max_ios > 0 && tw->nr_read == tw->window.max_ios) {
+    LOG_DEBUG("end of window reached");
+    tw->done = true;
+    return 1;
+  } else {
+    r = tw->trace->read_request(tw->trace, request);
+  }
+
+  if (r) {
+    reader->eof = tw->trace->eof;
+    tw->done = true;
+    return 1;
+  }
+
+  if (reader->features.use_duration) {
+    if (!tw->starting_time_set) {
+      tw->ending_time = request->ts + (TRACE_WINDOW_HOUR_LENGTH *
+                                       reader->features.duration_hrs);
+      tw->starting_time_set = true;
+    }
+    if (request->ts > tw->ending_time) {
+      LOG_DEBUG("end of duration reached");
+      tw->done = true;
+      return 1;
+    }
+  }
+
+  ++tw->nr_read;
+  return 0;
+}
+
+static int trace_window_read(struct trace_reader *reader,
+                             struct trace_reader_result *result) {
+  struct trace_request request;
+
+  if (trace_window_read_request(reader, &request)) {
+    return 1;
+  }
+
+  result->oblock = request.oblock;
+  result->nr_blocks = request.nr_blocks;
+  result->write = request.write;
+
+  return 0;
+}
+
+static void trace_window_exit(struct trace_reader *reader) {
+  struct trace_window_struct *tw =
+      container_of(reader, struct trace_window_struct, reader);
+
+  tw->trace->exit(tw->trace);
+  mem_free(tw);
+}
+
+#endif /* TRACE_READER_TRACE_WINDOW_H */
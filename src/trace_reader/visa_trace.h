@@ -1,10 +1,14 @@
 #ifndef TRACE_READER_VISA_TRACE_H
 #define TRACE_READER_VISA_TRACE_H
 
+#include "common.h"
+#include "trace_reader/trace_buffer.h"
+#include "trace_reader/trace_process.h"
 #include "trace_reader/trace_reader_structs.h"
 #include "types.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 /* The VISA traces are another set of traces collected in FIU and in the vps
  * cloud They use logical block address (lba) and size (based on blocks of size
@@ -35,96 +39,152 @@ static const long long VISA_HOUR_LENGTH = 60 * 60;
  * Tracks trace information
  */
 struct visa_struct {
-  oblock_t addr;
-  bool write;
-  block_t pages_left;
+  struct trace_reader reader;
   bool starting_time_set;
   uint64_t starting_time;
   uint64_t ending_time;
+  struct trace_buffer tb;
 };
 
-struct visa_struct visa_info = {
-    .addr = 0,
-    .write = false,
-    .pages_left = 0,
-};
-
-static int visa_trace_init(FILE *file, unsigned duration_hrs);
-static int visa_trace_read(struct trace_reader_result *result);
+static int visa_trace_read(struct trace_reader *reader,
+                           struct trace_reader_result *result);
+static int visa_trace_read_request(struct trace_reader *reader,
+                                   struct trace_request *request);
+static void visa_trace_exit(struct trace_reader *reader);
 
-struct trace_reader visa_trace = {
+static const struct trace_reader visa_trace = {
     .features = {0},
     .file = NULL,
-    .init = visa_trace_init,
+    .block_stride = VISA_BLOCKS_PER_PAGE,
+    .oblock_size = VISA_BLOCK_SIZE,
+    .sampling_rate = 1,
+    .eof = false,
     .read = visa_trace_read,
+    .read_request = visa_trace_read_request,
+    .set_range = NULL,
+    .seek = NULL,
+    .exit = visa_trace_exit,
 };
 
-static int visa_trace_init(FILE *file, unsigned duration_hrs) {
-  visa_trace.file = file;
+/** Create a trace_reader for the trace in file
+ *
+ * \return The trace_reader, or NULL if unable to allocate memory
+ */
+static struct trace_reader *visa_trace_create(FILE *file,
+                                              unsigned duration_hrs) {
+  struct visa_struct *visa_info =
+      (struct visa_struct *)mem_alloc(sizeof(*visa_info));
+
+  if (visa_info == NULL) {
+    return NULL;
+  }
+
+  visa_info->reader = visa_trace;
+  visa_info->reader.file = file;
 
   if (duration_hrs > 0) {
-    visa_trace.features.use_duration = true;
-    visa_trace.features.duration_hrs = duration_hrs;
+    visa_info->reader.features.use_duration = true;
+    visa_info->reader.features.duration_hrs = duration_hrs;
   } else {
-    visa_trace.features.use_duration = false;
+    visa_info->reader.features.use_duration = false;
   }
 
-  visa_info.starting_time_set = false;
-  return 0;
+  visa_info->starting_time_set = false;
+
+  if (trace_buffer_init(&visa_info->tb, file)) {
+    mem_free(visa_info);
+    return NULL;
+  }
+  return &visa_info->reader;
 }
 
-static int visa_trace_read(struct trace_reader_result *result) {
-  FILE *file = visa_trace.file;
+static void visa_trace_exit(struct trace_reader *reader) {
+  struct visa_struct *visa_info =
+      container_of(reader, struct visa_struct, reader);
 
-  if (visa_info.pages_left > 0) {
-    visa_info.addr += VISA_BLOCKS_PER_PAGE;
-    --visa_info.pages_left;
-  } else {
-    block_t size = 0;
-    block_t align;
-    char io[20];
-    float ts;
-
-    while (size == 0) {
-      if (fscanf(file, "%f %*d %*d %*s %lu %lu %s %*d %*d\n", &ts,
-                 &visa_info.addr, &size, io) != 4) {
-        if (feof(file)) {
-          LOG_DEBUG("end of file reached");
-        } else {
-          LOG_DEBUG("couldn't read file properly. error %d", ferror(file));
-        }
-        return 1;
+  trace_buffer_exit(&visa_info->tb);
+  mem_free(visa_info);
+}
+
+static int visa_trace_read_request(struct trace_reader *reader,
+                                   struct trace_request *request) {
+  struct visa_struct *visa_info =
+      container_of(reader, struct visa_struct, reader);
+  char *line;
+  block_t size = 0;
+  block_t align;
+  oblock_t addr;
+  char *io;
+  char *process;
+  unsigned pid;
+  float ts;
+
+  while (size == 0) {
+    if (trace_buffer_next_line(&visa_info->tb, &line)) {
+      if (visa_info->tb.error) {
+        LOG_DEBUG("couldn't read file properly. error %d", visa_info->tb.error);
+      } else {
+        LOG_DEBUG("end of file reached");
+        reader->eof = true;
       }
+      return 1;
     }
 
-    // align block address
-    // remainder blocks from realignment added to size
-    align = visa_info.addr % VISA_BLOCKS_PER_PAGE;
-    visa_info.addr -= align;
-    size += align;
-
-    visa_info.write = io[0] == 'W';
-    visa_info.pages_left = (size / VISA_BLOCKS_PER_PAGE) - 1;
-    if (size % VISA_BLOCKS_PER_PAGE != 0) {
-      ++visa_info.pages_left;
+    // [ts] [pid] [cpu] [process] [lba] [size] [Write or Read] ...
+    if (trace_parse_float(&line, &ts) || trace_parse_u32(&line, &pid) ||
+        trace_parse_skip(&line) || trace_parse_token(&line, &process) ||
+        trace_parse_u64(&line, &addr) || trace_parse_u64(&line, &size) ||
+        trace_parse_token(&line, &io)) {
+      LOG_DEBUG("couldn't parse line");
+      return 1;
     }
+  }
 
-    if (visa_trace.features.use_duration) {
-      if (!visa_info.starting_time_set) {
-        visa_info.starting_time = ts;
-        visa_info.ending_time =
-            ts + (VISA_HOUR_LENGTH * visa_trace.features.duration_hrs);
-        visa_info.starting_time_set = true;
-      }
-      if (ts > visa_info.ending_time) {
-        LOG_DEBUG("end of duration reached");
-        return 1;
-      }
+  // align block address
+  // remainder blocks from realignment added to size
+  align = addr % VISA_BLOCKS_PER_PAGE;
+  addr -= align;
+  size += align;
+
+  request->oblock = addr;
+  request->write = io[0] == 'W';
+  request->nr_blocks = size / VISA_BLOCKS_PER_PAGE;
+  if (size % VISA_BLOCKS_PER_PAGE != 0) {
+    ++request->nr_blocks;
+  }
+  // seconds -> nanoseconds
+  request->ts = ts * 1000000000.0;
+  request->volume = 0;
+  request->pid = pid;
+  request->process = trace_process_id(process, strcspn(process, " \t\r"));
+
+  if (reader->features.use_duration) {
+    if (!visa_info->starting_time_set) {
+      visa_info->starting_time = ts;
+      visa_info->ending_time =
+          ts + (VISA_HOUR_LENGTH * reader->features.duration_hrs);
+      visa_info->starting_time_set = true;
+    }
+    if (ts > visa_info->ending_time) {
+      LOG_DEBUG("end of duration reached");
+      return 1;
     }
   }
 
-  result->oblock = visa_info.addr;
-  result->write = visa_info.write;
+  return 0;
+}
+
+static int visa_trace_read(struct trace_reader *reader,
+                           struct trace_reader_result *result) {
+  struct trace_request request;
+
+  if (visa_trace_read_request(reader, &request)) {
+    return 1;
+  }
+
+  result->oblock = request.oblock;
+  result->nr_blocks = request.nr_blocks;
+  result->write = request.write;
 
   return 0;
 }
@@ -1,6 +1,8 @@
 #ifndef TRACE_READER_VSCSI_TRACE_H
 #define TRACE_READER_VSCSI_TRACE_H
 
+#include "common.h"
+#include "trace_reader/trace_buffer.h"
 #include "trace_reader/trace_reader_structs.h"
 #include "types.h"
 #include <stdio.h>
@@ -34,91 +36,142 @@ static const long long VSCSI_HOUR_LENGTH = 60 * 60;
  * Tracks trace information
  */
 struct vscsi_struct {
-  oblock_t addr;
-  bool write;
-  block_t pages_left;
+  struct trace_reader reader;
   bool starting_time_set;
   double starting_time;
   double ending_time;
+  struct trace_buffer tb;
 };
 
-struct vscsi_struct vscsi_info = {
-    .addr = 0,
-    .write = false,
-    .pages_left = 0,
-};
-
-static int vscsi_trace_init(FILE *file, unsigned duration_hrs);
-static int vscsi_trace_read(struct trace_reader_result *result);
+static int vscsi_trace_read(struct trace_reader *reader,
+                            struct trace_reader_result *result);
+static int vscsi_trace_read_request(struct trace_reader *reader,
+                                    struct trace_request *request);
+static void vscsi_trace_exit(struct trace_reader *reader);
 
-struct trace_reader vscsi_trace = {
+static const struct trace_reader vscsi_trace = {
     .features = {0},
     .file = NULL,
-    .init = vscsi_trace_init,
+    .block_stride = 1,
+    .oblock_size = VSCSI_BLOCK_SIZE,
+    .sampling_rate = 1,
+    .eof = false,
     .read = vscsi_trace_read,
+    .read_request = vscsi_trace_read_request,
+    .set_range = NULL,
+    .seek = NULL,
+    .exit = vscsi_trace_exit,
 };
 
-static int vscsi_trace_init(FILE *file, unsigned duration_hrs) {
-  vscsi_trace.file = file;
+/** Create a trace_reader for the trace in file
+ *
+ * \return The trace_reader, or NULL if unable to allocate memory
+ */
+static struct trace_reader *vscsi_trace_create(FILE *file,
+                                               unsigned duration_hrs) {
+  struct vscsi_struct *vscsi_info =
+      (struct vscsi_struct *)mem_alloc(sizeof(*vscsi_info));
+
+  if (vscsi_info == NULL) {
+    return NULL;
+  }
+
+  vscsi_info->reader = vscsi_trace;
+  vscsi_info->reader.file = file;
 
   if (duration_hrs > 0) {
-    vscsi_trace.features.use_duration = true;
-    vscsi_trace.features.duration_hrs = duration_hrs;
+    vscsi_info->reader.features.use_duration = true;
+    vscsi_info->reader.features.duration_hrs = duration_hrs;
   } else {
-    vscsi_trace.features.use_duration = false;
+    vscsi_info->reader.features.use_duration = false;
   }
 
-  vscsi_info.starting_time_set = false;
-  return 0;
+  vscsi_info->starting_time_set = false;
+
+  if (trace_buffer_init(&vscsi_info->tb, file)) {
+    mem_free(vscsi_info);
+    return NULL;
+  }
+  return &vscsi_info->reader;
 }
 
-static int vscsi_trace_read(struct trace_reader_result *result) {
-  FILE *file = vscsi_trace.file;
+static void vscsi_trace_exit(struct trace_reader *reader) {
+  struct vscsi_struct *vscsi_info =
+      container_of(reader, struct vscsi_struct, reader);
 
-  if (vscsi_info.pages_left > 0) {
-    vscsi_info.addr++;
-    --vscsi_info.pages_left;
-  } else {
-    block_t size = 0;
-    block_t align;
-    char io[20];
-    double ts;
-
-    while (size == 0) {
-      if (fscanf(file, "%s %lf %lu %lu\n", io, &ts, &vscsi_info.addr, &size) !=
-          4) {
-        if (feof(file)) {
-          LOG_DEBUG("end of file reached");
-        } else {
-          LOG_DEBUG("couldn't read file properly. error %d", ferror(file));
-        }
-        return 1;
+  trace_buffer_exit(&vscsi_info->tb);
+  mem_free(vscsi_info);
+}
+
+static int vscsi_trace_read_request(struct trace_reader *reader,
+                                    struct trace_request *request) {
+  struct vscsi_struct *vscsi_info =
+      container_of(reader, struct vscsi_struct, reader);
+  char *line;
+  block_t size = 0;
+  oblock_t addr;
+  char *io;
+  double ts;
+
+  while (size == 0) {
+    if (trace_buffer_next_line(&vscsi_info->tb, &line)) {
+      if (vscsi_info->tb.error) {
+        LOG_DEBUG("couldn't read file properly. error %d",
+                  vscsi_info->tb.error);
+      } else {
+        LOG_DEBUG("end of file reached");
+        reader->eof = true;
       }
+      return 1;
     }
 
-    vscsi_info.write = io[0] == 'W';
-    vscsi_info.pages_left = size / VSCSI_BLOCK_SIZE;
-    if (size % (VSCSI_BLOCK_SIZE) != 0) {
-      ++vscsi_info.pages_left;
+    // [Write or Read] [ts] [lba] [size]
+    if (trace_parse_token(&line, &io) || trace_parse_double(&line, &ts) ||
+        trace_parse_u64(&line, &addr) || trace_parse_u64(&line, &size)) {
+      LOG_DEBUG("couldn't parse line");
+      return 1;
     }
-    --vscsi_info.pages_left;
-
-    if (vscsi_trace.features.use_duration) {
-      if (!vscsi_info.starting_time_set) {
-        vscsi_info.starting_time = ts;
-        vscsi_info.ending_time =
-            ts + (VSCSI_HOUR_LENGTH * vscsi_trace.features.duration_hrs);
-        vscsi_info.starting_time_set = true;
-      }
-      if (ts > vscsi_info.ending_time) {
-        LOG_DEBUG("end of duration reached");
-        return 1;
-      }
+  }
+
+  request->oblock = addr;
+  request->write = io[0] == 'W';
+  request->nr_blocks = size / VSCSI_BLOCK_SIZE;
+  if (size % (VSCSI_BLOCK_SIZE) != 0) {
+    ++request->nr_blocks;
+  }
+  // seconds -> nanoseconds
+  request->ts = ts * 1000000000.0;
+  request->volume = 0;
+  request->pid = 0;
+  request->process = 0;
+
+  if (reader->features.use_duration) {
+    if (!vscsi_info->starting_time_set) {
+      vscsi_info->starting_time = ts;
+      vscsi_info->ending_time =
+          ts + (VSCSI_HOUR_LENGTH * reader->features.duration_hrs);
+      vscsi_info->starting_time_set = true;
+    }
+    if (ts > vscsi_info->ending_time) {
+      LOG_DEBUG("end of duration reached");
+      return 1;
     }
   }
 
-  result->oblock = vscsi_info.addr;
-  result->write = vscsi_info.write;
+  return 0;
+}
+
+static int vscsi_trace_read(struct trace_reader *reader,
+                            struct trace_reader_result *result) {
+  struct trace_request request;
+
+  if (vscsi_trace_read_request(reader, &request)) {
+    return 1;
+  }
+
+  result->oblock = request.oblock;
+  result->nr_blocks = request.nr_blocks;
+  result->write = request.write;
 
   return 0;
 }
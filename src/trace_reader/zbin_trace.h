@@ -0,0 +1,680 @@
+#ifndef TRACE_READER_ZBIN_TRACE_H
+#define TRACE_READER_ZBIN_TRACE_H
+
+#include "common.h"
+#include "trace_reader/trace_reader_structs.h"
+#include "types.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The zbin traces are compressed bin traces (see bin_trace.h), for keeping
+ * whole libraries of large traces in the page cache. Consecutive requests of
+ * a trace are strongly correlated (sequential runs, nearby addresses, close
+ * timestamps), so rather than their values, a zbin trace records how every
+ * request differs from the one before it, in variable length integers:
+ *
+ * - oblock: zigzag varint of its distance from where the request before it
+ *           ended (oblock + nr_blocks * block_stride), so sequential requests
+ *           take a single byte
+ * - ts: zigzag varint of its distance from the time of the request before it
+ * - nr_blocks: varint
+ * - write: run length encoded, as varints of the lengths of the runs of reads
+ *          and writes, taking turns (starting with reads)
+ *
+ * Varints hold 7 bits per byte, least significant first, with the top bit set
+ * on every byte but the last. Zigzag maps signed values to unsigned ones of
+ * about the same magnitude (0, -1, 1, -2, ... to 0, 1, 2, 3, ...).
+ *
+ * Format (native byte order):
+ * [zbin_trace_header] [zbin_trace_block] [streams]...
+ *
+ * Requests are encoded in blocks of at most ZBIN_TRACE_BLOCK_SIZE bytes, each
+ * starting from a request of 0 (at oblock 0, time 0), so every block can be
+ * decoded on its own. Every field of the requests of a block is encoded as a
+ * stream of its own, one after the other, so every stream is decoded with a
+ * short loop over a single kind of value.
+ *
+ * A zbin_trace reader decodes the blocks ahead of the one being read on a
+ * helper thread, into up to ZBIN_TRACE_NR_SLOTS blocks of decoded requests.
+ */
+
+#define ZBIN_TRACE_MAGIC "FOMOZBN"
+#define ZBIN_TRACE_VERSION 1
+#define ZBIN_TRACE_BLOCK_SIZE (64 << 10)
+// Largest encoding of a request: its oblock, ts and nr_blocks, the run of
+// reads or writes it ends, and the last run of the block
+#define ZBIN_TRACE_MAX_REQUEST_SIZE (10 + 10 + 5 + 5 + 5)
+#define ZBIN_TRACE_NR_SLOTS 4
+// nanosecond -> second -> minute -> hour
+static const long long ZBIN_HOUR_LENGTH = 1000000000LL * 60 * 60;
+
+/** zbin_trace_header
+ * magic - ZBIN_TRACE_MAGIC, including the terminating null character
+ * version - ZBIN_TRACE_VERSION of the writer
+ * block_size - ZBIN_TRACE_BLOCK_SIZE of the writer
+ * block_stride/nr_records/sampling_rate/oblock_size - As in bin_trace_header
+ */
+struct zbin_trace_header {
+  char magic[8];
+  uint32_t version;
+  uint32_t block_size;
+  uint64_t block_stride;
+  uint64_t nr_records;
+  uint64_t sampling_rate;
+  uint64_t oblock_size;
+  uint64_t reserved[2];
+};
+
+/** zbin_trace_block
+ * Header of a block, followed by its streams
+ *
+ * size - Bytes of streams following the header
+ * nr_records - Number of requests in the block
+ * ts/nr_blocks/write - Offsets of the ts, nr_blocks and write streams in the
+ *                      streams (the oblock stream being first)
+ */
+struct zbin_trace_block {
+  uint32_t size;
+  uint32_t nr_records;
+  uint32_t ts;
+  uint32_t nr_blocks;
+  uint32_t write;
+  uint32_t reserved;
+};
+
+static void zbin_trace_header_init(struct zbin_trace_header *header,
+                                   block_t block_stride) {
+  memset(header, 0, sizeof(*header));
+  memcpy(header->magic, ZBIN_TRACE_MAGIC, sizeof(header->magic));
+  header->version = ZBIN_TRACE_VERSION;
+  header->block_size = ZBIN_TRACE_BLOCK_SIZE;
+  header->block_stride = block_stride;
+}
+
+static bool zbin_trace_header_valid(struct zbin_trace_header *header) {
+  return memcmp(header->magic, ZBIN_TRACE_MAGIC, sizeof(header->magic)) ==
+             0 &&
+         header->version == ZBIN_TRACE_VERSION &&
+         header->block_size <= ZBIN_TRACE_BLOCK_SIZE &&
+         header->block_stride > 0;
+}
+
+static uint64_t zbin_zigzag(int64_t value) {
+  return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t zbin_unzigzag(uint64_t value) {
+  return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+/** Append value to buf as a varint
+ *
+ * \return Number of bytes appended
+ */
+static unsigned zbin_varint_put(uint8_t *buf, uint64_t value) {
+  unsigned len = 0;
+
+  while (value >= 0x80) {
+    buf[len++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  buf[len++] = (uint8_t)value;
+  return len;
+}
+
+/** Read a varint from *buf, up to end, moving *buf past it
+ *
+ * \return 0 if read, or not 0 if it runs past end
+ */
+static int zbin_varint_get(const uint8_t **buf, const uint8_t *end,
+                           uint64_t *value) {
+  const uint8_t *b = *buf;
+  uint64_t v;
+  unsigned shift;
+
+  // most varints of a trace are a single byte
+  if (b < end && *b < 0x80) {
+    *value = *b;
+    *buf = b + 1;
+    return 0;
+  }
+
+  v = 0;
+  for (shift = 0; b < end && shift < 64; shift += 7) {
+    v |= (uint64_t)(*b & 0x7f) << shift;
+    if (*b++ < 0x80) {
+      *value = v;
+      *buf = b;
+      return 0;
+    }
+  }
+  return 1;
+}
+
+enum zbin_trace_stream {
+  ZBIN_OBLOCK,
+  ZBIN_TS,
+  ZBIN_NR_BLOCKS,
+  ZBIN_WRITE,
+  ZBIN_NR_STREAMS,
+};
+
+/** zbin_trace_encoder
+ * Requests of the block being encoded
+ *
+ * streams/len - Every stream of the block (see zbin_trace_stream), each with
+ *               space for a whole block, and their lengths
+ * nr_records - Number of requests in the block
+ * next/prev_ts - Predicted oblock and time of the next request
+ * write/run - Kind and length of the current run of reads or writes
+ */
+struct zbin_trace_encoder {
+  uint8_t *streams[ZBIN_NR_STREAMS];
+  uint32_t len[ZBIN_NR_STREAMS];
+  uint32_t nr_records;
+  oblock_t next;
+  uint64_t prev_ts;
+  bool write;
+  uint32_t run;
+};
+
+static void __zbin_trace_encoder_reset(struct zbin_trace_encoder *enc) {
+  memset(enc->len, 0, sizeof(enc->len));
+  enc->nr_records = 0;
+  enc->next = 0;
+  enc->prev_ts = 0;
+  enc->write = false;
+  enc->run = 0;
+}
+
+/** \return 0 if no errors occur, or -ENOSPC if unable to allocate memory
+ */
+static int zbin_trace_encoder_init(struct zbin_trace_encoder *enc) {
+  unsigned s;
+
+  for (s = 0; s < ZBIN_NR_STREAMS; s++) {
+    enc->streams[s] = (uint8_t *)mem_alloc(ZBIN_TRACE_BLOCK_SIZE);
+    if (enc->streams[s] == NULL) {
+      while (s-- > 0) {
+        mem_free(enc->streams[s]);
+      }
+      return -ENOSPC;
+    }
+  }
+  __zbin_trace_encoder_reset(enc);
+  return 0;
+}
+
+static void zbin_trace_encoder_exit(struct zbin_trace_encoder *enc) {
+  unsigned s;
+
+  for (s = 0; s < ZBIN_NR_STREAMS; s++) {
+    mem_free(enc->streams[s]);
+  }
+}
+
+static uint32_t __zbin_trace_encoder_size(struct zbin_trace_encoder *enc) {
+  return enc->len[ZBIN_OBLOCK] + enc->len[ZBIN_TS] + enc->len[ZBIN_NR_BLOCKS] +
+         enc->len[ZBIN_WRITE];
+}
+
+/** Write the block being encoded (if it has any requests) to out, and start a
+ * new one
+ */
+static void zbin_trace_encoder_flush(struct zbin_trace_encoder *enc,
+                                     FILE *out) {
+  struct zbin_trace_block block;
+  unsigned s;
+
+  if (enc->nr_records == 0) {
+    return;
+  }
+  enc->len[ZBIN_WRITE] += zbin_varint_put(
+      enc->streams[ZBIN_WRITE] + enc->len[ZBIN_WRITE], enc->run);
+
+  block.size = __zbin_trace_encoder_size(enc);
+  block.nr_records = enc->nr_records;
+  block.ts = enc->len[ZBIN_OBLOCK];
+  block.nr_blocks = block.ts + enc->len[ZBIN_TS];
+  block.write = block.nr_blocks + enc->len[ZBIN_NR_BLOCKS];
+  block.reserved = 0;
+
+  if (fwrite(&block, sizeof(block), 1, out) != 1) {
+    LOG_FATAL("couldn't write zbin trace block. error %d", ferror(out));
+  }
+  for (s = 0; s < ZBIN_NR_STREAMS; s++) {
+    if (fwrite(enc->streams[s], 1, enc->len[s], out) != enc->len[s]) {
+      LOG_FATAL("couldn't write zbin trace block. error %d", ferror(out));
+    }
+  }
+
+  __zbin_trace_encoder_reset(enc);
+}
+
+/** Encode a request, writing the block being encoded to out first if it
+ * couldn't hold it
+ */
+static void zbin_trace_encoder_add(struct zbin_trace_encoder *enc, FILE *out,
+                                   block_t block_stride, oblock_t oblock,
+                                   block_t nr_blocks, uint64_t ts, bool write) {
+  if (sizeof(struct zbin_trace_block) + __zbin_trace_encoder_size(enc) +
+          ZBIN_TRACE_MAX_REQUEST_SIZE >
+      ZBIN_TRACE_BLOCK_SIZE) {
+    zbin_trace_encoder_flush(enc, out);
+  }
+
+  enc->len[ZBIN_OBLOCK] +=
+      zbin_varint_put(enc->streams[ZBIN_OBLOCK] + enc->len[ZBIN_OBLOCK],
+                      zbin_zigzag((int64_t)(oblock - enc->next)));
+  enc->len[ZBIN_TS] +=
+      zbin_varint_put(enc->streams[ZBIN_TS] + enc->len[ZBIN_TS],
+                      zbin_zigzag((int64_t)(ts - enc->prev_ts)));
+  enc->len[ZBIN_NR_BLOCKS] += zbin_varint_put(
+      enc->streams[ZBIN_NR_BLOCKS] + enc->len[ZBIN_NR_BLOCKS], nr_blocks);
+
+  if (write != enc->write) {
+    enc->len[ZBIN_WRITE] += zbin_varint_put(
+        enc->streams[ZBIN_WRITE] + enc->len[ZBIN_WRITE], enc->run);
+    enc->write = write;
+    enc->run = 0;
+  }
+  ++enc->run;
+
+  enc->next = oblock + (oblock_t)nr_blocks * block_stride;
+  enc->prev_ts = ts;
+  ++enc->nr_records;
+}
+
+/** zbin_trace_slot
+ * A decoded block
+ *
+ * requests/len/capacity - Decoded requests, their count and how many requests
+ *                         there is space for
+ * decoded - Has the block been decoded (and not yet read)?
+ * last - Is this the end of the trace (with no requests)?
+ */
+struct zbin_trace_slot {
+  struct trace_request *requests;
+  uint32_t len;
+  uint32_t capacity;
+  bool decoded;
+  bool last;
+};
+
+/** zbin_struct
+ * Tracks trace information
+ *
+ * thread - Helper thread reading and decoding the blocks
+ * buf - Block being decoded (by the helper thread)
+ * slots - Ring of decoded blocks, where block number b is decoded into
+ *         slots[b % ZBIN_TRACE_NR_SLOTS]
+ * lock/cond - Protect (and signal changes to) next_block, block, stop and the
+ *             decoded flags of slots
+ * next_block - Number of the next block to be decoded
+ * block/pos - Number of the block being read and position of the next request
+ *             in it
+ * held/len - Has the reader seen the slot of the block being read decoded
+ *            (so the slot is its own until handed back), and the number of
+ *            requests in it, as read under lock
+ * nr_records/read - Number of requests in the trace (0 if unknown), and read
+ *                   so far
+ */
+struct zbin_struct {
+  struct trace_reader reader;
+  bool starting_time_set;
+  uint64_t ending_time;
+
+  pthread_t thread;
+  uint8_t *buf;
+  struct zbin_trace_slot slots[ZBIN_TRACE_NR_SLOTS];
+
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  uint64_t next_block;
+  bool stop;
+
+  uint64_t block;
+  uint32_t pos;
+  bool held;
+  uint32_t len;
+  uint64_t nr_records;
+  uint64_t read;
+};
+
+static int zbin_trace_read(struct trace_reader *reader,
+                           struct trace_reader_result *result);
+static int zbin_trace_read_request(struct trace_reader *reader,
+                                   struct trace_request *request);
+static void zbin_trace_exit(struct trace_reader *reader);
+
+static const struct trace_reader zbin_trace = {
+    .features = {0},
+    .file = NULL,
+    .block_stride = 1,
+    .oblock_size = 0,
+    .sampling_rate = 1,
+    .eof = false,
+    .read = zbin_trace_read,
+    .read_request = zbin_trace_read_request,
+    .set_range = NULL,
+    .seek = NULL,
+    .exit = zbin_trace_exit,
+};
+
+/** Decode the streams of a block into the requests of slot
+ *
+ * \return 0 if decoded, or not 0 if the block is corrupt
+ */
+static int __zbin_trace_decode(struct zbin_struct *zbin_info,
+                               struct zbin_trace_block *block,
+                               struct zbin_trace_slot *slot) {
+  const uint8_t *buf = zbin_info->buf;
+  const uint8_t *p;
+  const uint8_t *end;
+  struct trace_request *r;
+  block_t stride = zbin_info->reader.block_stride;
+  oblock_t next = 0;
+  uint64_t ts = 0;
+  uint64_t v;
+  uint32_t i;
+  bool write = false;
+
+  if (block->ts > block->nr_blocks || block->nr_blocks > block->write ||
+      block->write > block->size) {
+    return 1;
+  }
+
+  if (block->nr_records > slot->capacity) {
+    r = (struct trace_request *)realloc(slot->requests,
+                                        sizeof(*r) * block->nr_records);
+    if (r == NULL) {
+      LOG_FATAL("unable to allocate decoded zbin trace block");
+    }
+    slot->requests = r;
+    slot->capacity = block->nr_records;
+  }
+  r = slot->requests;
+  slot->len = block->nr_records;
+
+  // one stream at a time, so each loop only decodes a single kind of value
+  p = buf + block->nr_blocks;
+  end = buf + block->write;
+  for (i = 0; i < block->nr_records; i++) {
+    if (zbin_varint_get(&p, end, &v)) {
+      return 1;
+    }
+    r[i].nr_blocks = v;
+    r[i].volume = 0;
+    r[i].pid = 0;
+    r[i].process = 0;
+  }
+
+  p = buf;
+  end = buf + block->ts;
+  for (i = 0; i < block->nr_records; i++) {
+    if (zbin_varint_get(&p, end, &v)) {
+      return 1;
+    }
+    r[i].oblock = next + zbin_unzigzag(v);
+    next = r[i].oblock + (oblock_t)r[i].nr_blocks * stride;
+  }
+
+  p = buf + block->ts;
+  end = buf + block->nr_blocks;
+  for (i = 0; i < block->nr_records; i++) {
+    if (zbin_varint_get(&p, end, &v)) {
+      return 1;
+    }
+    ts += zbin_unzigzag(v);
+    r[i].ts = ts;
+  }
+
+  p = buf + block->write;
+  end = buf + block->size;
+  for (i = 0; i < block->nr_records;) {
+    if (zbin_varint_get(&p, end, &v) || v > block->nr_records - i) {
+      return 1;
+    }
+    for (; v > 0; v--) {
+      r[i++].write = write;
+    }
+    write = !write;
+  }
+
+  return 0;
+}
+
+/** Read and decode the next block into slot
+ */
+static void __zbin_trace_read_block(struct zbin_struct *zbin_info,
+                                    struct zbin_trace_slot *slot) {
+  FILE *file = zbin_info->reader.file;
+  struct zbin_trace_block block;
+
+  slot->len = 0;
+  slot->last = true;
+
+  if (fread(&block, sizeof(block), 1, file) != 1) {
+    if (!feof(file)) {
+      LOG_DEBUG("couldn't read file properly. error %d", ferror(file));
+    }
+    return;
+  }
+  if (block.size > ZBIN_TRACE_BLOCK_SIZE - sizeof(block) ||
+      fread(zbin_info->buf, 1, block.size, file) != block.size ||
+      __zbin_trace_decode(zbin_info, &block, slot)) {
+    LOG_FATAL("corrupt zbin trace block");
+  }
+  slot->last = false;
+}
+
+static void *__zbin_trace_work(void *arg) {
+  struct zbin_struct *zbin_info = (struct zbin_struct *)arg;
+  struct zbin_trace_slot *slot;
+
+  for (;;) {
+    // wait for the slot of the next block to be read
+    pthread_mutex_lock(&zbin_info->lock);
+    while (!zbin_info->stop &&
+           zbin_info->next_block - zbin_info->block >= ZBIN_TRACE_NR_SLOTS) {
+      pthread_cond_wait(&zbin_info->cond, &zbin_info->lock);
+    }
+    if (zbin_info->stop) {
+      pthread_mutex_unlock(&zbin_info->lock);
+      return NULL;
+    }
+    slot = &zbin_info->slots[zbin_info->next_block % ZBIN_TRACE_NR_SLOTS];
+    pthread_mutex_unlock(&zbin_info->lock);
+
+    __zbin_trace_read_block(zbin_info, slot);
+
+    pthread_mutex_lock(&zbin_info->lock);
+    slot->decoded = true;
+    ++zbin_info->next_block;
+    pthread_cond_broadcast(&zbin_info->cond);
+    pthread_mutex_unlock(&zbin_info->lock);
+
+    if (slot->last) {
+      return NULL;
+    }
+  }
+}
+
+/** Create a trace_reader for the trace in file
+ *
+ * \return The trace_reader, or NULL if unable to allocate memory
+ */
+static struct trace_reader *zbin_trace_create(FILE *file,
+                                              unsigned duration_hrs) {
+  struct zbin_trace_header header;
+  struct zbin_struct *zbin_info =
+      (struct zbin_struct *)mem_alloc(sizeof(*zbin_info));
+  unsigned i;
+
+  if (zbin_info == NULL) {
+    return NULL;
+  }
+  zbin_info->buf = (uint8_t *)mem_alloc(ZBIN_TRACE_BLOCK_SIZE);
+  if (zbin_info->buf == NULL) {
+    mem_free(zbin_info);
+    return NULL;
+  }
+
+  zbin_info->reader = zbin_trace;
+  zbin_info->reader.file = file;
+
+  if (duration_hrs > 0) {
+    zbin_info->reader.features.use_duration = true;
+    zbin_info->reader.features.duration_hrs = duration_hrs;
+  } else {
+    zbin_info->reader.features.use_duration = false;
+  }
+
+  if (fread(&header, sizeof(header), 1, file) != 1) {
+    LOG_FATAL("couldn't read zbin trace header");
+  }
+  if (!zbin_trace_header_valid(&header)) {
+    LOG_FATAL("not a (supported) zbin trace");
+  }
+
+  zbin_info->reader.block_stride = header.block_stride;
+  zbin_info->reader.oblock_size = header.oblock_size;
+  if (header.sampling_rate > 1) {
+    zbin_info->reader.sampling_rate = header.sampling_rate;
+  }
+
+  zbin_info->starting_time_set = false;
+  zbin_info->next_block = 0;
+  zbin_info->stop = false;
+  zbin_info->block = 0;
+  zbin_info->pos = 0;
+  zbin_info->held = false;
+  zbin_info->len = 0;
+  zbin_info->nr_records = header.nr_records;
+  zbin_info->read = 0;
+  for (i = 0; i < ZBIN_TRACE_NR_SLOTS; i++) {
+    zbin_info->slots[i].requests = NULL;
+    zbin_info->slots[i].len = 0;
+    zbin_info->slots[i].capacity = 0;
+    zbin_info->slots[i].decoded = false;
+    zbin_info->slots[i].last = false;
+  }
+
+  pthread_mutex_init(&zbin_info->lock, NULL);
+  pthread_cond_init(&zbin_info->cond, NULL);
+  if (pthread_create(&zbin_info->thread, NULL, __zbin_trace_work,
+                     zbin_info)) {
+    LOG_FATAL("unable to create trace decoding thread");
+  }
+
+  return &zbin_info->reader;
+}
+
+static void zbin_trace_exit(struct trace_reader *reader) {
+  struct zbin_struct *zbin_info =
+      container_of(reader, struct zbin_struct, reader);
+  unsigned i;
+
+  pthread_mutex_lock(&zbin_info->lock);
+  zbin_info->stop = true;
+  pthread_cond_broadcast(&zbin_info->cond);
+  pthread_mutex_unlock(&zbin_info->lock);
+  pthread_join(zbin_info->thread, NULL);
+
+  for (i = 0; i < ZBIN_TRACE_NR_SLOTS; i++) {
+    free(zbin_info->slots[i].requests);
+  }
+  pthread_cond_destroy(&zbin_info->cond);
+  pthread_mutex_destroy(&zbin_info->lock);
+  mem_free(zbin_info->buf);
+  mem_free(zbin_info);
+}
+
+static int zbin_trace_read_request(struct trace_reader *reader,
+                                   struct trace_request *request) {
+  struct zbin_struct *zbin_info =
+      container_of(reader, struct zbin_struct, reader);
+  struct zbin_trace_slot *slot =
+      &zbin_info->slots[zbin_info->block % ZBIN_TRACE_NR_SLOTS];
+  bool last;
+
+  if (reader->eof ||
+      (zbin_info->nr_records > 0 &&
+       zbin_info->read == zbin_info->nr_records)) {
+    LOG_DEBUG("end of file reached");
+    reader->eof = true;
+    return 1;
+  }
+
+  for (;;) {
+    if (!zbin_info->held) {
+      pthread_mutex_lock(&zbin_info->lock);
+      while (!slot->decoded) {
+        pthread_cond_wait(&zbin_info->cond, &zbin_info->lock);
+      }
+      zbin_info->len = slot->len;
+      last = slot->last;
+      pthread_mutex_unlock(&zbin_info->lock);
+
+      // the helper thread is done, so the slot is never handed back
+      if (last) {
+        LOG_DEBUG("end of file reached");
+        reader->eof = true;
+        return 1;
+      }
+      zbin_info->held = true;
+    }
+
+    if (zbin_info->pos < zbin_info->len) {
+      break;
+    }
+
+    // hand the slot back for decoding
+    pthread_mutex_lock(&zbin_info->lock);
+    slot->decoded = false;
+    ++zbin_info->block;
+    pthread_cond_broadcast(&zbin_info->cond);
+    pthread_mutex_unlock(&zbin_info->lock);
+
+    zbin_info->held = false;
+    zbin_info->pos = 0;
+    slot = &zbin_info->slots[zbin_info->block % ZBIN_TRACE_NR_SLOTS];
+  }
+
+  *request = slot->requests[zbin_info->pos++];
+  ++zbin_info->read;
+
+  if (reader->features.use_duration) {
+    if (!zbin_info->starting_time_set) {
+      zbin_info->ending_time =
+          request->ts + (ZBIN_HOUR_LENGTH * reader->features.duration_hrs);
+      zbin_info->starting_time_set = true;
+    }
+    if (request->ts > zbin_info->ending_time) {
+      LOG_DEBUG("end of duration reached");
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+static int zbin_trace_read(struct trace_reader *reader,
+                           struct trace_reader_result *result) {
+  struct trace_request request;
+
+  if (zbin_trace_read_request(reader, &request)) {
+    return 1;
+  }
+
+  result->oblock = request.oblock;
+  result->nr_blocks = request.nr_blocks;
+  result->write = request.write;
+
+  return 0;
+}
+
+#endif /* TRACE_READER_ZBIN_TRACE_H */
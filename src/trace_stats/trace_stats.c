@@ -0,0 +1,308 @@
+#include "kernel/hash.h"
+#include "tools/logs.h"
+#include "trace_reader/trace_block.h"
+#include "trace_reader/trace_decompress.h"
+#include "trace_reader/trace_filter.h"
+#include "trace_reader/trace_multi.h"
+#include "trace_reader/trace_parallel.h"
+#include "trace_reader/trace_reader.h"
+#include "trace_reader/trace_window.h"
+#include "trace_stats_args.h"
+#include "trace_stats_shard.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/* trace-stats characterizes a trace of any supported format in a single pass
+ * over it: its read/write mix, request sizes, sequentiality, IO rate and
+ * unique blocks per hour, and hottest regions.
+ *
+ * The stats of every request (counts and histograms) are kept by the thread
+ * reading the trace, while the blocks accessed are sharded by region over
+ * --threads threads (see trace_stats_shard.h), which keep the stats needing
+ * every block of the trace, and are merged once it has been read.
+ *
+ * Blocks are oblock / block_stride (the oblock itself for sampled traces,
+ * whose oblocks are hashes), and regions --region-blocks consecutive blocks.
+ */
+
+// nanosecond -> second -> minute -> hour
+static const long long TRACE_STATS_HOUR_LENGTH = 1000000000LL * 60 * 60;
+
+// buckets of the histograms, one per power of 2
+#define TRACE_STATS_NR_BUCKETS 64
+
+struct trace_stats_options options = {
+    .fp = NULL,
+    .trace_name = NULL,
+    .duration_hrs = 0,
+    .decode_threads = 1,
+    .block_size = 0,
+    .threads = 0,
+    .top = 10,
+    .region_blocks = 256,
+};
+
+/** trace_stats_hour
+ * requests - Number of requests in the hour
+ * accesses - Number of blocks accessed in the hour
+ */
+struct trace_stats_hour {
+  uint64_t requests;
+  uint64_t accesses;
+};
+
+/** trace_stats
+ * Stats kept by the thread reading the trace
+ *
+ * requests/writes/accesses - Number of requests, of writes, and of blocks
+ *                            accessed
+ * sizes - Number of requests of every size (in blocks), by power of 2
+ * runs - Number of sequential runs of every length (in requests), by power
+ *        of 2
+ * run/next - Length of the current run, and the oblock continuing it
+ * hours/nr_hours/capacity - Stats of every hour, and space for them
+ * starting_time - Time of the first request
+ */
+struct trace_stats {
+  uint64_t requests;
+  uint64_t writes;
+  uint64_t accesses;
+  uint64_t sizes[TRACE_STATS_NR_BUCKETS];
+  uint64_t runs[TRACE_STATS_NR_BUCKETS];
+  uint64_t run;
+  oblock_t next;
+  struct trace_stats_hour *hours;
+  unsigned nr_hours;
+  unsigned capacity;
+  uint64_t starting_time;
+};
+
+/** Bucket of value (> 0), its power of 2
+ */
+static unsigned trace_stats_bucket(uint64_t value) {
+  return 63 - __builtin_clzl(value);
+}
+
+/** Hour of the request, adding it (and any hour before it) to the stats
+ */
+static unsigned trace_stats_hour(struct trace_stats *stats,
+                                 struct trace_request *request) {
+  unsigned hour;
+
+  if (stats->requests == 0) {
+    stats->starting_time = request->ts;
+  }
+  // requests slightly out of order before the first one are in hour 0
+  hour = request->ts > stats->starting_time
+             ? (request->ts - stats->starting_time) / TRACE_STATS_HOUR_LENGTH
+             : 0;
+
+  while (hour >= stats->nr_hours) {
+    if (stats->nr_hours == stats->capacity) {
+      stats->capacity = stats->capacity ? 2 * stats->capacity : 256;
+      stats->hours = realloc(stats->hours,
+                             sizeof(*stats->hours) * stats->capacity);
+      if (stats->hours == NULL) {
+        LOG_FATAL("Unable to allocate memory for the trace stats");
+      }
+    }
+    stats->hours[stats->nr_hours].requests = 0;
+    stats->hours[stats->nr_hours].accesses = 0;
+    ++stats->nr_hours;
+  }
+  return hour;
+}
+
+/** Add the stats of a request, handing its blocks over to their shards
+ */
+static void trace_stats_add(struct trace_stats *stats,
+                            struct trace_stats_shard *shards,
+                            unsigned nr_shards, struct trace_reader *reader,
+                            struct trace_request *request) {
+  block_t stride = reader->sampling_rate > 1 ? 1 : reader->block_stride;
+  unsigned hour = trace_stats_hour(stats, request);
+  oblock_t block;
+  block_t i;
+
+  // a run goes on for as long as every request starts where the one before
+  // it ended
+  if (stats->requests > 0 && request->oblock != stats->next) {
+    ++stats->runs[trace_stats_bucket(stats->run)];
+    stats->run = 0;
+  }
+  ++stats->run;
+  stats->next = request->oblock + (oblock_t)request->nr_blocks * stride;
+
+  ++stats->requests;
+  stats->writes += request->write;
+  stats->accesses += request->nr_blocks;
+  ++stats->hours[hour].requests;
+  stats->hours[hour].accesses += request->nr_blocks;
+  if (request->nr_blocks > 0) {
+    ++stats->sizes[trace_stats_bucket(request->nr_blocks)];
+  }
+
+  for (i = 0; i < request->nr_blocks; i++) {
+    block = request->oblock / stride + i;
+    trace_stats_shard_add(
+        &shards[hash_64(block / options.region_blocks, 32) % nr_shards],
+        block, hour);
+  }
+}
+
+static void trace_stats_print_histogram(const char *name, uint64_t *buckets) {
+  unsigned b;
+
+  for (b = 0; b < TRACE_STATS_NR_BUCKETS; b++) {
+    if (buckets[b] > 0) {
+      LOG_PRINT("%s %lu-%lu %lu", name, (uint64_t)1 << b,
+                ((uint64_t)2 << b) - 1, buckets[b]);
+    }
+  }
+}
+
+static int __trace_stats_region_cmp(const void *a, const void *b) {
+  const struct trace_stats_region *r_a = a;
+  const struct trace_stats_region *r_b = b;
+
+  if (r_a->accesses != r_b->accesses) {
+    return r_a->accesses > r_b->accesses ? -1 : 1;
+  }
+  return r_a->region < r_b->region ? -1 : r_a->region > r_b->region;
+}
+
+/** Merge the stats of the shards and print every stat
+ */
+static void trace_stats_print(struct trace_stats *stats,
+                              struct trace_stats_shard *shards,
+                              unsigned nr_shards) {
+  struct trace_stats_region *top;
+  uint64_t requests = stats->requests ? stats->requests : 1;
+  uint64_t unique = 0;
+  uint64_t hour_unique;
+  unsigned nr_top = 0;
+  unsigned h;
+  unsigned s;
+
+  if (stats->requests > 0) {
+    ++stats->runs[trace_stats_bucket(stats->run)];
+  }
+
+  for (s = 0; s < nr_shards; s++) {
+    unique += shards[s].blocks.nr;
+  }
+
+  LOG_PRINT("requests %lu", stats->requests);
+  LOG_PRINT("reads %lu %.2f%%", stats->requests - stats->writes,
+            100.0 * (stats->requests - stats->writes) / requests);
+  LOG_PRINT("writes %lu %.2f%%", stats->writes,
+            100.0 * stats->writes / requests);
+  LOG_PRINT("accesses %lu", stats->accesses);
+  LOG_PRINT("unique %lu", unique);
+  trace_stats_print_histogram("size", stats->sizes);
+  trace_stats_print_histogram("run", stats->runs);
+
+  for (h = 0; h < stats->nr_hours; h++) {
+    hour_unique = 0;
+    for (s = 0; s < nr_shards; s++) {
+      if (h < shards[s].nr_hours) {
+        hour_unique += shards[s].unique[h];
+      }
+    }
+    LOG_PRINT("hour %u %lu %lu %lu", h, stats->hours[h].requests,
+              stats->hours[h].accesses, hour_unique);
+  }
+
+  // every region belongs to a single shard, so the hottest regions are among
+  // the hottest of every shard
+  top = mem_alloc(sizeof(*top) * (options.top * nr_shards + 1));
+  if (!top) {
+    LOG_FATAL("Unable to allocate memory for the trace stats");
+  }
+  for (s = 0; s < nr_shards; s++) {
+    memcpy(&top[nr_top], shards[s].top, sizeof(*top) * shards[s].nr_top);
+    nr_top += shards[s].nr_top;
+  }
+  qsort(top, nr_top, sizeof(*top), __trace_stats_region_cmp);
+  for (h = 0; h < nr_top && h < options.top; h++) {
+    LOG_PRINT("region %lu %lu", top[h].region, top[h].accesses);
+  }
+  mem_free(top);
+}
+
+int main(int argc, char **argv) {
+  struct trace_reader *reader;
+  struct trace_request request;
+  struct trace_stats stats = {0};
+  struct trace_stats_shard *shards;
+  block_t block_stride;
+  unsigned s;
+  bool window;
+
+  options.fp = stdin;
+  options.threads = sysconf(_SC_NPROCESSORS_ONLN) > 0
+                        ? sysconf(_SC_NPROCESSORS_ONLN)
+                        : 1;
+
+  handle_args(argc, argv, &options);
+
+  // a window applies the duration itself, from the start of the window
+  window = trace_window_used(&options.window);
+
+  // several trace files are opened as they are read, by trace_multi
+  if (options.files.nr_paths > 1) {
+    reader = trace_multi_create(find_trace_reader(options.trace_name),
+                                &options.files,
+                                window ? 0 : options.duration_hrs,
+                                options.decode_threads);
+  } else {
+    options.fp = trace_decompress_open(options.fp);
+    LOG_ASSERT(options.fp != NULL);
+
+    reader = trace_parallel_create(find_trace_reader(options.trace_name),
+                                   options.fp,
+                                   window ? 0 : options.duration_hrs,
+                                   options.decode_threads);
+  }
+  if (reader != NULL && window) {
+    reader = trace_window_create(reader, &options.window, options.duration_hrs);
+  }
+  if (reader != NULL && trace_filter_used(&options.filter)) {
+    reader = trace_filter_create(reader, &options.filter);
+  }
+  if (reader != NULL && options.block_size > 0) {
+    reader = trace_block_create(reader, options.block_size);
+  }
+  LOG_ASSERT(reader != NULL);
+
+  // regions are given by their first oblock
+  block_stride = reader->sampling_rate > 1 ? 1 : reader->block_stride;
+
+  shards = mem_alloc(sizeof(*shards) * options.threads);
+  if (!shards) {
+    LOG_FATAL("Unable to allocate memory for the trace stats");
+  }
+  for (s = 0; s < options.threads; s++) {
+    trace_stats_shard_init(&shards[s], options.region_blocks, block_stride,
+                           options.top);
+  }
+
+  while (!reader->read_request(reader, &request)) {
+    trace_stats_add(&stats, shards, options.threads, reader, &request);
+  }
+
+  for (s = 0; s < options.threads; s++) {
+    trace_stats_shard_finish(&shards[s]);
+  }
+  trace_stats_print(&stats, shards, options.threads);
+
+  for (s = 0; s < options.threads; s++) {
+    trace_stats_shard_exit(&shards[s]);
+  }
+  mem_free(shards);
+  free(stats.hours);
+  trace_reader_exit(reader);
+
+  return 0;
+}
@@ -0,0 +1,235 @@
+#ifndef TRACE_STATS_TRACE_STATS_ARGS_H
+#define TRACE_STATS_TRACE_STATS_ARGS_H
+
+#include "trace_reader/trace_block.h"
+#include "trace_reader/trace_multi.h"
+#include "trace_reader/trace_reader.h"
+#include "trace_stats_options.h"
+#include <ctype.h>
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <unistd.h>
+
+void handle_optional_args(int argc, char **argv,
+                          struct trace_stats_options *options) {
+  char c;
+
+  static struct option long_options[] = {
+      {"file", required_argument, 0, 'f'},
+      {"manifest", required_argument, 0, '+'},
+      {"help", no_argument, 0, '`'},
+      {"duration", required_argument, 0, 'd'},
+      {"start", required_argument, 0, '@'},
+      {"skip-ios", required_argument, 0, '['},
+      {"max-ios", required_argument, 0, ']'},
+      {"decode-threads", required_argument, 0, '#'},
+      {"block-size", required_argument, 0, '*'},
+      {"reads-only", no_argument, 0, '{'},
+      {"writes-only", no_argument, 0, '}'},
+      {"lba-range", required_argument, 0, '('},
+      {"time-window", required_argument, 0, ')'},
+      {"pid", required_argument, 0, '$'},
+      {"process", required_argument, 0, '&'},
+      {"threads", required_argument, 0, 't'},
+      {"top", required_argument, 0, '^'},
+      {"region-blocks", required_argument, 0, 'r'},
+      {0, 0, 0, 0},
+  };
+  int option_index = 0;
+  char duration_time;
+
+  while ((c = getopt_long(argc, argv, "d:f:t:", long_options,
+                          &option_index)) != -1) {
+    switch (c) {
+    case 'f':
+      trace_files_add(&options->files, optarg);
+      break;
+    case '+':
+      trace_files_add_manifest(&options->files, optarg);
+      break;
+    case '`':
+      LOG_PRINT(
+          "Usage: ./trace-stats [TRACE_FORMAT] [OPTION]...\n"
+          "Characterize a trace in one pass over it.\n"
+          "  TRACE_FORMAT     format of the trace\n\n"
+          "With no -f or --file OPTION, read standard input.\n\n"
+          "  -f, --file       file of TRACE_TYPE to characterize. Given\n"
+          "                   several times, the files are read one after\n"
+          "                   the other as a single trace\n"
+          "      --manifest   file listing (one per line) trace files to\n"
+          "                   read as with -f\n"
+          "  -d, --duration   amount of the trace, based on time, that\n"
+          "                   is going to be read\n"
+          "                   Supported time designations:\n"
+          "                     XXh   XX hours\n"
+          "                     XXd   XX days\n"
+          "      --start      start the trace this long (as with --duration)\n"
+          "                   after its first request\n"
+          "      --skip-ios   skip the given number of requests from the\n"
+          "                   start of the trace\n"
+          "      --max-ios    read at most the given number of requests\n"
+          "      --block-size map the accesses of the trace onto cache\n"
+          "                   blocks of the given size in bytes (or KiB\n"
+          "                   with K, or MiB with M), accessing each cache\n"
+          "                   block a request touches once\n"
+          "      --reads-only only read the reads of the trace\n"
+          "      --writes-only\n"
+          "                   only read the writes of the trace\n"
+          "      --lba-range  FIRST-LAST, only read the accesses to the\n"
+          "                   addresses from FIRST to LAST (in the\n"
+          "                   addresses of the trace, such as sectors for\n"
+          "                   fiu or bytes for msr)\n"
+          "      --time-window\n"
+          "                   FROM-TO, only read the requests from FROM\n"
+          "                   to TO after the first request (in seconds,\n"
+          "                   or minutes, hours or days with m, h or d,\n"
+          "                   such as 30m-2h)\n"
+          "      --pid        only read the requests of the process of\n"
+          "                   the given pid (fiu and visa)\n"
+          "      --process    only read the requests of the processes\n"
+          "                   of the given name (fiu and visa)\n"
+          "  -t, --threads    shard the blocks of the trace over the given\n"
+          "                   number of threads (default: one per core)\n"
+          "      --top        print the given number of hottest regions\n"
+          "                   (default: 10)\n"
+          "      --region-blocks\n"
+          "                   size of a region in blocks (default: 256)\n"
+          "      --decode-threads\n"
+          "                   decode the trace file on the given number of\n"
+          "                   threads, in chunks (basic, fiu and msr)\n"
+          "      --help       display this help and exit\n\n"
+          "Output, one stat per line:\n"
+          "  requests N       requests read\n"
+          "  reads N P%%       read requests, and their share of requests\n"
+          "  writes N P%%      write requests, and their share of requests\n"
+          "  accesses N       blocks accessed, over every request\n"
+          "  unique N         distinct blocks accessed\n"
+          "  size LO-HI N     requests of LO to HI blocks\n"
+          "  run LO-HI N      sequential runs of LO to HI requests, each\n"
+          "                   starting where the one before it ended\n"
+          "  hour H REQUESTS ACCESSES UNIQUE\n"
+          "                   requests, accesses and distinct blocks\n"
+          "                   accessed in hour H of the trace\n"
+          "  region OBLOCK N  the hottest regions, by first oblock, with\n"
+          "                   their accesses, hottest first\n\n"
+          "Examples:\n"
+          "  ./trace-stats msr -f example.trace\n"
+          "      Characterize MSR trace example.trace\n"
+          "  ./trace-stats msr -f example.trace --block-size 64K --top 5\n"
+          "      Characterize example.trace in blocks of 64 KiB, printing\n"
+          "      its 5 hottest regions of 16 MiB\n\n");
+      exit(0);
+      break;
+    case 'd':
+      sscanf(optarg, "%lu%c", &options->duration_hrs, &duration_time);
+      switch (duration_time) {
+      case 'd':
+        options->duration_hrs *= 24;
+      case 'h':
+        break;
+      default:
+        LOG_FATAL("Unknown duration time %c", duration_time);
+      }
+      break;
+    case '#':
+      sscanf(optarg, "%u", &options->decode_threads);
+      LOG_ASSERT(options->decode_threads > 0u);
+      break;
+    case '*':
+      if (trace_block_parse_size(optarg, &options->block_size)) {
+        LOG_FATAL("Block size given was not a size in bytes `%s`", optarg);
+      }
+      break;
+    case 't':
+      sscanf(optarg, "%u", &options->threads);
+      LOG_ASSERT(options->threads > 0u);
+      break;
+    case '^':
+      sscanf(optarg, "%u", &options->top);
+      break;
+    case 'r':
+      sscanf(optarg, "%lu", &options->region_blocks);
+      LOG_ASSERT(options->region_blocks > 0u);
+      break;
+    case '@':
+      sscanf(optarg, "%u%c", &options->window.start_hrs, &duration_time);
+      switch (duration_time) {
+      case 'd':
+        options->window.start_hrs *= 24;
+      case 'h':
+        break;
+      default:
+        LOG_FATAL("Unknown start time %c", duration_time);
+      }
+      break;
+    case '[':
+      sscanf(optarg, "%lu", &options->window.skip_ios);
+      break;
+    case ']':
+      sscanf(optarg, "%lu", &options->window.max_ios);
+      break;
+    case '{':
+      options->filter.reads_only = true;
+      break;
+    case '}':
+      options->filter.writes_only = true;
+      break;
+    case '(':
+      if (trace_filter_parse_lba_range(&options->filter, optarg)) {
+        LOG_FATAL("Address range given was not FIRST-LAST `%s`", optarg);
+      }
+      break;
+    case ')':
+      if (trace_filter_parse_time_window(&options->filter, optarg)) {
+        LOG_FATAL("Time window given was not FROM-TO `%s`", optarg);
+      }
+      break;
+    case '$':
+      sscanf(optarg, "%u", &options->filter.pid_value);
+      options->filter.pid = true;
+      break;
+    case '&':
+      options->filter.process_value = trace_process_id(optarg, strlen(optarg));
+      options->filter.process = true;
+      break;
+    case '?':
+      if (isprint(optopt)) {
+        LOG_FATAL("Unknown option `-%c`", optopt);
+      } else {
+        LOG_FATAL("Unknown option character `\\x%x`", optopt);
+      }
+    default:
+      LOG_FATAL("Should've expected the unknown unknown");
+    }
+  }
+
+  // a single file is read as it is, several are read through trace_multi
+  if (options->files.nr_paths == 1) {
+    options->fp = fopen(options->files.paths[0], "r");
+    if (!options->fp) {
+      LOG_FATAL("File %s could not be opened. Errno = %d",
+                options->files.paths[0], errno);
+    }
+  }
+}
+
+void handle_required_args(int argc, char **argv,
+                          struct trace_stats_options *options) {
+  if (argc < 1) {
+    LOG_FATAL("Missing non-optional arguments\n"
+              "Try 'trace-stats --help' for more information.");
+  }
+
+  options->trace_name = argv[0];
+  if (!find_trace_reader(options->trace_name)) {
+    LOG_FATAL("Unknown trace type %s", options->trace_name);
+  }
+}
+
+void handle_args(int argc, char **argv, struct trace_stats_options *options) {
+  handle_optional_args(argc, argv, options);
+  handle_required_args(argc - optind, argv + optind, options);
+}
+
+#endif /* TRACE_STATS_TRACE_STATS_ARGS_H */
@@ -0,0 +1,31 @@
+#ifndef TRACE_STATS_TRACE_STATS_OPTIONS_H
+#define TRACE_STATS_TRACE_STATS_OPTIONS_H
+
+#include "trace_reader/trace_filter.h"
+#include "trace_reader/trace_multi.h"
+#include "trace_reader/trace_window.h"
+#include "types.h"
+#include <stdio.h>
+
+struct trace_stats_options {
+  FILE *fp;
+  // trace files given, read one after the other when there are several
+  struct trace_files files;
+  char *trace_name;
+  uint64_t duration_hrs;
+  // part of the trace to be read, if not all of it
+  struct trace_window window;
+  // requests of the trace to be read, if not all of them
+  struct trace_filter filter;
+  unsigned decode_threads;
+  // size in bytes of the cache blocks the trace's accesses are mapped onto
+  // (0 for the trace's own blocks)
+  uint64_t block_size;
+  // number of threads the blocks of the trace are sharded over
+  unsigned threads;
+  // number of hottest regions to print, and their size in blocks
+  unsigned top;
+  uint64_t region_blocks;
+};
+
+#endif /* TRACE_STATS_TRACE_STATS_OPTIONS_H */
@@ -0,0 +1,366 @@
+#ifndef TRACE_STATS_TRACE_STATS_SHARD_H
+#define TRACE_STATS_TRACE_STATS_SHARD_H
+
+#include "common.h"
+#include "kernel/hash.h"
+#include "types.h"
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The stats that need to remember every block of the trace (unique blocks,
+ * overall and per hour, and accesses per region) are sharded by region over
+ * several threads, each owning the blocks of its regions. The thread reading
+ * the trace hands the accesses of every shard over to it in batches, through
+ * a lock-free, single producer/single consumer ring (as in sim_pipeline.h).
+ *
+ * Since every region belongs to a single shard, the stats of the shards only
+ * have to be added up (or, for the hottest regions, merged) once the trace has
+ * been read.
+ */
+
+#define TRACE_STATS_NR_BATCHES 8
+#define TRACE_STATS_BATCH_SIZE 4096
+// Number of times to check the ring before yielding the processor
+#define TRACE_STATS_SPIN_COUNT 128
+
+/** trace_stats_access
+ * block - Block accessed (oblock / block_stride)
+ * hour - Hour of the access, from the first request of the trace
+ */
+struct trace_stats_access {
+  oblock_t block;
+  unsigned hour;
+};
+
+/** trace_stats_batch
+ * accesses - Accesses, in trace order
+ * len - Number of accesses in accesses
+ * last - Is this the last batch of the trace?
+ */
+struct trace_stats_batch {
+  struct trace_stats_access accesses[TRACE_STATS_BATCH_SIZE];
+  unsigned len;
+  bool last;
+};
+
+/** trace_stats_map
+ * An open addressing (linear probing) map of 64-bit keys to 64-bit values,
+ * with key + 1 stored in keys so that empty slots are 0
+ *
+ * keys/values - 1 << bits slots
+ * nr - Number of keys in the map
+ */
+struct trace_stats_map {
+  uint64_t *keys;
+  uint64_t *values;
+  uint64_t nr;
+  unsigned bits;
+};
+
+/** trace_stats_region
+ * region - First oblock of the region
+ * accesses - Number of accesses to the region
+ */
+struct trace_stats_region {
+  oblock_t region;
+  uint64_t accesses;
+};
+
+/** trace_stats_shard
+ * thread - Thread accumulating the stats of the shard
+ * batches - The ring of batches
+ * head - Number of batches filled by the reading thread (producer only)
+ * tail - Number of batches consumed (consumer only)
+ * pos - Position of the next access in the batch being filled (producer only)
+ * region_blocks/block_stride - Size of a region in blocks, and the oblock
+ *                              increment between blocks
+ * blocks - Last hour (+ 1) each block of the shard was accessed in
+ * regions - Number of accesses to each region of the shard
+ * unique/nr_hours/capacity - Number of unique blocks of the shard accessed in
+ *                            each hour, and space for them
+ * top/nr_top - Hottest regions of the shard, hottest first
+ */
+struct trace_stats_shard {
+  pthread_t thread;
+  struct trace_stats_batch *batches;
+
+  // keep head and tail on separate cache lines so they don't bounce around
+  uint64_t head __attribute__((aligned(64)));
+  uint64_t tail __attribute__((aligned(64)));
+  unsigned pos;
+
+  uint64_t region_blocks;
+  block_t block_stride;
+  struct trace_stats_map blocks;
+  struct trace_stats_map regions;
+  uint64_t *unique;
+  unsigned nr_hours;
+  unsigned capacity;
+
+  struct trace_stats_region *top;
+  unsigned nr_top;
+};
+
+static int trace_stats_map_init(struct trace_stats_map *map, unsigned bits) {
+  map->keys = calloc((size_t)1 << bits, sizeof(*map->keys));
+  map->values = malloc(sizeof(*map->values) << bits);
+  map->nr = 0;
+  map->bits = bits;
+  if (map->keys == NULL || map->values == NULL) {
+    free(map->keys);
+    free(map->values);
+    return -ENOSPC;
+  }
+  return 0;
+}
+
+static void trace_stats_map_exit(struct trace_stats_map *map) {
+  free(map->keys);
+  free(map->values);
+}
+
+/** Slot of key, or of the empty slot it would be added to
+ */
+static uint64_t __trace_stats_map_slot(struct trace_stats_map *map,
+                                       uint64_t key) {
+  uint64_t mask = ((uint64_t)1 << map->bits) - 1;
+  uint64_t i = hash_64(key, map->bits);
+
+  while (map->keys[i] != 0 && map->keys[i] != key + 1) {
+    i = (i + 1) & mask;
+  }
+  return i;
+}
+
+/** Double the number of slots of the map
+ */
+static void __trace_stats_map_grow(struct trace_stats_map *map) {
+  struct trace_stats_map old = *map;
+  uint64_t i;
+  uint64_t s;
+
+  if (trace_stats_map_init(map, old.bits + 1)) {
+    LOG_FATAL("Unable to allocate memory for the trace stats");
+  }
+
+  for (i = 0; i < (uint64_t)1 << old.bits; i++) {
+    if (old.keys[i] != 0) {
+      s = __trace_stats_map_slot(map, old.keys[i] - 1);
+      map->keys[s] = old.keys[i];
+      map->values[s] = old.values[i];
+    }
+  }
+  map->nr = old.nr;
+
+  trace_stats_map_exit(&old);
+}
+
+/** Value of key, adding key with a value of 0 if it isn't in the map
+ *
+ * \return The value, which stays valid until the next key is added
+ */
+static uint64_t *trace_stats_map_get(struct trace_stats_map *map,
+                                     uint64_t key) {
+  uint64_t s = __trace_stats_map_slot(map, key);
+
+  if (map->keys[s] == 0) {
+    // keep the map at most half full
+    if (2 * (map->nr + 1) > (uint64_t)1 << map->bits) {
+      __trace_stats_map_grow(map);
+      s = __trace_stats_map_slot(map, key);
+    }
+    map->keys[s] = key + 1;
+    map->values[s] = 0;
+    ++map->nr;
+  }
+  return &map->values[s];
+}
+
+static void __trace_stats_wait(unsigned *spins) {
+  if (++*spins >= TRACE_STATS_SPIN_COUNT) {
+    *spins = 0;
+    sched_yield();
+  }
+}
+
+/** Count an access of the shard
+ */
+static void __trace_stats_shard_count(struct trace_stats_shard *shard,
+                                      struct trace_stats_access *access) {
+  uint64_t *last_hour = trace_stats_map_get(&shard->blocks, access->block);
+
+  // a block only counts once per hour (and the hours of a trace only ever go
+  // up, but for requests slightly out of order)
+  if (*last_hour != access->hour + 1) {
+    *last_hour = access->hour + 1;
+
+    while (access->hour >= shard->nr_hours) {
+      if (shard->nr_hours == shard->capacity) {
+        shard->capacity = shard->capacity ? 2 * shard->capacity : 256;
+        shard->unique =
+            realloc(shard->unique, sizeof(*shard->unique) * shard->capacity);
+        if (shard->unique == NULL) {
+          LOG_FATAL("Unable to allocate memory for the trace stats");
+        }
+      }
+      shard->unique[shard->nr_hours++] = 0;
+    }
+    ++shard->unique[access->hour];
+  }
+
+  ++*trace_stats_map_get(&shard->regions,
+                         access->block / shard->region_blocks);
+}
+
+/** Find the nr_top hottest regions of the shard
+ */
+static void __trace_stats_shard_top(struct trace_stats_shard *shard) {
+  struct trace_stats_map *regions = &shard->regions;
+  struct trace_stats_region r;
+  unsigned capacity = shard->nr_top;
+  uint64_t i;
+  unsigned j;
+
+  shard->nr_top = 0;
+  if (capacity == 0) {
+    return;
+  }
+
+  for (i = 0; i < (uint64_t)1 << regions->bits; i++) {
+    if (regions->keys[i] == 0) {
+      continue;
+    }
+    r.region = (regions->keys[i] - 1) * shard->region_blocks *
+               shard->block_stride;
+    r.accesses = regions->values[i];
+
+    // insertion into the (short) sorted list of the hottest regions so far
+    if (shard->nr_top == capacity) {
+      if (r.accesses <= shard->top[capacity - 1].accesses) {
+        continue;
+      }
+      --shard->nr_top;
+    }
+    for (j = shard->nr_top;
+         j > 0 && shard->top[j - 1].accesses < r.accesses; j--) {
+      shard->top[j] = shard->top[j - 1];
+    }
+    shard->top[j] = r;
+    ++shard->nr_top;
+  }
+}
+
+static void *__trace_stats_shard_work(void *arg) {
+  struct trace_stats_shard *shard = arg;
+  struct trace_stats_batch *b;
+  unsigned spins = 0;
+  unsigned i;
+
+  for (;;) {
+    while (__atomic_load_n(&shard->head, __ATOMIC_ACQUIRE) == shard->tail) {
+      __trace_stats_wait(&spins);
+    }
+
+    b = &shard->batches[shard->tail % TRACE_STATS_NR_BATCHES];
+    for (i = 0; i < b->len; i++) {
+      __trace_stats_shard_count(shard, &b->accesses[i]);
+    }
+    if (b->last) {
+      break;
+    }
+    __atomic_store_n(&shard->tail, shard->tail + 1, __ATOMIC_RELEASE);
+  }
+
+  __trace_stats_shard_top(shard);
+  return NULL;
+}
+
+/** Start the thread of the shard, keeping track of the nr_top hottest
+ * regions of region_blocks blocks (block_stride apart)
+ */
+static void trace_stats_shard_init(struct trace_stats_shard *shard,
+                                   uint64_t region_blocks,
+                                   block_t block_stride, unsigned nr_top) {
+  shard->head = 0;
+  shard->tail = 0;
+  shard->pos = 0;
+  shard->region_blocks = region_blocks;
+  shard->block_stride = block_stride;
+  shard->unique = NULL;
+  shard->nr_hours = 0;
+  shard->capacity = 0;
+  shard->nr_top = nr_top;
+
+  shard->batches = mem_alloc(sizeof(*shard->batches) * TRACE_STATS_NR_BATCHES);
+  // (one more than needed, so nothing is allocated empty)
+  shard->top = mem_alloc(sizeof(*shard->top) * (nr_top + 1));
+  if (!shard->batches || !shard->top ||
+      trace_stats_map_init(&shard->blocks, 16) ||
+      trace_stats_map_init(&shard->regions, 10)) {
+    LOG_FATAL("Unable to allocate memory for the trace stats");
+  }
+
+  if (pthread_create(&shard->thread, NULL, __trace_stats_shard_work, shard)) {
+    LOG_FATAL("Unable to create trace stats thread");
+  }
+}
+
+/** Hand an access over to the shard
+ */
+static void trace_stats_shard_add(struct trace_stats_shard *shard,
+                                  oblock_t block, unsigned hour) {
+  struct trace_stats_batch *b;
+  unsigned spins = 0;
+
+  if (shard->pos == 0) {
+    while (shard->head - __atomic_load_n(&shard->tail, __ATOMIC_ACQUIRE) ==
+           TRACE_STATS_NR_BATCHES) {
+      __trace_stats_wait(&spins);
+    }
+  }
+
+  b = &shard->batches[shard->head % TRACE_STATS_NR_BATCHES];
+  b->accesses[shard->pos].block = block;
+  b->accesses[shard->pos].hour = hour;
+
+  if (++shard->pos == TRACE_STATS_BATCH_SIZE) {
+    b->len = TRACE_STATS_BATCH_SIZE;
+    b->last = false;
+    shard->pos = 0;
+    __atomic_store_n(&shard->head, shard->head + 1, __ATOMIC_RELEASE);
+  }
+}
+
+/** Hand the last batch over to the shard, and wait for its stats
+ */
+static void trace_stats_shard_finish(struct trace_stats_shard *shard) {
+  struct trace_stats_batch *b;
+  unsigned spins = 0;
+
+  if (shard->pos == 0) {
+    while (shard->head - __atomic_load_n(&shard->tail, __ATOMIC_ACQUIRE) ==
+           TRACE_STATS_NR_BATCHES) {
+      __trace_stats_wait(&spins);
+    }
+  }
+
+  b = &shard->batches[shard->head % TRACE_STATS_NR_BATCHES];
+  b->len = shard->pos;
+  b->last = true;
+  __atomic_store_n(&shard->head, shard->head + 1, __ATOMIC_RELEASE);
+
+  pthread_join(shard->thread, NULL);
+}
+
+static void trace_stats_shard_exit(struct trace_stats_shard *shard) {
+  trace_stats_map_exit(&shard->blocks);
+  trace_stats_map_exit(&shard->regions);
+  free(shard->unique);
+  mem_free(shard->top);
+  mem_free(shard->batches);
+}
+
+#endif /* TRACE_STATS_TRACE_STATS_SHARD_H */
@@ -438,13 +438,13 @@ int alecar_init(struct alecar_policy *alecar, cblock_t cache_size,
   alecar_learning_rate_init(&alecar->learning_rate, cache_size);
 
   epool_create(&cn->cache_pool, cache_size, struct alecar_entry, e);
-  if (!cn->cache_pool.entries_begin || !cn->cache_pool.entries) {
+  if (!cn->cache_pool.entries_begin) {
     LOG_DEBUG("epool_create for cache_pool failed.");
     goto cache_epool_create_fail;
   }
   // TODO reduce this?
   epool_create(&cn->meta_pool, alecar->history_size, struct alecar_entry, e);
-  if (!cn->meta_pool.entries_begin || !cn->meta_pool.entries) {
+  if (!cn->meta_pool.entries_begin) {
     LOG_DEBUG("epool_create for meta_pool failed.");
     goto meta_epool_create_fail;
   }
@@ -572,13 +572,13 @@ int dlirs_init(struct dlirs_policy *dlirs, cblock_t cache_size,
   dlirs->nonresident_count = 0;
 
   epool_create(&cn->cache_pool, cache_size, struct dlirs_entry, e);
-  if (!cn->cache_pool.entries_begin || !cn->cache_pool.entries) {
+  if (!cn->cache_pool.entries_begin) {
     LOG_DEBUG("epool_create for cache_pool failed.");
     goto cache_epool_create_fail;
   }
 
   epool_create(&cn->meta_pool, meta_size, struct dlirs_entry, e);
-  if (!cn->meta_pool.entries_begin || !cn->meta_pool.entries) {
+  if (!cn->meta_pool.entries_begin) {
     LOG_DEBUG("epool_create for meta_pool failed.");
     goto meta_epool_create_fail;
   }
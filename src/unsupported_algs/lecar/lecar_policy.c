@@ -409,13 +409,13 @@ int lecar_init(struct lecar_policy *lecar, cblock_t cache_size,
   lecar->history_size = meta_size;
 
   epool_create(&cn->cache_pool, cache_size, struct lecar_entry, e);
-  if (!cn->cache_pool.entries_begin || !cn->cache_pool.entries) {
+  if (!cn->cache_pool.entries_begin) {
     LOG_DEBUG("epool_create for cache_pool failed.");
     goto cache_epool_create_fail;
   }
   // TODO reduce this?
   epool_create(&cn->meta_pool, lecar->history_size, struct lecar_entry, e);
-  if (!cn->meta_pool.entries_begin || !cn->meta_pool.entries) {
+  if (!cn->meta_pool.entries_begin) {
     LOG_DEBUG("epool_create for meta_pool failed.");
     goto meta_epool_create_fail;
   }
@@ -1,5 +1,10 @@
 #include "tools/logs.h"
+#include "trace_reader/trace_block.h"
+#include "trace_reader/trace_decompress.h"
+#include "trace_reader/trace_filter.h"
+#include "trace_reader/trace_multi.h"
 #include "trace_reader/trace_reader.h"
+#include "trace_reader/trace_window.h"
 #include "set_size_args.h"
 #include <iostream>
 #include <unordered_set>
@@ -16,21 +21,50 @@ int main(int argc, char **argv) {
 
 	handle_args(argc, argv, &options);
 
-	struct trace_reader *reader = find_trace_reader(options.trace_name);
+	struct trace_reader *reader;
+	// a window applies the duration itself, from the start of the window
+	bool window = trace_window_used(&options.window);
+	unsigned duration_hrs = window ? 0 : options.duration_hrs;
+
+	// several trace files are opened as they are read, by trace_multi
+	if (options.files.nr_paths > 1) {
+		reader = trace_multi_create(find_trace_reader(options.trace_name),
+		                            &options.files, duration_hrs, 1);
+	} else {
+		options.fp = trace_decompress_open(options.fp);
+		LOG_ASSERT(options.fp != NULL);
+
+		reader = create_trace_reader(options.trace_name, options.fp,
+		                             duration_hrs);
+	}
+	if (reader != NULL && window) {
+		reader = trace_window_create(reader, &options.window,
+		                             options.duration_hrs);
+	}
+	if (reader != NULL && trace_filter_used(&options.filter)) {
+		reader = trace_filter_create(reader, &options.filter);
+	}
+	if (reader != NULL && options.block_size > 0) {
+		reader = trace_block_create(reader, options.block_size);
+	}
 	LOG_ASSERT(reader != NULL);
-	reader->init(options.fp, options.duration_hrs);
 
 	struct trace_reader_result read_result = {0};
 
-	while (!reader->read(&read_result)) {
+	while (!reader->read(reader, &read_result)) {
 		oblock_t oblock = read_result.oblock;
 
-		if (unique.find(oblock) == unique.end()) {
-			unique.insert(oblock);
+		for (block_t i = 0; i < read_result.nr_blocks; i++) {
+			if (unique.find(oblock) == unique.end()) {
+				unique.insert(oblock);
+			}
+			oblock += reader->block_stride;
 		}
 	}
 
 	std::cout << unique.size() << '\n';
 
+	trace_reader_exit(reader);
+
 	return 0;
 }
@@ -2,6 +2,7 @@
 #define WORKINGSET_SIZE_SET_SIZE_ARGS_H
 
 #include "set_size_options.h"
+#include "trace_reader/trace_block.h"
 #include "trace_reader/trace_reader.h"
 #include <ctype.h>
 #include <getopt.h>
@@ -14,9 +15,20 @@ void handle_optional_args(int argc, char **argv, struct set_size_options *option
 
   static struct option long_options[] = {
       {"file", required_argument, 0, 'f'},
+      {"manifest", required_argument, 0, '+'},
       {"help", no_argument, 0, '`'},
       {"duration", required_argument, 0, 'd'},
+      {"start", required_argument, 0, '@'},
+      {"skip-ios", required_argument, 0, '['},
+      {"max-ios", required_argument, 0, ']'},
       {"sampling-rate", required_argument, 0, 's'},
+      {"block-size", required_argument, 0, '*'},
+      {"reads-only", no_argument, 0, '{'},
+      {"writes-only", no_argument, 0, '}'},
+      {"lba-range", required_argument, 0, '('},
+      {"time-window", required_argument, 0, ')'},
+      {"pid", required_argument, 0, '$'},
+      {"process", required_argument, 0, '&'},
       {0, 0, 0, 0},
   };
   int option_index = 0;
@@ -26,10 +38,10 @@ void handle_optional_args(int argc, char **argv, struct set_size_options *option
                           &option_index)) != -1) {
     switch (c) {
     case 'f':
-      options->fp = fopen(optarg, "r");
-      if (!options->fp) {
-        LOG_FATAL("File %s could not be opened. Errno = %d", optarg, errno);
-      }
+      trace_files_add(&options->files, optarg);
+      break;
+    case '+':
+      trace_files_add_manifest(&options->files, optarg);
       break;
     case '`':
       LOG_PRINT(
@@ -37,12 +49,41 @@ void handle_optional_args(int argc, char **argv, struct set_size_options *option
           "Find the size of the trace's working set.\n"
           "  TRACE_FORMAT     format of the trace being processed\n\n"
           "With no -f or --file OPTION, read standard input.\n\n"
-          "  -f, --file       file of TRACE_TYPE to open and simulate for\n"
+          "  -f, --file       file of TRACE_TYPE to open and simulate for.\n"
+          "                   Given several times, the files are read one\n"
+          "                   after the other as a single trace\n"
+          "      --manifest   file listing (one per line) trace files to\n"
+          "                   read as with -f\n"
           "  -d, --duration   amount of the trace, based on time, that\n"
           "                   is going to be processed\n"
           "                   Supported time designations:\n"
           "                     XXh   XX hours\n"
           "                     XXd   XX days\n"
+          "      --start      start the trace this long (as with --duration)\n"
+          "                   after its first request\n"
+          "      --skip-ios   skip the given number of requests from the\n"
+          "                   start of the trace\n"
+          "      --max-ios    read at most the given number of requests\n"
+          "      --block-size map the accesses of the trace onto cache\n"
+          "                   blocks of the given size in bytes (or KiB\n"
+          "                   with K, or MiB with M), accessing each cache\n"
+          "                   block a request touches once\n"
+          "      --reads-only only read the reads of the trace\n"
+          "      --writes-only\n"
+          "                   only read the writes of the trace\n"
+          "      --lba-range  FIRST-LAST, only read the accesses to the\n"
+          "                   addresses from FIRST to LAST (in the\n"
+          "                   addresses of the trace, such as sectors for\n"
+          "                   fiu or bytes for msr)\n"
+          "      --time-window\n"
+          "                   FROM-TO, only read the requests from FROM\n"
+          "                   to TO after the first request (in seconds,\n"
+          "                   or minutes, hours or days with m, h or d,\n"
+          "                   such as 30m-2h)\n"
+          "      --pid        only read the requests of the process of\n"
+          "                   the given pid (fiu and visa)\n"
+          "      --process    only read the requests of the processes\n"
+          "                   of the given name (fiu and visa)\n"
           "      --help       display this help and exit\n\n"
           "Examples:\n"
           "  ./set-size fiu\n"
@@ -62,6 +103,52 @@ void handle_optional_args(int argc, char **argv, struct set_size_options *option
         LOG_FATAL("Unknown duration time %c", duration_time);
       }
       break;
+    case '*':
+      if (trace_block_parse_size(optarg, &options->block_size)) {
+        LOG_FATAL("Block size given was not a size in bytes `%s`", optarg);
+      }
+      break;
+    case '@':
+      sscanf(optarg, "%u%c", &options->window.start_hrs, &duration_time);
+      switch (duration_time) {
+      case 'd':
+        options->window.start_hrs *= 24;
+      case 'h':
+        break;
+      default:
+        LOG_FATAL("Unknown start time %c", duration_time);
+      }
+      break;
+    case '[':
+      sscanf(optarg, "%lu", &options->window.skip_ios);
+      break;
+    case ']':
+      sscanf(optarg, "%lu", &options->window.max_ios);
+      break;
+    case '{':
+      options->filter.reads_only = true;
+      break;
+    case '}':
+      options->filter.writes_only = true;
+      break;
+    case '(':
+      if (trace_filter_parse_lba_range(&options->filter, optarg)) {
+        LOG_FATAL("Address range given was not FIRST-LAST `%s`", optarg);
+      }
+      break;
+    case ')':
+      if (trace_filter_parse_time_window(&options->filter, optarg)) {
+        LOG_FATAL("Time window given was not FROM-TO `%s`", optarg);
+      }
+      break;
+    case '$':
+      sscanf(optarg, "%u", &options->filter.pid_value);
+      options->filter.pid = true;
+      break;
+    case '&':
+      options->filter.process_value = trace_process_id(optarg, strlen(optarg));
+      options->filter.process = true;
+      break;
     case '?':
       if (isprint(optopt)) {
         LOG_FATAL("Unknown option `-%c`", optopt);
@@ -72,6 +159,15 @@ void handle_optional_args(int argc, char **argv, struct set_size_options *option
       LOG_FATAL("Should've expected the unknown unknown");
     }
   }
+
+  // a single file is read as it is, several are read through trace_multi
+  if (options->files.nr_paths == 1) {
+    options->fp = fopen(options->files.paths[0], "r");
+    if (!options->fp) {
+      LOG_FATAL("File %s could not be opened. Errno = %d",
+                options->files.paths[0], errno);
+    }
+  }
 }
 
 void handle_required_args(int argc, char **argv, struct set_size_options *options) {
@@ -1,6 +1,9 @@
 #ifndef WORKINGSET_SIZE_SET_SIZE_OPTIONS_H
 #define WORKINGSET_SIZE_SET_SIZE_OPTIONS_H
 
+#include "trace_reader/trace_filter.h"
+#include "trace_reader/trace_multi.h"
+#include "trace_reader/trace_window.h"
 #include "types.h"
 #include <stdio.h>
 
@@ -8,6 +11,15 @@ struct set_size_options {
   FILE *fp;
   char *trace_name;
   uint64_t duration_hrs;
+  // part of the trace to be read, if not all of it
+  struct trace_window window;
+  // requests of the trace to be read, if not all of them
+  struct trace_filter filter;
+  // trace files given, read one after the other when there are several
+  struct trace_files files;
+  // size in bytes of the cache blocks the trace's accesses are mapped onto
+  // (0 to simulate the trace's own blocks)
+  uint64_t block_size;
 };
 
 #endif /* WORKINGSET_SIZE_SET_SIZE_OPTIONS_H */
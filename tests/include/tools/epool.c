@@ -15,7 +15,8 @@ void test_epool_create(void) {
   struct entry_pool ep = {0};
   epool_create(&ep, len, struct test_entry, e);
 
-  TEST_ASSERT(!epool_empty(&ep));
+  // entries are only free once the pool is initialized
+  TEST_ASSERT(epool_empty(&ep));
   TEST_ASSERT_EQUAL_UINT(ep.nr_entries, len);
   TEST_ASSERT_EQUAL(((struct test_entry *)ep.entries_begin) + len,
                     ep.entries_end);
@@ -25,10 +26,12 @@ void test_epool_create(void) {
 
 void test_epool_at(void) {
   int len = 5;
+  int i;
   struct entry_pool ep = {0};
   epool_create(&ep, len, struct test_entry, e);
-  for (int i = 0; i < len; ++i) {
-    TEST_ASSERT_EQUAL(epool_at(&ep, i), ep.entries[i]);
+  for (i = 0; i < len; ++i) {
+    TEST_ASSERT_EQUAL(epool_at(&ep, i),
+                      &((struct test_entry *)ep.entries_begin)[i].e);
   }
   TEST_ASSERT_NULL(epool_at(&ep, len));
 
@@ -39,26 +42,26 @@ void test_epool_init(void) {
   int len = 5;
   struct entry_pool ep = {0};
   epool_create(&ep, len, struct test_entry, e);
-  epool_init(&ep);
+  epool_init(&ep, 0);
 
   TEST_ASSERT(!epool_empty(&ep));
   TEST_ASSERT_EQUAL_UINT(ep.nr_allocated, 0);
-  TEST_ASSERT_EQUAL(ep.free.next, &epool_at(&ep, ep.nr_entries - 1)->pool_list);
+  TEST_ASSERT_EQUAL_UINT(ep.free, ep.nr_entries - 1);
 
   epool_exit(&ep);
 }
 
 void test_alloc_entry(void) {
   int len = 5;
+  int i;
   struct entry_pool ep = {0};
   epool_create(&ep, len, struct test_entry, e);
-  epool_init(&ep);
+  epool_init(&ep, 0);
 
-  for (int i = 0; i < ep.nr_entries; ++i) {
+  for (i = 0; i < ep.nr_entries; ++i) {
     struct entry *e;
 
-    TEST_ASSERT_EQUAL(ep.free.next,
-                      &epool_at(&ep, ep.nr_entries - 1 - i)->pool_list);
+    TEST_ASSERT_EQUAL_UINT(ep.free, ep.nr_entries - 1 - i);
     e = alloc_entry(&ep);
     TEST_ASSERT_EQUAL_UINT(ep.nr_allocated, i + 1);
     TEST_ASSERT_NOT_NULL(e);
@@ -75,7 +78,7 @@ void test_alloc_particular_entry(void) {
   struct entry_pool ep = {0};
   struct entry *e;
   epool_create(&ep, len, struct test_entry, e);
-  epool_init(&ep);
+  epool_init(&ep, 0);
 
   e = alloc_particular_entry(&ep, len / 2);
   TEST_ASSERT_EQUAL_UINT(ep.nr_allocated, 1);
@@ -91,7 +94,7 @@ void test_epool_find(void) {
   struct entry_pool ep = {0};
   struct entry *e;
   epool_create(&ep, len, struct test_entry, e);
-  epool_init(&ep);
+  epool_init(&ep, 0);
 
   TEST_ASSERT_NULL(epool_find(&ep, len / 2));
   e = alloc_particular_entry(&ep, len / 2);
@@ -102,25 +105,27 @@ void test_epool_find(void) {
 
 void test_in_pool(void) {
   int len = 5;
+  int i;
   struct entry_pool ep = {0};
   epool_create(&ep, len, struct test_entry, e);
 
-  for (int i = 0; i < ep.nr_entries; ++i) {
+  for (i = 0; i < ep.nr_entries; ++i) {
     TEST_ASSERT(in_pool(&ep, epool_at(&ep, i)));
   }
 
   TEST_ASSERT_FALSE(in_pool(&ep, &len));
-  TEST_ASSERT_FALSE(in_pool(&ep, &ep.entries[ep.nr_entries]));
+  TEST_ASSERT_FALSE(in_pool(&ep, ep.entries_end));
 
   epool_exit(&ep);
 }
 
 void test_infer_cblock(void) {
   int len = 5;
+  int i;
   struct entry_pool ep = {0};
   epool_create(&ep, len, struct test_entry, e);
 
-  for (int i = 0; i < ep.nr_entries; ++i) {
+  for (i = 0; i < ep.nr_entries; ++i) {
     TEST_ASSERT_EQUAL_UINT(i, infer_cblock(&ep, epool_at(&ep, i)));
   }
 
@@ -132,7 +137,7 @@ void test_free_entry(void) {
   struct entry_pool ep = {0};
   struct entry *e;
   epool_create(&ep, len, struct test_entry, e);
-  epool_init(&ep);
+  epool_init(&ep, 0);
 
   e = alloc_entry(&ep);
   TEST_ASSERT_EQUAL_UINT(1, ep.nr_allocated);
@@ -141,6 +146,98 @@ void test_free_entry(void) {
   TEST_ASSERT_FALSE(e->allocated);
 }
 
+/** Check the free list of the pool is made of the entries at indices, in order
+ */
+static void check_free_list(struct entry_pool *ep, const uint32_t *indices,
+                            unsigned nr) {
+  uint32_t prev = IQUEUE_NIL;
+  uint32_t i = ep->free;
+  struct entry *e;
+  unsigned n;
+
+  for (n = 0; n < nr; ++n) {
+    TEST_ASSERT_EQUAL_UINT(indices[n], i);
+    e = epool_at(ep, i + ep->starting_index);
+    TEST_ASSERT_FALSE(e->allocated);
+    TEST_ASSERT_EQUAL_UINT(prev, e->wb_list.prev);
+    prev = i;
+    i = e->wb_list.next;
+  }
+  TEST_ASSERT_EQUAL_UINT(IQUEUE_NIL, i);
+}
+
+void test_free_entry_out_of_order(void) {
+  int len = 5;
+  int i;
+  struct entry_pool ep = {0};
+  struct entry *e[5];
+  uint32_t all[] = {4, 3, 2, 1, 0};
+  uint32_t freed[] = {3, 0, 4, 1};
+  uint32_t rest[] = {4};
+  epool_create(&ep, len, struct test_entry, e);
+  epool_init(&ep, 0);
+  check_free_list(&ep, all, len);
+
+  for (i = 0; i < len; ++i) {
+    e[i] = alloc_entry(&ep);
+  }
+  TEST_ASSERT(epool_empty(&ep));
+  check_free_list(&ep, NULL, 0);
+
+  // freed entries are pushed onto the head of the free list
+  free_entry(&ep, e[3]);
+  free_entry(&ep, e[0]);
+  free_entry(&ep, e[4]);
+  free_entry(&ep, e[1]);
+  TEST_ASSERT_EQUAL_UINT(1, ep.nr_allocated);
+  check_free_list(&ep, freed, 4);
+
+  // from the middle of the free list, then from its head
+  TEST_ASSERT_EQUAL(epool_at(&ep, 3), alloc_particular_entry(&ep, 3));
+  TEST_ASSERT_EQUAL(epool_at(&ep, 1), alloc_particular_entry(&ep, 1));
+  TEST_ASSERT_EQUAL(epool_at(&ep, 0), alloc_particular_entry(&ep, 0));
+  check_free_list(&ep, rest, 1);
+
+  TEST_ASSERT_EQUAL(epool_at(&ep, 4), alloc_entry(&ep));
+  TEST_ASSERT(epool_empty(&ep));
+  TEST_ASSERT_EQUAL_UINT(len, ep.nr_allocated);
+
+  epool_exit(&ep);
+}
+
+void test_epool_offset(void) {
+  int len = 5;
+  int i;
+  unsigned starting_index = 100;
+  struct entry_pool ep = {0};
+  struct test_entry *entries;
+  struct entry *e;
+  epool_create(&ep, len, struct test_entry, e);
+  epool_init(&ep, starting_index);
+  entries = (struct test_entry *)ep.entries_begin;
+
+  // the general entry isn't at the start of the policy-specific ones
+  TEST_ASSERT_EQUAL_UINT(offsetof(struct test_entry, e), ep.offset);
+  TEST_ASSERT(ep.offset > 0);
+  TEST_ASSERT_EQUAL_UINT(sizeof(struct test_entry), ep.stride);
+
+  for (i = 0; i < len; ++i) {
+    e = epool_at(&ep, starting_index + i);
+    TEST_ASSERT_EQUAL(&entries[i].e, e);
+    TEST_ASSERT_EQUAL_UINT(starting_index + i, infer_cblock(&ep, e));
+  }
+  TEST_ASSERT_NULL(epool_at(&ep, starting_index - 1));
+  TEST_ASSERT_NULL(epool_at(&ep, starting_index + len));
+
+  e = alloc_particular_entry(&ep, starting_index + 2);
+  TEST_ASSERT_EQUAL(&entries[2].e, e);
+  TEST_ASSERT_EQUAL(e, epool_find(&ep, starting_index + 2));
+  free_entry(&ep, e);
+  TEST_ASSERT_EQUAL_UINT(2, ep.free);
+
+  epool_exit(&ep);
+}
+
 int main(void) {
   UNITY_BEGIN();
   RUN_TEST(test_epool_create);
@@ -152,5 +249,7 @@ int main(void) {
   RUN_TEST(test_in_pool);
   RUN_TEST(test_infer_cblock);
   RUN_TEST(test_free_entry);
+  RUN_TEST(test_free_entry_out_of_order);
+  RUN_TEST(test_epool_offset);
   return UNITY_END();
 }
@@ -1,6 +1,31 @@
 #include "../src/include/tools/hashtable.h"
 #include "unity/unity.h"
 
+#define NR_TEST_ENTRIES 4096
+
+static struct entry entries[NR_TEST_ENTRIES];
+
+#ifdef HASHTABLE_CHAINED
+#define ht_size(ht) ((ht)->nr_buckets)
+#define ht_min_size(ht) ((ht)->min_buckets)
+#define ht_migrating(ht) ((ht)->old_table != NULL)
+#else
+#define ht_size(ht) ((ht)->table.nr_slots)
+#define ht_min_size(ht) ((ht)->min_slots)
+#define ht_migrating(ht) ((ht)->old.ctrl != NULL)
+#endif
+
+/** Check that entries from first to last are all in the hashtable
+ */
+static void check_entries(struct hashtable *ht, unsigned first,
+                          unsigned last) {
+  unsigned i;
+
+  for (i = first; i < last; i++) {
+    TEST_ASSERT_EQUAL_PTR(&entries[i], hash_lookup(ht, entries[i].oblock));
+  }
+}
+
 void test_next_power(void) {
   TEST_ASSERT_EQUAL_UINT(32, next_power(17, 16));
   TEST_ASSERT_EQUAL_UINT(64, next_power(33, 16));
@@ -9,8 +34,8 @@ void test_next_power(void) {
 void test_hash_init(void) {
   int size = 5;
   struct hashtable ht;
-  hash_init(&ht, size);
-  TEST_ASSERT_EQUAL_UINT(16, ht.nr_buckets);
+  TEST_ASSERT_EQUAL_INT(0, ht_init(&ht, size));
+  TEST_ASSERT_EQUAL_UINT(16, ht_size(&ht));
 
   hash_exit(&ht);
 }
@@ -20,7 +45,7 @@ void test_hash_insert_and_lookup(void) {
   struct hashtable ht;
   struct entry e;
   e.oblock = size;
-  hash_init(&ht, size);
+  ht_init(&ht, size);
   TEST_ASSERT_NULL(hash_lookup(&ht, size));
   hash_insert(&ht, &e);
   TEST_ASSERT_NOT_NULL(hash_lookup(&ht, size));
@@ -33,20 +58,239 @@ void test_hash_remove(void) {
   struct hashtable ht;
   struct entry e;
   e.oblock = size;
-  hash_init(&ht, size);
+  ht_init(&ht, size);
   hash_insert(&ht, &e);
   TEST_ASSERT_NOT_NULL(hash_lookup(&ht, size));
-  hash_remove(&e);
+  hash_remove(&ht, &e);
   TEST_ASSERT_NULL(hash_lookup(&ht, size));
 
   hash_exit(&ht);
 }
 
+void test_hash_grow(void) {
+  struct hashtable ht;
+  unsigned migrating = 0;
+  unsigned i;
+
+  TEST_ASSERT_EQUAL_INT(0, ht_init(&ht, 16));
+  for (i = 0; i < NR_TEST_ENTRIES; i++) {
+    entries[i].oblock = 7 * i + 1;
+  }
+
+  // everything stays reachable while the old table is being moved
+  for (i = 0; i < NR_TEST_ENTRIES; i++) {
+    hash_insert(&ht, &entries[i]);
+    if (ht_migrating(&ht)) {
+      ++migrating;
+    }
+    check_entries(&ht, 0, i + 1);
+    if (i + 1 < NR_TEST_ENTRIES) {
+      TEST_ASSERT_NULL(hash_lookup(&ht, entries[i + 1].oblock));
+    }
+  }
+  TEST_ASSERT(migrating > 0);
+  TEST_ASSERT(ht_size(&ht) >= NR_TEST_ENTRIES / 2);
+
+  hash_exit(&ht);
+}
+
+void test_hash_shrink(void) {
+  struct hashtable ht;
+  unsigned size;
+  unsigned min_size;
+  unsigned largest;
+  unsigned migrating = 0;
+  unsigned i;
+
+  TEST_ASSERT_EQUAL_INT(0, ht_init(&ht, 256));
+  min_size = ht_min_size(&ht);
+  TEST_ASSERT_EQUAL_UINT(min_size, ht_size(&ht));
+  for (i = 0; i < NR_TEST_ENTRIES; i++) {
+    entries[i].oblock = 7 * i + 1;
+    hash_insert(&ht, &entries[i]);
+  }
+  largest = ht_size(&ht);
+  TEST_ASSERT(largest > min_size);
+
+  // shrinks as entries are removed, but never below the size it started with
+  for (i = 0; i < NR_TEST_ENTRIES; i++) {
+    size = ht_size(&ht);
+    hash_remove(&ht, &entries[i]);
+    if (ht_migrating(&ht)) {
+      ++migrating;
+    }
+    TEST_ASSERT(ht_size(&ht) <= size);
+    TEST_ASSERT(ht_size(&ht) >= min_size);
+    TEST_ASSERT_NULL(hash_lookup(&ht, entries[i].oblock));
+    if (i % 16 == 0) {
+      check_entries(&ht, i + 1, NR_TEST_ENTRIES);
+    }
+  }
+  TEST_ASSERT(migrating > 0);
+  TEST_ASSERT(ht_size(&ht) < largest);
+
+  // and doesn't shrink any further once empty
+  for (i = 0; i < 64; i++) {
+    hash_insert(&ht, &entries[i]);
+  }
+  for (i = 0; i < 64; i++) {
+    hash_remove(&ht, &entries[i]);
+    TEST_ASSERT(ht_size(&ht) >= min_size);
+  }
+
+  hash_exit(&ht);
+}
+
+#ifndef HASHTABLE_CHAINED
+
+/** Fill entries from the first one with oblocks whose probes start at group g
+ * of t (from oblock 0 on)
+ */
+static void entries_of_group(const struct ht_table *t, unsigned g,
+                             unsigned nr) {
+  oblock_t oblock = 0;
+  unsigned i;
+
+  for (i = 0; i < nr; oblock++) {
+    if (__ht_group(t, __ht_hash(oblock)) == g) {
+      entries[i++].oblock = oblock;
+    }
+  }
+}
+
+/** Index of the slot of e in t
+ */
+static unsigned slot_of(const struct ht_table *t, struct entry *e) {
+  unsigned i;
+
+  for (i = 0; i < t->nr_slots; i++) {
+    if (t->slots[i] == e) {
+      return i;
+    }
+  }
+  TEST_FAIL_MESSAGE("entry not in the table");
+  return 0;
+}
+
+void test_hash_match(void) {
+  uint8_t ctrl[HT_GROUP_SIZE];
+  uint8_t values[] = {0, 1, 0x7f, HT_EMPTY, HT_DELETED};
+  unsigned expected;
+  unsigned expected_free;
+  unsigned i;
+  unsigned j;
+  unsigned n;
+
+  // every mix of values, checked against the scalar comparison
+  srand(1);
+  for (n = 0; n < 10000; n++) {
+    for (i = 0; i < HT_GROUP_SIZE; i++) {
+      ctrl[i] = values[rand() % sizeof(values)];
+    }
+    for (j = 0; j < sizeof(values); j++) {
+      expected = 0;
+      expected_free = 0;
+      for (i = 0; i < HT_GROUP_SIZE; i++) {
+        if (ctrl[i] == values[j]) {
+          expected |= 1u << i;
+        }
+        if (ctrl[i] == HT_EMPTY || ctrl[i] == HT_DELETED) {
+          expected_free |= 1u << i;
+        }
+      }
+      TEST_ASSERT_EQUAL_HEX(expected, __ht_match(ctrl, values[j]));
+      TEST_ASSERT_EQUAL_HEX(expected_free, __ht_match_free(ctrl));
+    }
+  }
+}
+
+void test_hash_deleted_reused(void) {
+  struct hashtable ht;
+  unsigned growth_left;
+  unsigned i;
+  unsigned slot;
+
+  // two groups, where a full group 0 spills over into group 1
+  TEST_ASSERT_EQUAL_INT(0, ht_init(&ht, 20));
+  TEST_ASSERT_EQUAL_UINT(2 * HT_GROUP_SIZE, ht.table.nr_slots);
+  entries_of_group(&ht.table, 0, HT_GROUP_SIZE + 2);
+  for (i = 0; i <= HT_GROUP_SIZE; i++) {
+    hash_insert(&ht, &entries[i]);
+  }
+  TEST_ASSERT_EQUAL_UINT(1, slot_of(&ht.table, &entries[HT_GROUP_SIZE]) /
+                                HT_GROUP_SIZE);
+
+  // the group being full, the removed entry's slot is deleted, not emptied
+  slot = slot_of(&ht.table, &entries[3]);
+  growth_left = ht.table.growth_left;
+  hash_remove(&ht, &entries[3]);
+  TEST_ASSERT_EQUAL_HEX8(HT_DELETED, ht.table.ctrl[slot]);
+  TEST_ASSERT_EQUAL_UINT(growth_left, ht.table.growth_left);
+  TEST_ASSERT_NULL(hash_lookup(&ht, entries[3].oblock));
+  // and probes go on past it into group 1
+  TEST_ASSERT_EQUAL_PTR(&entries[HT_GROUP_SIZE],
+                        hash_lookup(&ht, entries[HT_GROUP_SIZE].oblock));
+
+  // the next insert into group 0 takes the deleted slot
+  hash_insert(&ht, &entries[HT_GROUP_SIZE + 1]);
+  TEST_ASSERT_EQUAL_UINT(slot,
+                         slot_of(&ht.table, &entries[HT_GROUP_SIZE + 1]));
+  TEST_ASSERT_EQUAL_UINT(growth_left, ht.table.growth_left);
+  TEST_ASSERT_EQUAL_HEX8(__ht_h2(__ht_hash(entries[HT_GROUP_SIZE + 1].oblock)),
+                         ht.table.ctrl[slot]);
+  for (i = 0; i <= HT_GROUP_SIZE + 1; i++) {
+    if (i != 3) {
+      TEST_ASSERT_EQUAL_PTR(&entries[i], hash_lookup(&ht, entries[i].oblock));
+    }
+  }
+
+  hash_exit(&ht);
+}
+
+void test_hash_probe_wraps(void) {
+  struct hashtable ht;
+  unsigned last;
+  unsigned i;
+
+  // four groups, where a full last group spills over into group 0
+  TEST_ASSERT_EQUAL_INT(0, ht_init(&ht, 50));
+  TEST_ASSERT_EQUAL_UINT(4 * HT_GROUP_SIZE, ht.table.nr_slots);
+  last = ht.table.group_mask;
+  entries_of_group(&ht.table, last, HT_GROUP_SIZE + 2);
+  for (i = 0; i < HT_GROUP_SIZE + 2; i++) {
+    hash_insert(&ht, &entries[i]);
+  }
+  for (i = HT_GROUP_SIZE; i < HT_GROUP_SIZE + 2; i++) {
+    TEST_ASSERT_EQUAL_UINT(0, slot_of(&ht.table, &entries[i]) / HT_GROUP_SIZE);
+  }
+
+  for (i = 0; i < HT_GROUP_SIZE + 2; i++) {
+    TEST_ASSERT_EQUAL_PTR(&entries[i], hash_lookup(&ht, entries[i].oblock));
+  }
+
+  // removing one of the wrapped entries leaves the other reachable
+  hash_remove(&ht, &entries[HT_GROUP_SIZE]);
+  TEST_ASSERT_NULL(hash_lookup(&ht, entries[HT_GROUP_SIZE].oblock));
+  TEST_ASSERT_EQUAL_PTR(&entries[HT_GROUP_SIZE + 1],
+                        hash_lookup(&ht, entries[HT_GROUP_SIZE + 1].oblock));
+
+  hash_exit(&ht);
+}
+
+#endif /* HASHTABLE_CHAINED */
+
 int main(void) {
   UNITY_BEGIN();
   RUN_TEST(test_next_power);
   RUN_TEST(test_hash_init);
   RUN_TEST(test_hash_insert_and_lookup);
   RUN_TEST(test_hash_remove);
+  RUN_TEST(test_hash_grow);
+  RUN_TEST(test_hash_shrink);
+#ifndef HASHTABLE_CHAINED
+  RUN_TEST(test_hash_match);
+  RUN_TEST(test_hash_deleted_reused);
+  RUN_TEST(test_hash_probe_wraps);
+#endif
   return UNITY_END();
 }
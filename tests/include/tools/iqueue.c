@@ -0,0 +1,221 @@
+#include "../src/include/tools/iqueue.h"
+#include "unity/unity.h"
+#include <string.h>
+
+#define NR_ITEMS 5
+
+struct item {
+  unsigned value;
+  struct iqueue_head list;
+};
+
+static struct iqueue_set s;
+static struct item arr[NR_ITEMS];
+static struct item arr2[NR_ITEMS];
+
+void setUp(void) {
+  memset(arr, 0, sizeof(arr));
+  memset(arr2, 0, sizeof(arr2));
+  iqueue_set_init(&s, sizeof(struct item));
+  iqueue_set_add(&s, arr, NR_ITEMS);
+}
+
+/** Pop every item of q, checking they're items in order
+ */
+static void check_pop(struct iqueue *q, struct item **items, unsigned len) {
+  unsigned i;
+
+  for (i = 0; i < len; ++i) {
+    TEST_ASSERT_EQUAL_UINT(len - i, iqueue_length(q));
+    TEST_ASSERT_EQUAL(&items[i]->list, iqueue_pop(q));
+    TEST_ASSERT_EQUAL_UINT(0, items[i]->list.queue);
+  }
+  TEST_ASSERT_NULL(iqueue_pop(q));
+  TEST_ASSERT_EQUAL_UINT(IQUEUE_NIL, q->head);
+  TEST_ASSERT_EQUAL_UINT(IQUEUE_NIL, q->tail);
+}
+
+void test_iqueue_init(void) {
+  struct iqueue q;
+  iqueue_init(&q, &s, struct item, list);
+  TEST_ASSERT_EQUAL_UINT(iqueue_length(&q), 0);
+  TEST_ASSERT(iqueue_empty(&q));
+  TEST_ASSERT_EQUAL_UINT(1, q.id);
+  TEST_ASSERT_EQUAL_UINT(1, s.nr_queues);
+  TEST_ASSERT_EQUAL(&q, s.queues[0]);
+  TEST_ASSERT_NULL(iqueue_peek(&q));
+}
+
+void test_iqueue_push(void) {
+  struct iqueue q;
+  iqueue_init(&q, &s, struct item, list);
+  iqueue_push(&q, &arr[2].list);
+  TEST_ASSERT_EQUAL_UINT(iqueue_length(&q), 1);
+  TEST_ASSERT(!iqueue_empty(&q));
+  TEST_ASSERT_EQUAL_UINT(2, q.head);
+  TEST_ASSERT_EQUAL_UINT(2, q.tail);
+  TEST_ASSERT_EQUAL_UINT(q.id, arr[2].list.queue);
+  TEST_ASSERT_EQUAL(&arr[2].list, iqueue_peek(&q));
+
+  iqueue_push(&q, &arr[0].list);
+  TEST_ASSERT_EQUAL_UINT(2, q.head);
+  TEST_ASSERT_EQUAL_UINT(0, q.tail);
+  TEST_ASSERT_EQUAL_UINT(0, arr[2].list.next);
+  TEST_ASSERT_EQUAL_UINT(2, arr[0].list.prev);
+  TEST_ASSERT_EQUAL_UINT(IQUEUE_NIL, arr[0].list.next);
+  TEST_ASSERT_EQUAL(&arr[0].list, iqueue_next(&q, &arr[2].list));
+  TEST_ASSERT_NULL(iqueue_next(&q, &arr[0].list));
+}
+
+void test_iqueue_remove(void) {
+  struct iqueue q;
+  struct item *items[] = {&arr[0], &arr[2]};
+  iqueue_init(&q, &s, struct item, list);
+  iqueue_push(&q, &arr[0].list);
+  iqueue_push(&q, &arr[1].list);
+  iqueue_push(&q, &arr[2].list);
+
+  iqueue_remove(&s, &arr[1].list);
+  TEST_ASSERT_EQUAL_UINT(iqueue_length(&q), 2);
+  TEST_ASSERT_EQUAL_UINT(0, arr[1].list.queue);
+  TEST_ASSERT_EQUAL_UINT(2, arr[0].list.next);
+  TEST_ASSERT_EQUAL_UINT(0, arr[2].list.prev);
+
+  // items in no queue are left alone
+  iqueue_remove(&s, &arr[1].list);
+  TEST_ASSERT_EQUAL_UINT(iqueue_length(&q), 2);
+
+  check_pop(&q, items, 2);
+  TEST_ASSERT(iqueue_empty(&q));
+}
+
+void test_iqueue_pop(void) {
+  struct iqueue q;
+  struct item *items[NR_ITEMS];
+  int i;
+  iqueue_init(&q, &s, struct item, list);
+
+  TEST_ASSERT_NULL(iqueue_pop(&q));
+
+  for (i = 0; i < NR_ITEMS; ++i) {
+    items[i] = &arr[NR_ITEMS - 1 - i];
+    iqueue_push(&q, &items[i]->list);
+  }
+  check_pop(&q, items, NR_ITEMS);
+}
+
+void test_iqueue_in_iqueue(void) {
+  struct iqueue q;
+  struct iqueue q2;
+  iqueue_init(&q, &s, struct item, list);
+  iqueue_init(&q2, &s, struct item, list);
+  iqueue_push(&q, &arr[0].list);
+
+  TEST_ASSERT_TRUE(in_iqueue(&q, &arr[0].list));
+  TEST_ASSERT_FALSE(in_iqueue(&q2, &arr[0].list));
+  TEST_ASSERT_FALSE(in_iqueue(&q, &arr[1].list));
+}
+
+void test_iqueue_swap(void) {
+  struct iqueue q;
+  struct item *items[] = {&arr[2], &arr[1], &arr[0]};
+  iqueue_init(&q, &s, struct item, list);
+  iqueue_push(&q, &arr[0].list);
+  iqueue_push(&q, &arr[1].list);
+  iqueue_push(&q, &arr[2].list);
+
+  iqueue_swap(&s, &arr[0].list, &arr[2].list);
+
+  check_pop(&q, items, 3);
+}
+
+void test_iqueue_swap_adjacent(void) {
+  struct iqueue q;
+  struct item *items[] = {&arr[1], &arr[2], &arr[0]};
+  iqueue_init(&q, &s, struct item, list);
+  iqueue_push(&q, &arr[0].list);
+  iqueue_push(&q, &arr[1].list);
+  iqueue_push(&q, &arr[2].list);
+
+  // head and the item after it: 1 0 2
+  iqueue_swap(&s, &arr[0].list, &arr[1].list);
+  TEST_ASSERT_EQUAL_UINT(1, q.head);
+  TEST_ASSERT_EQUAL_UINT(0, arr[1].list.next);
+  TEST_ASSERT_EQUAL_UINT(1, arr[0].list.prev);
+  // tail and the item before it, given the other way around: 1 2 0
+  iqueue_swap(&s, &arr[2].list, &arr[0].list);
+  TEST_ASSERT_EQUAL_UINT(0, q.tail);
+  TEST_ASSERT_EQUAL_UINT(2, arr[0].list.prev);
+  TEST_ASSERT_EQUAL_UINT(0, arr[2].list.next);
+
+  check_pop(&q, items, 3);
+}
+
+void test_iqueue_swap_queues(void) {
+  struct iqueue q;
+  struct iqueue q2;
+  struct item *items2[] = {&arr[1], &arr[3]};
+  struct item *items3[] = {&arr[4], &arr[2]};
+  iqueue_init(&q, &s, struct item, list);
+  iqueue_init(&q2, &s, struct item, list);
+  iqueue_push(&q, &arr[0].list);
+  iqueue_push(&q, &arr[1].list);
+  iqueue_push(&q2, &arr[2].list);
+  iqueue_push(&q2, &arr[3].list);
+
+  iqueue_swap(&s, &arr[1].list, &arr[2].list);
+  TEST_ASSERT_TRUE(in_iqueue(&q, &arr[2].list));
+  TEST_ASSERT_TRUE(in_iqueue(&q2, &arr[1].list));
+  TEST_ASSERT_EQUAL_UINT(2, q.tail);
+  TEST_ASSERT_EQUAL_UINT(1, q2.head);
+  TEST_ASSERT_EQUAL_UINT(iqueue_length(&q), 2);
+  TEST_ASSERT_EQUAL_UINT(iqueue_length(&q2), 2);
+  check_pop(&q2, items2, 2);
+
+  // with an item in no queue
+  iqueue_swap(&s, &arr[4].list, &arr[0].list);
+  TEST_ASSERT_EQUAL_UINT(0, arr[0].list.queue);
+  TEST_ASSERT_EQUAL_UINT(4, q.head);
+  check_pop(&q, items3, 2);
+}
+
+void test_iqueue_two_pools(void) {
+  struct iqueue q;
+  struct item *items[] = {&arr2[1], &arr[1], &arr2[0]};
+  iqueue_set_add(&s, arr2, NR_ITEMS);
+  TEST_ASSERT_EQUAL_UINT(0, s.first[0]);
+  TEST_ASSERT_EQUAL_UINT(NR_ITEMS, s.first[1]);
+  iqueue_init(&q, &s, struct item, list);
+
+  iqueue_push(&q, &arr2[1].list);
+  iqueue_push(&q, &arr[3].list);
+  iqueue_push(&q, &arr2[0].list);
+  TEST_ASSERT_EQUAL_UINT(NR_ITEMS + 1, q.head);
+  TEST_ASSERT_EQUAL_UINT(NR_ITEMS, q.tail);
+  TEST_ASSERT_EQUAL_UINT(3, arr2[1].list.next);
+  TEST_ASSERT_EQUAL_UINT(NR_ITEMS, arr[3].list.next);
+  TEST_ASSERT_EQUAL(&arr[3].list, iqueue_next(&q, iqueue_peek(&q)));
+  TEST_ASSERT_EQUAL(&arr2[0].list, iqueue_next(&q, &arr[3].list));
+
+  // moving an item from one pool to the other
+  iqueue_swap(&s, &arr[3].list, &arr[1].list);
+  TEST_ASSERT_EQUAL_UINT(0, arr[3].list.queue);
+  TEST_ASSERT_EQUAL_UINT(1, arr2[1].list.next);
+  TEST_ASSERT_EQUAL_UINT(1, arr2[0].list.prev);
+
+  check_pop(&q, items, 3);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_iqueue_init);
+  RUN_TEST(test_iqueue_push);
+  RUN_TEST(test_iqueue_remove);
+  RUN_TEST(test_iqueue_pop);
+  RUN_TEST(test_iqueue_in_iqueue);
+  RUN_TEST(test_iqueue_swap);
+  RUN_TEST(test_iqueue_swap_adjacent);
+  RUN_TEST(test_iqueue_swap_queues);
+  RUN_TEST(test_iqueue_two_pools);
+  return UNITY_END();
+}
@@ -1,122 +1,182 @@
 #include "include/writeback_tracker.h"
 #include "unity/unity.h"
+#include <string.h>
+
+#define NR_CACHE 4
+#define NR_META 2
+
+struct test_entry {
+  int filler;
+  struct entry e;
+};
+
+static struct cache_nucleus bp;
+
+void setUp(void) {
+  memset(&bp, 0, sizeof(bp));
+  epool_create(&bp.cache_pool, NR_CACHE, struct test_entry, e);
+  epool_init(&bp.cache_pool, 0);
+  epool_create(&bp.meta_pool, NR_META, struct test_entry, e);
+  epool_init(&bp.meta_pool, NR_CACHE);
+}
+
+void tearDown(void) {
+  epool_exit(&bp.cache_pool);
+  epool_exit(&bp.meta_pool);
+}
 
 void test_wb_init(void) {
   struct writeback_tracker wb;
-  wb_init(&wb);
-  TEST_ASSERT_EQUAL_UINT(0, queue_length(&wb.clean));
-  TEST_ASSERT_EQUAL_UINT(0, queue_length(&wb.dirty));
-  TEST_ASSERT_EQUAL_UINT(0, queue_length(&wb.meta));
+  wb_init(&wb, &bp);
+  TEST_ASSERT_EQUAL_UINT(0, iqueue_length(&wb.clean));
+  TEST_ASSERT_EQUAL_UINT(0, iqueue_length(&wb.dirty));
+  TEST_ASSERT_EQUAL_UINT(0, iqueue_length(&wb.meta));
+  TEST_ASSERT_EQUAL(&wb.queues, bp.wb_queues);
+  TEST_ASSERT_EQUAL_UINT(2, wb.queues.nr_pools);
+  TEST_ASSERT_EQUAL_UINT(NR_CACHE, wb.queues.first[1]);
 }
 
 void test_wb_push_cache_clean(void) {
-  struct entry e;
+  struct entry *e = alloc_entry(&bp.cache_pool);
   struct writeback_tracker wb;
-  wb_init(&wb);
+  wb_init(&wb, &bp);
 
-  e.dirty = false;
-  wb_push_cache(&wb, &e);
-  TEST_ASSERT_EQUAL_UINT(1, queue_length(&wb.clean));
-  TEST_ASSERT_EQUAL_UINT(0, queue_length(&wb.dirty));
-  TEST_ASSERT_EQUAL_UINT(0, queue_length(&wb.meta));
+  e->dirty = false;
+  wb_push_cache(&wb, e);
+  TEST_ASSERT_EQUAL_UINT(1, iqueue_length(&wb.clean));
+  TEST_ASSERT_EQUAL_UINT(0, iqueue_length(&wb.dirty));
+  TEST_ASSERT_EQUAL_UINT(0, iqueue_length(&wb.meta));
 }
 
 void test_wb_push_cache_dirty(void) {
-  struct entry e;
+  struct entry *e = alloc_entry(&bp.cache_pool);
   struct writeback_tracker wb;
-  wb_init(&wb);
+  wb_init(&wb, &bp);
 
-  e.dirty = true;
-  wb_push_cache(&wb, &e);
-  TEST_ASSERT_EQUAL_UINT(0, queue_length(&wb.clean));
-  TEST_ASSERT_EQUAL_UINT(1, queue_length(&wb.dirty));
-  TEST_ASSERT_EQUAL_UINT(0, queue_length(&wb.meta));
+  e->dirty = true;
+  wb_push_cache(&wb, e);
+  TEST_ASSERT_EQUAL_UINT(0, iqueue_length(&wb.clean));
+  TEST_ASSERT_EQUAL_UINT(1, iqueue_length(&wb.dirty));
+  TEST_ASSERT_EQUAL_UINT(0, iqueue_length(&wb.meta));
 }
 
 void test_wb_push_meta(void) {
-  struct entry e;
+  struct entry *e = alloc_entry(&bp.meta_pool);
   struct writeback_tracker wb;
-  wb_init(&wb);
+  wb_init(&wb, &bp);
 
-  wb_push_meta(&wb, &e);
-  TEST_ASSERT_EQUAL_UINT(0, queue_length(&wb.clean));
-  TEST_ASSERT_EQUAL_UINT(0, queue_length(&wb.dirty));
-  TEST_ASSERT_EQUAL_UINT(1, queue_length(&wb.meta));
+  wb_push_meta(&wb, e);
+  TEST_ASSERT_EQUAL_UINT(0, iqueue_length(&wb.clean));
+  TEST_ASSERT_EQUAL_UINT(0, iqueue_length(&wb.dirty));
+  TEST_ASSERT_EQUAL_UINT(1, iqueue_length(&wb.meta));
+  TEST_ASSERT_EQUAL_UINT(NR_CACHE + NR_META - 1, wb.meta.head);
 }
 
 void test_wb_remove_clean(void) {
-  struct entry e;
+  struct entry *e = alloc_entry(&bp.cache_pool);
   struct writeback_tracker wb;
-  wb_init(&wb);
+  wb_init(&wb, &bp);
 
-  e.dirty = false;
-  wb_push_cache(&wb, &e);
-  TEST_ASSERT_EQUAL_UINT(1, queue_length(&wb.clean));
-  wb_remove(&e);
-  TEST_ASSERT_EQUAL_UINT(0, queue_length(&wb.clean));
+  e->dirty = false;
+  wb_push_cache(&wb, e);
+  TEST_ASSERT_EQUAL_UINT(1, iqueue_length(&wb.clean));
+  wb_remove(&wb, e);
+  TEST_ASSERT_EQUAL_UINT(0, iqueue_length(&wb.clean));
 }
 
 void test_wb_remove_dirty(void) {
-  struct entry e;
+  struct entry *e = alloc_entry(&bp.cache_pool);
   struct writeback_tracker wb;
-  wb_init(&wb);
+  wb_init(&wb, &bp);
 
-  e.dirty = true;
-  wb_push_cache(&wb, &e);
-  TEST_ASSERT_EQUAL_UINT(1, queue_length(&wb.dirty));
-  wb_remove(&e);
-  TEST_ASSERT_EQUAL_UINT(0, queue_length(&wb.dirty));
+  e->dirty = true;
+  wb_push_cache(&wb, e);
+  TEST_ASSERT_EQUAL_UINT(1, iqueue_length(&wb.dirty));
+  wb_remove(&wb, e);
+  TEST_ASSERT_EQUAL_UINT(0, iqueue_length(&wb.dirty));
 }
 
 void test_wb_remove_meta(void) {
-  struct entry e;
+  struct entry *e = alloc_entry(&bp.meta_pool);
   struct writeback_tracker wb;
-  wb_init(&wb);
+  wb_init(&wb, &bp);
 
-  wb_push_meta(&wb, &e);
-  TEST_ASSERT_EQUAL_UINT(1, queue_length(&wb.meta));
-  wb_remove(&e);
-  TEST_ASSERT_EQUAL_UINT(0, queue_length(&wb.meta));
+  wb_push_meta(&wb, e);
+  TEST_ASSERT_EQUAL_UINT(1, iqueue_length(&wb.meta));
+  wb_remove(&wb, e);
+  TEST_ASSERT_EQUAL_UINT(0, iqueue_length(&wb.meta));
+  free_entry(&bp.meta_pool, e);
 }
 
 void test_wb_pop_dirty(void) {
   struct entry *popped;
-  struct entry e, f, g;
+  struct entry *e = alloc_entry(&bp.cache_pool);
+  struct entry *f = alloc_entry(&bp.cache_pool);
+  struct entry *g = alloc_entry(&bp.cache_pool);
   struct writeback_tracker wb;
-  wb_init(&wb);
+  wb_init(&wb, &bp);
 
-  e.dirty = true;
-  f.dirty = true;
-  g.dirty = false;
-  wb_push_cache(&wb, &e);
-  wb_push_cache(&wb, &f);
-  wb_push_cache(&wb, &g);
-  TEST_ASSERT_EQUAL_UINT(1, queue_length(&wb.clean));
-  TEST_ASSERT_EQUAL_UINT(2, queue_length(&wb.dirty));
+  e->dirty = true;
+  f->dirty = true;
+  g->dirty = false;
+  wb_push_cache(&wb, e);
+  wb_push_cache(&wb, f);
+  wb_push_cache(&wb, g);
+  TEST_ASSERT_EQUAL_UINT(1, iqueue_length(&wb.clean));
+  TEST_ASSERT_EQUAL_UINT(2, iqueue_length(&wb.dirty));
 
   popped = wb_pop_dirty(&wb);
   TEST_ASSERT_NOT_NULL(popped);
   TEST_ASSERT_TRUE(popped->dirty);
-  TEST_ASSERT_EQUAL(&e, popped);
-  TEST_ASSERT_EQUAL_UINT(1, queue_length(&wb.clean));
-  TEST_ASSERT_EQUAL_UINT(1, queue_length(&wb.dirty));
+  TEST_ASSERT_EQUAL(e, popped);
+  TEST_ASSERT_EQUAL_UINT(1, iqueue_length(&wb.clean));
+  TEST_ASSERT_EQUAL_UINT(1, iqueue_length(&wb.dirty));
 
   popped->dirty = false;
   wb_push_cache(&wb, popped);
-  TEST_ASSERT_EQUAL_UINT(2, queue_length(&wb.clean));
-  TEST_ASSERT_EQUAL_UINT(1, queue_length(&wb.dirty));
+  TEST_ASSERT_EQUAL_UINT(2, iqueue_length(&wb.clean));
+  TEST_ASSERT_EQUAL_UINT(1, iqueue_length(&wb.dirty));
 
   popped = wb_pop_dirty(&wb);
   TEST_ASSERT_NOT_NULL(popped);
   TEST_ASSERT_TRUE(popped->dirty);
-  TEST_ASSERT_EQUAL(&f, popped);
-  TEST_ASSERT_EQUAL_UINT(2, queue_length(&wb.clean));
-  TEST_ASSERT_EQUAL_UINT(0, queue_length(&wb.dirty));
+  TEST_ASSERT_EQUAL(f, popped);
+  TEST_ASSERT_EQUAL_UINT(2, iqueue_length(&wb.clean));
+  TEST_ASSERT_EQUAL_UINT(0, iqueue_length(&wb.dirty));
 
   popped = wb_pop_dirty(&wb);
   TEST_ASSERT_NULL(popped);
 }
 
+void test_wb_flags_kept(void) {
+  struct entry *e = alloc_entry(&bp.cache_pool);
+  struct entry *f = alloc_entry(&bp.cache_pool);
+  struct writeback_tracker wb;
+  wb_init(&wb, &bp);
+
+  // the flags share a word with the id of the queue
+  e->dirty = true;
+  e->migrating = true;
+  f->dirty = false;
+  wb_push_cache(&wb, e);
+  wb_push_cache(&wb, f);
+  iqueue_swap(&wb.queues, &e->wb_list, &f->wb_list);
+  TEST_ASSERT_TRUE(in_iqueue(&wb.clean, &e->wb_list));
+  TEST_ASSERT_TRUE(in_iqueue(&wb.dirty, &f->wb_list));
+  TEST_ASSERT_TRUE(e->dirty);
+  TEST_ASSERT_TRUE(e->allocated);
+  TEST_ASSERT_TRUE(e->migrating);
+  TEST_ASSERT_FALSE(f->dirty);
+  TEST_ASSERT_TRUE(f->allocated);
+  TEST_ASSERT_FALSE(f->migrating);
+
+  wb_remove(&wb, e);
+  TEST_ASSERT_EQUAL_UINT(0, e->wb_list.queue);
+  TEST_ASSERT_TRUE(e->dirty);
+  TEST_ASSERT_TRUE(e->allocated);
+  TEST_ASSERT_TRUE(e->migrating);
+}
+
 int main(void) {
   UNITY_BEGIN();
   RUN_TEST(test_wb_init);
@@ -127,5 +187,6 @@ int main(void) {
   RUN_TEST(test_wb_remove_dirty);
   RUN_TEST(test_wb_remove_meta);
   RUN_TEST(test_wb_pop_dirty);
+  RUN_TEST(test_wb_flags_kept);
   return UNITY_END();
 }
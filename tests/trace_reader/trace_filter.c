@@ -0,0 +1,227 @@
+#include "trace_reader/trace_filter.h"
+#include "unity/unity.h"
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define TEST_STRIDE 8
+#define TEST_SECOND 1000000000ULL
+
+/** array_trace
+ * Trace of the requests of an array, for feeding the trace_filter
+ */
+struct array_trace {
+  struct trace_reader reader;
+  const struct trace_request *requests;
+  unsigned nr;
+  unsigned pos;
+  bool exited;
+};
+
+static int array_trace_read_request(struct trace_reader *reader,
+                                    struct trace_request *request) {
+  struct array_trace *t = container_of(reader, struct array_trace, reader);
+
+  if (t->pos == t->nr) {
+    reader->eof = true;
+    return 1;
+  }
+  *request = t->requests[t->pos++];
+  return 0;
+}
+
+static void array_trace_exit(struct trace_reader *reader) {
+  container_of(reader, struct array_trace, reader)->exited = true;
+}
+
+static void array_trace_init(struct array_trace *t,
+                             const struct trace_request *requests,
+                             unsigned nr) {
+  memset(t, 0, sizeof(*t));
+  t->reader.block_stride = TEST_STRIDE;
+  t->reader.sampling_rate = 1;
+  t->reader.read_request = array_trace_read_request;
+  t->reader.exit = array_trace_exit;
+  t->requests = requests;
+  t->nr = nr;
+}
+
+static const struct trace_request test_requests[] = {
+    {0, 4, false, 0, 0, 0, 0},
+    {96, 8, true, 1 * TEST_SECOND, 0, 0, 0},
+    {1000, 1, false, 2 * TEST_SECOND, 0, 0, 0},
+    {200, 2, true, 3 * TEST_SECOND, 0, 0, 0},
+    {60, 10, false, 4 * TEST_SECOND, 0, 0, 0},
+    {8, 1, true, 5 * TEST_SECOND, 0, 0, 0},
+};
+
+#define TEST_NR_REQUESTS (sizeof(test_requests) / sizeof(*test_requests))
+
+void test_trace_filter_used(void) {
+  struct trace_filter filter;
+
+  memset(&filter, 0, sizeof(filter));
+  TEST_ASSERT_FALSE(trace_filter_used(&filter));
+  TEST_ASSERT_EQUAL_INT(0, trace_filter_parse_lba_range(&filter, "1-2"));
+  TEST_ASSERT(trace_filter_used(&filter));
+}
+
+void test_trace_filter_parse(void) {
+  struct trace_filter filter;
+
+  memset(&filter, 0, sizeof(filter));
+  TEST_ASSERT_NOT_EQUAL(0, trace_filter_parse_lba_range(&filter, "2-1"));
+  TEST_ASSERT_NOT_EQUAL(0, trace_filter_parse_lba_range(&filter, "1-2x"));
+  TEST_ASSERT_EQUAL_INT(0, trace_filter_parse_lba_range(&filter, "10-20"));
+  TEST_ASSERT_EQUAL_UINT64(10, filter.first_lba);
+  TEST_ASSERT_EQUAL_UINT64(20, filter.last_lba);
+
+  TEST_ASSERT_NOT_EQUAL(0, trace_filter_parse_time_window(&filter, "2h-1h"));
+  TEST_ASSERT_NOT_EQUAL(0, trace_filter_parse_time_window(&filter, "1m"));
+  TEST_ASSERT_EQUAL_INT(0, trace_filter_parse_time_window(&filter, "30m-2h"));
+  TEST_ASSERT_EQUAL_UINT64(30 * 60 * TEST_SECOND, filter.time_from);
+  TEST_ASSERT_EQUAL_UINT64(2 * 60 * 60 * TEST_SECOND, filter.time_to);
+}
+
+void test_trace_filter_lba_range(void) {
+  struct array_trace t;
+  struct trace_filter filter;
+  struct trace_reader *reader;
+  struct trace_request r;
+
+  memset(&filter, 0, sizeof(filter));
+  filter.lba_range = true;
+  filter.first_lba = 100;
+  filter.last_lba = 203;
+  array_trace_init(&t, test_requests, TEST_NR_REQUESTS);
+  reader = trace_filter_create(&t.reader, &filter);
+  TEST_ASSERT_NOT_NULL(reader);
+
+  // 96 to 152 straddles first_lba, cut to its accesses from 104
+  TEST_ASSERT_EQUAL_INT(0, reader->read_request(reader, &r));
+  TEST_ASSERT_EQUAL_UINT64(104, r.oblock);
+  TEST_ASSERT_EQUAL_UINT64(7, r.nr_blocks);
+  TEST_ASSERT(r.write);
+  // 200 to 208 straddles last_lba, cut to its access at 200
+  TEST_ASSERT_EQUAL_INT(0, reader->read_request(reader, &r));
+  TEST_ASSERT_EQUAL_UINT64(200, r.oblock);
+  TEST_ASSERT_EQUAL_UINT64(1, r.nr_blocks);
+  // 60 to 132 straddles first_lba, cut to its accesses from 100 to 132
+  TEST_ASSERT_EQUAL_INT(0, reader->read_request(reader, &r));
+  TEST_ASSERT_EQUAL_UINT64(100, r.oblock);
+  TEST_ASSERT_EQUAL_UINT64(5, r.nr_blocks);
+
+  TEST_ASSERT_NOT_EQUAL(0, reader->read_request(reader, &r));
+  TEST_ASSERT(reader->eof);
+
+  reader->exit(reader);
+  TEST_ASSERT(t.exited);
+}
+
+void test_trace_filter_lba_range_between_accesses(void) {
+  struct array_trace t;
+  struct trace_filter filter;
+  struct trace_reader *reader;
+  struct trace_request r;
+
+  // only addresses between the accesses of the request at 60
+  memset(&filter, 0, sizeof(filter));
+  filter.lba_range = true;
+  filter.first_lba = 61;
+  filter.last_lba = 63;
+  array_trace_init(&t, test_requests + 4, 1);
+  reader = trace_filter_create(&t.reader, &filter);
+  TEST_ASSERT_NOT_NULL(reader);
+
+  TEST_ASSERT_NOT_EQUAL(0, reader->read_request(reader, &r));
+  TEST_ASSERT(reader->eof);
+  reader->exit(reader);
+}
+
+void test_trace_filter_time_window(void) {
+  struct array_trace t;
+  struct trace_filter filter;
+  struct trace_reader *reader;
+  struct trace_request r;
+
+  memset(&filter, 0, sizeof(filter));
+  filter.time_window = true;
+  filter.time_from = 1 * TEST_SECOND;
+  filter.time_to = 3 * TEST_SECOND;
+  array_trace_init(&t, test_requests, TEST_NR_REQUESTS);
+  reader = trace_filter_create(&t.reader, &filter);
+  TEST_ASSERT_NOT_NULL(reader);
+
+  TEST_ASSERT_EQUAL_INT(0, reader->read_request(reader, &r));
+  TEST_ASSERT_EQUAL_UINT64(1 * TEST_SECOND, r.ts);
+  TEST_ASSERT_EQUAL_INT(0, reader->read_request(reader, &r));
+  TEST_ASSERT_EQUAL_UINT64(2 * TEST_SECOND, r.ts);
+
+  // the trace ends at the request at time_to, without reading any further
+  TEST_ASSERT_NOT_EQUAL(0, reader->read_request(reader, &r));
+  TEST_ASSERT_FALSE(reader->eof);
+  TEST_ASSERT_EQUAL_UINT(4, t.pos);
+  TEST_ASSERT_NOT_EQUAL(0, reader->read_request(reader, &r));
+  TEST_ASSERT_EQUAL_UINT(4, t.pos);
+
+  reader->exit(reader);
+}
+
+void test_trace_filter_reads_only(void) {
+  struct array_trace t;
+  struct trace_filter filter;
+  struct trace_reader *reader;
+  struct trace_request r;
+  unsigned nr = 0;
+
+  memset(&filter, 0, sizeof(filter));
+  filter.reads_only = true;
+  array_trace_init(&t, test_requests, TEST_NR_REQUESTS);
+  reader = trace_filter_create(&t.reader, &filter);
+  TEST_ASSERT_NOT_NULL(reader);
+
+  while (reader->read_request(reader, &r) == 0) {
+    TEST_ASSERT_FALSE(r.write);
+    ++nr;
+  }
+  TEST_ASSERT_EQUAL_UINT(3, nr);
+  TEST_ASSERT(reader->eof);
+
+  reader->exit(reader);
+}
+
+void test_trace_filter_reads_and_writes_only(void) {
+  struct array_trace t;
+  struct trace_filter filter;
+  int status;
+  pid_t pid;
+
+  memset(&filter, 0, sizeof(filter));
+  filter.reads_only = true;
+  filter.writes_only = true;
+  array_trace_init(&t, test_requests, TEST_NR_REQUESTS);
+
+  // fatal, so the reader is created in a child process
+  pid = fork();
+  TEST_ASSERT(pid >= 0);
+  if (pid == 0) {
+    freopen("/dev/null", "w", stderr);
+    trace_filter_create(&t.reader, &filter);
+    _exit(0);
+  }
+  TEST_ASSERT_EQUAL_INT(pid, waitpid(pid, &status, 0));
+  TEST_ASSERT(WIFSIGNALED(status));
+  TEST_ASSERT_EQUAL_INT(SIGABRT, WTERMSIG(status));
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_trace_filter_used);
+  RUN_TEST(test_trace_filter_parse);
+  RUN_TEST(test_trace_filter_lba_range);
+  RUN_TEST(test_trace_filter_lba_range_between_accesses);
+  RUN_TEST(test_trace_filter_time_window);
+  RUN_TEST(test_trace_filter_reads_only);
+  RUN_TEST(test_trace_filter_reads_and_writes_only);
+  return UNITY_END();
+}
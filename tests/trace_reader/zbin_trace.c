@@ -0,0 +1,112 @@
+#include "trace_reader/bin_trace_writer.h"
+#include "trace_reader/zbin_trace.h"
+#include "unity/unity.h"
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TEST_STRIDE 8
+#define TEST_NR_RUNS 40000
+
+static char path[] = "/tmp/zbin_trace_testXXXXXX";
+
+/** Write the requests to a zbin trace at path, read it back, and check every
+ * request read matches the one written
+ */
+static void round_trip(struct trace_request *requests, uint64_t nr) {
+  struct bin_trace_writer w;
+  struct trace_reader *reader;
+  struct trace_request r;
+  FILE *file;
+  uint64_t i;
+
+  file = fopen(path, "wb");
+  TEST_ASSERT_NOT_NULL(file);
+  bin_trace_writer_init(&w, file, TEST_STRIDE, 0, 1, true);
+  for (i = 0; i < nr; i++) {
+    bin_trace_writer_add(&w, requests[i].oblock, requests[i].nr_blocks,
+                         requests[i].ts, requests[i].write);
+  }
+  bin_trace_writer_close(&w);
+
+  file = fopen(path, "rb");
+  TEST_ASSERT_NOT_NULL(file);
+  reader = zbin_trace_create(file, 0);
+  TEST_ASSERT_NOT_NULL(reader);
+  TEST_ASSERT_EQUAL_UINT64(TEST_STRIDE, reader->block_stride);
+
+  for (i = 0; i < nr; i++) {
+    TEST_ASSERT_EQUAL_INT(0, reader->read_request(reader, &r));
+    TEST_ASSERT_EQUAL_UINT64(requests[i].oblock, r.oblock);
+    TEST_ASSERT_EQUAL_UINT64(requests[i].nr_blocks, r.nr_blocks);
+    TEST_ASSERT_EQUAL_UINT64(requests[i].ts, r.ts);
+    TEST_ASSERT_EQUAL(requests[i].write, r.write);
+  }
+  TEST_ASSERT_NOT_EQUAL(0, reader->read_request(reader, &r));
+  TEST_ASSERT(reader->eof);
+
+  reader->exit(reader);
+  fclose(file);
+}
+
+void setUp(void) {
+  int fd = mkstemp(path);
+  TEST_ASSERT(fd >= 0);
+  close(fd);
+}
+
+void tearDown(void) {
+  unlink(path);
+  memcpy(path + sizeof(path) - 7, "XXXXXX", 6);
+}
+
+void test_zbin_empty(void) { round_trip(NULL, 0); }
+
+void test_zbin_large_deltas(void) {
+  struct trace_request requests[] = {
+      {UINT64_MAX - TEST_STRIDE, 1, false, UINT64_MAX, 0, 0, 0},
+      {0, 1, true, 0, 0, 0, 0},
+      {UINT64_MAX / 2, UINT32_MAX, true, UINT64_MAX / 2, 0, 0, 0},
+      {1, 1, false, 1, 0, 0, 0},
+      {INT64_MAX, 2, false, (uint64_t)INT64_MAX + 1, 0, 0, 0},
+      {(uint64_t)INT64_MAX + 1, 3, true, INT64_MAX, 0, 0, 0},
+      {0, 0, true, 0, 0, 0, 0},
+  };
+
+  round_trip(requests, sizeof(requests) / sizeof(*requests));
+}
+
+void test_zbin_write_runs_across_blocks(void) {
+  struct trace_request *requests;
+  struct stat st;
+  uint64_t nr = 2 * TEST_NR_RUNS;
+  uint64_t i;
+
+  requests = (struct trace_request *)calloc(nr, sizeof(*requests));
+  TEST_ASSERT_NOT_NULL(requests);
+
+  // sequential requests of a few bytes each, in runs longer than a block
+  for (i = 0; i < nr; i++) {
+    requests[i].oblock = i * TEST_STRIDE;
+    requests[i].nr_blocks = 1;
+    requests[i].ts = i * 1000;
+    requests[i].write = (i / (TEST_NR_RUNS / 2 + 1)) % 2 == 1;
+  }
+  // and runs of a single request
+  for (i = TEST_NR_RUNS; i < TEST_NR_RUNS + 16; i++) {
+    requests[i].write = i % 2 == 0;
+  }
+  round_trip(requests, nr);
+
+  TEST_ASSERT_EQUAL_INT(0, stat(path, &st));
+  TEST_ASSERT(st.st_size > 2 * ZBIN_TRACE_BLOCK_SIZE);
+
+  free(requests);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_zbin_empty);
+  RUN_TEST(test_zbin_large_deltas);
+  RUN_TEST(test_zbin_write_runs_across_blocks);
+  return UNITY_END();
+}